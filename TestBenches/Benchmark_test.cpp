@@ -0,0 +1,162 @@
+// Throughput benchmark of the C simulation of the processing modules
+//
+// Runs the stages of the chain of Chain.h, either each module on its own or
+// the whole chain, over the events of the emulation printouts, repeated up
+// to $BENCH_NEVENTS events (500 by default). The modules to run are given as
+// arguments, among IR, VMR, TE, TC, PR, ME, MC, TB and chain; without any,
+// all of them are run in that order.
+//
+// A module run on its own reads all its inputs from the emulation printouts,
+// including the ones passed in process by the stages before it in the chain.
+// The inputs of all the events are in memory before the event loop starts,
+// as the printouts are memory-mapped (MemPrintsBinary.h), and only the calls
+// to the top functions are timed; loading the inputs of an event, counting
+// the entries of the outputs and comparing them with the emulation are not.
+// The chain runs its stages one after the other for each event, on a single
+// thread, so that its time is the sum of the times of its modules.
+//
+// Each run prints one line, a JSON object, with the number of events, the
+// time spent in the top functions, the events per second, the time per stub
+// on the links of the InputRouters, which is the same for all modules, and
+// the time per input entry processed by the top functions, as counted by the
+// stages (see Chain.h). The lines are also appended to $BENCH_OUTPUT if set,
+// to follow the C simulation performance from one version to the next.
+#include "Chain.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const int nevents = 100;  // number of events in the emulation printouts
+
+using namespace std;
+
+// Number of events to run: $BENCH_NEVENTS if set
+int getNBenchmarkEvents()
+{
+  const char* env = getenv("BENCH_NEVENTS");
+  return (env && atoi(env) > 0) ? atoi(env) : 5*nevents;
+}
+
+// Module of a stage, e.g. TC for TC_L1L2G
+string getModule(const ChainStage& stage)
+{
+  return stage.getName().substr(0, stage.getName().find('_'));
+}
+
+struct BenchmarkResult {
+  string module;
+  string stages;
+  unsigned long nevents;
+  double seconds;
+  unsigned long nstubs;
+  unsigned long nelements;
+  unsigned int errors;
+};
+
+string toJSON(const BenchmarkResult& result)
+{
+  ostringstream json;
+  json << "{\"module\": \"" << result.module << "\", \"stages\": \"" << result.stages << "\""
+       << ", \"events\": " << result.nevents << ", \"seconds\": " << result.seconds
+       << ", \"events_per_s\": " << (result.seconds > 0 ? result.nevents/result.seconds : 0.)
+       << ", \"stubs\": " << result.nstubs
+       << ", \"ns_per_stub\": " << (result.nstubs ? 1e9*result.seconds/result.nstubs : 0.)
+       << ", \"elements\": " << result.nelements
+       << ", \"ns_per_element\": " << (result.nelements ? 1e9*result.seconds/result.nelements : 0.)
+       << ", \"errors\": " << result.errors << "}";
+  return json.str();
+}
+
+// Run the stages of the chain for the module, or all of them for "chain",
+// for nrun events
+BenchmarkResult runBenchmark(vector<ChainStage>& stages, const string& module,
+                             const vector<unsigned int>& nstubs, int nrun)
+{
+  const bool chain = (module == "chain");
+
+  vector<ChainStage*> selected;
+  for (auto& stage : stages) {
+    if (not chain && getModule(stage) != module) continue;
+    stage.setStandalone(not chain);
+    selected.push_back(&stage);
+  }
+
+  BenchmarkResult result = {module, "", (unsigned long)nrun, 0, 0, 0, 0};
+  for (auto stage : selected) {
+    result.stages += (result.stages.empty() ? "" : " ") + stage->getName();
+    result.seconds -= stage->getSeconds();
+    result.nelements -= stage->getNElements();
+    result.errors -= stage->getErrors();
+  }
+
+  for (int irun = 0; irun < nrun; ++irun) {
+    const int ievt = irun % nevents;
+    for (auto stage : selected) {
+      stage->load(ievt);
+      stage->run(ievt);
+      stage->check(ievt);
+    }
+    result.nstubs += nstubs[ievt];
+  }
+
+  for (auto stage : selected) {
+    result.seconds += stage->getSeconds();
+    result.nelements += stage->getNElements();
+    result.errors += stage->getErrors();
+  }
+  return result;
+}
+
+int main(int argc, char* argv[])
+{
+  vector<string> modules(argv + 1, argv + argc);
+  if (modules.empty()) modules = {"IR", "VMR", "TE", "TC", "PR", "ME", "MC", "TB", "chain"};
+
+  const Wiring wiring("emData/wires_hourglass.dat");
+  const MemPrintsDirectory memprints("emData/MemPrints");
+  if (not wiring.good() || not memprints.good()) {
+    cerr << "Wiring file or emulation printouts not found, run emData/download.sh" << endl;
+    return -1;
+  }
+
+  // The chain is allocated on the heap, as its memories are too large for
+  // the stack
+  unique_ptr<Chain> chain(new Chain(wiring, memprints));
+  if (not chain->good()) return -1;
+  vector<ChainStage>& stages = chain->getStages();
+
+  vector<unsigned int> nstubs(nevents);
+  for (int ievt = 0; ievt < nevents; ++ievt) nstubs[ievt] = chain->getNStubs(ievt);
+
+  for (const auto& module : modules) {
+    bool found = (module == "chain");
+    for (const auto& stage : stages) found |= (getModule(stage) == module);
+    if (not found) {
+      cerr << "No stage for module " << module << endl;
+      return -1;
+    }
+  }
+
+  const char* output = getenv("BENCH_OUTPUT");
+  ofstream fout;
+  if (output) fout.open(output, ios::app);
+
+  ///////////////////////////
+  // loop over modules
+  int err = 0;
+  for (const auto& module : modules) {
+    const BenchmarkResult result = runBenchmark(stages, module, nstubs, getNBenchmarkEvents());
+    cout << toJSON(result) << endl;
+    if (fout.is_open()) fout << toJSON(result) << endl;
+    err += result.errors;
+  }
+
+  // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
+  if (err > 255) err = 255;
+  return err;
+}
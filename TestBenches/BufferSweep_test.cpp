@@ -0,0 +1,192 @@
+// Buffer depth sweep for the TrackletEngine and the MatchEngine
+//
+// Both modules keep a circular buffer between the stage that reads their
+// inputs and the stage that processes them: a buffer that is too small makes
+// the read stage stall, so that inputs are left over when the loop runs out
+// of steps. This test bench runs the same events through TrackletEngine and
+// MatchEngine with buffers of 2 to 64 entries and prints, for each size, the
+// fraction of the stub pairs and candidate matches of the emulation that are
+// found, i.e. the smallest buffer that does not lose any.
+#include "TrackletEngine.h"
+#include "StubPairMemory.h"
+#include "VMStubTEInnerMemory.h"
+#include "VMStubTEOuterMemory.h"
+#include "FileReadUtility.h"
+#include "MemPrintsBinary.h"
+#include "LookupTableFile.h"
+
+// Included last, as it defines macros such as LAYER
+#include "MatchEngine.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+const int nevents = 100;  // number of events to run
+
+using namespace std;
+
+// Outputs of one module for one buffer size, summed over the events
+struct SweepResult {
+  unsigned int nbits;      // buffer of 1<<nbits entries
+  unsigned int nout;       // outputs produced
+  unsigned int nref;       // outputs of the emulation
+  unsigned int nfound;     // outputs of the emulation that were produced
+  unsigned int ncomplete;  // events with all the outputs of the emulation
+};
+
+// Count the words of the emulation found among the output words. The
+// modules do not set the number of entries of their output memory, so the
+// whole page is read and empty words are skipped.
+template<class MemType>
+void compareOutputs(const MemType& memory, const MemType& memory_ref, BXType bx, SweepResult& result)
+{
+  vector<string> out, ref;
+  for (unsigned int i = 0; i < memory.getDepth(); ++i) {
+    const auto word = memory.read_mem(bx, i).raw();
+    if (word != 0) out.push_back(word.to_string(16));
+  }
+  for (unsigned int i = 0; i < memory_ref.getEntries(bx); ++i) {
+    ref.push_back(memory_ref.read_mem(bx, i).raw().to_string(16));
+  }
+
+  sort(out.begin(), out.end());
+  sort(ref.begin(), ref.end());
+  vector<string> found;
+  set_intersection(ref.begin(), ref.end(), out.begin(), out.end(), back_inserter(found));
+
+  result.nout += out.size();
+  result.nref += ref.size();
+  result.nfound += found.size();
+  result.ncomplete += (found.size() == ref.size());
+}
+
+// Inputs read once and shared by all the buffer sizes
+struct TrackletEngineInputs {
+  TrackletEngineInputs(const string& dir):
+    vmstubsinner(dir + "VMStubs_VMSTE_L1PHIE18n2_04.dat"),
+    vmstubsouter(dir + "VMStubs_VMSTE_L2PHIC17n4_04.dat"),
+    stubpairs(dir + "StubPairs_SP_L1PHIE18_L2PHIC17_04.dat")
+  {}
+
+  bool good() const {return vmstubsinner.good() && vmstubsouter.good() && stubpairs.good();}
+
+  MemPrintsBinary vmstubsinner;
+  MemPrintsBinary vmstubsouter;
+  MemPrintsBinary stubpairs;
+};
+
+struct MatchEngineInputs {
+  MatchEngineInputs(const string& dir):
+    vmprojs(dir + "VMProjections_VMPROJ_L3PHIC20_04.dat"),
+    vmstubs(dir + "VMStubs_VMSME_L3PHIC20n1_04.dat"),
+    candmatches(dir + "CandidateMatches_CM_L3PHIC20_04.dat")
+  {}
+
+  bool good() const {return vmprojs.good() && vmstubs.good() && candmatches.good();}
+
+  MemPrintsBinary vmprojs;
+  MemPrintsBinary vmstubs;
+  MemPrintsBinary candmatches;
+};
+
+template<unsigned int NBitsBuffer>
+SweepResult sweepTrackletEngine(const TrackletEngineInputs& in,
+                                const ap_uint<1> bendinnertable[256], const ap_uint<1> bendoutertable[256])
+{
+  static VMStubTEInnerMemory<BARRELPS> inputvmstubsinner;
+  static VMStubTEOuterMemory<BARRELPS> inputvmstubsouter;
+  static StubPairMemory outputstubpairs;
+  static StubPairMemory stubpairs_ref;
+
+  SweepResult result = {NBitsBuffer, 0, 0, 0, 0};
+  for (int ievt = 0; ievt < nevents; ++ievt) {
+    writeMemFromFile<VMStubTEInnerMemory<BARRELPS> >(inputvmstubsinner, in.vmstubsinner, ievt);
+    writeMemFromFile<VMStubTEOuterMemory<BARRELPS> >(inputvmstubsouter, in.vmstubsouter, ievt);
+    writeMemFromFile<StubPairMemory>(stubpairs_ref, in.stubpairs, ievt);
+
+    BXType bx = ievt&0x7;
+    BXType bx_o;
+    outputstubpairs.clear(bx);
+
+    TrackletEngine<BARRELPS, BARRELPS, 256, 256, NBitsBuffer>
+      (bx, inputvmstubsinner, inputvmstubsouter, bendinnertable, bendoutertable, bx_o, outputstubpairs);
+
+    compareOutputs(outputstubpairs, stubpairs_ref, bx, result);
+  }
+  return result;
+}
+
+template<unsigned int NBitsBuffer>
+SweepResult sweepMatchEngine(const MatchEngineInputs& in)
+{
+  static VMProjectionMemory<PROJECTIONTYPE> inputvmprojs;
+  static VMStubMEMemory<MODULETYPE, NBITBIN> inputvmstubs;
+  static CandidateMatchMemory outputcandmatches;
+  static CandidateMatchMemory candmatches_ref;
+
+  SweepResult result = {NBitsBuffer, 0, 0, 0, 0};
+  for (int ievt = 0; ievt < nevents; ++ievt) {
+    writeMemFromFile<VMProjectionMemory<PROJECTIONTYPE> >(inputvmprojs, in.vmprojs, ievt);
+    writeMemFromFile<VMStubMEMemory<MODULETYPE, NBITBIN> >(inputvmstubs, in.vmstubs, ievt);
+    writeMemFromFile<CandidateMatchMemory>(candmatches_ref, in.candmatches, ievt);
+
+    BXType bx = ievt&0x7;
+    BXType bx_o;
+    outputcandmatches.clear(bx);
+
+    MatchEngine<LAYER, 0, MODULETYPE, PROJECTIONTYPE, NBitsBuffer>
+      (bx, bx_o, inputvmstubs, inputvmprojs, outputcandmatches);
+
+    compareOutputs(outputcandmatches, candmatches_ref, bx, result);
+  }
+  return result;
+}
+
+void printResults(const string& module, const string& output, unsigned int nbitsDefault,
+                  const vector<SweepResult>& results)
+{
+  cout << endl << module << " " << output << " versus buffer size, for " << nevents << " events" << endl
+       << setw(8) << "buffer" << setw(10) << "outputs" << setw(12) << "emulation"
+       << setw(10) << "found" << setw(12) << "complete" << setw(14) << "full events" << endl;
+  for (const auto& result : results) {
+    cout << setw(8) << (1 << result.nbits) << setw(10) << result.nout << setw(12) << result.nref
+         << setw(10) << result.nfound << setw(11) << fixed << setprecision(1)
+         << (result.nref ? 100.*result.nfound/result.nref : 100.) << "%"
+         << setw(14) << result.ncomplete << (result.nbits == nbitsDefault ? "  (default)" : "") << endl;
+  }
+}
+
+int main()
+{
+  const TrackletEngineInputs te("../../../../../emData/TE/TE_L1PHIE18_L2PHIC17/");
+  if (not te.good()) return -1;
+
+  ap_uint<1> bendinnertable[256], bendoutertable[256];
+  if (not readLookupTable("../../../../../emData/TE/tables/TE_L1PHIE18_L2PHIC17_stubptinnercut.tab", bendinnertable, 256)
+      || not readLookupTable("../../../../../emData/TE/tables/TE_L1PHIE18_L2PHIC17_stubptoutercut.tab", bendoutertable, 256)) {
+    return -1;
+  }
+
+  const MatchEngineInputs me("../../../../../emData/ME/ME_L3PHIC20/");
+  if (not me.good()) return -2;
+
+  const vector<SweepResult> teResults = {
+    sweepTrackletEngine<1>(te, bendinnertable, bendoutertable),
+    sweepTrackletEngine<2>(te, bendinnertable, bendoutertable),
+    sweepTrackletEngine<3>(te, bendinnertable, bendoutertable),
+    sweepTrackletEngine<4>(te, bendinnertable, bendoutertable),
+    sweepTrackletEngine<5>(te, bendinnertable, bendoutertable),
+    sweepTrackletEngine<6>(te, bendinnertable, bendoutertable)
+  };
+  printResults("TrackletEngine", "stub pairs", TE::kNBits_BufferAddr, teResults);
+
+  const vector<SweepResult> meResults = {
+    sweepMatchEngine<1>(me), sweepMatchEngine<2>(me), sweepMatchEngine<3>(me),
+    sweepMatchEngine<4>(me), sweepMatchEngine<5>(me), sweepMatchEngine<6>(me)
+  };
+  printResults("MatchEngine", "candidate matches", kNBits_BufferAddr, meResults);
+
+  return 0;
+}
@@ -0,0 +1,502 @@
+// Slice of the chain run in a single process, used only in test bench for C
+// simulation:
+//   IR -> VMR_L1PHIE -> TE_L1PHIE18_L2PHIC17 -> TC_L1L2G -> PR_L3PHIC
+//      -> ME_L3PHIC17..24 -> MC_L3PHIC -> TB_L1L2
+// i.e. the processing modules with a top function in TrackletAlgorithm,
+// following one path through wires_hourglass.dat.
+//
+// Each stage calls the same top function as its own test bench. A memory
+// written by one stage and read by the next is passed in process, by handing
+// the same memory object to both top functions or, where their array layouts
+// differ, by copying the BX page. All other inputs are read from the
+// emulation printouts, and every memory passed in process is compared with
+// its printout.
+//
+// Chain sets up the memories and the stages; the chain test bench runs them
+// as a pipeline and the benchmark test bench one by one. Each stage counts
+// the input entries its top function processes: the stubs of the links for
+// the InputRouter, the input stubs for the VMRouter, the inner and outer VM
+// stubs for the TrackletEngine, the stub pairs for the TrackletCalculator,
+// the tracklet projections for the ProjectionRouter, the VM projections for
+// the MatchEngines, the candidate matches for the MatchCalculator and the
+// full matches for the TrackBuilder.
+#ifndef __SYNTHESIS__
+
+#ifndef TestBenches_Chain_h
+#define TestBenches_Chain_h
+
+#include "InputRouterTop.h"
+#include "VMRouterTop.h"
+#include "TrackletEngineTop.h"
+#include "TrackletCalculatorTop.h"
+#include "ProjectionRouterTop.h"
+#include "MatchCalculatorTop.h"
+#include "TrackBuilderTop.h"
+
+#include "FileReadUtility.h"
+#include "MemPrintsBinary.h"
+#include "LookupTableFile.h"
+#include "ChainUtility.h"
+#include "InputRouterLinks.h"
+
+// Included last, as it defines macros such as LAYER
+#include "MatchEngine.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Memories read by the TrackletCalculator and the TrackBuilder, in the order
+// of the arrays passed to their top functions
+const std::string tcStubPairNames[] = {
+  "SP_L1PHIE17_L2PHIB16", "SP_L1PHIE17_L2PHIC17", "SP_L1PHIE17_L2PHIC18",
+  "SP_L1PHIE17_L2PHIC19", "SP_L1PHIE18_L2PHIB16", "SP_L1PHIE18_L2PHIC17",
+  "SP_L1PHIE18_L2PHIC18", "SP_L1PHIE18_L2PHIC19", "SP_L1PHIE18_L2PHIC20",
+  "SP_L1PHIE19_L2PHIC17", "SP_L1PHIE19_L2PHIC18", "SP_L1PHIE19_L2PHIC19",
+  "SP_L1PHIE19_L2PHIC20"
+};
+const std::string prProjectionNames[] = {
+  "TPROJ_L1L2F_L3PHIC", "TPROJ_L1L2G_L3PHIC", "TPROJ_L1L2H_L3PHIC",
+  "TPROJ_L1L2I_L3PHIC", "TPROJ_L1L2J_L3PHIC", "TPROJ_L5L6B_L3PHIC",
+  "TPROJ_L5L6C_L3PHIC", "TPROJ_L5L6D_L3PHIC"
+};
+const char tbBarrelLayers[] = {'3', '4', '5', '6'};
+const char tbDisks[] = {'1', '2', '3', '4'};
+
+constexpr int nStubPairs = sizeof(tcStubPairNames)/sizeof(tcStubPairNames[0]);
+constexpr int nProjections = sizeof(prProjectionNames)/sizeof(prProjectionNames[0]);
+constexpr int nTrackletParameters = 12;
+constexpr int nFullMatches = 16;
+
+// Index of a memory in one of the lists above
+template<int N>
+int findMemory(const std::string (&names)[N], const std::string& name)
+{
+  for (int i = 0; i < N; ++i) {
+    if (names[i] == name) return i;
+  }
+  return -1;
+}
+
+// Memories of the InputRouter reading out one link
+struct InputRouterLink {
+  int linkId;
+  int memIndex; // index of the memory read by the VMRouter
+  std::ifstream fin;
+  MemPrintsIndex index;
+  ap_uint<kNBits_DTC> inputStubs[kMaxStubsFromLink];
+  DTCStubStream inputStream;
+  DTCStubMemory memories[cNMemories];
+};
+
+// All memories of the chain. A memory passed in process is a single object,
+// declared with the stage whose top function fixes its array layout.
+struct ChainMemories {
+  // VMRouter
+  InputStubMemory<inputType> vmrInputStubs[numInputs];
+  AllStubMemory<outputType> vmrAllStubs[maxASCopies];
+  VMStubMEMemory<outputType, nbitsbin> vmrMEStubs[nvmME];
+  VMStubTEInnerMemory<outputType> vmrTEInnerStubs[nvmTEI][maxTEICopies];
+  VMStubTEInnerMemory<BARRELOL> vmrTEOverlapStubs[nvmOL][maxOLCopies];
+
+  // TrackletEngine
+  VMStubTEOuterMemory<BARRELPS> teOuterStubs;
+
+  // TrackletCalculator
+  AllStubMemory<BARRELPS> tcOuterStubs[2];
+  StubPairMemory tcStubPairs[nStubPairs];
+  TrackletProjectionMemory<BARRELPS> tcProjBarrelPS[TC::N_PROJOUT_BARRELPS];
+  TrackletProjectionMemory<BARREL2S> tcProjBarrel2S[TC::N_PROJOUT_BARREL2S];
+  TrackletProjectionMemory<DISK> tcProjDisk[TC::N_PROJOUT_DISK];
+
+  // ProjectionRouter
+  TrackletProjectionMemory<BARRELPS> prProjections[nProjections];
+  AllProjectionMemory<BARRELPS> prAllProj;
+  VMProjectionMemory<BARREL> prVMProjections[maxMatchCopies];
+
+  // MatchEngine
+  VMStubMEMemory<BARRELPS, 3> meStubs[maxMatchCopies];
+  CandidateMatchMemory meCandidateMatches[maxMatchCopies];
+
+  // MatchCalculator
+  AllStubMemory<BARRELPS> mcAllStubs;
+  FullMatchMemory<BARREL_FOR_MC> mcFullMatches[maxFullMatchCopies];
+
+  // TrackBuilder
+  TrackletParameterMemory tbTrackletParameters[nTrackletParameters];
+  FullMatchMemory<BARREL> tbBarrelFullMatches[nFullMatches];
+  FullMatchMemory<DISK> tbDiskFullMatches[nFullMatches];
+  TrackFit::TrackWord tbTrackWord[kMaxProc];
+  TrackFit::BarrelStubWord tbBarrelStubWords[4][kMaxProc];
+  TrackFit::DiskStubWord tbDiskStubWords[4][kMaxProc];
+  TrackFitMemory tbTracks;
+};
+
+// The memories and stages of the chain. It is too large for the stack and
+// must be allocated on the heap; the stages refer to its memories, so it
+// must outlive them.
+class Chain
+{
+public:
+
+  // truncation: compare results to truncated emulation
+  // runInputRouter: produce the VMRouter inputs with the InputRouter, instead
+  // of reading them from the emulation printouts
+  Chain(const Wiring& wiring, const MemPrintsDirectory& memprints,
+        bool truncation = false, bool runInputRouter = true);
+
+  Chain(const Chain&) = delete;
+  Chain& operator=(const Chain&) = delete;
+
+  bool good() const {return valid_;}
+
+  std::vector<ChainStage>& getStages() {return stages_;}
+
+  // Number of stubs on the links read out by the InputRouters in event ievt
+  unsigned int getNStubs(int ievt);
+
+private:
+
+  // Check that a memory passed in process is in the wiring file
+  void checkWiring(const Wiring& wiring, const std::string& memory,
+                   const std::string& source, const std::string& destination);
+
+  ChainMemories mem_;
+  std::vector<std::unique_ptr<InputRouterLink> > links_;
+  ap_uint<1> bendinnertable_[256];
+  ap_uint<1> bendoutertable_[256];
+  MemPrintsBinary fout_tracks_;
+  std::vector<ChainStage> stages_;
+  bool valid_;
+
+};
+
+inline void Chain::checkWiring(const Wiring& wiring, const std::string& memory,
+                               const std::string& source, const std::string& destination)
+{
+  if (wiring.connects(memory, source, destination)) return;
+  std::cerr << memory << " does not connect " << source << " to " << destination << std::endl;
+  valid_ = false;
+}
+
+inline unsigned int Chain::getNStubs(int ievt)
+{
+  unsigned int nstubs = 0;
+  for (auto& link : links_) {
+    if (not link) continue;
+    ap_uint<kNBits_DTC> stubs[kMaxStubsFromLink] = {};
+    writeArrayFromFile<ap_uint<kNBits_DTC> >(stubs, link->fin, link->index, ievt);
+    for (const auto& stub : stubs) nstubs += (stub != 0);
+  }
+  return nstubs;
+}
+
+inline Chain::Chain(const Wiring& wiring, const MemPrintsDirectory& memprints,
+                    bool truncation, bool runInputRouter):
+  valid_(true)
+{
+  ChainMemories& mem = mem_;
+
+  ///////////////////////////
+  // InputRouter
+  // one InputRouter per link read out by the VMRouter
+  const std::string vmrModule = "VMR_L1PHIE";
+  const std::vector<std::string> vmrInputNames = wiring.getInputs(vmrModule);
+  if (vmrInputNames.size() != numInputs) {
+    std::cerr << vmrModule << " has " << vmrInputNames.size() << " inputs in the wiring file" << std::endl;
+    valid_ = false;
+    return;
+  }
+
+  links_.resize(numInputs);
+  stages_.emplace_back("IR", memprints);
+  for (unsigned int i = 0; i < numInputs; i++) {
+    if (not runInputRouter) break;
+
+    // e.g. IL_L1PHIE_PS10G_1_A is read out by the link of DTC PS10G_1_A
+    const std::string prefix = std::string("IL_L") + std::to_string(kLAYER) + "PHI" + phiRegion + "_";
+    const std::string dtc = vmrInputNames[i].substr(prefix.size());
+    const int linkId = getLinkId(dtc);
+    if (linkId < 0 || kLinkNMemories[linkId%12] > cNMemories) {
+      std::cout << vmrInputNames[i] << ": link not handled by InputRouterTop, read from emulation" << std::endl;
+      continue;
+    }
+    checkWiring(wiring, vmrInputNames[i], wiring.getSource(vmrInputNames[i]), vmrModule);
+
+    auto& link = links_[i];
+    link.reset(new InputRouterLink());
+    link->linkId = linkId;
+    link->memIndex = getMemIndex(linkId, true, kLAYER, phiRegion - 'A');
+    const std::string linkFile = "emData/MemPrints/InputStubs/Link_" + dtc + ".dat";
+    if (link->memIndex < 0 || not openDataFile(link->fin, linkFile)) {
+      valid_ = false;
+      return;
+    }
+    link->index.open(linkFile);
+
+    InputRouterLink* plink = link.get();
+    stages_.back().addLoader([plink](int ievt) {
+      for (auto& stub : plink->inputStubs) stub = 0;
+      writeArrayFromFile<ap_uint<kNBits_DTC> >(plink->inputStubs, plink->fin, plink->index, ievt);
+      writeLinkStream(plink->inputStream, plink->inputStubs);
+    });
+    stages_.back().addCount([plink](BXType) {
+      unsigned int nstubs = 0;
+      for (const auto& stub : plink->inputStubs) nstubs += (stub != 0);
+      return nstubs;
+    });
+    for (auto& memory : link->memories) stages_.back().addOutput(memory);
+    valid_ &= stages_.back().addReference(vmrInputNames[i], link->memories[link->memIndex], truncation);
+  }
+  stages_.back().setProcess([this](BXType bx) {
+    for (auto& link : links_) {
+      if (not link) continue;
+      const auto hLinkWord = kLinkAssignmentTable[link->linkId%12];
+      const auto hPhBnWord = kLinkNPhiBns[link->linkId%12];
+      const bool hIs2S = hLinkWord.range(kLINKMAPwidth-4, kLINKMAPwidth-4);
+      BXType bx_o;
+      InputRouterTop(bx, hLinkWord, hPhBnWord,
+        hIs2S ? kPhiCorrtable_L4 : kPhiCorrtable_L1,
+        hIs2S ? kPhiCorrtable_L5 : kPhiCorrtable_L2,
+        hIs2S ? kPhiCorrtable_L6 : kPhiCorrtable_L3,
+        link->inputStream, bx_o, link->memories);
+    }
+  });
+
+  ///////////////////////////
+  // VMRouter
+  stages_.emplace_back(vmrModule, memprints);
+  for (unsigned int i = 0; i < numInputs; i++) {
+    if (links_[i]) {
+      auto& memory = links_[i]->memories[links_[i]->memIndex];
+      valid_ &= stages_.back().addRead(vmrInputNames[i], memory);
+      stages_.back().countEntries(memory);
+    } else {
+      valid_ &= stages_.back().addInput(vmrInputNames[i], mem.vmrInputStubs[i]);
+      stages_.back().countEntries(mem.vmrInputStubs[i]);
+    }
+  }
+  for (auto& memory : mem.vmrAllStubs) stages_.back().addOutput(memory);
+  for (auto& memory : mem.vmrMEStubs) stages_.back().addOutput(memory);
+  for (auto& memories : mem.vmrTEInnerStubs) for (auto& memory : memories) stages_.back().addOutput(memory);
+  for (auto& memories : mem.vmrTEOverlapStubs) for (auto& memory : memories) stages_.back().addOutput(memory);
+  stages_.back().setProcess([this](BXType bx) {
+    for (unsigned int i = 0; i < numInputs; i++) {
+      if (links_[i]) copyMemPage(mem_.vmrInputStubs[i], links_[i]->memories[links_[i]->memIndex], bx);
+    }
+    BXType bx_o;
+    VMRouterTop(bx, bx_o, mem_.vmrInputStubs, mem_.vmrAllStubs, mem_.vmrMEStubs,
+                mem_.vmrTEInnerStubs, mem_.vmrTEOverlapStubs);
+  });
+
+  ///////////////////////////
+  // TrackletEngine
+  const std::string teModule = "TE_L1PHIE18_L2PHIC17";
+  const std::string teInnerName = "VMSTE_L1PHIE18n2";
+  const std::string teStubPairName = "SP_L1PHIE18_L2PHIC17";
+  checkWiring(wiring, teInnerName, vmrModule, teModule);
+  auto& teInnerStubs = mem.vmrTEInnerStubs[(getVMNumber(teInnerName)-1)%nvmTEI][getCopyIndex(teInnerName)];
+  auto& teStubPairs = mem.tcStubPairs[findMemory(tcStubPairNames, teStubPairName)];
+
+  valid_ &= readLookupTable("emData/LUTs/" + teModule + "_stubptinnercut.tab", bendinnertable_, 256);
+  valid_ &= readLookupTable("emData/LUTs/" + teModule + "_stubptoutercut.tab", bendoutertable_, 256);
+
+  stages_.emplace_back(teModule, memprints);
+  valid_ &= stages_.back().addInput("VMSTE_L2PHIC17n4", mem.teOuterStubs);
+  stages_.back().addOutput(teStubPairs);
+  valid_ &= stages_.back().addPassedInput(teInnerName, teInnerStubs, truncation);
+  stages_.back().countEntries(teInnerStubs);
+  stages_.back().countEntries(mem.teOuterStubs);
+  const auto pTEInnerStubs = &teInnerStubs;
+  const auto pTEStubPairs = &teStubPairs;
+  stages_.back().setProcess([this, pTEInnerStubs, pTEStubPairs](BXType bx) {
+    BXType bx_o;
+    TrackletEngineTop(bx, *pTEInnerStubs, mem_.teOuterStubs, bendinnertable_, bendoutertable_, bx_o, *pTEStubPairs);
+  });
+
+  ///////////////////////////
+  // TrackletCalculator
+  const std::string tcModule = "TC_L1L2G";
+  const std::string tcInnerName = "AS_L1PHIEn2";
+  const std::string tcParameterName = "TPAR_L1L2G";
+  const std::string tcProjectionName = "TPROJ_L1L2G_L3PHIC";
+  checkWiring(wiring, teStubPairName, teModule, tcModule);
+  checkWiring(wiring, tcInnerName, vmrModule, tcModule);
+  auto& tcInnerStubs = mem.vmrAllStubs[getCopyIndex(tcInnerName)];
+  auto& tcParameters = mem.tbTrackletParameters[tcModule.back() - 'A'];
+
+  stages_.emplace_back(tcModule, memprints);
+  valid_ &= stages_.back().addInput("AS_L2PHIBn5", mem.tcOuterStubs[0]);
+  valid_ &= stages_.back().addInput("AS_L2PHICn2", mem.tcOuterStubs[1]);
+  for (int i = 0; i < nStubPairs; i++) {
+    if (&mem.tcStubPairs[i] != &teStubPairs) valid_ &= stages_.back().addInput(tcStubPairNames[i], mem.tcStubPairs[i]);
+    stages_.back().countEntries(mem.tcStubPairs[i]);
+  }
+  stages_.back().addOutput(tcParameters);
+  for (auto& memory : mem.tcProjBarrelPS) stages_.back().addOutput(memory);
+  for (auto& memory : mem.tcProjBarrel2S) stages_.back().addOutput(memory);
+  for (auto& memory : mem.tcProjDisk) stages_.back().addOutput(memory);
+  valid_ &= stages_.back().addPassedInput(tcInnerName, tcInnerStubs, truncation);
+  valid_ &= stages_.back().addPassedInput(teStubPairName, teStubPairs, truncation);
+  const auto pTCInnerStubs = &tcInnerStubs;
+  const auto pTCParameters = &tcParameters;
+  stages_.back().setProcess([this, pTCInnerStubs, pTCParameters](BXType bx) {
+    BXType bx_o;
+    TrackletCalculator_L1L2G(bx, pTCInnerStubs, mem_.tcOuterStubs, mem_.tcStubPairs, bx_o,
+                             pTCParameters, mem_.tcProjBarrelPS, mem_.tcProjBarrel2S, mem_.tcProjDisk);
+  });
+
+  ///////////////////////////
+  // ProjectionRouter
+  const std::string prModule = "PR_L3PHIC";
+  const std::string prAllProjName = "AP_L3PHIC";
+  const int prProjection = findMemory(prProjectionNames, tcProjectionName);
+  checkWiring(wiring, tcProjectionName, tcModule, prModule);
+
+  stages_.emplace_back(prModule, memprints);
+  for (int i = 0; i < nProjections; i++) {
+    if (i == prProjection) continue;
+    valid_ &= stages_.back().addInput(prProjectionNames[i], mem.prProjections[i]);
+    stages_.back().countEntries(mem.prProjections[i]);
+  }
+  stages_.back().addOutput(mem.prAllProj);
+  for (auto& memory : mem.prVMProjections) stages_.back().addOutput(memory);
+  valid_ &= stages_.back().addPassedInput(tcProjectionName, mem.tcProjBarrelPS[TC::L3PHIC], truncation);
+  stages_.back().countEntries(mem.tcProjBarrelPS[TC::L3PHIC]);
+  stages_.back().setProcess([this, prProjection](BXType bx) {
+    copyMemPage(mem_.prProjections[prProjection], mem_.tcProjBarrelPS[TC::L3PHIC], bx);
+    BXType bx_o;
+    ProjectionRouterTop(bx, mem_.prProjections, bx_o, mem_.prAllProj, mem_.prVMProjections);
+  });
+
+  ///////////////////////////
+  // MatchEngines, one per virtual module of L3PHIC
+  // The MatchEngines process the output of the ProjectionRouter in the same
+  // pipeline step, so that the TrackletParameter memories, with 4 BX pages,
+  // are read by the TrackBuilder 3 steps after they are written
+  stages_.emplace_back("ME_L3PHIC", memprints);
+  stages_.back().setStepIncrement(0);
+  for (int i = 0; i < maxMatchCopies; i++) {
+    const std::string vm = "L3PHIC" + std::to_string(17+i);
+    checkWiring(wiring, "VMPROJ_" + vm, prModule, "ME_" + vm);
+    valid_ &= stages_.back().addInput("VMSME_" + vm + "n1", mem.meStubs[i]);
+    valid_ &= stages_.back().addPassedInput("VMPROJ_" + vm, mem.prVMProjections[i], truncation);
+    stages_.back().countEntries(mem.prVMProjections[i]);
+    stages_.back().addOutput(mem.meCandidateMatches[i]);
+  }
+  stages_.back().setProcess([this](BXType bx) {
+    for (int i = 0; i < maxMatchCopies; i++) {
+      BXType bx_o;
+      MatchEngineTop(bx, bx_o, mem_.meStubs[i], mem_.prVMProjections[i], mem_.meCandidateMatches[i]);
+    }
+  });
+
+  ///////////////////////////
+  // MatchCalculator
+  const std::string mcModule = "MC_L3PHIC";
+  const std::string mcFullMatchName = "FM_L1L2_L3PHIC";
+  checkWiring(wiring, prAllProjName, prModule, mcModule);
+
+  stages_.emplace_back(mcModule, memprints);
+  valid_ &= stages_.back().addInput("AS_L3PHICn6", mem.mcAllStubs);
+  for (auto& memory : mem.mcFullMatches) stages_.back().addOutput(memory);
+  valid_ &= stages_.back().addPassedInput(prAllProjName, mem.prAllProj, truncation);
+  for (int i = 0; i < maxMatchCopies; i++) {
+    const std::string vm = "L3PHIC" + std::to_string(17+i);
+    checkWiring(wiring, "CM_" + vm, "ME_" + vm, mcModule);
+    valid_ &= stages_.back().addPassedInput("CM_" + vm, mem.meCandidateMatches[i], truncation);
+    stages_.back().countEntries(mem.meCandidateMatches[i]);
+  }
+  stages_.back().setProcess([this](BXType bx) {
+    BXType bx_o;
+    MatchCalculatorTop(bx, mem_.meCandidateMatches, &mem_.mcAllStubs, &mem_.prAllProj, bx_o, mem_.mcFullMatches);
+  });
+
+  ///////////////////////////
+  // TrackBuilder
+  const std::string tbModule = "TB_L1L2";
+  const int tbFullMatch = 2; // FM_L1L2_L3PHIC
+  checkWiring(wiring, tcParameterName, tcModule, tbModule);
+  checkWiring(wiring, mcFullMatchName, mcModule, tbModule);
+
+  stages_.emplace_back(tbModule, memprints);
+  for (int i = 0; i < nTrackletParameters; i++) {
+    if (&mem.tbTrackletParameters[i] != &tcParameters)
+      valid_ &= stages_.back().addInput(std::string("TPAR_L1L2") + char('A'+i), mem.tbTrackletParameters[i]);
+  }
+  for (int i = 0; i < nFullMatches; i++) {
+    const std::string region = std::string("PHI") + char('A'+i%4);
+    if (i != tbFullMatch) {
+      valid_ &= stages_.back().addInput(std::string("FM_L1L2_L") + tbBarrelLayers[i/4] + region, mem.tbBarrelFullMatches[i]);
+      stages_.back().countEntries(mem.tbBarrelFullMatches[i]);
+    }
+    valid_ &= stages_.back().addInput(std::string("FM_L1L2_D") + tbDisks[i/4] + region, mem.tbDiskFullMatches[i]);
+    stages_.back().countEntries(mem.tbDiskFullMatches[i]);
+  }
+  stages_.back().addOutput(mem.tbTracks);
+  valid_ &= stages_.back().addPassedInput(tcParameterName, tcParameters, truncation);
+  valid_ &= stages_.back().addPassedInput(mcFullMatchName, mem.mcFullMatches[0], truncation);
+  valid_ &= stages_.back().addRead("AS_L3PHICn6", mem.mcAllStubs);
+  stages_.back().countEntries(mem.mcFullMatches[0]);
+  stages_.back().setProcess([this, tbFullMatch](BXType bx) {
+    // The MatchCalculator does not fill the stub r of its full matches yet,
+    // so it is taken from the AllStub memory the match was made with
+    copyMemPage(mem_.tbBarrelFullMatches[tbFullMatch], mem_.mcFullMatches[0], bx,
+      [this, bx](const FullMatch<BARREL_FOR_MC>& fm) {
+        FullMatch<BARREL> match;
+        match.setTCID(fm.getTCID());
+        match.setTrackletIndex(fm.getTrackletIndex());
+        match.setStubIndex(fm.getStubIndex());
+        match.setStubR(mem_.mcAllStubs.read_mem(bx, fm.getStubID()).getR());
+        match.setPhiRes(fm.getPhiRes());
+        match.setZRes(fm.getZRes());
+        return match;
+      });
+    BXType bx_o;
+    TrackBuilder_L1L2(bx, mem_.tbTrackletParameters, mem_.tbBarrelFullMatches, mem_.tbDiskFullMatches,
+                      bx_o, mem_.tbTrackWord, mem_.tbBarrelStubWords, mem_.tbDiskStubWords);
+  });
+
+  if (not openDataFile(fout_tracks_, memprints.getFile("TF_L1L2"))) {
+    valid_ = false;
+    return;
+  }
+  stages_.back().addCheck([this](int ievt) {
+    // Write the valid tracks to a memory, as in the TrackBuilder test bench
+    const BXType bx = ievt;
+    unsigned int nTracks = 0;
+    for (unsigned short i = 0; i < kMaxProc; i++) {
+      TrackFit track;
+      track.setTrackWord(mem_.tbTrackWord[i]);
+      track.setBarrelStubWord<0>(mem_.tbBarrelStubWords[0][i]);
+      track.setBarrelStubWord<1>(mem_.tbBarrelStubWords[1][i]);
+      track.setBarrelStubWord<2>(mem_.tbBarrelStubWords[2][i]);
+      track.setBarrelStubWord<3>(mem_.tbBarrelStubWords[3][i]);
+      track.setDiskStubWord<4>(mem_.tbDiskStubWords[0][i]);
+      track.setDiskStubWord<5>(mem_.tbDiskStubWords[1][i]);
+      track.setDiskStubWord<6>(mem_.tbDiskStubWords[2][i]);
+      track.setDiskStubWord<7>(mem_.tbDiskStubWords[3][i]);
+      if (track.getTrackValid())
+        mem_.tbTracks.write_mem(bx, track, nTracks++);
+    }
+
+    const bool truncate = true;
+    unsigned int err = 0;
+    err += compareMemWithFile<TrackFitMemory,16,16,TrackFit::kTFHitMapLSB,TrackFit::kTFTrackValidMSB>(mem_.tbTracks, fout_tracks_, ievt, "\nTrack word", truncate);
+    err += compareMemWithFile<TrackFitMemory,16,16,TrackFit::kTFStubRZResidLSB(0),TrackFit::kTFStubValidMSB(0)>(mem_.tbTracks, fout_tracks_, ievt, "\nStub 0 word", truncate);
+    err += compareMemWithFile<TrackFitMemory,16,16,TrackFit::kTFStubRZResidLSB(1),TrackFit::kTFStubValidMSB(1)>(mem_.tbTracks, fout_tracks_, ievt, "\nStub 1 word", truncate);
+    err += compareMemWithFile<TrackFitMemory,16,16,TrackFit::kTFStubRZResidLSB(2),TrackFit::kTFStubValidMSB(2)>(mem_.tbTracks, fout_tracks_, ievt, "\nStub 2 word", truncate);
+    err += compareMemWithFile<TrackFitMemory,16,16,TrackFit::kTFStubRZResidLSB(3),TrackFit::kTFStubValidMSB(3)>(mem_.tbTracks, fout_tracks_, ievt, "\nStub 3 word", truncate);
+    err += compareMemWithFile<TrackFitMemory,16,16,TrackFit::kTFStubRZResidLSB(4),TrackFit::kTFStubValidMSB(4)>(mem_.tbTracks, fout_tracks_, ievt, "\nStub 4 word", truncate);
+    err += compareMemWithFile<TrackFitMemory,16,16,TrackFit::kTFStubRZResidLSB(5),TrackFit::kTFStubValidMSB(5)>(mem_.tbTracks, fout_tracks_, ievt, "\nStub 5 word", truncate);
+    err += compareMemWithFile<TrackFitMemory,16,16,TrackFit::kTFStubRZResidLSB(6),TrackFit::kTFStubValidMSB(6)>(mem_.tbTracks, fout_tracks_, ievt, "\nStub 6 word", truncate);
+    err += compareMemWithFile<TrackFitMemory,16,16,TrackFit::kTFStubRZResidLSB(7),TrackFit::kTFStubValidMSB(7)>(mem_.tbTracks, fout_tracks_, ievt, "\nStub 7 word", truncate);
+    return err;
+  });
+}
+
+#endif // TestBenches_Chain_h
+
+#endif // __SYNTHESIS__
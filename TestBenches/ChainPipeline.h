@@ -0,0 +1,202 @@
+// Pipelined scheduling of the stages of a chain, used only in test bench for
+// C simulation.
+//
+// In firmware, the processing modules of a chain all run at the same time on
+// different BXs: while one module processes BX n, the module after it
+// processes BX n-1, which is why the memories between them have several BX
+// pages. ChainPipeline does the same with the ChainStages of a chain test
+// bench. Each stage is given a pipeline step, and in time step t the stages
+// of step s process event t-s. The steps run on separate threads, in lock
+// step, so the time taken to process all events gives the steady state
+// throughput of the chain rather than the sum of the latencies of its stages.
+//
+// Stages of the same step run one after the other on the same thread, in the
+// order they were added, like modules that share a BX period in firmware.
+// A memory written by a stage of step s and read d steps later is written
+// for event n+d while it is read for event n, so it needs more than d BX
+// pages. validate() checks this for every memory a stage writes and another
+// stage reads.
+#ifndef __SYNTHESIS__
+
+#ifndef TestBenches_ChainPipeline_h
+#define TestBenches_ChainPipeline_h
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FileReadUtility.h"
+#include "ChainUtility.h"
+#include "ParallelEventLoop.h"
+
+// Threads wait in wait() until all of them have reached it
+class ChainBarrier
+{
+public:
+
+  explicit ChainBarrier(unsigned int nthreads):
+    nthreads_(nthreads), nwaiting_(0), generation_(0)
+  {}
+
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const unsigned int generation = generation_;
+    if (++nwaiting_ == nthreads_) {
+      nwaiting_ = 0;
+      ++generation_;
+      condition_.notify_all();
+    } else {
+      condition_.wait(lock, [this, generation] {return generation != generation_;});
+    }
+  }
+
+private:
+
+  const unsigned int nthreads_;
+  unsigned int nwaiting_;
+  unsigned int generation_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+
+};
+
+class ChainPipeline
+{
+public:
+
+  // Sets the pipeline step of each stage from its step increment
+  explicit ChainPipeline(std::vector<ChainStage>& stages):
+    stages_(stages), nsteps_(0), seconds_(0)
+  {
+    int step = -1;
+    for (auto& stage : stages_) {
+      step = (step < 0) ? 0 : step + stage.getStepIncrement();
+      stage.setStep(step);
+    }
+    nsteps_ = step + 1;
+  }
+
+  int getNSteps() const {return nsteps_;}
+
+  // Time spent processing, i.e. with all steps running their top functions
+  double getSeconds() const {return seconds_;}
+
+  // Check that no memory is written for one event while it is still read
+  // for an earlier one
+  bool validate() const
+  {
+    bool valid = true;
+    for (unsigned int j = 0; j < stages_.size(); ++j) {
+      for (const auto& read : stages_[j].getReads()) {
+        for (unsigned int i = 0; i < stages_.size(); ++i) {
+          for (const auto& write : stages_[i].getWrites()) {
+            if (write.memory != read.memory) continue;
+
+            const int distance = stages_[j].getStep() - stages_[i].getStep();
+            if (distance < 0 || (distance == 0 && j < i)) {
+              std::cerr << stages_[j].getName() << " reads " << read.name
+                        << " before " << stages_[i].getName() << " writes it" << std::endl;
+              valid = false;
+            } else if (distance >= (int)write.nPages) {
+              std::cerr << stages_[j].getName() << " reads " << read.name << " " << distance
+                        << " steps after " << stages_[i].getName() << " writes it, but the memory has only "
+                        << write.nPages << " BX pages" << std::endl;
+              valid = false;
+            }
+          }
+        }
+      }
+    }
+    return valid;
+  }
+
+  // Process nevents events and return the number of errors. The printout of
+  // the checks is written out in event order at the end, as for
+  // runEventLoop().
+  unsigned int run(int nevents, unsigned int nthreads = getNThreads())
+  {
+    if (nevents <= 0) return 0;
+    if (nthreads > (unsigned int)nsteps_) nthreads = nsteps_;
+    if (nthreads < 1) nthreads = 1;
+
+    // Stages of each thread, with the steps shared out in turn
+    std::vector<std::vector<unsigned int> > threadStages(nthreads);
+    for (unsigned int i = 0; i < stages_.size(); ++i) {
+      threadStages[stages_[i].getStep() % nthreads].push_back(i);
+    }
+
+    std::vector<unsigned int> err(nevents, 0);
+    std::vector<std::vector<std::string> > log(nevents, std::vector<std::string>(stages_.size()));
+    ChainBarrier barrier(nthreads);
+    std::chrono::steady_clock::time_point start;
+
+    auto worker = [&](unsigned int ithread) {
+      std::ostringstream out;
+      tbStream() = &out;
+
+      // event processed by stage i in time step t, or -1 if there is none
+      auto event = [&](unsigned int i, int t) {
+        const int ievt = t - stages_[i].getStep();
+        return (ievt >= 0 && ievt < nevents) ? ievt : -1;
+      };
+
+      for (int t = 0; t < nevents + nsteps_ - 1; ++t) {
+        for (auto i : threadStages[ithread]) {
+          if (event(i, t) >= 0) stages_[i].load(event(i, t));
+        }
+
+        barrier.wait();
+        if (ithread == 0) start = std::chrono::steady_clock::now();
+        for (auto i : threadStages[ithread]) {
+          if (event(i, t) >= 0) stages_[i].run(event(i, t));
+        }
+        barrier.wait();
+        if (ithread == 0) seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (auto i : threadStages[ithread]) {
+          const int ievt = event(i, t);
+          if (ievt < 0) continue;
+          out.str("");
+          const unsigned int nerr = stages_[i].check(ievt);
+          log[ievt][i] = out.str();
+          std::lock_guard<std::mutex> lock(errMutex_);
+          err[ievt] += nerr;
+        }
+        barrier.wait();
+      }
+
+      tbStream() = &std::cout;
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < nthreads; ++i) threads.emplace_back(worker, i);
+    for (auto& thread : threads) thread.join();
+
+    unsigned int err_count = 0;
+    for (int ievt = 0; ievt < nevents; ++ievt) {
+      std::cout << "Event: " << std::dec << ievt << std::endl;
+      for (const auto& stageLog : log[ievt]) std::cout << stageLog;
+      err_count += err[ievt];
+    }
+
+    return err_count;
+  }
+
+private:
+
+  std::vector<ChainStage>& stages_;
+  int nsteps_;
+  double seconds_;
+  std::mutex errMutex_;
+
+};
+
+#endif // TestBenches_ChainPipeline_h
+
+#endif // __SYNTHESIS__
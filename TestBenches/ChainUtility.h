@@ -0,0 +1,521 @@
+// Utilities to run several processing modules in one test bench, used only in
+// test bench for C simulation.
+//
+// Wiring reads the wiring file, e.g. wires_hourglass.dat, whose lines read
+//   <memory> input=> <module>.<port> output=> <module>.<port>
+// and tells which processing module writes and which reads each memory.
+// MemPrintsDirectory finds the emulation printout of a memory by its name,
+// the same way emData/download.sh does, and copyMemPage() passes a BX page
+// from the memory written by one module to the one read by the next when the
+// two cannot be the same object. ChainStage wraps the top function of one
+// processing module together with the inputs it reads from the emulation
+// printouts and the outputs that are checked against them.
+#ifndef __SYNTHESIS__
+
+#ifndef TestBenches_ChainUtility_h
+#define TestBenches_ChainUtility_h
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+
+#include "Constants.h"
+#include "FileReadUtility.h"
+#include "MemPrintsBinary.h"
+
+class Wiring
+{
+public:
+
+  struct Connection {
+    std::string memory;
+    std::string source;       // writing processing module, "" if none
+    std::string sourcePort;
+    std::string destination;  // reading processing module, "" if none
+    std::string destinationPort;
+  };
+
+  explicit Wiring(const std::string& file_name)
+  {
+    std::ifstream fin;
+    if (not openDataFile(fin, file_name)) return;
+
+    for (std::string line; getline(fin, line); ) {
+      std::istringstream tokens(line);
+      Connection connection;
+      if (not (tokens >> connection.memory)) continue;
+
+      // Either side of the memory can be missing, e.g. for the first inputs
+      std::string token, *module = nullptr, *port = nullptr;
+      while (tokens >> token) {
+        if (token == "input=>") {
+          module = &connection.source;
+          port = &connection.sourcePort;
+        } else if (token == "output=>") {
+          module = &connection.destination;
+          port = &connection.destinationPort;
+        } else if (module) {
+          const auto dot = token.find('.');
+          *module = token.substr(0, dot);
+          *port = (dot != std::string::npos) ? token.substr(dot+1) : "";
+        }
+      }
+      connections_.push_back(connection);
+    }
+  }
+
+  bool good() const {return not connections_.empty();}
+
+  const std::vector<Connection>& getConnections() const {return connections_;}
+
+  // Processing module that writes a memory
+  std::string getSource(const std::string& memory) const
+  {
+    for (const auto& connection : connections_) {
+      if (connection.memory == memory) return connection.source;
+    }
+    return "";
+  }
+
+  // Processing modules that read a memory
+  std::vector<std::string> getDestinations(const std::string& memory) const
+  {
+    std::vector<std::string> modules;
+    for (const auto& connection : connections_) {
+      if (connection.memory == memory) modules.push_back(connection.destination);
+    }
+    return modules;
+  }
+
+  // Memories read and written by a processing module, in wiring file order
+  std::vector<std::string> getInputs(const std::string& module) const
+  {
+    std::vector<std::string> memories;
+    for (const auto& connection : connections_) {
+      if (connection.destination == module) memories.push_back(connection.memory);
+    }
+    return memories;
+  }
+
+  std::vector<std::string> getOutputs(const std::string& module) const
+  {
+    std::vector<std::string> memories;
+    for (const auto& connection : connections_) {
+      if (connection.source == module) memories.push_back(connection.memory);
+    }
+    return memories;
+  }
+
+  // Check that memory is written by module source and read by destination
+  bool connects(const std::string& memory, const std::string& source, const std::string& destination) const
+  {
+    for (const auto& connection : connections_) {
+      if (connection.memory == memory && connection.source == source
+          && connection.destination == destination) return true;
+    }
+    return false;
+  }
+
+private:
+
+  std::vector<Connection> connections_;
+
+};
+
+// Emulation printouts of all memories below a directory, e.g. emData/MemPrints.
+// Files are named <type>_<memory>_<sector>.dat, e.g.
+// AllStubs_AS_L1PHIEn2_04.dat for memory AS_L1PHIEn2 in sector 4.
+class MemPrintsDirectory
+{
+public:
+
+  explicit MemPrintsDirectory(const std::string& dir, int sector = 4)
+  {
+    std::ostringstream ending;
+    ending << "_" << std::setw(2) << std::setfill('0') << sector << ".dat";
+    ending_ = ending.str();
+    scan(dir);
+  }
+
+  bool good() const {return not files_.empty();}
+
+  // File name of the printout of a memory, "" if there is none
+  std::string getFile(const std::string& memory) const
+  {
+    const auto file = files_.find(memory);
+    return (file != files_.end()) ? file->second : "";
+  }
+
+private:
+
+  void scan(const std::string& dir)
+  {
+    DIR* dirp = opendir(dir.c_str());
+    if (not dirp) return;
+
+    for (dirent* entry = readdir(dirp); entry; entry = readdir(dirp)) {
+      const std::string name = entry->d_name;
+      if (name == "." || name == "..") continue;
+
+      const std::string path = dir + "/" + name;
+      const auto type = name.find('_');
+      if (name.size() > ending_.size() && type != std::string::npos
+          && name.compare(name.size()-ending_.size(), ending_.size(), ending_) == 0) {
+        files_[name.substr(type+1, name.size()-ending_.size()-type-1)] = path;
+      } else if (name.find('.') == std::string::npos) {
+        scan(path);
+      }
+    }
+    closedir(dirp);
+  }
+
+  std::string ending_;
+  std::map<std::string, std::string> files_;
+
+};
+
+// Position of the copy number of a memory, e.g. the "n2" of AS_L1PHIEn2,
+// or std::string::npos if the memory name has none
+size_t findCopyNumber(const std::string& memory)
+{
+  const auto n = memory.find_last_of('n');
+  if (n == std::string::npos || n+1 >= memory.size()
+      || memory.find_first_not_of("0123456789", n+1) != std::string::npos) return std::string::npos;
+  return n;
+}
+
+// Copy index of a memory, e.g. 1 for AS_L1PHIEn2, and 0 if it has no copies
+int getCopyIndex(const std::string& memory)
+{
+  const auto n = findCopyNumber(memory);
+  return (n != std::string::npos) ? std::stoi(memory.substr(n+1)) - 1 : 0;
+}
+
+// Virtual module number of a memory, e.g. 18 for VMSTE_L1PHIE18n2
+int getVMNumber(const std::string& memory)
+{
+  const std::string name = memory.substr(0, findCopyNumber(memory));
+  const auto first = name.find_last_not_of("0123456789") + 1;
+  return (first < name.size()) ? std::stoi(name.substr(first)) : 0;
+}
+
+// Copy BX page bx of memory src into memory dst, converting each data word
+// with convert(). The page is written with write_page(), so it replaces
+// whatever dst held for that BX.
+template<class DstMem, class SrcMem, class Convert>
+void copyMemPage(DstMem& dst, const SrcMem& src, BXType bx, Convert convert)
+{
+  constexpr unsigned int nlimbs = (DstMem::getWidth() + 63) / 64;
+
+  const unsigned int nent = src.getEntries(bx);
+  std::vector<uint64_t> records;
+  records.reserve(nent*(1+nlimbs));
+  for (unsigned int i = 0; i < nent; ++i) {
+    const auto word = convert(src.read_mem(bx, i)).raw();
+    records.push_back(0);
+    for (unsigned int ilimb = 0; ilimb < nlimbs; ++ilimb) {
+      const unsigned int msb = std::min(64*ilimb+63, (unsigned int)DstMem::getWidth()-1);
+      records.push_back(word.range(msb, 64*ilimb).to_uint64());
+    }
+  }
+
+  dst.write_page(bx, records.data(), nent, nlimbs);
+}
+
+// Same as above, keeping the raw bits of each word, which are truncated or
+// zero-padded to the width of the data type of dst
+template<class DstMem, class SrcMem>
+void copyMemPage(DstMem& dst, const SrcMem& src, BXType bx)
+{
+  typedef typename std::decay<decltype(src.read_mem(0, 0))>::type SrcData;
+  typedef typename std::decay<decltype(std::declval<DstMem>().read_mem(0, 0))>::type DstData;
+  typedef typename std::decay<decltype(std::declval<DstData>().raw())>::type DstWord;
+
+  copyMemPage(dst, src, bx, [](const SrcData& data) {
+    return DstData(DstWord(data.raw()));
+  });
+}
+
+// The top functions write their outputs with write_mem(bx, data, addr), which
+// does not count the entries; in firmware the count is kept by the memory.
+// Recount the entries of BX page bx, taking the first zero word of the page,
+// or of each bin for binned memories, as its end as the test benches do.
+template<class MemType>
+auto updateEntries(MemType& memory, BXType bx) -> decltype(memory.getNBins(), void())
+{
+  constexpr unsigned int nlimbs = (MemType::getWidth() + 63) / 64;
+
+  std::vector<uint64_t> records;
+  unsigned int nent = 0;
+  for (unsigned int slot = 0; slot < memory.getNBins(); ++slot) {
+    for (unsigned int i = 0; i < memory.getNEntryPerBin(); ++i) {
+      const auto word = memory.read_mem(bx, slot, i).raw();
+      if (word == 0) break;
+      records.push_back(slot);
+      for (unsigned int ilimb = 0; ilimb < nlimbs; ++ilimb) {
+        const unsigned int msb = std::min(64*ilimb+63, (unsigned int)MemType::getWidth()-1);
+        records.push_back(word.range(msb, 64*ilimb).to_uint64());
+      }
+      ++nent;
+    }
+  }
+
+  memory.write_page(bx, records.data(), nent, nlimbs);
+}
+
+template<class MemType>
+auto updateEntries(MemType& memory, BXType bx) -> decltype(memory.getEntries(bx), void())
+{
+  constexpr unsigned int nlimbs = (MemType::getWidth() + 63) / 64;
+
+  std::vector<uint64_t> records;
+  unsigned int nent = 0;
+  for (; nent < memory.getDepth(); ++nent) {
+    const auto word = memory.read_mem(bx, nent).raw();
+    if (word == 0) break;
+    records.push_back(0);
+    for (unsigned int ilimb = 0; ilimb < nlimbs; ++ilimb) {
+      const unsigned int msb = std::min(64*ilimb+63, (unsigned int)MemType::getWidth()-1);
+      records.push_back(word.range(msb, 64*ilimb).to_uint64());
+    }
+  }
+
+  memory.write_page(bx, records.data(), nent, nlimbs);
+}
+
+// One processing module of a chain. Everything that is not part of the
+// processing itself, i.e. clearing the outputs, reading the inputs that come
+// from outside the chain, counting the entries of the outputs, and checking
+// the outputs, is not timed, so that getSeconds() is the time spent in the
+// module.
+//
+// Only the BX page of the event being processed is cleared, loaded and
+// checked, so that the stages can work on different events at the same time
+// (see ChainPipeline.h). For this, a stage keeps track of the memories it
+// writes and reads.
+//
+// A stage can also run on its own, without the stages before it: the
+// memories it reads from them are then loaded from their emulation printouts
+// too (see setStandalone()).
+class ChainStage
+{
+public:
+
+  // A memory written or read by a stage, and its number of BX pages
+  struct MemoryPages {
+    const void* memory;
+    unsigned int nPages;
+    std::string name;
+  };
+
+  ChainStage(const std::string& name, const MemPrintsDirectory& memprints):
+    name_(name), memprints_(&memprints), step_(0), stepIncrement_(1), standalone_(false),
+    seconds_(0), errors_(0), nCalls_(0), nElements_(0)
+  {}
+
+  const std::string& getName() const {return name_;}
+  double getSeconds() const {return seconds_;}
+  unsigned int getErrors() const {return errors_;}
+
+  // Number of calls to the top function, and number of input entries they
+  // processed, as counted by addCount()
+  unsigned long getNCalls() const {return nCalls_;}
+  unsigned long getNElements() const {return nElements_;}
+
+  // Run without the stages before this one, reading the memories they pass
+  // in process (addRead() and addPassedInput()) from the emulation printouts
+  bool isStandalone() const {return standalone_;}
+  void setStandalone(bool standalone) {standalone_ = standalone;}
+
+  // Pipeline step of the stage, set by ChainPipeline, and its distance to
+  // the step of the previous stage: 1 by default, or 0 to run in the same
+  // step as the previous stage
+  int getStep() const {return step_;}
+  void setStep(int step) {step_ = step;}
+  unsigned int getStepIncrement() const {return stepIncrement_;}
+  void setStepIncrement(unsigned int increment) {stepIncrement_ = increment;}
+
+  const std::vector<MemoryPages>& getWrites() const {return writes_;}
+  const std::vector<MemoryPages>& getReads() const {return reads_;}
+
+  // Processing of one BX, i.e. the call to the top function
+  void setProcess(std::function<void(BXType)> process) {process_ = process;}
+
+  // Called for each event before the processing
+  void addLoader(std::function<void(int)> loader) {loaders_.push_back(loader);}
+
+  // Memory cleared before each event, whose entries are counted after the
+  // processing
+  template<class MemType>
+  void addOutput(MemType& memory)
+  {
+    loaders_.push_back([&memory](int ievt) {memory.clear(ievt);});
+    updates_.push_back([&memory](BXType bx) {updateEntries(memory, bx);});
+    writes_.push_back({&memory, memory.getNBX(), ""});
+  }
+
+  // Memory read from the emulation printout of memory name
+  template<class MemType>
+  bool addInput(const std::string& name, MemType& memory)
+  {
+    const MemPrintsBinary* fin = open(name);
+    if (not fin) return false;
+
+    loaders_.push_back([&memory, fin](int ievt) {
+      writeMemFromFile<MemType>(memory, *fin, ievt);
+    });
+    writes_.push_back({&memory, memory.getNBX(), name});
+    return true;
+  }
+
+  // Memory compared with the emulation printout of memory name
+  template<class MemType>
+  bool addReference(const std::string& name, const MemType& memory, bool truncation = false)
+  {
+    const MemPrintsBinary* fout = open(name);
+    if (not fout) return false;
+
+    checks_.push_back([&memory, fout, name, truncation](int ievt) {
+      return compareMemWithFile<MemType>(memory, *fout, ievt, name, truncation);
+    });
+    reads_.push_back({&memory, memory.getNBX(), name});
+    return true;
+  }
+
+  // Memory written by another stage and read by the processing, if it is not
+  // already a reference
+  template<class MemType>
+  bool addRead(const std::string& name, MemType& memory)
+  {
+    reads_.push_back({&memory, memory.getNBX(), name});
+    return addStandaloneInput(name, memory);
+  }
+
+  // Memory written by another stage and read by the processing, compared
+  // with its emulation printout
+  template<class MemType>
+  bool addPassedInput(const std::string& name, MemType& memory, bool truncation = false)
+  {
+    return addReference(name, memory, truncation) && addStandaloneInput(name, memory);
+  }
+
+  // Any other check, returning the number of errors of event ievt
+  void addCheck(std::function<unsigned int(int)> check) {checks_.push_back(check);}
+
+  // Number of input entries of a BX processed by the top function, counted
+  // before each call; see also countEntries()
+  void addCount(std::function<unsigned int(BXType)> count) {counts_.push_back(count);}
+
+  // Count the entries of a memory read by the top function
+  template<class MemType>
+  void countEntries(const MemType& memory)
+  {
+    counts_.push_back([&memory](BXType bx) {return getNEntries(memory, bx);});
+  }
+
+  void load(int ievt)
+  {
+    if (standalone_) {
+      for (auto& loader : standaloneLoaders_) loader(ievt);
+    }
+    for (auto& loader : loaders_) loader(ievt);
+  }
+
+  void run(BXType bx)
+  {
+    for (auto& count : counts_) nElements_ += count(bx);
+    ++nCalls_;
+
+    const auto start = std::chrono::steady_clock::now();
+    process_(bx);
+    seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto& update : updates_) update(bx);
+  }
+
+  unsigned int check(int ievt)
+  {
+    unsigned int err = 0;
+    for (auto& check : checks_) err += check(ievt);
+    errors_ += err;
+    return err;
+  }
+
+private:
+
+  template<class MemType>
+  bool addStandaloneInput(const std::string& name, MemType& memory)
+  {
+    const MemPrintsBinary* fin = open(name);
+    if (not fin) return false;
+
+    standaloneLoaders_.push_back([&memory, fin](int ievt) {
+      writeMemFromFile<MemType>(memory, *fin, ievt);
+    });
+    return true;
+  }
+
+  template<class MemType>
+  static auto getNEntries(const MemType& memory, BXType bx) -> decltype(memory.getNBins(), 0u)
+  {
+    unsigned int nent = 0;
+    for (unsigned int slot = 0; slot < memory.getNBins(); ++slot) nent += memory.getEntries(bx, slot);
+    return nent;
+  }
+
+  template<class MemType>
+  static auto getNEntries(const MemType& memory, BXType bx) -> decltype(memory.getEntries(bx), 0u)
+  {
+    return memory.getEntries(bx);
+  }
+
+  const MemPrintsBinary* open(const std::string& name)
+  {
+    const std::string file_name = memprints_->getFile(name);
+    if (file_name.empty()) {
+      std::cerr << name_ << ": no emulation printout for memory " << name << std::endl;
+      return nullptr;
+    }
+
+    files_.emplace_back(new MemPrintsBinary());
+    if (not openDataFile(*files_.back(), file_name)) return nullptr;
+    return files_.back().get();
+  }
+
+  std::string name_;
+  const MemPrintsDirectory* memprints_;
+  int step_;
+  unsigned int stepIncrement_;
+  bool standalone_;
+  std::function<void(BXType)> process_;
+  std::vector<std::function<void(int)> > loaders_;
+  std::vector<std::function<void(int)> > standaloneLoaders_;
+  std::vector<std::function<void(BXType)> > updates_;
+  std::vector<std::function<unsigned int(BXType)> > counts_;
+  std::vector<std::function<unsigned int(int)> > checks_;
+  std::vector<std::unique_ptr<MemPrintsBinary> > files_;
+  std::vector<MemoryPages> writes_;
+  std::vector<MemoryPages> reads_;
+  double seconds_;
+  unsigned int errors_;
+  unsigned long nCalls_;
+  unsigned long nElements_;
+
+};
+
+#endif // TestBenches_ChainUtility_h
+
+#endif // __SYNTHESIS__
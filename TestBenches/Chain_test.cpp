@@ -0,0 +1,74 @@
+// Test bench for a slice of the chain, run in a single process:
+//   IR -> VMR_L1PHIE -> TE_L1PHIE18_L2PHIC17 -> TC_L1L2G -> PR_L3PHIC
+//      -> ME_L3PHIC17..24 -> MC_L3PHIC -> TB_L1L2
+// The stages and the memories passed between them are set up by Chain.h.
+//
+// The stages run as a pipeline (ChainPipeline.h): while one stage processes
+// an event, the stage after it processes the previous event, on a separate
+// thread. The time spent in the top functions of each stage, and by the
+// pipeline as a whole, gives the throughput of the chain; reading and
+// checking the memories is not included. Setting TB_NTHREADS=1 runs all
+// stages on one thread.
+#include "Chain.h"
+#include "ChainPipeline.h"
+#include "ModuleMonitorReport.h"
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+
+const int nevents = 100;  // number of events to run
+const bool truncation = false; // compare results to truncated emulation
+
+// Produce the VMRouter inputs with the InputRouter, instead of reading them
+// from the emulation printouts
+const bool runInputRouter = true;
+
+using namespace std;
+
+int main()
+{
+  const Wiring wiring("emData/wires_hourglass.dat");
+  const MemPrintsDirectory memprints("emData/MemPrints");
+  if (not wiring.good() || not memprints.good()) {
+    cerr << "Wiring file or emulation printouts not found, run emData/download.sh" << endl;
+    return -1;
+  }
+
+  // The chain is allocated on the heap, as its memories are too large for
+  // the stack
+  unique_ptr<Chain> chain(new Chain(wiring, memprints, truncation, runInputRouter));
+  vector<ChainStage>& stages = chain->getStages();
+
+  ChainPipeline pipeline(stages);
+  if (not chain->good() || not pipeline.validate()) return -1;
+
+  ///////////////////////////
+  // loop over events
+  cout << "Start event loop ..." << endl;
+  int err = pipeline.run(nevents);
+
+  // Summary of the errors and of the time spent in each stage
+  double seconds = 0;
+  cout << endl << setw(24) << left << "Stage" << right << setw(6) << "step" << setw(10) << "errors"
+       << setw(16) << "us/event" << endl;
+  for (auto& stage : stages) {
+    seconds += stage.getSeconds();
+    cout << setw(24) << left << stage.getName() << right << setw(6) << stage.getStep()
+         << setw(10) << stage.getErrors()
+         << setw(16) << fixed << setprecision(1) << 1e6*stage.getSeconds()/nevents << endl;
+  }
+  cout << "Chain: " << nevents << " events in " << setprecision(3) << seconds << " s, "
+       << setprecision(1) << nevents/seconds << " events/s one event at a time" << endl;
+  cout << "Pipeline: " << nevents << " events in " << setprecision(3) << pipeline.getSeconds() << " s, "
+       << setprecision(1) << nevents/pipeline.getSeconds() << " events/s with "
+       << pipeline.getNSteps() << " steps" << endl;
+
+  printModuleMonitorReport();
+
+  // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
+  if (err > 255) err = 255;
+  return err;
+}
@@ -8,13 +8,26 @@
 #include <fstream>
 #include <string>
 #include <cstring>
+#include <cstdio>
 #include <cerrno>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <vector>
 #include <bitset>
 
 #include "../TrackletAlgorithm/Constants.h"
 
+// Stream used for the printout of the comparisons. It is the standard
+// output, except in the threads of runEventLoop (ParallelEventLoop.h) which
+// buffer the printout of each event.
+std::ostream*& tbStream()
+{
+  thread_local std::ostream* stream = &std::cout;
+  return stream;
+}
+
+std::ostream& tbout() {return *tbStream();}
+
 bool openDataFile(std::ifstream& file_in, const std::string& file_name)
 {
   file_in.open(file_name);
@@ -44,6 +57,123 @@ std::vector<std::string> split(const std::string& s, char delimiter)
   return tokens;
 }
 
+// Index of the "Event" headers in a MemPrints file, so that a stream can be
+// positioned at any event without reading the events before it.
+// The index is cached in <file>.idx next to the .dat file, and rebuilt when
+// the size or modification time of the .dat file changes.
+class MemPrintsIndex
+{
+public:
+
+  MemPrintsIndex() {}
+
+  explicit MemPrintsIndex(const std::string& file_name) {open(file_name);}
+
+  bool open(const std::string& file_name)
+  {
+    headerOffset_.clear();
+    dataOffset_.clear();
+
+    struct stat st;
+    if (stat(file_name.c_str(), &st) != 0) {
+      std::cerr << "Index of file " << file_name << " failed: no such file" << std::endl;
+      return false;
+    }
+
+    const std::string idx_name = file_name + ".idx";
+    if (read(idx_name, st)) return true;
+    if (not build(file_name)) return false;
+    write(idx_name, st);
+    return true;
+  }
+
+  unsigned int getNEvents() const {return headerOffset_.size();}
+
+  // Byte offset of the "Event" header line of event ievt
+  std::streamoff getHeaderOffset(int ievt) const {return headerOffset_.at(ievt);}
+
+  // Byte offset of the first line after the "Event" header of event ievt
+  std::streamoff getDataOffset(int ievt) const {return dataOffset_.at(ievt);}
+
+private:
+
+  bool build(const std::string& file_name)
+  {
+    std::ifstream fin(file_name);
+    if (not fin.good()) return false;
+
+    std::streamoff offset = 0;
+    for (std::string line; getline(fin, line); ) {
+      const std::streamoff next = fin.tellg();
+      if (line.find("Event") != std::string::npos) {
+        headerOffset_.push_back(offset);
+        dataOffset_.push_back(next);
+      }
+      offset = next;
+    }
+
+    return true;
+  }
+
+  bool read(const std::string& idx_name, const struct stat& st)
+  {
+    std::ifstream fidx(idx_name);
+    if (not fidx.good()) return false;
+
+    std::string tag;
+    long long size, mtime;
+    unsigned int nevents;
+    fidx >> tag >> size >> mtime >> nevents;
+    if (tag != "MemPrintsIndex" || size != st.st_size || mtime != st.st_mtime) return false;
+
+    headerOffset_.resize(nevents);
+    dataOffset_.resize(nevents);
+    for (unsigned int i = 0; i < nevents; ++i) {
+      fidx >> headerOffset_[i] >> dataOffset_[i];
+    }
+
+    if (fidx.fail()) {
+      headerOffset_.clear();
+      dataOffset_.clear();
+      return false;
+    }
+    return true;
+  }
+
+  void write(const std::string& idx_name, const struct stat& st) const
+  {
+    // Write to a temporary file first so a concurrent reader never sees a
+    // partially written index. Failing to cache the index is not an error.
+    const std::string tmp_name = idx_name + ".tmp." + std::to_string(getpid());
+    std::ofstream fidx(tmp_name);
+    fidx << "MemPrintsIndex " << (long long)st.st_size << " " << (long long)st.st_mtime
+         << " " << headerOffset_.size() << std::endl;
+    for (unsigned int i = 0; i < headerOffset_.size(); ++i) {
+      fidx << headerOffset_[i] << " " << dataOffset_[i] << std::endl;
+    }
+    fidx.close();
+
+    if (not fidx.good() || rename(tmp_name.c_str(), idx_name.c_str()) != 0) {
+      std::remove(tmp_name.c_str());
+    }
+  }
+
+  std::vector<std::streamoff> headerOffset_;
+  std::vector<std::streamoff> dataOffset_;
+
+};
+
+// Position a stream where the sequential readers below expect it to be
+// before reading event ievt: on the "Event" header for the first event, and
+// just after it for the others.
+bool seekEvent(std::ifstream& fin, const MemPrintsIndex& index, int ievt)
+{
+  if (ievt < 0 || (unsigned int)ievt >= index.getNEvents()) return false;
+
+  fin.clear();
+  fin.seekg(ievt == 0 ? index.getHeaderOffset(ievt) : index.getDataOffset(ievt));
+  return fin.good();
+}
 
 // S.S. Storey 
 // added because the IR 
@@ -90,6 +220,19 @@ void writeArrayFromFile(DataType* hData, std::ifstream& pInputStream, int pEvent
   }while( pInputStream.good() && cEventCounter <= pEvent);
 }
 
+// Same as above, but seeks straight to event pEvent instead of rescanning
+// the stream from wherever it currently is
+template<class DataType, int Base=2>
+void writeArrayFromFile(DataType* hData, std::ifstream& pInputStream, const MemPrintsIndex& pIndex, int pEvent
+, char pDelimeter = '|' , char pSplitToken = ' '){
+
+  if (pEvent < 0 || (unsigned int)pEvent >= pIndex.getNEvents()) return;
+
+  pInputStream.clear();
+  pInputStream.seekg(pIndex.getHeaderOffset(pEvent));
+  writeArrayFromFile<DataType, Base>(hData, pInputStream, 0, pDelimeter, pSplitToken);
+}
+
 template<class MemType>
 void writeMemFromFile(MemType& memory, std::ifstream& fin, int ievt, int base=16)
 {
@@ -121,17 +264,23 @@ void writeMemFromFile(MemType& memory, std::ifstream& fin, int ievt, int base=16
   
 }
 
-template<class MemType, int InputBase=16, int OutputBase=16, int LSB=-1, int MSB=-1>
-unsigned int compareMemWithFile(const MemType& memory, std::ifstream& fout,
-                                int ievt, const std::string& label,
-                                const bool truncated = false, int maxProc = kMaxProc)
+// Same as above, but reads event ievt wherever the stream currently is
+template<class MemType>
+void writeMemFromFile(MemType& memory, std::ifstream& fin, const MemPrintsIndex& index, int ievt, int base=16)
 {
-  unsigned int err_count = 0;
+  if (not seekEvent(fin, index, ievt)) {
+    memory.clear();
+    return;
+  }
+  writeMemFromFile<MemType>(memory, fin, ievt, base);
+}
 
-  ////////////////////////////////////////
-  // Read from file
-  MemType memory_ref;
-  writeMemFromFile<MemType>(memory_ref, fout, ievt, InputBase);
+template<class MemType, int OutputBase=16, int LSB=-1, int MSB=-1>
+unsigned int compareMemWithMem(const MemType& memory, const MemType& memory_ref,
+                               int ievt, const std::string& label,
+                               const bool truncated = false)
+{
+  unsigned int err_count = 0;
 
   constexpr int width = (LSB >= 0 && MSB >= LSB) ? (MSB + 1) : MemType::getWidth();
   constexpr int lsb = (LSB >= 0 && MSB >= LSB) ? LSB : 0;
@@ -143,59 +292,67 @@ unsigned int compareMemWithFile(const MemType& memory, std::ifstream& fout,
     if (i==0) {
       // If both reference and computed memories are completely empty, skip it
       if (data_com == 0 && data_ref == 0) break;
-      std::cout << label << ":" << std::endl;
-      std::cout << "index" << "\t" << "reference" << "\t" << "computed" << std::endl;
+      tbout() << label << ":" << std::endl;
+      tbout() << "index" << "\t" << "reference" << "\t" << "computed" << std::endl;
     }
     // If have reached the end of valid entries in both computed and reference, don't bother printing further
     if (data_com == 0 && data_ref == 0) continue;
 
-    std::cout << i << "\t";
-    if (OutputBase == 2) std::cout << std::bitset<width>(data_ref) << "\t";
-    else                 std::cout << std::hex << data_ref << "\t";
+    tbout() << i << "\t";
+    if (OutputBase == 2) tbout() << std::bitset<width>(data_ref) << "\t";
+    else                 tbout() << std::hex << data_ref << "\t";
     
-    if (OutputBase == 2) std::cout << std::bitset<width>(data_com);
-    else                 std::cout << std::hex << data_com; // << std::endl;
+    if (OutputBase == 2) tbout() << std::bitset<width>(data_com);
+    else                 tbout() << std::hex << data_com; // << std::endl;
 
     // If there is extra entries in reference
     if (data_com == 0) {
-      std::cout << "\t" << "<=== missing";
+      tbout() << "\t" << "<=== missing";
       if (!truncated) err_count++;
     // If there is extra entries in computed
     } else if (data_ref == 0) {
-      std::cout << "\t" << "<=== EXTRA";
+      tbout() << "\t" << "<=== EXTRA";
       err_count++;
     // If reference and computed entry are inconsistent
     } else if (data_com != data_ref) {
-      std::cout << "\t" << "<=== INCONSISTENT";
+      tbout() << "\t" << "<=== INCONSISTENT";
       err_count++;
     }
 
-    std::cout << std::endl;
+    tbout() << std::endl;
   }
   
   return err_count;
   
 }
 
-template<class MemType, int InputBase=16, int OutputBase=16>
-unsigned int compareBinnedMemWithFile(const MemType& memory, 
-                                      std::ifstream& fout,
-                                      int ievt, const std::string& label,
-                                      const bool truncated = false, int maxProc = kMaxProc)
+template<class MemType, int InputBase=16, int OutputBase=16, int LSB=-1, int MSB=-1>
+unsigned int compareMemWithFile(const MemType& memory, std::ifstream& fout,
+                                int ievt, const std::string& label,
+                                const bool truncated = false, int maxProc = kMaxProc)
 {
-  unsigned int err_count = 0;
-
   ////////////////////////////////////////
   // Read from file
   MemType memory_ref;
   writeMemFromFile<MemType>(memory_ref, fout, ievt, InputBase);
 
+  return compareMemWithMem<MemType, OutputBase, LSB, MSB>(memory, memory_ref, ievt, label, truncated);
+}
+
+template<class MemType, int OutputBase=16>
+unsigned int compareBinnedMemWithMem(const MemType& memory,
+                                     const MemType& memory_ref,
+                                     int ievt, const std::string& label,
+                                     const bool truncated = false)
+{
+  unsigned int err_count = 0;
+
   ////////////////////////////////////////
   // compare expected data with those computed and stored in the output memory
-  std::cout << label << ":" << std::endl;
-  std::cout << "index" << "\t" << "reference" << "\t" << "computed" << std::endl;
+  tbout() << label << ":" << std::endl;
+  tbout() << "index" << "\t" << "reference" << "\t" << "computed" << std::endl;
   for ( int j = 0; j < memory_ref.getNBins(); ++j ) {
-    std::cout << "Bin " << std::dec << j << std::endl;
+    tbout() << "Bin " << std::dec << j << std::endl;
     for (int i = 0; i < memory_ref.getNEntryPerBin() ; ++i) {
       auto data_ref = memory_ref.read_mem(ievt,j,i).raw();
       auto data_com = memory.read_mem(ievt,j,i).raw();
@@ -203,29 +360,29 @@ unsigned int compareBinnedMemWithFile(const MemType& memory,
       // If have reached the end of valid entries in both computed and reference, don't bother printing further
       if (data_com == 0 && data_ref == 0) continue;
 
-      std::cout << i << "\t";
+      tbout() << i << "\t";
 
-      if (OutputBase == 2) std::cout << std::bitset<MemType::getWidth()>(data_ref) << "\t";
-      else                 std::cout << std::hex << data_ref << "\t";
+      if (OutputBase == 2) tbout() << std::bitset<MemType::getWidth()>(data_ref) << "\t";
+      else                 tbout() << std::hex << data_ref << "\t";
     
-      if (OutputBase ==2) std::cout << std::bitset<MemType::getWidth()>(data_com);
-      else                std::cout << std::hex << data_com; // << std::endl;
+      if (OutputBase ==2) tbout() << std::bitset<MemType::getWidth()>(data_com);
+      else                tbout() << std::hex << data_com; // << std::endl;
 
       // If there is extra entries in reference
       if (data_com == 0) {
-        std::cout << "\t" << "<=== missing";
+        tbout() << "\t" << "<=== missing";
         if (!truncated) err_count++;
       // If there is extra entries in computed
       } else if (data_ref == 0) {
-        std::cout << "\t" << "<=== EXTRA";
+        tbout() << "\t" << "<=== EXTRA";
         err_count++;
       // If reference and computed entry are inconsistent
       } else if (data_com != data_ref) {
-        std::cout << "\t" << "<=== INCONSISTENT";
+        tbout() << "\t" << "<=== INCONSISTENT";
         err_count++;
       }
 
-      std::cout << std::endl;
+      tbout() << std::endl;
     } // loop over entries in bin
   } // loop over bins
 
@@ -233,6 +390,20 @@ unsigned int compareBinnedMemWithFile(const MemType& memory,
   
 }
 
+template<class MemType, int InputBase=16, int OutputBase=16>
+unsigned int compareBinnedMemWithFile(const MemType& memory, 
+                                      std::ifstream& fout,
+                                      int ievt, const std::string& label,
+                                      const bool truncated = false, int maxProc = kMaxProc)
+{
+  ////////////////////////////////////////
+  // Read from file
+  MemType memory_ref;
+  writeMemFromFile<MemType>(memory_ref, fout, ievt, InputBase);
+
+  return compareBinnedMemWithMem<MemType, OutputBase>(memory, memory_ref, ievt, label, truncated);
+}
+
 #endif // TestBenches_FileReadUtility_h
 
 #endif // __SYNTHESIS__
@@ -0,0 +1,215 @@
+// Link tables of the InputRouter, used only in test bench for C simulation.
+// Shared by the InputRouter test bench and the chain test bench, which both
+// need to know which memories a link is routed to.
+#ifndef TestBenches_InputRouterLinks_h
+#define TestBenches_InputRouterLinks_h
+
+#include "FileReadUtility.h"
+#include "InputRouter.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+
+
+// link assignment table 
+// TO-BE fixed :  need this added to emData 
+// 3 bits for layer/disk id  --> 3 bits 
+// 1 bit for barrel/disk --> 4 bits  
+// up-to 4 layers/disks per DTC
+// 16 bits per link
+// then 3 bits 
+// 1 bit to assign whether link is PS/2S 
+// 3 bits to encode the number of layers readout by this DTC 
+// 20 bits in total 
+const ap_uint<kLINKMAPwidth> kLinkAssignmentTable[] =
+{
+  0x500b9, 0x3000b, 0x3000d, 0x5006d, 
+  0x50082, 0x500a4, 0x60843, 0x8a623, 
+  0x20005, 0x60a62, 0x40047, 0x40087
+};
+
+// number of phi bins read out 
+// by each link (kSizeBinWord per layer )
+// upto 4 layers per link  
+const ap_uint<kBINMAPwidth> kLinkNPhiBns[] = 
+{
+  0x01B , 0x003 , 0x003 , 0x01B , 
+  0x01B , 0x01B , 0x0DF , 0x6DF , 
+  0x003 , 0x0DB , 0x01B , 0x01B 
+};
+
+// total number of memoreis 
+// readout b each link 
+const ap_uint<kNMEMwidth> kLinkNMemories[] = 
+{
+   8 ,  4 ,  4 ,  8 , 
+   8 ,  8 , 16 , 20 , 
+   4 , 12 ,  8 ,  8 
+};
+
+
+
+// LUT with phi corrections to the nominal radius. Only used by layers.
+// Values are determined by the radius and the bend of the stub.
+const int kPhiCorrtable_L1[] =
+#include "../emData/LUTs/VMPhiCorrL1.tab"
+;
+const int kPhiCorrtable_L2[] =
+#include "../emData/LUTs/VMPhiCorrL2.tab"
+;
+const int kPhiCorrtable_L3[] =
+#include "../emData/LUTs/VMPhiCorrL3.tab"
+;
+const int kPhiCorrtable_L4[] =
+#include "../emData/LUTs/VMPhiCorrL4.tab"
+;
+const int kPhiCorrtable_L5[] =
+#include "../emData/LUTs/VMPhiCorrL5.tab"
+;
+const int kPhiCorrtable_L6[] =
+#include "../emData/LUTs/VMPhiCorrL6.tab"
+;
+
+// write the stubs of a link, as read by 
+// writeArrayFromFile, to the stream 
+// read by the IR : the valid stubs 
+// then the end-of-BX word 
+void writeLinkStream( DTCStubStream& hStream
+  , const ap_uint<kNBits_DTC>* hStubs 
+  , int pNStubs = kMaxStubsFromLink )
+{
+  for( int cStubIndx=0; cStubIndx < pNStubs; cStubIndx++)
+  {
+    if( hStubs[cStubIndx].range(kMSBVldBt, kLSBVldBt) != 0 )
+      hStream.write( hStubs[cStubIndx] );
+  }
+  hStream.write( kEndOfBXWord );
+}
+
+// map of input links  [per DTC ]
+using LinkMap = std::map<int, std::pair<std::string ,std::vector<std::uint8_t>>> ; 
+
+// create link map
+// map is 
+// link id [key]
+// DTC name [from dtclinklayer]
+// then a list of encoded layers 
+void createLinkMap(std::string pInputCablingMap, int pDTCsplit, LinkMap& pLinkMap ) 
+{
+  std::string cBaseName  = "Link_";
+  //std::cout << "Loading link map into memory .. will be used later" <<std::endl;
+  std::ifstream fin_il_map;
+  if (not openDataFile(fin_il_map,pInputCablingMap)) 
+  {
+    std::cout << "Could not find file " 
+      << pInputCablingMap << std::endl;
+  }
+  size_t cLinkCounter=0;
+  // parse link map 
+  for(std::string cInputLine; getline( fin_il_map, cInputLine ); )
+  {
+    auto cStream = std::istringstream{cInputLine};
+    std::string cToken;
+    while (cStream >> cToken) 
+    {
+      bool cIsAlNum =true;
+      for( auto cChar : cToken )
+        cIsAlNum = cIsAlNum && std::isalnum(cChar);
+      if( !cIsAlNum ) // input link name 
+      {
+        if( cToken.find("2S") != std::string::npos 
+          || cToken.find("PS") != std::string::npos ) 
+        {
+          pLinkMap[cLinkCounter].first += cBaseName + cToken;
+          pLinkMap[cLinkCounter].first += (pDTCsplit==0)?"_A":"_B";
+          if( IR_DEBUG)
+            std::cout << "Link name : " << pLinkMap[cLinkCounter].first << "\n";
+        }
+      }
+      else
+      {
+        auto cLayerId = std::stoi( cToken);
+        if(cLayerId != -1 )
+          pLinkMap[cLinkCounter].second.push_back( cLayerId );
+      }
+    }
+    cLinkCounter++;
+  }
+}
+
+// return name of link file based on link id 
+// link 
+std::string getLinkName( int pLinkId
+  , int pDTCsplit = 0 
+  , std::string pInputFile_LinkMap = "emData/dtclinklayerdisk.dat")
+{
+  // create link map 
+  LinkMap cInputMap;
+  createLinkMap(pInputFile_LinkMap, pDTCsplit, cInputMap );
+  
+  // get link Id 
+  std::string cLinkName = cInputMap[pLinkId].first; 
+  return cLinkName; 
+}
+
+// return name of dtc based on link id 
+std::string getDTCName( int pLinkId
+  , int pDTCsplit = 0 
+  , std::string pInputFile_LinkMap = "emData/dtclinklayerdisk.dat")
+{
+  
+  std::string cBaseName = "Link_"; 
+  std::string cLinkName = getLinkName( pLinkId, pDTCsplit, pInputFile_LinkMap);
+  std::string cDTCName  = cLinkName.substr(cLinkName.find(cBaseName)+cBaseName.length(), cLinkName.length() - cBaseName.length()) ; 
+  return cDTCName;
+}
+
+// return link id of a DTC e.g. PS10G_1_A
+// or -1 if it is not in the link map
+int getLinkId( std::string pDTCName
+  , std::string pInputFile_LinkMap = "emData/dtclinklayerdisk.dat")
+{
+  // last letter of the name
+  // is the half of the DTC
+  int cDTCsplit = ( pDTCName.back() == 'B' ) ? 1 : 0;
+  LinkMap cInputMap;
+  createLinkMap(pInputFile_LinkMap, cDTCsplit, cInputMap );
+  for( auto& cLink : cInputMap )
+  {
+    if( cLink.second.first == "Link_" + pDTCName )
+      return cLink.first;
+  }
+  return -1;
+}
+
+// return index of the IR output
+// memory that gets the stubs of a
+// layer/disk in a given phi bin
+// or -1 if the link does not read
+// out this layer/disk
+// follows the memory index
+// computed in InputRouter()
+int getMemIndex( int pLinkId
+  , bool pIsBrl , int pLyrId , int pPhiBn )
+{
+  auto hLinkWord = kLinkAssignmentTable[pLinkId%12];
+  auto hPhBnWord = kLinkNPhiBns[pLinkId%12];
+  int cMemIndx=0;
+  for(int cLyrIndx=0; cLyrIndx< kMaxLyrsPerDTC; cLyrIndx++)
+  {
+    ap_uint<kSizeLinkWord> hWrd = hLinkWord.range(kSizeLinkWord*cLyrIndx+kSizeLinkWord-1,kSizeLinkWord*cLyrIndx);
+    ap_uint<kSizeBinWord> hBnWrd = hPhBnWord.range(kSizeBinWord * cLyrIndx + (kSizeBinWord-1), kSizeBinWord * cLyrIndx);
+    ap_uint<1> hIsBrl = hWrd.range(0, 0);
+    ap_uint<3> hLyrId = hWrd.range(3, 1);
+    if( hWrd != 0 && hIsBrl == pIsBrl && hLyrId == pLyrId )
+      return ( pPhiBn <= (int)hBnWrd ) ? cMemIndx + pPhiBn : -1;
+    cMemIndx += 1+(int)(hBnWrd);
+  }
+  return -1;
+}
+
+#endif // TestBenches_InputRouterLinks_h
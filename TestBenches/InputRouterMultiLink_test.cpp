@@ -0,0 +1,195 @@
+// Test bench for the multi-link InputRouter
+//
+// Random events of stubs on cNLinks PS links are routed by
+// InputRouterMultiLinkTop, all links at once, and by InputRouterTop, one link
+// at a time, whose output memories must be the same. The stubs are random
+// words with the valid bit set and one of the layers/disks read out by the
+// link, so that they go to all the memories of the link. The last two
+// events check that the stubs of a link past the loop budget of a BX are
+// skipped without shifting the next BX.
+#include "InputRouterTop.h"
+#include "InputRouterLinks.h"
+
+#include <cstdlib>
+#include <iostream>
+
+const int nevents = 100;  // number of events to run
+
+// PS links with at most cNMemories memories
+const int linkIds[cNLinks] = {6, 9, 10, 11};
+
+using namespace std;
+
+// Number of layers/disks read out by a link
+int getNLayers(const ap_uint<kLINKMAPwidth> hLinkWord)
+{
+  int nlayers = 0;
+  for (int i = 0; i < kMaxLyrsPerDTC; ++i) {
+    nlayers += (hLinkWord.range(kSizeLinkWord*i+kSizeLinkWord-1, kSizeLinkWord*i) != 0);
+  }
+  return nlayers;
+}
+
+// Random stub with the valid bit set, on one of the nlayers layers/disks
+ap_uint<kNBits_DTC> randomStub(int nlayers)
+{
+  ap_uint<kNBits_DTC> stub = 0;
+  for (int i = 0; i < kLSBLyrBts; i += 16) {
+    const int msb = (i + 15 < kLSBLyrBts) ? i + 15 : kLSBLyrBts - 1;
+    stub.range(msb, i) = rand();
+  }
+  stub.range(kMSBLyrBts, kLSBLyrBts) = rand() % nlayers;
+  stub.range(kMSBVldBt, kLSBVldBt) = 1;
+  return stub;
+}
+
+// Compare the pages bx of the memories of all the links with the reference,
+// whole pages, as the entries are not counted
+int comparePages(DTCStubMemory hMemories[][cNMemories], DTCStubMemory hMemories_ref[][cNMemories],
+  const BXType bx, const int ievt)
+{
+  int err = 0;
+  for (unsigned int i = 0; i < cNLinks; ++i) {
+    for (unsigned int j = 0; j < cNMemories; ++j) {
+      for (unsigned int k = 0; k < hMemories[i][j].getDepth(); ++k) {
+        const auto word = hMemories[i][j].read_mem(bx, k).raw();
+        const auto word_ref = hMemories_ref[i][j].read_mem(bx, k).raw();
+        if (word != word_ref) {
+          cout << "Event " << ievt << ", link " << linkIds[i] << ", memory " << j << ", entry " << k
+               << ": " << word.to_string(16) << ", expected " << word_ref.to_string(16) << endl;
+          ++err;
+        }
+      }
+    }
+  }
+  return err;
+}
+
+int main()
+{
+  // error counts
+  int err = 0;
+
+  ap_uint<kLINKMAPwidth> hLinkWord[cNLinks];
+  ap_uint<kBINMAPwidth> hPhBnWord[cNLinks];
+  int nlayers[cNLinks];
+  for (unsigned int i = 0; i < cNLinks; ++i) {
+    hLinkWord[i] = kLinkAssignmentTable[linkIds[i]%12];
+    hPhBnWord[i] = kLinkNPhiBns[linkIds[i]%12];
+    nlayers[i] = getNLayers(hLinkWord[i]);
+    if (hLinkWord[i].range(kLINKMAPwidth-4, kLINKMAPwidth-4) != 0 || kLinkNMemories[linkIds[i]%12] > cNMemories) {
+      cerr << "Link " << linkIds[i] << " is not a PS link with at most " << cNMemories << " memories" << endl;
+      return -1;
+    }
+  }
+
+  static ap_uint<kNBits_DTC> hInputStubs[cNLinks][kMaxStubsFromLink];
+  static DTCStubMemory hMemories[cNLinks][cNMemories];
+  static DTCStubMemory hMemories_ref[cNLinks][cNMemories];
+
+  ///////////////////////////
+  // loop over events
+  cout << "Start event loop ..." << endl;
+  srand(1);
+  for (int ievt = 0; ievt < nevents; ++ievt) {
+
+    // bx
+    BXType bx = ievt&0x7;
+    BXType bx_o;
+
+    // Random inputs, from empty links to full ones, with gaps
+    for (unsigned int i = 0; i < cNLinks; ++i) {
+      const int nstubs = rand() % (kMaxStubsFromLink + 1);
+      for (int j = 0; j < kMaxStubsFromLink; ++j) {
+        hInputStubs[i][j] = (j < nstubs && rand() % 8 != 0) ? randomStub(nlayers[i]) : ap_uint<kNBits_DTC>(0);
+      }
+      for (unsigned int j = 0; j < cNMemories; ++j) {
+        hMemories[i][j].clear();
+        hMemories_ref[i][j].clear();
+      }
+    }
+
+    // Unit Under Test
+    DTCStubStream hInputStreams[cNLinks];
+    for (unsigned int i = 0; i < cNLinks; ++i) writeLinkStream(hInputStreams[i], hInputStubs[i]);
+    InputRouterMultiLinkTop(bx, hLinkWord, hPhBnWord,
+      kPhiCorrtable_L1, kPhiCorrtable_L2, kPhiCorrtable_L3,
+      hInputStreams, bx_o, hMemories);
+
+    // reference: one link at a time
+    for (unsigned int i = 0; i < cNLinks; ++i) {
+      if (not hInputStreams[i].empty()) {
+        cout << "Event " << ievt << ", link " << linkIds[i] << ": stream not read to the end of the BX" << endl;
+        ++err;
+      }
+      DTCStubStream hInputStream;
+      writeLinkStream(hInputStream, hInputStubs[i]);
+      InputRouterTop(bx, hLinkWord[i], hPhBnWord[i],
+        kPhiCorrtable_L1, kPhiCorrtable_L2, kPhiCorrtable_L3,
+        hInputStream, bx_o, hMemories_ref[i]);
+    }
+
+    err += comparePages(hMemories, hMemories_ref, bx, ievt);
+
+  } // end of event loop
+
+  ///////////////////////////
+  // Over-full links: an event with more than kMaxStubsFromLink stubs on each
+  // link, followed on the same streams by an event with a few. The stubs past
+  // the loop budget must be skipped up to the end-of-BX word, so that the
+  // first event gives the memories of its first kMaxStubsFromLink stubs, and
+  // the second event is read from its first stub.
+  cout << "Over-full links ..." << endl;
+  const int nOverFull = kMaxStubsFromLink + 20;
+  const int nNext = 10;
+  static ap_uint<kNBits_DTC> hOverFullStubs[cNLinks][nOverFull];
+  static ap_uint<kNBits_DTC> hNextStubs[cNLinks][kMaxStubsFromLink];
+  static DTCStubMemory hMemories_single[cNLinks][cNMemories];
+  DTCStubStream hInputStreams[cNLinks];
+  DTCStubStream hInputStreams_single[cNLinks];
+  for (unsigned int i = 0; i < cNLinks; ++i) {
+    for (int j = 0; j < nOverFull; ++j) hOverFullStubs[i][j] = randomStub(nlayers[i]);
+    for (int j = 0; j < kMaxStubsFromLink; ++j) {
+      hNextStubs[i][j] = (j < nNext) ? randomStub(nlayers[i]) : ap_uint<kNBits_DTC>(0);
+    }
+    writeLinkStream(hInputStreams[i], hOverFullStubs[i], nOverFull);
+    writeLinkStream(hInputStreams[i], hNextStubs[i]);
+    writeLinkStream(hInputStreams_single[i], hOverFullStubs[i], nOverFull);
+    writeLinkStream(hInputStreams_single[i], hNextStubs[i]);
+    for (unsigned int j = 0; j < cNMemories; ++j) {
+      hMemories[i][j].clear();
+      hMemories_single[i][j].clear();
+      hMemories_ref[i][j].clear();
+    }
+  }
+  for (int ievt = nevents; ievt < nevents + 2; ++ievt) {
+    BXType bx = ievt&0x7;
+    BXType bx_o;
+    InputRouterMultiLinkTop(bx, hLinkWord, hPhBnWord,
+      kPhiCorrtable_L1, kPhiCorrtable_L2, kPhiCorrtable_L3,
+      hInputStreams, bx_o, hMemories);
+    for (unsigned int i = 0; i < cNLinks; ++i) {
+      InputRouterTop(bx, hLinkWord[i], hPhBnWord[i],
+        kPhiCorrtable_L1, kPhiCorrtable_L2, kPhiCorrtable_L3,
+        hInputStreams_single[i], bx_o, hMemories_single[i]);
+      // reference: the stubs within the loop budget only
+      DTCStubStream hInputStream;
+      writeLinkStream(hInputStream, (ievt == nevents) ? hOverFullStubs[i] : hNextStubs[i]);
+      InputRouterTop(bx, hLinkWord[i], hPhBnWord[i],
+        kPhiCorrtable_L1, kPhiCorrtable_L2, kPhiCorrtable_L3,
+        hInputStream, bx_o, hMemories_ref[i]);
+    }
+    err += comparePages(hMemories, hMemories_ref, bx, ievt);
+    err += comparePages(hMemories_single, hMemories_ref, bx, ievt);
+  }
+  for (unsigned int i = 0; i < cNLinks; ++i) {
+    if (not hInputStreams[i].empty() || not hInputStreams_single[i].empty()) {
+      cout << "Over-full link " << linkIds[i] << ": stream not read to the end of the last BX" << endl;
+      ++err;
+    }
+  }
+
+  // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
+  if (err > 255) err = 255;
+  return err;
+}
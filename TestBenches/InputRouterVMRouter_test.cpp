@@ -0,0 +1,205 @@
+// Test bench for the fused InputRouter/VMRouter
+//
+// Random events of stubs on numInputs copies of a PS link reading out layer 1
+// are sorted by InputRouterVMRouterTop, and by InputRouterTop, one link at a
+// time, followed by VMRouterTop on the InputRouter memories of the region,
+// whose output memories must be the same. About half of the stubs of layer 1
+// are in the phi region of the VMRouter, the others in random ones.
+//
+// The VMRouter and the InputRouter use the layer 1 phi corrections of
+// emData/VMR/tables and emData/LUTs, which are the same emulation table.
+#include "InputRouterVMRouterTop.h"
+#include "VMRouterTop.h"
+#include "InputRouterTop.h"
+#include "InputRouterLinks.h"
+
+#include <cstdlib>
+#include <iostream>
+
+const int nevents = 100;  // number of events to run
+
+// PS link reading out layer 1, with at most cNMemories memories
+const int linkId = 6;
+
+using namespace std;
+
+// Compare the whole pages of two memories, as the entries are not counted
+template<class MemType>
+int compareMemories(int ievt, const string& name, BXType bx, const MemType& mem, const MemType& mem_ref)
+{
+  int err = 0;
+  for (unsigned int k = 0; k < mem.getDepth(); ++k) {
+    const auto word = mem.read_mem(bx, k).raw();
+    const auto word_ref = mem_ref.read_mem(bx, k).raw();
+    if (word != word_ref) {
+      cout << "Event " << ievt << ", " << name << ", entry " << k
+           << ": " << word.to_string(16) << ", expected " << word_ref.to_string(16) << endl;
+      ++err;
+    }
+  }
+  return err;
+}
+
+// Random stub with the valid bit set, on one of the nlayers layers/disks
+// of the link. The stubs of layer 1, encoded as lyrL1, are in the phi
+// region of the VMRouter half of the time.
+ap_uint<kNBits_DTC> randomStub(int nlayers, int lyrL1)
+{
+  ap_uint<kNBits_DTC> hStub = 0;
+  for (int i = 0; i < kLSBLyrBts; i += 16) {
+    const int msb = (i + 15 < kLSBLyrBts) ? i + 15 : kLSBLyrBts - 1;
+    hStub.range(msb, i) = rand();
+  }
+  const int lyr = rand() % nlayers;
+  if (lyr == lyrL1 && rand() % 2) {
+    InputStub<inputType> stub(hStub.range(kBRAMwidth - 1, 0));
+    auto phi = stub.getPhi();
+    phi.range(phi.length() - 1, phi.length() - kNbitsPhiBinsPSL1) = phiRegion - 'A';
+    stub.setPhi(phi);
+    hStub.range(kBRAMwidth - 1, 0) = stub.raw();
+  }
+  hStub.range(kMSBLyrBts, kLSBLyrBts) = lyr;
+  hStub.range(kMSBVldBt, kLSBVldBt) = 1;
+  return hStub;
+}
+
+int main()
+{
+  // error counts
+  int err = 0;
+
+  const ap_uint<kLINKMAPwidth> hLinkWord = kLinkAssignmentTable[linkId%12];
+  const ap_uint<kBINMAPwidth> hPhBnWord = kLinkNPhiBns[linkId%12];
+  const int memIndex = getMemIndex(linkId, true, kLAYER, phiRegion - 'A');
+  if (kLAYER != kFrstPSBrlLyr || memIndex < 0 || kLinkNMemories[linkId%12] > cNMemories) {
+    cerr << "Link " << linkId << " does not read out the VMRouter region in at most " << cNMemories << " memories" << endl;
+    return -1;
+  }
+
+  // Number of layers/disks of the link and encoding of layer 1
+  int nlayers = 0;
+  int lyrL1 = -1;
+  for (int i = 0; i < kMaxLyrsPerDTC; ++i) {
+    const ap_uint<kSizeLinkWord> hWrd = hLinkWord.range(kSizeLinkWord*i+kSizeLinkWord-1, kSizeLinkWord*i);
+    if (hWrd == 0) continue;
+    if (hWrd.range(0, 0) == 1 && hWrd.range(3, 1) == kLAYER) lyrL1 = i;
+    ++nlayers;
+  }
+
+  ap_uint<kLINKMAPwidth> hLinkWords[numInputs];
+  for (int i = 0; i < numInputs; ++i) hLinkWords[i] = hLinkWord;
+
+  static ap_uint<kNBits_DTC> hInputStubs[numInputs][kMaxStubsFromLink];
+  static DTCStubMemory hMemories[cNMemories];
+  static InputStubMemory<inputType> inputStub[numInputs];
+
+  static AllStubMemory<outputType> memoriesAS[maxASCopies];
+  static VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME];
+  static VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies];
+  static VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies];
+
+  static AllStubMemory<outputType> memoriesAS_ref[maxASCopies];
+  static VMStubMEMemory<outputType, nbitsbin> memoriesME_ref[nvmME];
+  static VMStubTEInnerMemory<outputType> memoriesTEI_ref[nvmTEI][maxTEICopies];
+  static VMStubTEInnerMemory<BARRELOL> memoriesOL_ref[nvmOL][maxOLCopies];
+
+  ///////////////////////////
+  // loop over events
+  cout << "Start event loop ..." << endl;
+  srand(1);
+  for (int ievt = 0; ievt < nevents; ++ievt) {
+
+    // bx
+    BXType bx = ievt&0x7;
+    BXType bx_o;
+
+    // Random inputs, from empty links to full ones, with gaps
+    for (int i = 0; i < numInputs; ++i) {
+      const int nstubs = rand() % (kMaxStubsFromLink + 1);
+      for (int j = 0; j < kMaxStubsFromLink; ++j) {
+        hInputStubs[i][j] = (j < nstubs && rand() % 8 != 0) ? randomStub(nlayers, lyrL1) : ap_uint<kNBits_DTC>(0);
+      }
+    }
+    for (int i = 0; i < maxASCopies; ++i) {
+      memoriesAS[i].clear();
+      memoriesAS_ref[i].clear();
+    }
+    for (int i = 0; i < nvmME; ++i) {
+      memoriesME[i].clear();
+      memoriesME_ref[i].clear();
+    }
+    for (int i = 0; i < nvmTEI; ++i) {
+      for (int j = 0; j < maxTEICopies; ++j) {
+        memoriesTEI[i][j].clear();
+        memoriesTEI_ref[i][j].clear();
+      }
+    }
+    for (int i = 0; i < nvmOL; ++i) {
+      for (int j = 0; j < maxOLCopies; ++j) {
+        memoriesOL[i][j].clear();
+        memoriesOL_ref[i][j].clear();
+      }
+    }
+
+    // Unit Under Test
+    DTCStubStream hInputStreams[numInputs];
+    for (int i = 0; i < numInputs; ++i) writeLinkStream(hInputStreams[i], hInputStubs[i]);
+    InputRouterVMRouterTop(bx, bx_o, hLinkWords, hInputStreams,
+      memoriesAS, memoriesME, memoriesTEI, memoriesOL);
+
+    for (int i = 0; i < numInputs; ++i) {
+      if (not hInputStreams[i].empty()) {
+        cout << "Event " << ievt << ", link " << i << ": stream not read to the end of the BX" << endl;
+        ++err;
+      }
+    }
+
+    // reference: InputRouter of each link, then VMRouter
+    for (int i = 0; i < numInputs; ++i) {
+      for (unsigned int j = 0; j < cNMemories; ++j) hMemories[j].clear();
+      DTCStubStream hInputStream;
+      writeLinkStream(hInputStream, hInputStubs[i]);
+      InputRouterTop(bx, hLinkWord, hPhBnWord,
+        kPhiCorrtable_L1, kPhiCorrtable_L2, kPhiCorrtable_L3,
+        hInputStream, bx_o, hMemories);
+
+      // The InputRouter does not count the entries of its memories: copy the
+      // stubs of the region up to the first empty entry
+      uint64_t records[2*(1<<kNBits_MemAddr)];
+      unsigned int nent = 0;
+      for (unsigned int k = 0; k < hMemories[memIndex].getDepth(); ++k) {
+        const auto word = hMemories[memIndex].read_mem(bx, k).raw();
+        if (word == 0) break;
+        records[2*nent] = nent;
+        records[2*nent+1] = word.to_uint64();
+        ++nent;
+      }
+      inputStub[i].clear();
+      inputStub[i].write_page(bx, records, nent, 1);
+    }
+    VMRouterTop(bx, bx_o, inputStub,
+      memoriesAS_ref, memoriesME_ref, memoriesTEI_ref, memoriesOL_ref);
+
+    for (int i = 0; i < maxASCopies; ++i) {
+      err += compareMemories(ievt, "AS copy " + to_string(i), bx, memoriesAS[i], memoriesAS_ref[i]);
+    }
+    for (int i = 0; i < nvmME; ++i) {
+      err += compareMemories(ievt, "ME " + to_string(i), bx, memoriesME[i], memoriesME_ref[i]);
+    }
+    for (int i = 0; i < nvmTEI; ++i) {
+      for (int j = 0; j < maxTEICopies; ++j) {
+        err += compareMemories(ievt, "TEI " + to_string(i) + " copy " + to_string(j), bx, memoriesTEI[i][j], memoriesTEI_ref[i][j]);
+      }
+    }
+    for (int i = 0; i < nvmOL; ++i) {
+      for (int j = 0; j < maxOLCopies; ++j) {
+        err += compareMemories(ievt, "OL " + to_string(i) + " copy " + to_string(j), bx, memoriesOL[i][j], memoriesOL_ref[i][j]);
+      }
+    }
+
+  } // end of event loop
+
+  // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
+  if (err > 255) err = 255;
+  return err;
+}
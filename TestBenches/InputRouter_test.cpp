@@ -2,6 +2,7 @@
 //#include "InputStubs.h"
 #include "FileReadUtility.h"
 #include "InputRouterTop.h"
+#include "InputRouterLinks.h"
 
 #include <iostream>
 #include <fstream>
@@ -14,67 +15,6 @@
 
 static const int kMaxNEvents = 10;  // max number of events to run
 
-// link assignment table 
-// TO-BE fixed :  need this added to emData 
-// 3 bits for layer/disk id  --> 3 bits 
-// 1 bit for barrel/disk --> 4 bits  
-// up-to 4 layers/disks per DTC
-// 16 bits per link
-// then 3 bits 
-// 1 bit to assign whether link is PS/2S 
-// 3 bits to encode the number of layers readout by this DTC 
-// 20 bits in total 
-const ap_uint<kLINKMAPwidth> kLinkAssignmentTable[] =
-{
-  0x500b9, 0x3000b, 0x3000d, 0x5006d, 
-  0x50082, 0x500a4, 0x60843, 0x8a623, 
-  0x20005, 0x60a62, 0x40047, 0x40087
-};
-
-// number of phi bins read out 
-// by each link (kSizeBinWord per layer )
-// upto 4 layers per link  
-const ap_uint<kBINMAPwidth> kLinkNPhiBns[] = 
-{
-  0x01B , 0x003 , 0x003 , 0x01B , 
-  0x01B , 0x01B , 0x0DF , 0x6DF , 
-  0x003 , 0x0DB , 0x01B , 0x01B 
-};
-
-// total number of memoreis 
-// readout b each link 
-const ap_uint<kNMEMwidth> kLinkNMemories[] = 
-{
-   8 ,  4 ,  4 ,  8 , 
-   8 ,  8 , 16 , 20 , 
-   4 , 12 ,  8 ,  8 
-};
-
-
-
-// LUT with phi corrections to the nominal radius. Only used by layers.
-// Values are determined by the radius and the bend of the stub.
-const int kPhiCorrtable_L1[] =
-#include "../emData/LUTs/VMPhiCorrL1.tab"
-;
-const int kPhiCorrtable_L2[] =
-#include "../emData/LUTs/VMPhiCorrL2.tab"
-;
-const int kPhiCorrtable_L3[] =
-#include "../emData/LUTs/VMPhiCorrL3.tab"
-;
-const int kPhiCorrtable_L4[] =
-#include "../emData/LUTs/VMPhiCorrL4.tab"
-;
-const int kPhiCorrtable_L5[] =
-#include "../emData/LUTs/VMPhiCorrL5.tab"
-;
-const int kPhiCorrtable_L6[] =
-#include "../emData/LUTs/VMPhiCorrL6.tab"
-;
-
-// map of input links  [per DTC ]
-using LinkMap = std::map<int, std::pair<std::string ,std::vector<std::uint8_t>>> ; 
 //map of input stubs [ per Bx ]
 using InputStubs = std::map<int, std::vector<std::string>> ; 
 //vector of stubs 
@@ -85,80 +25,6 @@ typedef std::map<int, std::vector<int>> TkMap;
 
 using namespace std;
 
-// create link map
-// map is 
-// link id [key]
-// DTC name [from dtclinklayer]
-// then a list of encoded layers 
-void createLinkMap(std::string pInputCablingMap, int pDTCsplit, LinkMap& pLinkMap ) 
-{
-  std::string cBaseName  = "Link_";
-  //std::cout << "Loading link map into memory .. will be used later" <<std::endl;
-  std::ifstream fin_il_map;
-  if (not openDataFile(fin_il_map,pInputCablingMap)) 
-  {
-    std::cout << "Could not find file " 
-      << pInputCablingMap << std::endl;
-  }
-  size_t cLinkCounter=0;
-  // parse link map 
-  for(std::string cInputLine; getline( fin_il_map, cInputLine ); )
-  {
-    auto cStream = std::istringstream{cInputLine};
-    std::string cToken;
-    while (cStream >> cToken) 
-    {
-      bool cIsAlNum =true;
-      for( auto cChar : cToken )
-        cIsAlNum = cIsAlNum && std::isalnum(cChar);
-      if( !cIsAlNum ) // input link name 
-      {
-        if( cToken.find("2S") != std::string::npos 
-          || cToken.find("PS") != std::string::npos ) 
-        {
-          pLinkMap[cLinkCounter].first += cBaseName + cToken;
-          pLinkMap[cLinkCounter].first += (pDTCsplit==0)?"_A":"_B";
-          if( IR_DEBUG)
-            std::cout << "Link name : " << pLinkMap[cLinkCounter].first << "\n";
-        }
-      }
-      else
-      {
-        auto cLayerId = std::stoi( cToken);
-        if(cLayerId != -1 )
-          pLinkMap[cLinkCounter].second.push_back( cLayerId );
-      }
-    }
-    cLinkCounter++;
-  }
-}
-
-// return name of link file based on link id 
-// link 
-std::string getLinkName( int pLinkId
-  , int pDTCsplit = 0 
-  , std::string pInputFile_LinkMap = "emData/dtclinklayerdisk.dat")
-{
-  // create link map 
-  LinkMap cInputMap;
-  createLinkMap(pInputFile_LinkMap, pDTCsplit, cInputMap );
-  
-  // get link Id 
-  std::string cLinkName = cInputMap[pLinkId].first; 
-  return cLinkName; 
-}
-
-// return name of dtc based on link id 
-std::string getDTCName( int pLinkId
-  , int pDTCsplit = 0 
-  , std::string pInputFile_LinkMap = "emData/dtclinklayerdisk.dat")
-{
-  
-  std::string cBaseName = "Link_"; 
-  std::string cLinkName = getLinkName( pLinkId, pDTCsplit, pInputFile_LinkMap);
-  std::string cDTCName  = cLinkName.substr(cLinkName.find(cBaseName)+cBaseName.length(), cLinkName.length() - cBaseName.length()) ; 
-  return cDTCName;
-}
 
 // get name of mem print 
 // from emulation 
@@ -316,6 +182,9 @@ int main()
   // check file exists 
   if( !openDataFile(cLinkDataStream,cInputFile_Link ) ) 
     return 1; 
+  // index of the events in the LINK_ file
+  // so that each event can be read directly
+  MemPrintsIndex cLinkDataIndex(cInputFile_Link);
 
   // now prepare inputs for IR 
   ap_uint<kNBitsNLnks> hLinkId = cLinkId;
@@ -346,7 +215,9 @@ int main()
     ap_uint<kNBits_DTC> hInputStubs[kMaxStubsFromLink];
     for( size_t cStubIndx=0; cStubIndx < kMaxStubsFromLink; cStubIndx++)
       hInputStubs[cStubIndx]=ap_uint<kNBits_DTC>(0);
-    writeArrayFromFile<ap_uint<kNBits_DTC>>(hInputStubs , cLinkDataStream, cEvId);
+    writeArrayFromFile<ap_uint<kNBits_DTC>>(hInputStubs , cLinkDataStream, cLinkDataIndex, cEvId);
+    DTCStubStream hInputStream;
+    writeLinkStream(hInputStream, hInputStubs);
     
     // clear memories 
     for( unsigned int cIndx=0; cIndx < (unsigned int)hNmemories ; cIndx++)
@@ -386,7 +257,7 @@ int main()
       , cLUT_L1// corrections frst brl lyr  
       , cLUT_L2 // corrections scnd brl lyr  
       , cLUT_L3 // corrections thrd brl lyr  
-      , hInputStubs // input stub stream 
+      , hInputStream // input stub stream 
       , bx_o // output bx 
       , hMemories);  // output memories 
 
@@ -408,9 +279,6 @@ int main()
       cTotalErrCnt += cErCnt;
     }
 
-    // reset input file stream back to the start 
-    cLinkDataStream.clear();
-    cLinkDataStream.seekg (0, ios::beg);
   }
 
   // place point back to start 
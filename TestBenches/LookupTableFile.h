@@ -0,0 +1,112 @@
+// Lookup tables read at run time, used only in test bench for C simulation
+//
+// The processing modules get their tables at compile time
+// (TrackletAlgorithm/LookupTables.h). The tables a test bench passes to a
+// module can instead be read from the .tab file when the test bench runs, so
+// that a new table does not need a recompilation. lookupTable() maps the
+// file, parses its values once and keeps them, so all the threads and module
+// instances of a test bench share one copy.
+#ifndef __SYNTHESIS__
+
+#ifndef TestBenches_LookupTableFile_h
+#define TestBenches_LookupTableFile_h
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Parse the values of a .tab file, i.e. a C initializer list such as
+// "{1, 0, -3};", with the braces, separators and comments skipped
+inline bool parseLookupTableFile(const std::string& file_name, std::vector<int>& values)
+{
+  const int fd = ::open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+  if (st.st_size == 0) {
+    ::close(fd);
+    return true;
+  }
+
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) return false;
+
+  const char* c = static_cast<const char*>(data);
+  const char* const end = c + st.st_size;
+  while (c < end) {
+    if (*c == '/' && c + 1 < end && c[1] == '/') {
+      while (c < end && *c != '\n') ++c;
+    } else if (*c == '/' && c + 1 < end && c[1] == '*') {
+      c += 2;
+      while (c + 1 < end && !(c[0] == '*' && c[1] == '/')) ++c;
+      c += 2;
+    } else if ((*c >= '0' && *c <= '9') || *c == '-') {
+      int sign = 1;
+      if (*c == '-') {
+        sign = -1;
+        ++c;
+      }
+      long value = 0;
+      while (c < end && *c >= '0' && *c <= '9') value = 10 * value + (*c++ - '0');
+      values.push_back(sign * value);
+    } else {
+      ++c;
+    }
+  }
+
+  munmap(data, st.st_size);
+  return true;
+}
+
+// Values of a .tab file, read on the first call and shared afterwards. The
+// returned vector is empty if the file could not be read.
+inline const std::vector<int>& lookupTable(const std::string& file_name)
+{
+  static std::map<std::string, std::unique_ptr<std::vector<int>>> tables;
+  static std::mutex mutex;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& table = tables[file_name];
+  if (not table) {
+    table.reset(new std::vector<int>);
+    if (not parseLookupTableFile(file_name, *table)) {
+      std::cerr << "Open of lookup table " << file_name << " failed" << std::endl;
+      std::cerr << "running from directory " << getcwd(nullptr,0) << std::endl;
+      table->clear();
+    }
+  }
+  return *table;
+}
+
+// Fill the first size entries of table from a .tab file. Returns false if
+// the file has fewer values.
+template<class T>
+bool readLookupTable(const std::string& file_name, T table[], unsigned int size)
+{
+  const std::vector<int>& values = lookupTable(file_name);
+  if (values.size() < size) {
+    std::cerr << "Lookup table " << file_name << " has " << values.size()
+              << " entries, " << size << " expected" << std::endl;
+    return false;
+  }
+  for (unsigned int i = 0; i < size; ++i) table[i] = values[i];
+  return true;
+}
+
+#endif // TestBenches_LookupTableFile_h
+
+#endif // __SYNTHESIS__
@@ -2,6 +2,9 @@
 #include "MatchCalculatorTop.h"
 
 #include "FileReadUtility.h"
+#include "MemPrintsBinary.h"
+#include "ParallelEventLoop.h"
+#include "ModuleMonitorReport.h"
 #include "Constants.h"
 
 #include "hls_math.h"
@@ -19,29 +22,29 @@ using namespace std;
 
 
 
-int main() {
-  // error counter
-  int err_count = 0;
-
-  // declare input memory arrays to be read from the emulation files
-  static CandidateMatchMemory           match[maxMatchCopies];
-  static AllStubMemory<BARRELPS>        allstub;
-  static AllProjectionMemory<BARRELPS>  allproj;
+// memories used by each thread of the event loop
+struct MatchCalculatorMemories {
+  // input memory arrays to be read from the emulation files
+  CandidateMatchMemory           match[maxMatchCopies];
+  AllStubMemory<BARRELPS>        allstub;
+  AllProjectionMemory<BARRELPS>  allproj;
 
-  // declare output memory array to be filled by hls simulation
-  static FullMatchMemory<BARREL_FOR_MC> fullmatch[maxFullMatchCopies];
+  // output memory array to be filled by hls simulation
+  FullMatchMemory<BARREL_FOR_MC> fullmatch[maxFullMatchCopies];
+};
 
+int main() {
   // read in input files
-  ifstream fin_as;
-  ifstream fin_ap;
-  ifstream fin_cm1;
-  ifstream fin_cm2;
-  ifstream fin_cm3;
-  ifstream fin_cm4;
-  ifstream fin_cm5;
-  ifstream fin_cm6;
-  ifstream fin_cm7;
-  ifstream fin_cm8;
+  MemPrintsBinary fin_as;
+  MemPrintsBinary fin_ap;
+  MemPrintsBinary fin_cm1;
+  MemPrintsBinary fin_cm2;
+  MemPrintsBinary fin_cm3;
+  MemPrintsBinary fin_cm4;
+  MemPrintsBinary fin_cm5;
+  MemPrintsBinary fin_cm6;
+  MemPrintsBinary fin_cm7;
+  MemPrintsBinary fin_cm8;
 
   if (not openDataFile(fin_as,"MC/MC_L3PHIC/AllStubs_AS_L3PHICn6_04.dat")) return -1;
   if (not openDataFile(fin_ap,"MC/MC_L3PHIC/AllProj_AP_L3PHIC_04.dat")) return -1;
@@ -55,14 +58,14 @@ int main() {
   if (not openDataFile(fin_cm8,"MC/MC_L3PHIC/CandidateMatches_CM_L3PHIC24_04.dat")) return -1;
 
   // open file(s) with reference results
-  ifstream fout_fm1;
-  ifstream fout_fm2;
-  ifstream fout_fm3;
-  ifstream fout_fm4;
-  ifstream fout_fm5;
-  ifstream fout_fm6;
-  ifstream fout_fm7;
-  ifstream fout_fm8;
+  MemPrintsBinary fout_fm1;
+  MemPrintsBinary fout_fm2;
+  MemPrintsBinary fout_fm3;
+  MemPrintsBinary fout_fm4;
+  MemPrintsBinary fout_fm5;
+  MemPrintsBinary fout_fm6;
+  MemPrintsBinary fout_fm7;
+  MemPrintsBinary fout_fm8;
 
   if (not openDataFile(fout_fm1,"MC/MC_L3PHIC/FullMatches_FM_L1L2_L3PHIC_04.dat")) return -1;
   //if (not openDataFile(fout_fm2,"MC/MC_L1PHIC/FullMatches_FM_L2L3_L1PHIC_04.dat")) return -1;
@@ -73,30 +76,31 @@ int main() {
   //if (not openDataFile(fout_fm6,"")) return -1;
   //if (not openDataFile(fout_fm7,"MC/MC_L1PHIC/FullMatches_FM_L2D1_L1PHIC_04.dat")) return -1;
 
-  // loop over events
-  for (int ievt = 0; ievt < nevents; ++ievt) {
-    //cout << "Event: " << dec << ievt << endl;
-
-    fullmatch[0].clear();
-//    fullmatch[1].clear();
-//    fullmatch[2].clear();
-    fullmatch[3].clear();
-//    fullmatch[4].clear();
-//    fullmatch[5].clear();
-//    fullmatch[6].clear();
-//    fullmatch[7].clear();
-
-    // make memories from the input text files
-    writeMemFromFile<AllStubMemory<BARRELPS> >(allstub, fin_as, ievt);
-    writeMemFromFile<AllProjectionMemory<BARRELPS> >(allproj, fin_ap, ievt);
-    writeMemFromFile<CandidateMatchMemory>(match[0], fin_cm1, ievt);
-    writeMemFromFile<CandidateMatchMemory>(match[1], fin_cm2, ievt);
-    writeMemFromFile<CandidateMatchMemory>(match[2], fin_cm3, ievt);
-    writeMemFromFile<CandidateMatchMemory>(match[3], fin_cm4, ievt);
-    writeMemFromFile<CandidateMatchMemory>(match[4], fin_cm5, ievt);
-    writeMemFromFile<CandidateMatchMemory>(match[5], fin_cm6, ievt);
-    writeMemFromFile<CandidateMatchMemory>(match[6], fin_cm7, ievt);
-    writeMemFromFile<CandidateMatchMemory>(match[7], fin_cm8, ievt);
+  // loop over events, in parallel
+  int err_count = runEventLoop<MatchCalculatorMemories>(nevents, [&](MatchCalculatorMemories& mem, int ievt) {
+    //tbout() << "Event: " << dec << ievt << endl;
+    unsigned int err = 0;
+
+    mem.fullmatch[0].clear();
+//    mem.fullmatch[1].clear();
+//    mem.fullmatch[2].clear();
+    mem.fullmatch[3].clear();
+//    mem.fullmatch[4].clear();
+//    mem.fullmatch[5].clear();
+//    mem.fullmatch[6].clear();
+//    mem.fullmatch[7].clear();
+
+    // make memories from the input files
+    writeMemFromFile<AllStubMemory<BARRELPS> >(mem.allstub, fin_as, ievt);
+    writeMemFromFile<AllProjectionMemory<BARRELPS> >(mem.allproj, fin_ap, ievt);
+    writeMemFromFile<CandidateMatchMemory>(mem.match[0], fin_cm1, ievt);
+    writeMemFromFile<CandidateMatchMemory>(mem.match[1], fin_cm2, ievt);
+    writeMemFromFile<CandidateMatchMemory>(mem.match[2], fin_cm3, ievt);
+    writeMemFromFile<CandidateMatchMemory>(mem.match[3], fin_cm4, ievt);
+    writeMemFromFile<CandidateMatchMemory>(mem.match[4], fin_cm5, ievt);
+    writeMemFromFile<CandidateMatchMemory>(mem.match[5], fin_cm6, ievt);
+    writeMemFromFile<CandidateMatchMemory>(mem.match[6], fin_cm7, ievt);
+    writeMemFromFile<CandidateMatchMemory>(mem.match[7], fin_cm8, ievt);
 
     //set bunch crossing
     BXType bx = ievt;
@@ -104,48 +108,32 @@ int main() {
 
     // Unit Under Test
     MatchCalculatorTop(
-      bx, match, &allstub, &allproj, bx_out, fullmatch
+      bx, mem.match, &mem.allstub, &mem.allproj, bx_out, mem.fullmatch
     );
 
     // compare the computed outputs with the expected ones 
-    //std::cout << "FM: L1L2 seeding" << std::endl;
-    err_count += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(fullmatch[0], fout_fm1, ievt, "FullMatch", truncation);
-    //std::cout << "FM: L2L3 seeding" << std::endl;
-    //err_count += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(fullmatch[1], fout_fm2, ievt, "FullMatch", truncation);
-    //std::cout << "FM: L3L4 seeding" << std::endl;
-    //err_count += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(fullmatch[2], fout_fm3, ievt, "FullMatch", truncation);
-    //std::cout << "FM: L5L6 seeding" << std::endl;
-    err_count += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(fullmatch[3], fout_fm4, ievt, "FullMatch", truncation);
-    //std::cout << "FM: D1D2 seeding" << std::endl;
-    //err_count += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(fullmatch[4], fout_fm5, ievt, "FullMatch", truncation);
-    //std::cout << "FM: D3D4 seeding" << std::endl;
-    //err_count += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(fullmatch[5], fout_fm6, ievt, "FullMatch", truncation);
-    //std::cout << "FM: L1D1 seeding" << std::endl;
-    //err_count += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(fullmatch[6], fout_fm7, ievt, "FullMatch", truncation);
-    //std::cout << "FM: L2D1 seeding" << std::endl;
-    //err_count += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(fullmatch[7], fout_fm8, ievt, "FullMatch", truncation);
-
-  }  // end of event loop
-  
-  // close files
-  fin_as.close();
-  fin_ap.close();
-  fin_cm1.close();
-  fin_cm2.close();
-  fin_cm3.close();
-  fin_cm4.close();
-  fin_cm5.close();
-  fin_cm6.close();
-  fin_cm7.close();
-  fin_cm8.close();
-  fout_fm1.close();
-  fout_fm2.close();
-  fout_fm3.close();
-  fout_fm4.close();
-  fout_fm5.close();
-  fout_fm6.close();
-  fout_fm7.close();
-  fout_fm7.close();
+    //tbout() << "FM: L1L2 seeding" << std::endl;
+    err += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(mem.fullmatch[0], fout_fm1, ievt, "FullMatch", truncation);
+    //tbout() << "FM: L2L3 seeding" << std::endl;
+    //err += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(mem.fullmatch[1], fout_fm2, ievt, "FullMatch", truncation);
+    //tbout() << "FM: L3L4 seeding" << std::endl;
+    //err += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(mem.fullmatch[2], fout_fm3, ievt, "FullMatch", truncation);
+    //tbout() << "FM: L5L6 seeding" << std::endl;
+    err += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(mem.fullmatch[3], fout_fm4, ievt, "FullMatch", truncation);
+    //tbout() << "FM: D1D2 seeding" << std::endl;
+    //err += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(mem.fullmatch[4], fout_fm5, ievt, "FullMatch", truncation);
+    //tbout() << "FM: D3D4 seeding" << std::endl;
+    //err += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(mem.fullmatch[5], fout_fm6, ievt, "FullMatch", truncation);
+    //tbout() << "FM: L1D1 seeding" << std::endl;
+    //err += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(mem.fullmatch[6], fout_fm7, ievt, "FullMatch", truncation);
+    //tbout() << "FM: L2D1 seeding" << std::endl;
+    //err += compareMemWithFile<FullMatchMemory<BARREL_FOR_MC> >(mem.fullmatch[7], fout_fm8, ievt, "FullMatch", truncation);
+
+    return err;
+
+  });  // end of event loop
+
+  printModuleMonitorReport();
 
   // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
   if (err_count > 255) err_count = 255;
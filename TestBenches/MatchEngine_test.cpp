@@ -6,6 +6,7 @@
 #include "VMProjectionMemory.h"
 #include "VMStubMEMemory.h"
 #include "FileReadUtility.h"
+#include "ModuleMonitorReport.h"
 
 // HLS Headers
 #include "hls_math.h"
@@ -19,6 +20,16 @@
 
 using namespace std;
 
+// The barrel MatchEngine is configured in MatchEngine.h, the disk one is run
+// with -DME_D1, see script_ME.tcl
+#ifdef ME_D1
+typedef VMProjectionMemory<DISK> VMProjectionMemoryME;
+typedef VMStubMEMemory<DISK, ME::nBitsBin(0)> VMStubMEMemoryME;
+#else
+typedef VMProjectionMemory<PROJECTIONTYPE> VMProjectionMemoryME;
+typedef VMStubMEMemory<MODULETYPE, NBITBIN> VMStubMEMemoryME;
+#endif
+
 const int nevents = 100;  // number of events to run
 
 int main() {
@@ -26,8 +37,8 @@ int main() {
 	int err_count = 0;
 
 	// Declare input memory arrays to be read from the emulation files
-	VMProjectionMemory<PROJECTIONTYPE> inputvmprojs;
-	VMStubMEMemory<MODULETYPE, NBITBIN> inputvmstubs;
+	VMProjectionMemoryME inputvmprojs;
+	VMStubMEMemoryME inputvmstubs;
 	//CandidateMatchMemory inputcandmatches;
 
 	// Declare output memory array to be filled by hls simulation
@@ -40,7 +51,11 @@ int main() {
 	bool validvmproj    = false;
 	bool validvmstub    = false;
 	bool validcandmatch = false;
-#if LAYER == 1
+#if defined ME_D1
+	validvmproj    = openDataFile(fin_vmproj,"ME/ME_D1PHIA4/VMProjections_VMPROJ_D1PHIA4_04.dat");
+	validvmstub    = openDataFile(fin_vmstub,"ME/ME_D1PHIA4/VMStubs_VMSME_D1PHIA4n1_04.dat");
+	validcandmatch = openDataFile(fin_candmatch,"ME/ME_D1PHIA4/CandidateMatches_CM_D1PHIA4_04.dat");
+#elif LAYER == 1
 	validvmproj    = openDataFile(fin_vmproj,"ME/ME_L1PHIE20/VMProjections_VMPROJ_L1PHIE20_04.dat");
 	validvmstub    = openDataFile(fin_vmstub,"ME/ME_L1PHIE20/VMStubs_VMSME_L1PHIE20n1_04.dat");
 	validcandmatch = openDataFile(fin_candmatch,"ME/ME_L1PHIE20/CandidateMatches_CM_L1PHIE20_04.dat");
@@ -75,8 +90,8 @@ int main() {
 
                 outputcandmatches.clear();
 
-		writeMemFromFile<VMProjectionMemory<PROJECTIONTYPE> >(inputvmprojs, fin_vmproj, ievt);
-		writeMemFromFile<VMStubMEMemory<MODULETYPE, NBITBIN> >(inputvmstubs, fin_vmstub, ievt);
+		writeMemFromFile<VMProjectionMemoryME>(inputvmprojs, fin_vmproj, ievt);
+		writeMemFromFile<VMStubMEMemoryME>(inputvmstubs, fin_vmstub, ievt);
 
 		//Set bunch crossing
 		BXType bx=ievt&0x7;
@@ -84,13 +99,17 @@ int main() {
 
 		//Print the number of projections and stubs
 		std::cout << "In MatchEngine #proj ="<<std::hex<<inputvmprojs.getEntries(bx)<<" #stubs=";
-		for (unsigned int zbin=0;zbin<8;zbin++){
+		for (unsigned int zbin=0;zbin<inputvmstubs.getNBins();zbin++){
 			std::cout <<" "<<inputvmstubs.getEntries(bx,zbin);
 		}
 		std::cout<<std::dec<<std::endl;
 
 		// Unit Under Test
+#ifdef ME_D1
+		MatchEngineTop_D1(bx,bx_out,inputvmstubs,inputvmprojs,outputcandmatches);
+#else
 		MatchEngineTop(bx,bx_out,inputvmstubs,inputvmprojs,outputcandmatches);
+#endif
 
 		// Compare the computed outputs with the expected ones for the candidate matches
 		bool truncation = false;
@@ -103,6 +122,8 @@ int main() {
 	fin_vmproj.close();
 	fin_candmatch.close();
 
+        printModuleMonitorReport();
+
         // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
         if (err_count > 255) err_count = 255;
 	return err_count;
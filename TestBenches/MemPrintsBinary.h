@@ -0,0 +1,334 @@
+// Binary MemPrints format and memory-mapped reader, used only in test bench
+// for C simulation.
+//
+// The emulation writes the memory contents of each event as text, which is
+// slow to parse: every line is split into strings and every word goes
+// through strtol. convertMemPrintsToBinary() parses a .dat file once and
+// stores the words as raw 64-bit limbs together with the offset of each
+// event, and MemPrintsBinary maps the result into memory so a BX page can be
+// filled with MemoryTemplate::write_page() without any string handling.
+//
+// File layout (native endianness, all fields 64-bit aligned):
+//   MemPrintsBinaryHeader
+//   uint64_t eventOffset[nEvents+1]   first record of each event
+//   uint64_t record[nRecords][1+nLimbs] {slot, limb0 (LSBs), limb1, ...}
+// The slot is the bin number for binned memories, and 0 otherwise.
+#ifndef __SYNTHESIS__
+
+#ifndef TestBenches_MemPrintsBinary_h
+#define TestBenches_MemPrintsBinary_h
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "FileReadUtility.h"
+
+struct MemPrintsBinaryHeader
+{
+  char magic[8];          // "MEMPRNTB"
+  uint32_t version;
+  uint32_t base;          // base used to parse the text words
+  uint64_t nEvents;
+  uint64_t nLimbs;        // number of 64-bit limbs per word
+  uint64_t nRecords;
+  uint64_t sourceSize;    // size and modification time of the .dat file,
+  int64_t sourceMTime;    // used to detect a stale binary file
+};
+
+constexpr char kMemPrintsBinaryMagic[8] = {'M','E','M','P','R','N','T','B'};
+constexpr uint32_t kMemPrintsBinaryVersion = 1;
+
+// Name of the binary file cached next to a .dat file
+std::string memPrintsBinaryName(const std::string& file_name)
+{
+  return file_name + ".bin";
+}
+
+// Parse one text word, e.g. "0x1F2A" or "0|101|11", into little-endian limbs
+void parseMemPrintsWord(const char* str, int base, std::vector<uint64_t>& limbs)
+{
+  limbs.assign(1, 0);
+
+  if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X') && base == 16) str += 2;
+  if (str[0] == '0' && (str[1] == 'b' || str[1] == 'B') && base == 2) str += 2;
+
+  for (; *str; ++str) {
+    const char c = *str;
+    int digit;
+    if (c >= '0' && c <= '9') digit = c - '0';
+    else if (c >= 'a' && c <= 'z') digit = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'Z') digit = c - 'A' + 10;
+    else continue; // skip field delimiters such as '|'
+    if (digit >= base) continue;
+
+    // limbs = limbs*base + digit
+    unsigned __int128 carry = digit;
+    for (auto& limb : limbs) {
+      const unsigned __int128 value = (unsigned __int128)limb * base + carry;
+      limb = (uint64_t)value;
+      carry = value >> 64;
+    }
+    if (carry) limbs.push_back((uint64_t)carry);
+  }
+}
+
+// Convert a text MemPrints file into the binary format.
+// Lines are interpreted the same way as in writeMemFromFile: lines with four
+// fields belong to binned memories and start with the bin number, and the
+// data word is always the last field.
+bool convertMemPrintsToBinary(const std::string& txt_name, const std::string& bin_name, int base=16)
+{
+  std::ifstream fin(txt_name);
+  if (not fin.good()) {
+    std::cerr << "Open of file " << txt_name << " failed" << std::endl;
+    return false;
+  }
+
+  std::vector<uint64_t> eventOffset;
+  std::vector<uint64_t> slots;
+  std::vector<std::vector<uint64_t> > words;
+  uint64_t nLimbs = 1;
+
+  std::vector<uint64_t> limbs;
+  std::vector<const char*> fields;
+  for (std::string line; getline(fin, line); ) {
+    if (line.find("Event") != std::string::npos) {
+      eventOffset.push_back(words.size());
+      continue;
+    }
+
+    // Split on spaces in place, without allocating a string per field
+    fields.clear();
+    for (char* c = &line[0]; *c; ++c) {
+      if (*c == ' ' || *c == '\t' || *c == '\r') *c = '\0';
+      else if (c == &line[0] || *(c-1) == '\0') fields.push_back(c);
+    }
+    if (fields.empty()) continue;
+
+    // Data before the first event header belongs to the first event
+    if (eventOffset.empty()) eventOffset.push_back(0);
+
+    slots.push_back(fields.size() == 4 ? strtol(fields.front(), nullptr, base) : 0);
+    parseMemPrintsWord(fields.back(), base, limbs);
+    if (limbs.size() > nLimbs) nLimbs = limbs.size();
+    words.push_back(limbs);
+  }
+  eventOffset.push_back(words.size());
+
+  struct stat st;
+  if (stat(txt_name.c_str(), &st) != 0) return false;
+
+  MemPrintsBinaryHeader header;
+  std::memcpy(header.magic, kMemPrintsBinaryMagic, sizeof(header.magic));
+  header.version = kMemPrintsBinaryVersion;
+  header.base = base;
+  header.nEvents = eventOffset.size() - 1;
+  header.nLimbs = nLimbs;
+  header.nRecords = words.size();
+  header.sourceSize = st.st_size;
+  header.sourceMTime = st.st_mtime;
+
+  // Write to a temporary file first so a concurrent reader never sees a
+  // partially written file
+  const std::string tmp_name = bin_name + ".tmp." + std::to_string(getpid());
+  std::ofstream fout(tmp_name, std::ios::binary);
+  if (not fout.good()) {
+    std::cerr << "Open of file " << tmp_name << " failed" << std::endl;
+    return false;
+  }
+
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fout.write(reinterpret_cast<const char*>(eventOffset.data()), eventOffset.size()*sizeof(uint64_t));
+  for (size_t i = 0; i < words.size(); ++i) {
+    words[i].resize(nLimbs, 0);
+    fout.write(reinterpret_cast<const char*>(&slots[i]), sizeof(uint64_t));
+    fout.write(reinterpret_cast<const char*>(words[i].data()), nLimbs*sizeof(uint64_t));
+  }
+  fout.close();
+
+  if (not fout.good() || rename(tmp_name.c_str(), bin_name.c_str()) != 0) {
+    std::remove(tmp_name.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+// Read-only, memory-mapped view of a binary MemPrints file
+class MemPrintsBinary
+{
+public:
+
+  MemPrintsBinary():
+    data_(nullptr), size_(0), header_(nullptr), eventOffset_(nullptr), records_(nullptr)
+  {}
+
+  // Open a text MemPrints file through its binary cache, converting it
+  // first if the cache is missing or older than the text file
+  explicit MemPrintsBinary(const std::string& file_name, int base=16):
+    MemPrintsBinary()
+  {
+    open(file_name, base);
+  }
+
+  ~MemPrintsBinary() {close();}
+
+  MemPrintsBinary(const MemPrintsBinary&) = delete;
+  MemPrintsBinary& operator=(const MemPrintsBinary&) = delete;
+
+  bool open(const std::string& file_name, int base=16)
+  {
+    close();
+
+    const std::string bin_name = memPrintsBinaryName(file_name);
+    if (map(bin_name) && isCurrent(file_name, base)) return true;
+
+    close();
+    if (not convertMemPrintsToBinary(file_name, bin_name, base)) return false;
+    return map(bin_name);
+  }
+
+  // Map an existing binary file, without checking it against a text file
+  bool map(const std::string& bin_name)
+  {
+    close();
+
+    const int fd = ::open(bin_name.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MemPrintsBinaryHeader)) {
+      ::close(fd);
+      return false;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return false;
+
+    data_ = data;
+    size_ = st.st_size;
+    header_ = static_cast<const MemPrintsBinaryHeader*>(data_);
+
+    const size_t expected = sizeof(MemPrintsBinaryHeader)
+      + (header_->nEvents + 1 + header_->nRecords*(1 + header_->nLimbs))*sizeof(uint64_t);
+    if (std::memcmp(header_->magic, kMemPrintsBinaryMagic, sizeof(header_->magic)) != 0
+        || header_->version != kMemPrintsBinaryVersion || size_ != expected) {
+      close();
+      return false;
+    }
+
+    eventOffset_ = reinterpret_cast<const uint64_t*>(header_ + 1);
+    records_ = eventOffset_ + header_->nEvents + 1;
+
+    return true;
+  }
+
+  void close()
+  {
+    if (data_) munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    eventOffset_ = nullptr;
+    records_ = nullptr;
+  }
+
+  bool good() const {return data_ != nullptr;}
+
+  unsigned int getNEvents() const {return header_->nEvents;}
+  unsigned int getNLimbs() const {return header_->nLimbs;}
+
+  // Number of words in event ievt
+  unsigned int getEntries(int ievt) const
+  {
+    if (ievt < 0 || (uint64_t)ievt >= header_->nEvents) return 0;
+    return eventOffset_[ievt+1] - eventOffset_[ievt];
+  }
+
+  // Records of event ievt, each of 1+getNLimbs() words {slot, limbs...}
+  const uint64_t* getRecords(int ievt) const
+  {
+    if (ievt < 0 || (uint64_t)ievt >= header_->nEvents) return records_;
+    return records_ + eventOffset_[ievt]*(1 + header_->nLimbs);
+  }
+
+private:
+
+  bool isCurrent(const std::string& file_name, int base) const
+  {
+    struct stat st;
+    if (stat(file_name.c_str(), &st) != 0) return true; // binary file only
+    return header_->base == (uint32_t)base
+      && header_->sourceSize == (uint64_t)st.st_size
+      && header_->sourceMTime == (int64_t)st.st_mtime;
+  }
+
+  void* data_;
+  size_t size_;
+  const MemPrintsBinaryHeader* header_;
+  const uint64_t* eventOffset_;
+  const uint64_t* records_;
+
+};
+
+bool openDataFile(MemPrintsBinary& file_in, const std::string& file_name, int base=16)
+{
+  bool success = file_in.open(file_name, base);
+  if (not success) {
+    std::cerr << "Open of file " << file_name << " as binary MemPrints failed" << std::endl;
+    std::cerr << "running from directory " << getcwd(nullptr,0) << std::endl;
+  }
+
+  return success;
+}
+
+// Binary counterpart of writeMemFromFile: fill the BX page of event ievt.
+// Only that page is cleared, so the other pages can be in use elsewhere.
+template<class MemType>
+void writeMemFromFile(MemType& memory, const MemPrintsBinary& fin, int ievt)
+{
+  memory.clear(ievt);
+  memory.write_page(ievt, fin.getRecords(ievt), fin.getEntries(ievt), fin.getNLimbs());
+}
+
+// Binary counterparts of compareMemWithFile and compareBinnedMemWithFile.
+// InputBase is only kept so that the call sites need not change; the base
+// is fixed when the MemPrintsBinary is opened.
+template<class MemType, int InputBase=16, int OutputBase=16, int LSB=-1, int MSB=-1>
+unsigned int compareMemWithFile(const MemType& memory, const MemPrintsBinary& fout,
+                                int ievt, const std::string& label,
+                                const bool truncated = false, int maxProc = kMaxProc)
+{
+  MemType memory_ref;
+  writeMemFromFile<MemType>(memory_ref, fout, ievt);
+
+  return compareMemWithMem<MemType, OutputBase, LSB, MSB>(memory, memory_ref, ievt, label, truncated);
+}
+
+template<class MemType, int InputBase=16, int OutputBase=16>
+unsigned int compareBinnedMemWithFile(const MemType& memory,
+                                      const MemPrintsBinary& fout,
+                                      int ievt, const std::string& label,
+                                      const bool truncated = false, int maxProc = kMaxProc)
+{
+  MemType memory_ref;
+  writeMemFromFile<MemType>(memory_ref, fout, ievt);
+
+  return compareBinnedMemWithMem<MemType, OutputBase>(memory, memory_ref, ievt, label, truncated);
+}
+
+#endif // TestBenches_MemPrintsBinary_h
+
+#endif // __SYNTHESIS__
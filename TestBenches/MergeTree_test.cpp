@@ -0,0 +1,183 @@
+// Test bench for the merge tree of the candidate matches
+//
+// Random events, each with kNMergeTreeInputs CM memories sorted by
+// projection index, are merged by MergeTreeTop, whose output must hold all
+// the candidate matches of the inputs sorted by projection index. There is
+// no emulation output to compare with, as the order of the candidate matches
+// with the same projection index depends on when they reach the tree.
+//
+// The latency and II of the tree are then measured clock by clock for fan-ins
+// from 2 to 32: the latency is the number of steps until the first merged
+// candidate match comes out, and the II the number of steps per candidate
+// match after that, which must be 1.
+#include "MergeTreeTop.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+const int nevents = 100;  // number of events to run
+
+using namespace std;
+
+// Fill the page bx of a memory with n candidate matches of increasing
+// projection index. The stub index is never 0, so that no candidate match is
+// an empty word.
+void fillMemory(CandidateMatchMemory& memory, BXType bx, unsigned int n, vector<string>& words)
+{
+  memory.clear(bx);
+  unsigned int projindex = rand() % 4;
+  for (unsigned int i = 0; i < n; ++i) {
+    projindex += rand() % 3;
+    const CandidateMatch cm(CandidateMatch::CMProjIndex(projindex), CandidateMatch::CMStubIndex(1 + rand() % 127));
+    memory.write_mem(bx, cm.raw().to_string(16).c_str(), 16);
+    words.push_back(cm.raw().to_string(16));
+  }
+}
+
+// Check that the merged words are the input words sorted by projection
+// index. The output memory does not set its number of entries, so the whole
+// page is read and empty words are skipped.
+int checkMerged(const CandidateMatchMemory& merged, BXType bx, vector<string> inputs)
+{
+  int err = 0;
+  vector<string> outputs;
+  CandidateMatch::CMProjIndex last = 0;
+  for (unsigned int i = 0; i < merged.getDepth(); ++i) {
+    const CandidateMatch cm = merged.read_mem(bx, i);
+    if (cm.raw() == 0) continue;
+    if (!outputs.empty() && cm.getProjIndex() < last) {
+      cout << "Candidate match " << i << " out of order: projection index "
+           << cm.getProjIndex() << " after " << last << endl;
+      ++err;
+    }
+    last = cm.getProjIndex();
+    outputs.push_back(cm.raw().to_string(16));
+  }
+
+  sort(inputs.begin(), inputs.end());
+  sort(outputs.begin(), outputs.end());
+  if (inputs != outputs) {
+    cout << "Merged " << outputs.size() << " candidate matches, expected the "
+         << inputs.size() << " of the inputs" << endl;
+    ++err;
+  }
+  return err;
+}
+
+// Latency and II of a tree with NInputs inputs, for an event with
+// nPerInput candidate matches in each input
+struct TreeTiming {
+  unsigned int ninputs;
+  unsigned int nin;       // candidate matches in the inputs
+  unsigned int nout;      // candidate matches merged
+  unsigned int latency;   // steps until the first output
+  unsigned int nsteps;    // steps from the first to the last output
+  bool sorted;
+};
+
+template<unsigned int NInputs>
+TreeTiming measureTree(unsigned int nPerInput)
+{
+  static CandidateMatchMemory memories[NInputs];
+  const BXType bx = 0;
+  vector<string> words;
+  for (unsigned int i = 0; i < NInputs; ++i) fillMemory(memories[i], bx, nPerInput, words);
+
+  MergeTree<CandidateMatch, NInputs> merge;
+  ap_uint<kNBits_MemAddr> addr[NInputs] = {};
+  bool read[NInputs] = {};
+
+  TreeTiming timing = {NInputs, (unsigned int)words.size(), 0, 0, 0, true};
+  CandidateMatch::CMProjIndex last = 0;
+  unsigned int first = 0;
+  for (unsigned int istep = 0; istep < 4 * kMaxProc && timing.nout < timing.nin; ++istep) {
+    CandidateMatch in[NInputs];
+    bool valid[NInputs];
+    for (unsigned int i = 0; i < NInputs; ++i) {
+      if (read[i]) addr[i]++;
+      in[i] = memories[i].read_mem(bx, addr[i]);
+      valid[i] = (addr[i] < memories[i].getEntries(bx));
+    }
+
+    merge.step(in, valid, read);
+
+    if (merge.valid()) {
+      if (timing.nout == 0) first = istep;
+      else if (merge.out().getProjIndex() < last) timing.sorted = false;
+      last = merge.out().getProjIndex();
+      timing.nout++;
+      timing.latency = first + 1;
+      timing.nsteps = istep - first + 1;
+    }
+  }
+  return timing;
+}
+
+int main()
+{
+  // error counts
+  int err = 0;
+
+  static CandidateMatchMemory match[kNMergeTreeInputs];
+  static CandidateMatchMemory merged;
+
+  ///////////////////////////
+  // loop over events
+  cout << "Start event loop ..." << endl;
+  srand(1);
+  for (unsigned int ievt = 0; ievt < nevents; ++ievt) {
+
+    // bx
+    BXType bx = ievt;
+    BXType bx_o;
+
+    // Random inputs, from empty memories to about one candidate match per
+    // clock in total, so that all of them are merged within kMaxProc steps
+    vector<string> inputs;
+    const unsigned int nmax = 1 + (ievt % 4) * (kMaxProc - 2 * kNMergeTreeInputs) / (4 * kNMergeTreeInputs);
+    for (unsigned int i = 0; i < kNMergeTreeInputs; ++i) {
+      fillMemory(match[i], bx, (rand() % 3 == 0) ? 0 : rand() % (nmax + 1), inputs);
+    }
+
+    merged.clear(bx);
+
+    // Unit Under Test
+    MergeTreeTop(bx, match, bx_o, merged);
+
+    // check the merged candidate matches
+    err += checkMerged(merged, bx, inputs);
+
+  } // end of event loop
+
+  ///////////////////////////
+  // latency and II versus fan-in
+  const unsigned int n = 96;
+  const vector<TreeTiming> timings = {
+    measureTree<2>(n / 2), measureTree<4>(n / 4), measureTree<5>(n / 5),
+    measureTree<8>(n / 8), measureTree<12>(n / 12), measureTree<16>(n / 16),
+    measureTree<32>(n / 32)
+  };
+
+  cout << endl << "Merge tree latency and II versus fan-in" << endl
+       << setw(8) << "inputs" << setw(8) << "levels" << setw(8) << "merged"
+       << setw(10) << "latency" << setw(8) << "II" << endl;
+  for (const auto& t : timings) {
+    const unsigned int levels = mergeTreeLevels(t.ninputs);
+    const double ii = t.nout ? double(t.nsteps) / t.nout : 0.;
+    cout << setw(8) << t.ninputs << setw(8) << levels << setw(8) << t.nout
+         << setw(10) << t.latency << setw(8) << fixed << setprecision(2) << ii << endl;
+    if (t.nout != t.nin || !t.sorted || t.nsteps != t.nout) {
+      cout << "Fan-in " << t.ninputs << ": merged " << t.nout << " of " << t.nin
+           << (t.sorted ? "" : ", out of order") << " in " << t.nsteps << " steps" << endl;
+      ++err;
+    }
+  }
+
+  // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
+  if (err > 255) err = 255;
+  return err;
+
+}
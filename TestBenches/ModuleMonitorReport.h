@@ -0,0 +1,194 @@
+// Summary of the ModuleMonitor counters (TrackletAlgorithm/ModuleMonitor.h),
+// used only in test bench for C simulation.
+//
+// printModuleMonitorReport() groups the records of all monitored calls by
+// module type, each call being one event of one module, and prints for each
+// type histograms over the events of the number of busy steps, the number of
+// stalled steps, the number of truncated inputs and the headroom, i.e. the
+// number of steps left after the last busy one. A module whose headroom is
+// often close to zero is about to truncate. It starts with a table of the
+// entries each module type dropped, by cause, to size kMaxProc and the
+// memory depths against the data. Nothing is printed unless the C simulation
+// was compiled with -DMODULE_MONITOR.
+#ifndef __SYNTHESIS__
+
+#ifndef TestBenches_ModuleMonitorReport_h
+#define TestBenches_ModuleMonitorReport_h
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ModuleMonitor.h"
+
+inline std::string moduleName(module::type m)
+{
+  static const char* const names[module::NMODULES] = {"UNKNOWN", "IR", "VMR", "TE", "TC", "PR", "ME", "MC", "TB", "PD"};
+  return (m >= 0 && m < module::NMODULES) ? names[m] : names[module::UNKNOWN];
+}
+
+inline std::string dropName(drop::cause c)
+{
+  static const char* const names[drop::NCAUSES] = {"loop budget", "page full", "bin full"};
+  return names[c];
+}
+
+// Histogram of a per-event count, with either nbins equal bins up to max or,
+// if log2 is set, the bins 0, 1, 2-3, 4-7, ...
+class ModuleHistogram
+{
+public:
+
+  ModuleHistogram(unsigned int max, unsigned int nbins, bool log2 = false):
+    open_(log2), entries_(0), sum_(0), max_(0)
+  {
+    if (log2) {
+      lower_.push_back(0);
+      for (unsigned int lo = 1; lo <= max; lo *= 2) lower_.push_back(lo);
+      lower_.push_back(-1u);
+    } else {
+      if (nbins > max + 1) nbins = max + 1;
+      for (unsigned int i = 0; i <= nbins; ++i) lower_.push_back((max + 1) * i / nbins);
+    }
+    counts_.assign(lower_.size() - 1, 0);
+  }
+
+  void fill(unsigned int x)
+  {
+    unsigned int i = 0;
+    while (i + 1 < counts_.size() && x >= lower_[i + 1]) ++i;
+    ++counts_[i];
+    ++entries_;
+    sum_ += x;
+    if (x > max_) max_ = x;
+  }
+
+  void print(std::ostream& os, const std::string& title) const
+  {
+    constexpr unsigned int kWidth = 40;
+    unsigned int maxCount = 0;
+    for (auto count : counts_) if (count > maxCount) maxCount = count;
+
+    os << "  " << title << ": mean " << std::fixed << std::setprecision(1)
+       << (entries_ ? (double)sum_ / entries_ : 0.) << ", max " << max_ << std::endl;
+    for (unsigned int i = 0; i < counts_.size(); ++i) {
+      const unsigned int hi = lower_[i + 1] - 1;
+      std::string range = std::to_string(lower_[i]);
+      if (hi != lower_[i]) range += (open_ && i + 1 == counts_.size()) ? "+" : "-" + std::to_string(hi);
+      os << "    " << std::setw(9) << range << " " << std::setw(6) << counts_[i] << " "
+         << std::string(maxCount ? (counts_[i] * kWidth + maxCount - 1) / maxCount : 0, '#') << std::endl;
+    }
+  }
+
+private:
+
+  bool open_; // last bin has no upper edge
+  std::vector<unsigned int> lower_;
+  std::vector<unsigned int> counts_;
+  unsigned int entries_;
+  unsigned long sum_;
+  unsigned int max_;
+
+};
+
+#ifdef MODULE_MONITOR_ON
+
+// Entries dropped by each module type: the total for each cause, the number
+// of events (module calls) with drops, and the most dropped in one call and
+// its BX
+inline void printModuleDrops(std::ostream& os, const std::vector<ModuleRecord>& records)
+{
+  os << std::endl << "Module monitor: dropped entries" << std::endl
+     << std::setw(8) << std::left << "Module" << std::right << std::setw(8) << "events";
+  for (int c = 0; c < drop::NCAUSES; ++c) os << std::setw(13) << dropName(drop::cause(c));
+  os << std::setw(12) << "with drops" << std::setw(10) << "max" << std::setw(6) << "BX" << std::endl;
+
+  for (int m = 0; m < module::NMODULES; ++m) {
+    unsigned int ncalls = 0, nwithdrops = 0, maxdrops = 0, maxbx = 0;
+    unsigned long ndropped[drop::NCAUSES] = {0};
+    for (const auto& record : records) {
+      if (record.module != m) continue;
+      ++ncalls;
+      unsigned int n = 0;
+      for (int c = 0; c < drop::NCAUSES; ++c) {
+        ndropped[c] += record.getNDropped(drop::cause(c));
+        n += record.getNDropped(drop::cause(c));
+      }
+      nwithdrops += (n > 0);
+      if (n > maxdrops) {
+        maxdrops = n;
+        maxbx = record.bx;
+      }
+    }
+    if (ncalls == 0) continue;
+
+    os << std::setw(8) << std::left << moduleName(module::type(m)) << std::right << std::setw(8) << ncalls;
+    for (int c = 0; c < drop::NCAUSES; ++c) os << std::setw(13) << ndropped[c];
+    os << std::setw(12) << nwithdrops << std::setw(10) << maxdrops;
+    if (maxdrops > 0) os << std::setw(6) << maxbx;
+    os << std::endl;
+  }
+}
+
+#endif
+
+inline void printModuleMonitorReport(std::ostream& os = std::cout)
+{
+#ifdef MODULE_MONITOR_ON
+  std::lock_guard<std::mutex> lock(moduleRecordsMutex());
+  const auto& records = moduleRecords();
+  if (records.empty()) return;
+
+  printModuleDrops(os, records);
+
+  os << std::endl << "Module monitor: per event histograms of the main loop of each module" << std::endl;
+
+  module::type closest = module::UNKNOWN;
+  double closestFraction = -1.;
+  for (int m = 0; m < module::NMODULES; ++m) {
+    unsigned int nsteps = 0, ncalls = 0;
+    for (const auto& record : records) {
+      if (record.module != m) continue;
+      if (record.getNSteps() > nsteps) nsteps = record.getNSteps();
+      ++ncalls;
+    }
+    if (ncalls == 0) continue;
+
+    ModuleHistogram busy(nsteps, 10), stalled(nsteps, 10), truncated(nsteps, 0, true), headroom(nsteps, 10);
+    unsigned int ntruncated = 0, nlastbusy = 0;
+    for (const auto& record : records) {
+      if (record.module != m) continue;
+      busy.fill(record.getNBusy());
+      stalled.fill(record.getNStalled());
+      truncated.fill(record.getNTruncated());
+      headroom.fill(record.getHeadroom());
+      ntruncated += (record.getNTruncated() > 0);
+      nlastbusy += (record.getNSteps() > 0 && record.getHeadroom() == 0);
+    }
+
+    os << std::endl << moduleName(module::type(m)) << ": " << ncalls << " events, "
+       << nsteps << " steps, truncated in " << ntruncated << ", busy in the last step in " << nlastbusy << std::endl;
+    busy.print(os, "busy steps");
+    stalled.print(os, "stalled steps");
+    truncated.print(os, "truncated inputs");
+    headroom.print(os, "steps left after the last busy one");
+
+    const double fraction = (double)(ntruncated + nlastbusy) / (2 * ncalls);
+    if (fraction > closestFraction) {
+      closest = module::type(m);
+      closestFraction = fraction;
+    }
+  }
+
+  if (closestFraction > 0) {
+    os << std::endl << "Closest to truncating: " << moduleName(closest) << std::endl;
+  }
+#else
+  (void)os; // nothing is recorded without MODULE_MONITOR_ON
+#endif
+}
+
+#endif // TestBenches_ModuleMonitorReport_h
+
+#endif // __SYNTHESIS__
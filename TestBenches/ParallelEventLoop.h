@@ -0,0 +1,97 @@
+// Event-parallel event loop used only in test bench for C simulation.
+//
+// Events are independent of each other in the test benches, so they can be
+// processed concurrently as long as every thread works on its own set of
+// memories. runEventLoop() creates one MemorySet per worker thread, hands
+// out the events to the workers, and returns the sum of the error counts
+// returned for each event. The printout of each event is buffered and
+// written out in event order once all events have been processed, so the
+// log does not depend on the number of threads.
+//
+// The input and reference files must support random access to an event,
+// i.e. MemPrintsBinary, or std::ifstream together with a MemPrintsIndex.
+#ifndef __SYNTHESIS__
+
+#ifndef TestBenches_ParallelEventLoop_h
+#define TestBenches_ParallelEventLoop_h
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FileReadUtility.h"
+
+// Number of worker threads: $TB_NTHREADS if set, otherwise the number of
+// cores. The RTL co-simulation wrapper of the top function is not
+// reentrant, so co-simulation always runs on a single thread.
+unsigned int getNThreads()
+{
+#ifdef __RTL_SIMULATION__
+  return 1;
+#else
+  const char* env = std::getenv("TB_NTHREADS");
+  if (env && std::atoi(env) > 0) return std::atoi(env);
+
+  const unsigned int ncores = std::thread::hardware_concurrency();
+  return (ncores > 0) ? ncores : 1;
+#endif
+}
+
+// processEvent(MemorySet& memories, int ievt) processes event ievt using
+// the memories of the calling thread, and returns its error count.
+// Everything it prints should go to tbout().
+template<class MemorySet, class EventFunction>
+unsigned int runEventLoop(int nevents, EventFunction processEvent, unsigned int nthreads = getNThreads())
+{
+  if (nevents <= 0) return 0;
+  if (nthreads > (unsigned int)nevents) nthreads = nevents;
+
+  // Single thread: process the events in order and print directly
+  if (nthreads <= 1) {
+    std::unique_ptr<MemorySet> memories(new MemorySet());
+    unsigned int err_count = 0;
+    for (int ievt = 0; ievt < nevents; ++ievt) {
+      err_count += processEvent(*memories, ievt);
+    }
+    return err_count;
+  }
+
+  std::vector<unsigned int> err(nevents, 0);
+  std::vector<std::string> log(nevents);
+  std::atomic<int> next_event(0);
+
+  auto worker = [&]() {
+    // Memories are allocated on the heap, as a full set can be too large
+    // for the stack of a thread
+    std::unique_ptr<MemorySet> memories(new MemorySet());
+
+    for (int ievt = next_event++; ievt < nevents; ievt = next_event++) {
+      std::ostringstream out;
+      tbStream() = &out;
+      err[ievt] = processEvent(*memories, ievt);
+      tbStream() = &std::cout;
+      log[ievt] = out.str();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < nthreads; ++i) threads.emplace_back(worker);
+  for (auto& thread : threads) thread.join();
+
+  unsigned int err_count = 0;
+  for (int ievt = 0; ievt < nevents; ++ievt) {
+    std::cout << log[ievt];
+    err_count += err[ievt];
+  }
+
+  return err_count;
+}
+
+#endif // TestBenches_ParallelEventLoop_h
+
+#endif // __SYNTHESIS__
@@ -1,118 +1,131 @@
 // Test bench for ProjectionRouter
+// The region is chosen with -DPR_REGION_<region> in the CFLAGS, see script_PR.tcl,
+// as PR_<region> is the label of the module in the top function
+#if defined PR_REGION_D1PHIA
+#include "ProjectionRouterTop_D1PHIA.h"
+const char* const region = "D1PHIA";
+#else
 #include "ProjectionRouterTop.h"
+const char* const region = "L3PHIC";
+#endif
 
 #include <algorithm>
+#include <cmath>
 #include <iterator>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
 
 #include "FileReadUtility.h"
+#include "ModuleMonitorReport.h"
 #include "Constants.h"
 
 const int nevents = 100;  //number of events to run
 
 using namespace std;
 
+// Names of the files in dir that start with prefix and end with suffix, sorted
+vector<string> findDataFiles(const string& dir, const string& prefix, const string& suffix)
+{
+  vector<string> names;
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) return names;
+  while (const dirent* entry = readdir(d)) {
+    const string name = entry->d_name;
+    if (name.size() >= prefix.size() + suffix.size()
+        && name.compare(0, prefix.size(), prefix) == 0
+        && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+      names.push_back(name);
+  }
+  closedir(d);
+  sort(names.begin(), names.end());
+  return names;
+}
+
+// Compare the r position of the disk projections, computed with a
+// multiplication and a shift, with the division by the width of an rbin, for
+// all the r from rbins_rmin to rbins_rmax. Returns the number of differences.
+int checkDiskRBinPosition()
+{
+  using namespace PR;
+  constexpr int nrbits = TrackletProjection<DISK>::BitWidths::kTProjRZSize;
+  constexpr unsigned int nbins = 1 << (MEBinsBits+rbins_nbitsextra);
+
+  int nerr = 0;
+  if (abs(rbins_rmin*krprojdisk - rmindiskvm) > krprojdisk || abs(rbins_rmax*krprojdisk - rmaxdisk) > krprojdisk) {
+    cerr << "rbins_rmin " << rbins_rmin << " or rbins_rmax " << rbins_rmax << " do not match rmindiskvm or rmaxdisk" << endl;
+    ++nerr;
+  }
+  for (unsigned int ir = rbins_rmin; ir < rbins_rmax; ++ir) {
+    const unsigned int expected = (ir-rbins_rmin) * nbins / (rbins_rmax-rbins_rmin);
+    const unsigned int rbinpos = getDiskRBinPosition<nrbits>(ap_uint<nrbits>(ir-rbins_rmin));
+    if (rbinpos != expected) {
+      cerr << "r " << ir << ": r position " << rbinpos << ", expected " << expected << endl;
+      ++nerr;
+    }
+  }
+  return nerr;
+}
+
 int main()
-{ 
+{
   // error counts
   int err = 0;
 
+  if (kProjTypePR == DISK) err += checkDiskRBinPosition();
+
   ///////////////////////////
   // input memories
-  static TrackletProjectionMemory<BARRELPS> tprojarray[8];
+  static TrackletProjectionMemory<kProjTypePR> tprojarray[kNInMemPR];
 
   // output memories
-  static AllProjectionMemory<BARRELPS> allproj;
-  static VMProjectionMemory<BARREL> vmprojarray[8];
+  static AllProjectionMemory<kProjTypePR> allproj;
+  static VMProjectionMemory<kVMProjTypePR> vmprojarray[kNOutMemPR];
 
   ///////////////////////////
   // open input files
+  // The inputs are all the tracklet projections to the region, in the order
+  // of their names, e.g. TPROJ_L1L2F_L3PHIC to TPROJ_L5L6D_L3PHIC.
   cout << "Open files..." << endl;
 
-  ifstream fin_tproj1;
-  bool validin1 = openDataFile(fin_tproj1, "PR_L3PHIC/TrackletProjections_TPROJ_L1L2F_L3PHIC_04.dat");
-  if (not validin1) return -1;
+  const string dir = string("PR_") + region;
 
-  ifstream fin_tproj2;
-  bool validin2 = openDataFile(fin_tproj2, "PR_L3PHIC/TrackletProjections_TPROJ_L1L2G_L3PHIC_04.dat");
-  if (not validin2) return -1;
+  const vector<string> inNames = findDataFiles(dir, "TrackletProjections_TPROJ_", string("_") + region + "_04.dat");
+  if (inNames.size() != kNInMemPR) {
+    cerr << "Found " << inNames.size() << " input files in " << dir << ", expected " << kNInMemPR << endl;
+    return -1;
+  }
 
-  ifstream fin_tproj3;
-  bool validin3 = openDataFile(fin_tproj3, "PR_L3PHIC/TrackletProjections_TPROJ_L1L2H_L3PHIC_04.dat");
-  if (not validin3) return -1;
-
-  ifstream fin_tproj4;
-  bool validin4 = openDataFile(fin_tproj4, "PR_L3PHIC/TrackletProjections_TPROJ_L1L2I_L3PHIC_04.dat");
-  if (not validin4) return -1;
-
-  ifstream fin_tproj5;
-  bool validin5 = openDataFile(fin_tproj5, "PR_L3PHIC/TrackletProjections_TPROJ_L1L2J_L3PHIC_04.dat");
-  if (not validin5) return -1;
-
-  ifstream fin_tproj6;
-  bool validin6 = openDataFile(fin_tproj6, "PR_L3PHIC/TrackletProjections_TPROJ_L5L6B_L3PHIC_04.dat");
-  if (not validin6) return -1;
-
-  ifstream fin_tproj7;
-  bool validin7 = openDataFile(fin_tproj7, "PR_L3PHIC/TrackletProjections_TPROJ_L5L6C_L3PHIC_04.dat");
-  if (not validin7) return -1;
-
-  ifstream fin_tproj8;
-  bool validin8 = openDataFile(fin_tproj8, "PR_L3PHIC/TrackletProjections_TPROJ_L5L6D_L3PHIC_04.dat");
-  if (not validin8) return -1;
+  ifstream fin_tproj[kNInMemPR];
+  for (unsigned int i = 0; i < inNames.size(); ++i) {
+    if (not openDataFile(fin_tproj[i], dir + "/" + inNames[i])) return -1;
+  }
 
   ///////////////////////////
   // open output files
   ifstream fout_aproj;
-  bool valid_aproj = openDataFile(fout_aproj, "PR_L3PHIC/AllProj_AP_L3PHIC_04.dat");
+  bool valid_aproj = openDataFile(fout_aproj, dir + "/AllProj_AP_" + region + "_04.dat");
   if (not valid_aproj) return -1;
 
-  ifstream fout_vmproj1;
-  bool valid_vmproj1 =  openDataFile(fout_vmproj1, "PR_L3PHIC/VMProjections_VMPROJ_L3PHIC17_04.dat");
-  if (not valid_vmproj1) return -1;
-
-  ifstream fout_vmproj2;
-  bool valid_vmproj2 = openDataFile(fout_vmproj2, "PR_L3PHIC/VMProjections_VMPROJ_L3PHIC18_04.dat");
-  if (not valid_vmproj2) return -1;
-
-  ifstream fout_vmproj3;
-  bool valid_vmproj3 = openDataFile(fout_vmproj3, "PR_L3PHIC/VMProjections_VMPROJ_L3PHIC19_04.dat");
-  if (not valid_vmproj3) return -1;
+  // VM projections, numbered from 1 to nvm within the region
+  const unsigned int ivmfirst = (dir.back() - 'A') * kNOutMemPR + 1;
+  ifstream fout_vmproj[kNOutMemPR];
+  for (unsigned int i = 0; i < kNOutMemPR; ++i) {
+    const string name = dir + "/VMProjections_VMPROJ_" + region + to_string(ivmfirst + i) + "_04.dat";
+    if (not openDataFile(fout_vmproj[i], name)) return -1;
+  }
 
-  ifstream fout_vmproj4;
-  bool valid_vmproj4 = openDataFile(fout_vmproj4, "PR_L3PHIC/VMProjections_VMPROJ_L3PHIC20_04.dat");
-  if (not valid_vmproj4) return -1;
-
-  ifstream fout_vmproj5;
-  bool valid_vmproj5 =  openDataFile(fout_vmproj5, "PR_L3PHIC/VMProjections_VMPROJ_L3PHIC21_04.dat");
-  if (not valid_vmproj5) return -1;
-
-  ifstream fout_vmproj6;
-  bool valid_vmproj6 = openDataFile(fout_vmproj6, "PR_L3PHIC/VMProjections_VMPROJ_L3PHIC22_04.dat");
-  if (not valid_vmproj6) return -1;
-
-  ifstream fout_vmproj7;
-  bool valid_vmproj7 = openDataFile(fout_vmproj7, "PR_L3PHIC/VMProjections_VMPROJ_L3PHIC23_04.dat");
-  if (not valid_vmproj7) return -1;
-
-  ifstream fout_vmproj8;
-  bool valid_vmproj8 = openDataFile(fout_vmproj8, "PR_L3PHIC/VMProjections_VMPROJ_L3PHIC24_04.dat");
-  if (not valid_vmproj8) return -1;
-
-  ///////////////////////////  
+  ///////////////////////////
   // loop over events
   cout << "Start event loop ..." << endl;
   for (unsigned int ievt = 0; ievt < nevents; ++ievt) {
     cout << "Event: " << dec << ievt << endl;
 
     // read event and write to memories
-    writeMemFromFile<TrackletProjectionMemory<BARRELPS> >(tprojarray[0], fin_tproj1, ievt);
-    writeMemFromFile<TrackletProjectionMemory<BARRELPS> >(tprojarray[1], fin_tproj2, ievt);
-    writeMemFromFile<TrackletProjectionMemory<BARRELPS> >(tprojarray[2], fin_tproj3, ievt);
-    writeMemFromFile<TrackletProjectionMemory<BARRELPS> >(tprojarray[3], fin_tproj4, ievt);
-    writeMemFromFile<TrackletProjectionMemory<BARRELPS> >(tprojarray[4], fin_tproj5, ievt);
-    writeMemFromFile<TrackletProjectionMemory<BARRELPS> >(tprojarray[5], fin_tproj6, ievt);
-    writeMemFromFile<TrackletProjectionMemory<BARRELPS> >(tprojarray[6], fin_tproj7, ievt);
-    writeMemFromFile<TrackletProjectionMemory<BARRELPS> >(tprojarray[7], fin_tproj8, ievt);
+    for (unsigned int i = 0; i < inNames.size(); ++i) {
+      writeMemFromFile<TrackletProjectionMemory<kProjTypePR> >(tprojarray[i], fin_tproj[i], ievt);
+    }
 
     // bx
     BXType bx = ievt;
@@ -120,7 +133,7 @@ int main()
 
     // Clear output memories
     allproj.clear();
-    for (unsigned int imem = 0; imem<8; imem++) {
+    for (unsigned int imem = 0; imem<kNOutMemPR; imem++) {
       vmprojarray[imem].clear();
     }
 
@@ -130,44 +143,21 @@ int main()
     // compare the computed outputs with the expected ones
     bool truncation = false;
     // AllProjection
-    err += compareMemWithFile<AllProjectionMemory<BARRELPS> >
+    err += compareMemWithFile<AllProjectionMemory<kProjTypePR> >
       (allproj,fout_aproj, ievt, "AllProjection", truncation);
-    // VMProjection1
-    err += compareMemWithFile<VMProjectionMemory<BARREL> >
-      (vmprojarray[0], fout_vmproj1, ievt, "VMProjection1", truncation);
-
-    // VMProjection2
-    err += compareMemWithFile<VMProjectionMemory<BARREL> >
-      (vmprojarray[1], fout_vmproj2, ievt, "VMProjection2", truncation);
-
-    // VMProjection3
-    err += compareMemWithFile<VMProjectionMemory<BARREL> >
-      (vmprojarray[2], fout_vmproj3, ievt, "VMProjection3", truncation);
-
-    // VMProjection4
-    err += compareMemWithFile<VMProjectionMemory<BARREL> >
-      (vmprojarray[3], fout_vmproj4, ievt, "VMProjection4", truncation);
-
-    // VMProjection5
-    err += compareMemWithFile<VMProjectionMemory<BARREL> >
-      (vmprojarray[4], fout_vmproj5, ievt, "VMProjection5", truncation);
-
-    // VMProjection6
-    err += compareMemWithFile<VMProjectionMemory<BARREL> >
-      (vmprojarray[5], fout_vmproj6, ievt, "VMProjection6", truncation);
-
-    // VMProjection7
-    err += compareMemWithFile<VMProjectionMemory<BARREL> >
-      (vmprojarray[6], fout_vmproj7, ievt, "VMProjection7", truncation);
-
-    // VMProjection8
-    err += compareMemWithFile<VMProjectionMemory<BARREL> >
-      (vmprojarray[7], fout_vmproj8, ievt, "VMProjection8", truncation);
-    
+
+    // VMProjections
+    for (unsigned int i = 0; i < kNOutMemPR; ++i) {
+      err += compareMemWithFile<VMProjectionMemory<kVMProjTypePR> >
+        (vmprojarray[i], fout_vmproj[i], ievt, "VMProjection" + to_string(i + 1), truncation);
+    }
+
   } // end of event loop
-  
+
+  printModuleMonitorReport();
+
   // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
   if (err > 255) err = 255;
   return err;
-  
+
 }
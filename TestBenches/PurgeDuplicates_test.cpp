@@ -0,0 +1,134 @@
+// Test bench for PurgeDuplicates
+#include "PurgeDuplicatesTop.h"
+
+#include "FileReadUtility.h"
+#include "ModuleMonitorReport.h"
+#include "Constants.h"
+
+const int nevents = 100;  //number of events to run
+
+using namespace std;
+
+int main()
+{
+  // error counts
+  int err = 0;
+
+  // input and output arrays
+  static TrackFit::TrackWord trackWord[kMaxProc];
+  static TrackFit::BarrelStubWord barrelStubWords[4][kMaxProc];
+  static TrackFit::DiskStubWord diskStubWords[4][kMaxProc];
+  static TrackFit::TrackWord trackWord_o[kMaxProc];
+  static TrackFit::BarrelStubWord barrelStubWords_o[4][kMaxProc];
+  static TrackFit::DiskStubWord diskStubWords_o[4][kMaxProc];
+
+  // input and output memories, i.e. the same tracks as in the .dat files
+  static TrackFitMemory tracksMem;
+  static TrackFitMemory cleanTracksMem;
+  static TrackFitMemory cleanTracksMem_ref;
+
+  ///////////////////////////
+  // open input files
+  cout << "Open files..." << endl;
+
+  const string dir = "PD";
+
+  ifstream fin_tracks;
+  if (not openDataFile(fin_tracks, dir + "/TrackFit_TF_L1L2_04.dat")) return -1;
+
+  ///////////////////////////
+  // open output files
+  ifstream fout_cleanTracks;
+  if (not openDataFile(fout_cleanTracks, dir + "/CleanTrack_CT_L1L2_04.dat")) return -1;
+
+  unsigned nTracksIn = 0, nTracksOut = 0, nTracksRef = 0;
+
+  ///////////////////////////
+  // loop over events
+  cout << "Start event loop ..." << endl;
+  for (unsigned int ievt = 0; ievt < nevents; ++ievt) {
+    cout << "Event: " << dec << ievt << endl;
+
+    // bx
+    BXType bx = ievt;
+    BXType bx_o;
+
+    // read event and write to the input arrays, as TrackBuilder does
+    writeMemFromFile<TrackFitMemory>(tracksMem, fin_tracks, ievt);
+    for (unsigned short i = 0; i < kMaxProc; i++) {
+      const bool valid = (i < tracksMem.getEntries(bx));
+      const TrackFit track = valid ? tracksMem.read_mem(bx, i) : TrackFit();
+      trackWord[i] = track.getTrackWord();
+      barrelStubWords[0][i] = track.getBarrelStubWord<0>();
+      barrelStubWords[1][i] = track.getBarrelStubWord<1>();
+      barrelStubWords[2][i] = track.getBarrelStubWord<2>();
+      barrelStubWords[3][i] = track.getBarrelStubWord<3>();
+      diskStubWords[0][i] = track.getDiskStubWord<4>();
+      diskStubWords[1][i] = track.getDiskStubWord<5>();
+      diskStubWords[2][i] = track.getDiskStubWord<6>();
+      diskStubWords[3][i] = track.getDiskStubWord<7>();
+      nTracksIn += track.getTrackValid();
+    }
+
+    // Clear all output memories before starting.
+    for (unsigned short i = 0; i < kMaxProc; i++) {
+      trackWord_o[i] = TrackFit::TrackWord(0);
+      for (unsigned short j = 0; j < 4; j++) {
+        barrelStubWords_o[j][i] = TrackFit::BarrelStubWord(0);
+        diskStubWords_o[j][i] = TrackFit::DiskStubWord(0);
+      }
+    }
+    cleanTracksMem.clear();
+
+    // Unit Under Test
+    PurgeDuplicates_L1L2(bx,
+      trackWord,
+      barrelStubWords,
+      diskStubWords,
+      bx_o,
+      trackWord_o,
+      barrelStubWords_o,
+      diskStubWords_o
+    );
+
+    unsigned nTracks = 0;
+    for (unsigned short i = 0; i < kMaxProc; i++) {
+      TrackFit track;
+      track.setTrackWord(trackWord_o[i]);
+      track.setBarrelStubWord<0>(barrelStubWords_o[0][i]);
+      track.setBarrelStubWord<1>(barrelStubWords_o[1][i]);
+      track.setBarrelStubWord<2>(barrelStubWords_o[2][i]);
+      track.setBarrelStubWord<3>(barrelStubWords_o[3][i]);
+      track.setDiskStubWord<4>(diskStubWords_o[0][i]);
+      track.setDiskStubWord<5>(diskStubWords_o[1][i]);
+      track.setDiskStubWord<6>(diskStubWords_o[2][i]);
+      track.setDiskStubWord<7>(diskStubWords_o[3][i]);
+      if (track.getTrackValid())
+        cleanTracksMem.write_mem(bx, track, nTracks++);
+    }
+    nTracksOut += nTracks;
+
+    // compare the computed outputs with the expected ones: all the tracks
+    // kept by the emulation must be kept, and no other
+    writeMemFromFile<TrackFitMemory>(cleanTracksMem_ref, fout_cleanTracks, ievt);
+    err += compareMemWithMem<TrackFitMemory>(cleanTracksMem, cleanTracksMem_ref, ievt, "\nClean track");
+    if (nTracks != cleanTracksMem_ref.getEntries(bx)) {
+      cout << "Event " << ievt << ": " << nTracks << " clean tracks, expected "
+           << cleanTracksMem_ref.getEntries(bx) << endl;
+      ++err;
+    }
+    nTracksRef += cleanTracksMem_ref.getEntries(bx);
+    cout << endl;
+
+  } // end of event loop
+
+  cout << "Tracks in: " << nTracksIn << ", out: " << nTracksOut << " (expected " << nTracksRef
+       << "), duplicates removed: " << (nTracksIn ? 100. * (nTracksIn - nTracksOut) / nTracksIn : 0.) << "%" << endl;
+
+  printModuleMonitorReport();
+
+  // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
+  if (err > 255) err = 255;
+  return err;
+
+}
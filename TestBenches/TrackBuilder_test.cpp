@@ -6,6 +6,7 @@
 #include <cstring>
 
 #include "FileReadUtility.h"
+#include "ModuleMonitorReport.h"
 #include "Constants.h"
 
 const int nevents = 100;  //number of events to run
@@ -290,6 +291,8 @@ int main()
 
   } // end of event loop
 
+  printModuleMonitorReport();
+
   // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
   if (err > 255) err = 255;
   return err;
@@ -4,6 +4,10 @@
 #include "VMStubTEInnerMemory.h"
 #include "VMStubTEOuterMemory.h"
 #include "FileReadUtility.h"
+#include "MemPrintsBinary.h"
+#include "LookupTableFile.h"
+#include "ParallelEventLoop.h"
+#include "ModuleMonitorReport.h"
 #include "hls_math.h"
 
 #include <iostream>
@@ -16,61 +20,57 @@ const int nevents = 100;  // number of events to run
 
 using namespace std;
 
-int main(){
-  // error counter
-  int err_count = 0;
-  
-  // declare input memory arrays to be read from emulations files
+// memories used by each thread of the event loop
+struct TrackletEngineMemories {
+  // input memory arrays to be read from emulations files
   VMStubTEInnerMemory<BARRELPS> inputvmstubsinner;
   VMStubTEOuterMemory<BARRELPS> inputvmstubsouter;
-  //StubPairMemory inputstubpairs;
-
-  // declare the output memory array for the sub pairs
-  StubPairMemory outputstubpairs; //produced by hls simulation
 
+  // output memory array for the sub pairs, produced by hls simulation
+  StubPairMemory outputstubpairs;
+};
 
+int main(){
   // open input files from emulation
-  ifstream fin_vmstubsinner("../../../../../emData/TE/TE_L1PHIE18_L2PHIC17/VMStubs_VMSTE_L1PHIE18n2_04.dat");
-  ifstream fin_vmstubsouter("../../../../../emData/TE/TE_L1PHIE18_L2PHIC17/VMStubs_VMSTE_L2PHIC17n4_04.dat");
-  ifstream fin_stubpairs("../../../../../emData/TE/TE_L1PHIE18_L2PHIC17/StubPairs_SP_L1PHIE18_L2PHIC17_04.dat");  
+  MemPrintsBinary fin_vmstubsinner("../../../../../emData/TE/TE_L1PHIE18_L2PHIC17/VMStubs_VMSTE_L1PHIE18n2_04.dat");
+  MemPrintsBinary fin_vmstubsouter("../../../../../emData/TE/TE_L1PHIE18_L2PHIC17/VMStubs_VMSTE_L2PHIC17n4_04.dat");
+  MemPrintsBinary fin_stubpairs("../../../../../emData/TE/TE_L1PHIE18_L2PHIC17/StubPairs_SP_L1PHIE18_L2PHIC17_04.dat");  
   assert(fin_vmstubsinner.good());
   assert(fin_vmstubsouter.good());
   assert(fin_stubpairs.good());
 
-  ap_uint<1> bendinnertable[256] =
-#include "../emData/TE/tables/TE_L1PHIE18_L2PHIC17_stubptinnercut.tab"
-  ap_uint<1> bendoutertable[256] =
-#include "../emData/TE/tables/TE_L1PHIE18_L2PHIC17_stubptoutercut.tab"
+  ap_uint<1> bendinnertable[256], bendoutertable[256];
+  if (not readLookupTable("../../../../../emData/TE/tables/TE_L1PHIE18_L2PHIC17_stubptinnercut.tab", bendinnertable, 256)
+      || not readLookupTable("../../../../../emData/TE/tables/TE_L1PHIE18_L2PHIC17_stubptoutercut.tab", bendoutertable, 256)) {
+    return -1;
+  }
 
-  // loop over events
-  for (int ievt = 0; ievt < nevents; ++ievt) {
-    cout << "Event: " << dec << ievt << endl;
+  // loop over events, in parallel
+  int err_count = runEventLoop<TrackletEngineMemories>(nevents, [&](TrackletEngineMemories& mem, int ievt) {
+    tbout() << "Event: " << dec << ievt << endl;
 
-    outputstubpairs.clear();
+    mem.outputstubpairs.clear();
 
     //read next event from the input files
-    writeMemFromFile<VMStubTEInnerMemory<BARRELPS> >(inputvmstubsinner, fin_vmstubsinner,ievt);
-    writeMemFromFile<VMStubTEOuterMemory<BARRELPS> >(inputvmstubsouter, fin_vmstubsouter,ievt);
+    writeMemFromFile<VMStubTEInnerMemory<BARRELPS> >(mem.inputvmstubsinner, fin_vmstubsinner, ievt);
+    writeMemFromFile<VMStubTEOuterMemory<BARRELPS> >(mem.inputvmstubsouter, fin_vmstubsouter, ievt);
 
     //set the bunch crossing
     BXType bx=ievt&0x7;
     BXType bx_o;
 
     // Unit Under Test
-    TrackletEngineTop(bx, inputvmstubsinner, inputvmstubsouter, bendinnertable, bendoutertable, bx_o, outputstubpairs);
+    TrackletEngineTop(bx, mem.inputvmstubsinner, mem.inputvmstubsouter, bendinnertable, bendoutertable, bx_o, mem.outputstubpairs);
 
     bool truncation = false;
 
     // compare calculated outputs with those read from emulation printout
-    err_count += compareMemWithFile<StubPairMemory>(outputstubpairs,fin_stubpairs,ievt,"StubPair",truncation);
+    return compareMemWithFile<StubPairMemory>(mem.outputstubpairs, fin_stubpairs, ievt, "StubPair", truncation);
+
+  });  // end of event loop
 
-  }  // end of event loop
+  printModuleMonitorReport();
 
-  // close files
-  fin_vmstubsinner.close();
-  fin_vmstubsouter.close();
-  fin_stubpairs.close();
-  
   // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
   if (err_count > 255) err_count = 255;
   return err_count;
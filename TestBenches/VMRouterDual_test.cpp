@@ -0,0 +1,161 @@
+// Test bench for the VMRouter routing two stubs per clock
+//
+// Random events of stubs in the input memories of the region of
+// VMRouterTop.h are routed by VMRouterDualTop and by VMRouterTop. The events
+// range from empty ones to ones above the kMaxProc stubs VMRouterTop routes.
+// VMRouterDualTop must write the same entries as VMRouterTop, at the same
+// addresses, and, from the stubs VMRouterTop has no time for, only entries
+// that VMRouterTop leaves empty. Its AllStub memories must have all the
+// stubs, up to the depth of the memories, in the order of the inputs.
+#include "VMRouterTop.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const int nevents = 100;  // number of events to run
+
+// Maximum number of stubs per input memory
+const int maxInputStubs = 48;
+
+using namespace std;
+
+// Compare the whole pages of two memories, as the entries are not counted.
+// The entries past the stubs of the reference are only compared if it
+// routed all the stubs.
+template<class MemType>
+int compareMemories(int ievt, const string& name, BXType bx, const MemType& mem, const MemType& mem_ref, bool all)
+{
+  int err = 0;
+  for (unsigned int k = 0; k < mem.getDepth(); ++k) {
+    const auto word = mem.read_mem(bx, k).raw();
+    const auto word_ref = mem_ref.read_mem(bx, k).raw();
+    if ((word_ref != 0 || all) && word != word_ref) {
+      cout << "Event " << ievt << ", " << name << ", entry " << k
+           << ": " << word.to_string(16) << ", expected " << word_ref.to_string(16) << endl;
+      ++err;
+    }
+  }
+  return err;
+}
+
+int main()
+{
+  // error counts
+  int err = 0;
+
+  static InputStubMemory<inputType> inputStub[numInputs];
+
+  static AllStubMemory<outputType> memoriesAS[maxASCopies];
+  static VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME];
+  static VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies];
+  static VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies];
+
+  static AllStubMemory<outputType> memoriesAS_ref[maxASCopies];
+  static VMStubMEMemory<outputType, nbitsbin> memoriesME_ref[nvmME];
+  static VMStubTEInnerMemory<outputType> memoriesTEI_ref[nvmTEI][maxTEICopies];
+  static VMStubTEInnerMemory<BARRELOL> memoriesOL_ref[nvmOL][maxOLCopies];
+
+  // Number of events above kMaxProc stubs
+  int nfull = 0;
+
+  ///////////////////////////
+  // loop over events
+  cout << "Start event loop ..." << endl;
+  srand(1);
+  for (int ievt = 0; ievt < nevents; ++ievt) {
+
+    // bx
+    BXType bx = ievt&0x7;
+    BXType bx_o;
+
+    // Random stubs, in the order they are read
+    vector<InputStub<inputType> > stubs;
+    for (int i = 0; i < numInputs; ++i) {
+      const int nstubs = rand() % (maxInputStubs + 1);
+      uint64_t records[2*maxInputStubs];
+      for (int j = 0; j < nstubs; ++j) {
+        ap_uint<InputStub<inputType>::getWidth()> word = 0;
+        for (int k = 0; k < word.length(); k += 16) {
+          const int msb = (k + 15 < word.length()) ? k + 15 : word.length() - 1;
+          word.range(msb, k) = rand();
+        }
+        word[0] = 1;
+        records[2*j] = j;
+        records[2*j+1] = word.to_uint64();
+        stubs.push_back(InputStub<inputType>(word));
+      }
+      inputStub[i].clear();
+      inputStub[i].write_page(bx, records, nstubs, 1);
+    }
+    const bool all = (stubs.size() <= kMaxProc);
+    if (not all) ++nfull;
+
+    for (int i = 0; i < maxASCopies; ++i) {
+      memoriesAS[i].clear();
+      memoriesAS_ref[i].clear();
+    }
+    for (int i = 0; i < nvmME; ++i) {
+      memoriesME[i].clear();
+      memoriesME_ref[i].clear();
+    }
+    for (int i = 0; i < nvmTEI; ++i) {
+      for (int j = 0; j < maxTEICopies; ++j) {
+        memoriesTEI[i][j].clear();
+        memoriesTEI_ref[i][j].clear();
+      }
+    }
+    for (int i = 0; i < nvmOL; ++i) {
+      for (int j = 0; j < maxOLCopies; ++j) {
+        memoriesOL[i][j].clear();
+        memoriesOL_ref[i][j].clear();
+      }
+    }
+
+    // Unit Under Test
+    VMRouterDualTop(bx, bx_o, inputStub,
+      memoriesAS, memoriesME, memoriesTEI, memoriesOL);
+
+    // reference
+    VMRouterTop(bx, bx_o, inputStub,
+      memoriesAS_ref, memoriesME_ref, memoriesTEI_ref, memoriesOL_ref);
+
+    // All the stubs up to the depth of the memories
+    for (int i = 0; i < maxASCopies; ++i) {
+      for (unsigned int k = 0; k < memoriesAS[i].getDepth(); ++k) {
+        const auto word = memoriesAS[i].read_mem(bx, k).raw();
+        const auto word_ref = (k < stubs.size()) ? stubs[k].raw() : ap_uint<InputStub<inputType>::getWidth()>(0);
+        if (word != word_ref) {
+          cout << "Event " << ievt << ", AS copy " << i << ", entry " << k
+               << ": " << word.to_string(16) << ", expected " << word_ref.to_string(16) << endl;
+          ++err;
+        }
+      }
+    }
+
+    for (int i = 0; i < maxASCopies; ++i) {
+      err += compareMemories(ievt, "AS copy " + to_string(i), bx, memoriesAS[i], memoriesAS_ref[i], all);
+    }
+    for (int i = 0; i < nvmME; ++i) {
+      err += compareMemories(ievt, "ME " + to_string(i), bx, memoriesME[i], memoriesME_ref[i], all);
+    }
+    for (int i = 0; i < nvmTEI; ++i) {
+      for (int j = 0; j < maxTEICopies; ++j) {
+        err += compareMemories(ievt, "TEI " + to_string(i) + " copy " + to_string(j), bx, memoriesTEI[i][j], memoriesTEI_ref[i][j], all);
+      }
+    }
+    for (int i = 0; i < nvmOL; ++i) {
+      for (int j = 0; j < maxOLCopies; ++j) {
+        err += compareMemories(ievt, "OL " + to_string(i) + " copy " + to_string(j), bx, memoriesOL[i][j], memoriesOL_ref[i][j], all);
+      }
+    }
+
+  } // end of event loop
+
+  cout << nfull << " of " << nevents << " events above " << kMaxProc << " stubs" << endl;
+
+  // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
+  if (err > 255) err = 255;
+  return err;
+}
@@ -1,9 +1,18 @@
 // Test bench for VMRouter
+// The region is chosen with -DVMR_REGION=<region> in the CFLAGS, which includes
+// the top of the region written by emData/vmrouter_tops.sh, see script_VMR.tcl
+#if defined VMR_REGION
+#define VMR_STRING(x) #x
+#define VMR_TOP_HEADER_(region) VMR_STRING(VMRouterTop_##region.h)
+#define VMR_TOP_HEADER(region) VMR_TOP_HEADER_(region)
+#include VMR_TOP_HEADER(VMR_REGION)
+#else
 #include "VMRouterTop.h"
-//#include "VMRouterTop_D1PHIA.h"
+#endif
 
 #include <algorithm>
 #include <iterator>
+#include <vector>
 
 #include "FileReadUtility.h"
 
@@ -14,11 +23,8 @@ const int nEvents = 100;  //number of events to run
 // VMRouter Test that works for all regions
 // Sort stubs into smaller regions in phi, i.e. Virtual Modules (VMs).
 
-// NOTE: to run a different phi region, change the following
-//          - the included top function in VMRouter_test.cpp (if file name is changed)
-//          - the top function and memory directory in script_VMR.tcl (if file name is changed)
-//          - add the phi region in emData/download.sh, make sure to also run clean
-//          - and the changes listed in VMRouterTop.cc/h
+// NOTE: to run a different phi region, add the phi region in emData/download.sh,
+//       make sure to also run clean, and pass it to script_VMR.tcl
 
 
 // Finds all memory names for the specified processing module found in the wiring file,
@@ -66,6 +72,52 @@ bool findFileNames(string fileDirStart, string wireFileName, string memID, strin
 }
 
 
+// The MatchEngine takes the disk stubs below kVMSMEFirst2SRPosDisk as PS stubs,
+// as the ME stubs have no PS/2S flag (VMStubMEMemory.h). Checks this split
+// against the input, PS or 2S, that each stub of the ME memories comes from.
+// Returns the number of stubs on the wrong side, and adds the number of stubs
+// checked to nStubs.
+int checkDiskPSSplit(const BXType bx, const InputStubMemory<inputType> inputStub[], const int nInputsPS,
+                     const InputStubMemory<DISK2S> inputStubDisk2S[], const int nInputs2S,
+                     const AllStubMemory<outputType>& allStub, const VMStubMEMemory<outputType, nbitsbin> memoriesME[],
+                     int& nStubs) {
+
+  typedef typename AllStub<outputType>::AllStubData AllStubData;
+
+  vector<AllStubData> stubsPS, stubs2S;
+  for (int i = 0; i < nInputsPS; i++) {
+    for (unsigned int j = 0; j < inputStub[i].getEntries(bx); j++) {
+      stubsPS.push_back(AllStub<outputType>(inputStub[i].read_mem(bx, j).raw()).raw());
+    }
+  }
+  for (int i = 0; i < nInputs2S; i++) {
+    for (unsigned int j = 0; j < inputStubDisk2S[i].getEntries(bx); j++) {
+      stubs2S.push_back(AllStub<outputType>(inputStubDisk2S[i].read_mem(bx, j).raw()).raw());
+    }
+  }
+
+  int nerr = 0;
+  for (unsigned int i = 0; i < nvmME; i++) {
+    for (unsigned int bin = 0; bin < memoriesME[i].getNBins(); bin++) {
+      for (unsigned int j = 0; j < memoriesME[i].getNEntryPerBin(); j++) {
+        // The empty entries read as 0, as in compareBinnedMemWithMem
+        const auto stub = memoriesME[i].read_mem(bx, bin, j);
+        if (stub.raw() == 0) continue;
+        const AllStubData data = allStub.read_mem(bx, stub.getIndex()).raw();
+        const bool fromPS = find(stubsPS.begin(), stubsPS.end(), data) != stubsPS.end();
+        const bool from2S = find(stubs2S.begin(), stubs2S.end(), data) != stubs2S.end();
+        if (fromPS == from2S) continue; // not found, or in both
+        nStubs++;
+        if (isPSStubDisk(ap_uint<MEBinsBits>(bin), stub.getFineZ()) != fromPS) {
+          cout << "VMStubME" << i << " bin " << bin << " fine r " << stub.getFineZ()
+               << ": " << (fromPS ? "PS" : "2S") << " stub on the " << (fromPS ? "2S" : "PS") << " side of the MatchEngine split" << endl;
+          nerr++;
+        }
+      }
+    }
+  }
+  return nerr;
+}
 
 int main() {
 
@@ -240,6 +292,9 @@ int main() {
 
   // error count
   int err = 0;
+  // disk stubs checked against the PS/2S split of the MatchEngine, and errors
+  int nStubsPSSplit = 0;
+  int errPSSplit = 0;
 
   ///////////////////////////
   // loop over events
@@ -348,8 +403,18 @@ int main() {
         }
       }
     }
+
+    // PS/2S split of the disk stubs in the MatchEngine
+    if (kDISK) {
+      errPSSplit += checkDiskPSSplit(bx, inputStub, numInputs - num2S, inputStubDisk2S, num2S, memoriesAS[0], memoriesME, nStubsPSSplit);
+    }
   } // end of event loop
 
+  if (kDISK) {
+    cout << "PS/2S split of the MatchEngine: " << errPSSplit << " of " << nStubsPSSplit << " disk stubs on the wrong side" << endl;
+    err += errPSSplit;
+  }
+
 	cerr << "Exiting with return value " << err << endl;
 	// This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
 	if (err > 255) err = 255;
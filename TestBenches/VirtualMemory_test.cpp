@@ -0,0 +1,148 @@
+// Test bench for the virtual memories
+//
+// Random events of stubs in the input memories of the region of
+// VMRouterTop.h are routed by VMRouterVirtualTop, whose AllStub memory is a
+// VirtualMemory, and by VMRouterTop, with one AllStub memory per reader. Each
+// port of the virtual AllStub memory must read the same entries as the
+// AllStub copy of its reader, and the other memories must be the same.
+// Then prints the block RAMs of the memories of the region, with the
+// virtual AllStub memory, and the block RAMs saved.
+#include "VMRouterTop.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const int nevents = 100;  // number of events to run
+
+// Maximum number of stubs per input memory
+const int maxInputStubs = 32;
+
+using namespace std;
+
+// Compare the whole pages of two memories, as the entries are not counted
+template<class MemType>
+int compareMemories(int ievt, const string& name, BXType bx, const MemType& mem, const MemType& mem_ref)
+{
+  int err = 0;
+  for (unsigned int k = 0; k < mem.getDepth(); ++k) {
+    const auto word = mem.read_mem(bx, k).raw();
+    const auto word_ref = mem_ref.read_mem(bx, k).raw();
+    if (word != word_ref) {
+      cout << "Event " << ievt << ", " << name << ", entry " << k
+           << ": " << word.to_string(16) << ", expected " << word_ref.to_string(16) << endl;
+      ++err;
+    }
+  }
+  return err;
+}
+
+int main()
+{
+  // error counts
+  int err = 0;
+
+  static_assert(VirtualAllStubMemory::kNCopies < maxASCopies, "No AllStub copy saved");
+
+  static InputStubMemory<inputType> inputStub[numInputs];
+
+  static VirtualAllStubMemory allStub;
+  static VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME];
+  static VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies];
+  static VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies];
+
+  static AllStubMemory<outputType> memoriesAS_ref[maxASCopies];
+  static VMStubMEMemory<outputType, nbitsbin> memoriesME_ref[nvmME];
+  static VMStubTEInnerMemory<outputType> memoriesTEI_ref[nvmTEI][maxTEICopies];
+  static VMStubTEInnerMemory<BARRELOL> memoriesOL_ref[nvmOL][maxOLCopies];
+
+  ///////////////////////////
+  // loop over events
+  cout << "Start event loop ..." << endl;
+  srand(1);
+  for (int ievt = 0; ievt < nevents; ++ievt) {
+
+    // bx
+    BXType bx = ievt&0x7;
+    BXType bx_o;
+
+    // Random stubs
+    for (int i = 0; i < numInputs; ++i) {
+      const int nstubs = rand() % (maxInputStubs + 1);
+      uint64_t records[2*maxInputStubs];
+      for (int j = 0; j < nstubs; ++j) {
+        ap_uint<InputStub<inputType>::getWidth()> word = 0;
+        for (int k = 0; k < word.length(); k += 16) {
+          const int msb = (k + 15 < word.length()) ? k + 15 : word.length() - 1;
+          word.range(msb, k) = rand();
+        }
+        records[2*j] = j;
+        records[2*j+1] = word.to_uint64();
+      }
+      inputStub[i].clear();
+      inputStub[i].write_page(bx, records, nstubs, 1);
+    }
+
+    allStub.clear(bx);
+    for (int i = 0; i < maxASCopies; ++i) {
+      memoriesAS_ref[i].clear();
+    }
+    for (int i = 0; i < nvmME; ++i) {
+      memoriesME[i].clear();
+      memoriesME_ref[i].clear();
+    }
+    for (int i = 0; i < nvmTEI; ++i) {
+      for (int j = 0; j < maxTEICopies; ++j) {
+        memoriesTEI[i][j].clear();
+        memoriesTEI_ref[i][j].clear();
+      }
+    }
+    for (int i = 0; i < nvmOL; ++i) {
+      for (int j = 0; j < maxOLCopies; ++j) {
+        memoriesOL[i][j].clear();
+        memoriesOL_ref[i][j].clear();
+      }
+    }
+
+    // Unit Under Test
+    VMRouterVirtualTop(bx, bx_o, inputStub,
+      allStub, memoriesME, memoriesTEI, memoriesOL);
+
+    // reference
+    VMRouterTop(bx, bx_o, inputStub,
+      memoriesAS_ref, memoriesME_ref, memoriesTEI_ref, memoriesOL_ref);
+
+    for (int i = 0; i < maxASCopies; ++i) {
+      err += compareMemories(ievt, "AS port " + to_string(i), bx, allStub.getPort(i), memoriesAS_ref[i]);
+    }
+    for (int i = 0; i < nvmME; ++i) {
+      err += compareMemories(ievt, "ME " + to_string(i), bx, memoriesME[i], memoriesME_ref[i]);
+    }
+    for (int i = 0; i < nvmTEI; ++i) {
+      for (int j = 0; j < maxTEICopies; ++j) {
+        err += compareMemories(ievt, "TEI " + to_string(i) + " copy " + to_string(j), bx, memoriesTEI[i][j], memoriesTEI_ref[i][j]);
+      }
+    }
+    for (int i = 0; i < nvmOL; ++i) {
+      for (int j = 0; j < maxOLCopies; ++j) {
+        err += compareMemories(ievt, "OL " + to_string(i) + " copy " + to_string(j), bx, memoriesOL[i][j], memoriesOL_ref[i][j]);
+      }
+    }
+
+  } // end of event loop
+
+  // Block RAMs of the output memories of the region. The TE Inner and
+  // overlap copies have their own bend cuts, and are kept.
+  const vector<VirtualMemoryReport> reports = {
+    virtualMemoryReport<VirtualAllStubMemory>("AllStub"),
+    replicatedMemoryReport<VMStubMEMemory<outputType, nbitsbin> >("VMStubME", 1, nvmME),
+    replicatedMemoryReport<VMStubTEInnerMemory<outputType> >("VMStubTEInner", maxTEICopies, nvmTEI),
+    replicatedMemoryReport<VMStubTEInnerMemory<BARRELOL> >("VMStubOverlap", maxOLCopies, nvmOL)
+  };
+  printVirtualMemoryReport(reports);
+
+  // This is necessary because HLS seems to only return an 8-bit error count, so if err%256==0, the test bench can falsely pass
+  if (err > 255) err = 255;
+  return err;
+}
@@ -17,7 +17,7 @@ constexpr int kMaxProc = kTMUX * 6;
 
 // List of module types
 namespace module {
-  enum type {UNKNOWN, IR, VMR, TE, TC, PR, ME, MC, NMODULES};
+  enum type {UNKNOWN, IR, VMR, TE, TC, PR, ME, MC, TB, PD, NMODULES};
 };
 
 // Map from a module type to an offset used to reduce the number of iterations
@@ -84,6 +84,7 @@ constexpr double zlength = 120.0; // cm
 constexpr double rmindiskvm = 22.5; // cm
 constexpr double rmindisk = 20.0; // cm
 constexpr double rmaxdisk = 120.0; // cm
+constexpr double rPS2S = 60.0; // cm, boundary between the PS and 2S disk modules
 
 // cut constants
 constexpr double ptcut = 1.91; // GeV
@@ -3,9 +3,12 @@
 
 
 #include <cassert>
+#include "hls_stream.h"
 #include "Constants.h"
 #include "AllStubMemory.h"
 #include "DTCStubMemory.h"
+#include "ModuleMonitor.h"
+#include "PhiCorrection.h"
 
 
 // link map
@@ -27,8 +30,6 @@ static const int kNMEMwidth = 5;
 // mxmium number of layers readout by a DTC 
 static const int kMaxLyrsPerDTC = 4; 
 
-// Number of MSBs used for r index in phicorr LUTs
-static const int kNBitsPhiCorrTableR = 3; // Found hardcoded in VMRouterphicorrtable.h
 // size of link LUT 
 static const int kSizeLinkTable = 12;
 // size of phi correction table 
@@ -79,52 +80,122 @@ static const int kMSBVldBt = kNBits_DTC-1;//0;
 static const int kLSBLyrBts = kNBits_DTC - 3;//1; 
 static const int kMSBLyrBts = kNBits_DTC - 2;//2; 
 
+// The stubs of a link arrive on a stream, one BX after the other, each
+// followed by an end-of-BX word, i.e. a word with the valid bit clear.
+// The IR stops reading at the end-of-BX word, so that it is done as soon
+// as the last stub of the BX is in. It processes at most kMaxStubsFromLink
+// stubs of a BX: the stubs after them are read up to the end-of-BX word
+// without being processed, so that the next BX starts at its first stub, and
+// are counted as dropped by the loop budget.
+typedef hls::stream<ap_uint<kNBits_DTC> > DTCStubStream;
+static const ap_uint<kNBits_DTC> kEndOfBXWord = 0;
 
-#define IR_DEBUG false
-
-// Get the corrected phi, i.e. phi at the average radius of the barrel
-// Corrected phi is used by ME and TE memories in the barrel
-template<regionType InType>
-inline typename AllStub<InType>::ASPHI getPhiCorr(
-		const typename AllStub<InType>::ASPHI phi,
-		const typename AllStub<InType>::ASR r,
-		const typename AllStub<InType>::ASBEND bend, const int phicorrtable[]) 
-{
-	
-	#pragma HLS array_partition variable = phicorrtable complete
-	constexpr auto rbins = 1 << kNBitsPhiCorrTableR; // The number of bins for r
-
-	ap_uint<kNBitsPhiCorrTableR> rbin = (r + (1 << (r.length() - 1)))
-			>> (r.length() - kNBitsPhiCorrTableR); // Which bin r belongs to. Note r = 0 is mid radius
-	auto index = bend * rbins + rbin; // Index for where we find our correction value
-	auto corrval = phicorrtable[index]; // The amount we need to correct our phi
 
-	auto phicorr = phi - corrval; // the corrected phi
+#define IR_DEBUG false
 
-	// Check for overflow
-	if (phicorr < 0)
-		phicorr = 0; // can't be less than 0
-	if (phicorr >= 1 << phi.length())
-		phicorr = (1 << phi.length()) - 1;  // can't be more than the max value
+// Decoding of one encoded layer of a link, the same for all the stubs of the
+// link on that layer/disk, see getIRLinkDecode
+struct IRLayerDecode {
+	// index of the first memory of the layer/disk
+	ap_uint<kNMEMwidth> hBaseIndx;
+	BrlBit hIsBrl;
+	TkLyrId hLyrId;
+	// number of bits of the phi bin
+	ap_uint<2> hPhiBnWdth;
+	// phi-correction table: 0, 1 or 2 for the first, second or third
+	// barrel layer of the link
+	ap_uint<2> hLUTSel;
+};
 
-	return phicorr;
+// Decoding table of a link, one entry per encoded layer. It only depends on
+// the link and bin words, so it is built once, before the stubs are read,
+// and the stubs only look it up.
+inline void getIRLinkDecode(const ap_uint<kLINKMAPwidth> hLinkWord
+	, const ap_uint<kBINMAPwidth> hPhBnWord
+	, IRLayerDecode hDecode[kMaxLyrsPerDTC])
+{
+	#pragma HLS inline
+	// the memories of the layers/disks before this one in the link word,
+	// one per phi bin
+	ap_uint<kNMEMwidth> cIndx = 0;
+	LOOP_DecodeLyrs:
+	for (int cLyr = 0; cLyr < kMaxLyrsPerDTC; cLyr++) 
+	{
+	  #pragma HLS unroll
+	  auto hIsBrl = hLinkWord.range((kNBitsBrlBit-1) + kSizeLinkWord * cLyr, kSizeLinkWord * cLyr);
+	  auto hLyrId = hLinkWord.range((kNBitsLyrTk-1) + kSizeLinkWord * cLyr + kNBitsBrlBit, kNBitsBrlBit + kSizeLinkWord * cLyr);
+	  auto hBnWrd = hPhBnWord.range(kSizeBinWord * cLyr + (kSizeBinWord-1), kSizeBinWord * cLyr);
+	  hDecode[cLyr].hBaseIndx = cIndx;
+	  hDecode[cLyr].hIsBrl = hIsBrl;
+	  hDecode[cLyr].hLyrId = hLyrId;
+	  hDecode[cLyr].hPhiBnWdth = (hIsBrl == 1 && hLyrId == kFrstPSBrlLyr) ? kNbitsPhiBinsPSL1 : kNbitsPhiBinsTkr;
+	  if( hLyrId == kScndPSBrlLyr || hLyrId == kScnd2SBrlLyr ) 
+	    hDecode[cLyr].hLUTSel = 1;
+	  else if( hLyrId == kThrdPSBrlLyr || hLyrId == kThrd2SBrlLyr )
+	    hDecode[cLyr].hLUTSel = 2;
+	  else
+	    hDecode[cLyr].hLUTSel = 0;
+	  cIndx += 1 + hBnWrd;
+	}
+}
 
-	// auto rbins = 1 << kNBitsPhiCorrTableR; // The number of bins for r
-	// auto rbin = (r + (1 << (r.length() - 1))) >> (r.length() - kNBitsPhiCorrTableR); // Which bin r belongs to. Note r = 0 is mid radius
-	// auto index = bend * rbins + rbin; // Index for where we find our correction value
-	// auto corrval = phicorrtable[index]; // The amount we need to correct our phi
-	// auto phicorr = ((phi) - corrval); // the corrected phi
+// Index of the output memory of a valid stub: the first memory of the
+// stub's layer/disk in the decoding table of the link, plus the phi bin of
+// the stub. The phi-correction tables are those of the first, second and
+// third barrel layer of the link, PS or 2S.
+inline unsigned int getIRMemIndex(const ap_uint<kNBits_DTC> hStub
+	, const ap_uint<1> hIs2S
+	, const IRLayerDecode hDecode[kMaxLyrsPerDTC]
+	, const int* hPhiCorrtable_L1
+	, const int* hPhiCorrtable_L2
+	, const int* hPhiCorrtable_L3)
+{
+	#pragma HLS inline
+	// encoded layer 
+	auto hEncLyr = hStub.range(kMSBLyrBts, kLSBLyrBts);
+	const IRLayerDecode& hLyr = hDecode[hEncLyr];
+	auto hIsBrl = hLyr.hIsBrl;
 	
-	// // Check for overflow
-	// if (phicorr < 0)
-	// 	phicorr = 0; // can't be less than 0
-	// if (phicorr >= 1 << phi.length())
-	// 	phicorr = (1 << phi.length()) - 1;  // can't be more than the max value
-
-	// return phicorr;
+	// point to the correct 
+	// LUT with the phi 
+	// corrections 
+	const int* cLUT = (hLyr.hLUTSel == 2) ? hPhiCorrtable_L3 
+		: (hLyr.hLUTSel == 1) ? hPhiCorrtable_L2 : hPhiCorrtable_L1;
+	
+	// get phi bin
+	unsigned int cIndxThisBn = 0;
+	if( hIsBrl == 1 && hIs2S == 0 )
+	{
+		auto cOffset = hLyr.hPhiBnWdth; 
+		AllStub<BARRELPS> hAStub(hStub.range(kNBits_DTC-1,0));
+		auto hPhiCorrected = getPhiCorr<BARRELPS>(hAStub.getPhi(), hAStub.getR(), hAStub.getBend(), cLUT); 
+		auto hPhiBn = hPhiCorrected.range(hPhiCorrected.length()-1, hPhiCorrected.length()-cOffset);
+		cIndxThisBn =  hPhiBn;
+	}
+	else if( hIsBrl == 0 && hIs2S == 0 )
+	{
+		auto hPhiMSB = AllStub<DISKPS>::kASPhiMSB;
+		auto hPhiLSB = AllStub<DISKPS>::kASPhiMSB-(kNbitsPhiBinsTkr-1);
+		auto  hPhiBn = hStub.range(hPhiMSB,hPhiLSB) ;
+		cIndxThisBn = hPhiBn;
+	}
+	else if(  hIsBrl == 1)
+	{
+		AllStub<BARREL2S> hAStub(hStub.range(kNBits_DTC-1,0));
+		auto hPhiCorrected = getPhiCorr<BARREL2S>(hAStub.getPhi(), hAStub.getR(), hAStub.getBend(), cLUT); 
+		auto hPhiBn = hPhiCorrected.range(hPhiCorrected.length()-1, hPhiCorrected.length()-kNbitsPhiBinsTkr);
+		cIndxThisBn = hPhiBn;
+	}
+	else if(  hIsBrl == 0)
+	{
+		auto hPhiMSB = AllStub<DISK2S>::kASPhiMSB;
+		auto hPhiLSB = AllStub<DISK2S>::kASPhiMSB-(kNbitsPhiBinsTkr-1);
+		auto hPhiBn = hStub.range(hPhiMSB,hPhiLSB);
+		cIndxThisBn =  hPhiBn;
+	}
+	return hLyr.hBaseIndx+cIndxThisBn;
 }
 
-
 template<unsigned int nOMems, unsigned int nLUTEntries>
 void InputRouter( const BXType bx
 	, const ap_uint<kLINKMAPwidth> hLinkWord
@@ -132,7 +203,7 @@ void InputRouter( const BXType bx
 	, const int hPhiCorrtable_L1[nLUTEntries]
 	, const int hPhiCorrtable_L2[nLUTEntries]
 	, const int hPhiCorrtable_L3[nLUTEntries]
-	, ap_uint<kNBits_DTC>* hInputStubs
+	, DTCStubStream& hInputStubs
 	, BXType& bx_o 
 	, DTCStubMemory* hOutputStubs)
 {
@@ -141,12 +212,24 @@ void InputRouter( const BXType bx
 	#pragma HLS interface ap_memory port = hPhiCorrtable_L1
   	#pragma HLS interface ap_memory port = hPhiCorrtable_L2
   	#pragma HLS interface ap_memory port = hPhiCorrtable_L3
+	#pragma HLS array_partition variable = hPhiCorrtable_L1 complete
+	#pragma HLS array_partition variable = hPhiCorrtable_L2 complete
+	#pragma HLS array_partition variable = hPhiCorrtable_L3 complete
   	#pragma HLS interface register 	port = bx 
   
-  	ap_uint<1> hIs2S= hLinkWord.range(kLINKMAPwidth-4,kLINKMAPwidth-4);
 	// clear stub counter
 	ap_uint<kNBits_MemAddr> hNStubs[nOMems];
 	#pragma HLS array_partition variable = hNStubs complete
+	#ifndef __SYNTHESIS__
+	// set once the stub counter of a memory has wrapped around, for the monitor
+	bool hWrapped[nOMems] = {};
+	#endif
+	// decoding of the link, looked up by the stubs
+	ap_uint<1> hIs2S = hLinkWord.range(kLINKMAPwidth-4,kLINKMAPwidth-4);
+	IRLayerDecode hDecode[kMaxLyrsPerDTC];
+	#pragma HLS array_partition variable = hDecode complete
+	getIRLinkDecode(hLinkWord, hPhBnWord, hDecode);
+	ModuleMonitor monitor(module::IR, bx);
 	LOOP_ClearOutputMemories:
 	for (unsigned int cMemIndx = 0; cMemIndx < nOMems ; cMemIndx++) 
 	{
@@ -162,6 +245,8 @@ void InputRouter( const BXType bx
 	#endif
 	}
 
+	// set once the end-of-BX word has been read
+	bool hEndOfBX = false;
 	LOOP_ProcessIR:
 	for (int cStubCounter = 0; cStubCounter < kMaxStubsFromLink; cStubCounter++) 
 	{
@@ -169,20 +254,20 @@ void InputRouter( const BXType bx
 	//#pragma HLS PIPELINE rewind
 	  // decode stub
 	  // check which memory
-	  auto hStub = hInputStubs[cStubCounter];
-	  // add check of valid bit here 
-	  if (hStub == 0)   continue;
-	  // check valid bit
+	  auto hStub = hInputStubs.read();
+	  // check valid bit, clear at the end of the BX
 	  auto hVldBt = hStub.range( kMSBVldBt ,  kLSBVldBt);
-	  if( hVldBt == 0 ) continue;
-	  // encoded layer 
-	  auto hEncLyr = hStub.range(kMSBLyrBts, kLSBLyrBts);
+	  monitor.step(hVldBt != 0);
+	  hEndOfBX = ( hVldBt == 0 );
+	  if( hEndOfBX ) break;
+	  monitor.inputs(1);
+	  monitor.read();
 	  #ifndef __SYNTHESIS__
 	  if( IR_DEBUG)
 	  {
 	  	  std::cout << "\t.. Stub : " << std::bitset<kNBits_DTC>(hStub) 
 		            << " [ ValidBit " << std::bitset<1>(hVldBt) << " ] "
-					<< " [ EncLyrId " << std::bitset<2>(hEncLyr) << " ] "
+					<< " [ EncLyrId " << std::bitset<2>(hStub.range(kMSBLyrBts, kLSBLyrBts)) << " ] "
 					<< "\n";
 	  }
 	  #endif
@@ -190,74 +275,15 @@ void InputRouter( const BXType bx
 	  auto hStbWrd = ap_uint<kBRAMwidth>(hStub.range(kBRAMwidth - 1, 0));
 	  DTCStub hMemWord(hStbWrd);
 	    
-	  // decode link wrd for this layer
-	  auto hIsBrl= hLinkWord.range((kNBitsBrlBit-1) + kSizeLinkWord * hEncLyr, kSizeLinkWord * hEncLyr);
-	  auto hLyrId= hLinkWord.range((kNBitsLyrTk-1) + kSizeLinkWord * hEncLyr + kNBitsBrlBit, kNBitsBrlBit + kSizeLinkWord * hEncLyr);
-	  
-	  // point to the correct 
-	  // LUT with the phi 
-	  // corrections 
-	  static const int* cLUT; 
-	  if( hLyrId == kFrstPSBrlLyr || hLyrId == kFrst2SBrlLyr ) 
-	  	cLUT = hPhiCorrtable_L1;
-	  else if( hLyrId == kScndPSBrlLyr || hLyrId == kScnd2SBrlLyr ) 
-	  	cLUT = hPhiCorrtable_L2;
-	  else if( hLyrId == kThrdPSBrlLyr || hLyrId == kThrd2SBrlLyr )
-	  	cLUT = hPhiCorrtable_L3;
-	  
-	  // update index
-	  // and add phi bin 
-	  int cIndx = 0;
-	  LOOP_UpdateMemIndx:
-	  for (int cLyr = 0; cLyr < kMaxLyrsPerDTC; cLyr++) 
-	  {
-	    #pragma HLS unroll
-	    // update index
-	    auto hBnWrd = hPhBnWord.range(kSizeBinWord * cLyr + (kSizeBinWord-1), kSizeBinWord * cLyr);
-	   	cIndx += (cLyr < hEncLyr) ? (1+(int)(hBnWrd)) : 0; 
-	  }
-	  
-	  // get phi bin
-	  int cIndxThisBn = 0;
-	  if( hIsBrl == 1 && hIs2S == 0 )
-	  {
-	  	auto cOffset = (hLyrId == kFrstPSBrlLyr) ? kNbitsPhiBinsPSL1 : kNbitsPhiBinsTkr; 
-	  	AllStub<BARRELPS> hAStub(hStub.range(kNBits_DTC-1,0));
-		auto hPhiCorrected = getPhiCorr<BARRELPS>(hAStub.getPhi(), hAStub.getR(), hAStub.getBend(), cLUT); 
-		auto hPhiBn = hPhiCorrected.range(hPhiCorrected.length()-1, hPhiCorrected.length()-cOffset);
-	  	cIndxThisBn =  hPhiBn;
-	  }
-	  else if( hIsBrl == 0 && hIs2S == 0 )
-	  {
-	  	auto hPhiMSB = AllStub<DISKPS>::kASPhiMSB;
-		auto hPhiLSB = AllStub<DISKPS>::kASPhiMSB-(kNbitsPhiBinsTkr-1);
-	    auto  hPhiBn = hStub.range(hPhiMSB,hPhiLSB) ;
-		cIndxThisBn = hPhiBn;
-	  }
-	  else if(  hIsBrl == 1)
-	  {
-	  	AllStub<BARREL2S> hAStub(hStub.range(kNBits_DTC-1,0));
-	  	auto hPhiCorrected = getPhiCorr<BARREL2S>(hAStub.getPhi(), hAStub.getR(), hAStub.getBend(), cLUT); 
-		auto hPhiBn = hPhiCorrected.range(hPhiCorrected.length()-1, hPhiCorrected.length()-kNbitsPhiBinsTkr);
-	  	cIndxThisBn = hPhiBn;
-	  }
-	  else if(  hIsBrl == 0)
-	  {
-	  	auto hPhiMSB = AllStub<DISK2S>::kASPhiMSB;
-		auto hPhiLSB = AllStub<DISK2S>::kASPhiMSB-(kNbitsPhiBinsTkr-1);
-	    auto hPhiBn = hStub.range(hPhiMSB,hPhiLSB);
-	    cIndxThisBn =  hPhiBn;
-	  }
 	  // assign memory index
-	  auto cMemIndx = cIndx+cIndxThisBn;
+	  unsigned int cMemIndx = getIRMemIndex(hStub, hIs2S, hDecode
+	  	, hPhiCorrtable_L1, hPhiCorrtable_L2, hPhiCorrtable_L3);
 	  assert(cMemIndx < nOMems);
 	  auto hEntries = hNStubs[cMemIndx];
 	  #ifndef __SYNTHESIS__
 	  if( IR_DEBUG )
 	  {
 		  std::cout << "\t.. Stub : " << std::hex << hStbWrd << std::dec
-		            << " [ EncLyrId " << hEncLyr << " ] "
-		            << "[ LyrId " << hLyrId << " ] IsBrl bit " << +hIsBrl
 		            << " Mem#" << cMemIndx
 		            << " Current number of entries " << +hEntries << "\n";
 	  }
@@ -265,6 +291,145 @@ void InputRouter( const BXType bx
 	  (&hOutputStubs[cMemIndx])->write_mem(bx, hMemWord, hEntries);
 	  // update counter 
 	  hNStubs[cMemIndx] = hEntries + 1;
+	  #ifndef __SYNTHESIS__
+	  // the counter wraps around when the memory is full, and older stubs
+	  // are overwritten
+	  monitor.dropped(drop::PAGEFULL, hWrapped[cMemIndx]);
+	  hWrapped[cMemIndx] = hWrapped[cMemIndx] || hNStubs[cMemIndx] == 0;
+	  #endif
+	}
+	// skip the stubs past the loop budget, up to the end-of-BX word
+	LOOP_SkipIR:
+	while( !hEndOfBX )
+	{
+	#pragma HLS pipeline II = 1
+	  auto hStub = hInputStubs.read();
+	  hEndOfBX = ( hStub.range( kMSBVldBt ,  kLSBVldBt) == 0 );
+	  monitor.step(false);
+	  monitor.inputs(!hEndOfBX);
+	}
+	// update output bx port 
+	bx_o = bx;
+}
+
+
+// InputRouter reading out nLinks links at once, one lane per link. The
+// lanes process one stub of each link per clock and share one copy of the
+// phi-correction tables, so the links of one instance must all be PS or all
+// be 2S. A lane stops reading its link at the end-of-BX word, and the IR is
+// done when all of them have. Each link has its own output memories, as in
+// the wiring, and each lane its own write counters, so that the lanes never
+// write the same memory. A link with fewer than nOMems memories leaves the
+// others empty.
+template<unsigned int nLinks, unsigned int nOMems, unsigned int nLUTEntries>
+void InputRouterMultiLink( const BXType bx
+	, const ap_uint<kLINKMAPwidth> hLinkWord[nLinks]
+	, const ap_uint<kBINMAPwidth> hPhBnWord[nLinks]
+	, const int hPhiCorrtable_L1[nLUTEntries]
+	, const int hPhiCorrtable_L2[nLUTEntries]
+	, const int hPhiCorrtable_L3[nLUTEntries]
+	, DTCStubStream hInputStubs[nLinks]
+	, BXType& bx_o 
+	, DTCStubMemory hOutputStubs[nLinks][nOMems])
+{
+	#pragma HLS inline
+	#pragma HLS interface ap_memory port = hPhiCorrtable_L1
+	#pragma HLS interface ap_memory port = hPhiCorrtable_L2
+	#pragma HLS interface ap_memory port = hPhiCorrtable_L3
+	#pragma HLS array_partition variable = hPhiCorrtable_L1 complete
+	#pragma HLS array_partition variable = hPhiCorrtable_L2 complete
+	#pragma HLS array_partition variable = hPhiCorrtable_L3 complete
+	#pragma HLS array_partition variable = hLinkWord complete
+	#pragma HLS array_partition variable = hPhBnWord complete
+	#pragma HLS array_partition variable = hInputStubs complete
+	#pragma HLS array_partition variable = hOutputStubs complete dim = 0
+	#pragma HLS interface register port = bx 
+
+	// stub counters of each lane
+	ap_uint<kNBits_MemAddr> hNStubs[nLinks][nOMems];
+	#pragma HLS array_partition variable = hNStubs complete dim = 0
+	#ifndef __SYNTHESIS__
+	// set once the stub counter of a memory has wrapped around, for the monitor
+	bool hWrapped[nLinks][nOMems] = {};
+	#endif
+	// set once the end-of-BX word of a link has been read
+	bool hDone[nLinks];
+	#pragma HLS array_partition variable = hDone complete
+	// decoding of the links, looked up by the stubs
+	ap_uint<1> hIs2S[nLinks];
+	#pragma HLS array_partition variable = hIs2S complete
+	IRLayerDecode hDecode[nLinks][kMaxLyrsPerDTC];
+	#pragma HLS array_partition variable = hDecode complete dim = 0
+	ModuleMonitor monitor(module::IR, bx);
+	LOOP_ClearCounters:
+	for (unsigned int cLink = 0; cLink < nLinks; cLink++)
+	{
+	#pragma HLS unroll
+		hDone[cLink] = false;
+		hIs2S[cLink] = hLinkWord[cLink].range(kLINKMAPwidth-4,kLINKMAPwidth-4);
+		getIRLinkDecode(hLinkWord[cLink], hPhBnWord[cLink], hDecode[cLink]);
+		for (unsigned int cMemIndx = 0; cMemIndx < nOMems; cMemIndx++)
+		{
+		#pragma HLS unroll
+			hNStubs[cLink][cMemIndx] = 0;
+		}
+	}
+
+	LOOP_ProcessIRLinks:
+	for (int cStubCounter = 0; cStubCounter < kMaxStubsFromLink; cStubCounter++) 
+	{
+	#pragma HLS pipeline II = 1
+	  bool hBusy = false;
+	  bool hAllDone = true;
+	  LOOP_Lanes:
+	  for (unsigned int cLink = 0; cLink < nLinks; cLink++)
+	  {
+	  #pragma HLS unroll
+	    if( hDone[cLink] ) continue;
+	    auto hStub = hInputStubs[cLink].read();
+	    // check valid bit, clear at the end of the BX
+	    auto hVldBt = hStub.range( kMSBVldBt ,  kLSBVldBt);
+	    hDone[cLink] = ( hVldBt == 0 );
+	    if( hDone[cLink] ) continue;
+	    hBusy = true;
+	    hAllDone = false;
+	    monitor.inputs(1);
+	    monitor.read();
+
+	    // get memory word
+	    DTCStub hMemWord(ap_uint<kBRAMwidth>(hStub.range(kBRAMwidth - 1, 0)));
+	    // assign memory index
+	    unsigned int cMemIndx = getIRMemIndex(hStub, hIs2S[cLink], hDecode[cLink]
+	    	, hPhiCorrtable_L1, hPhiCorrtable_L2, hPhiCorrtable_L3);
+	    assert(cMemIndx < nOMems);
+	    auto hEntries = hNStubs[cLink][cMemIndx];
+	    hOutputStubs[cLink][cMemIndx].write_mem(bx, hMemWord, hEntries);
+	    // update counter 
+	    hNStubs[cLink][cMemIndx] = hEntries + 1;
+	    #ifndef __SYNTHESIS__
+	    // the counter wraps around when the memory is full, and older stubs
+	    // are overwritten
+	    monitor.dropped(drop::PAGEFULL, hWrapped[cLink][cMemIndx]);
+	    hWrapped[cLink][cMemIndx] = hWrapped[cLink][cMemIndx] || hNStubs[cLink][cMemIndx] == 0;
+	    #endif
+	  }
+	  monitor.step(hBusy);
+	  if( hAllDone ) break;
+	}
+	// skip the stubs past the loop budget, up to the end-of-BX word of each
+	// link
+	LOOP_SkipIRLinks:
+	for (unsigned int cLink = 0; cLink < nLinks; cLink++)
+	{
+	  LOOP_SkipLink:
+	  while( !hDone[cLink] )
+	  {
+	  #pragma HLS pipeline II = 1
+	    auto hStub = hInputStubs[cLink].read();
+	    hDone[cLink] = ( hStub.range( kMSBVldBt ,  kLSBVldBt) == 0 );
+	    monitor.step(false);
+	    monitor.inputs(!hDone[cLink]);
+	  }
 	}
 	// update output bx port 
 	bx_o = bx;
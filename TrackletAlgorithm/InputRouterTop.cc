@@ -6,12 +6,12 @@ void InputRouterTop( const BXType bx
   , const int kPhiCorrtable_L1[cNEntriesLUT] // corrections frst brl lyr  
   , const int kPhiCorrtable_L2[cNEntriesLUT] // corrections scnd brl lyr   
   , const int kPhiCorrtable_L3[cNEntriesLUT] // corrections thrd brl lyr  
-  , ap_uint<kNBits_DTC> hInputStubs[kMaxStubsFromLink]
+  , DTCStubStream& hInputStubs
   , BXType & bx_o // output bx 
   , DTCStubMemory hOutputStubs[cNMemories]) {
 
   #pragma HLS clock domain = slow_clock
-  #pragma HLS stream variable = hInputStubs depth = 1
+  #pragma HLS interface ap_fifo port = hInputStubs
  
   
   InputRouter<cNMemories,cNEntriesLUT>( bx
@@ -24,3 +24,27 @@ void InputRouterTop( const BXType bx
       , bx_o
       , hOutputStubs);
 }
+
+void InputRouterMultiLinkTop( const BXType bx
+  , const ap_uint<kLINKMAPwidth> hLinkWord[cNLinks] // input link LUT of each link
+  , const ap_uint<kBINMAPwidth> hPhBnWord[cNLinks]  // n phi bins LUT of each link
+  , const int kPhiCorrtable_L1[cNEntriesLUT] // corrections frst brl lyr, shared
+  , const int kPhiCorrtable_L2[cNEntriesLUT] // corrections scnd brl lyr, shared
+  , const int kPhiCorrtable_L3[cNEntriesLUT] // corrections thrd brl lyr, shared
+  , DTCStubStream hInputStubs[cNLinks]
+  , BXType & bx_o // output bx 
+  , DTCStubMemory hOutputStubs[cNLinks][cNMemories]) {
+
+  #pragma HLS clock domain = slow_clock
+  #pragma HLS interface ap_fifo port = hInputStubs
+
+  InputRouterMultiLink<cNLinks,cNMemories,cNEntriesLUT>( bx
+      , hLinkWord
+      , hPhBnWord
+      , kPhiCorrtable_L1
+      , kPhiCorrtable_L2
+      , kPhiCorrtable_L3
+      , hInputStubs
+      , bx_o
+      , hOutputStubs);
+}
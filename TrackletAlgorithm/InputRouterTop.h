@@ -19,10 +19,24 @@ void InputRouterTop( const BXType bx
   	, const int kPhiCorrtable_L1[] // corrections frst brl lyr  
 	, const int kPhiCorrtable_L2[] // corrections scnd brl lyr  
 	, const int kPhiCorrtable_L3[] // corrections thrd brl lyr   
-	, ap_uint<kNBits_DTC> hInputStubs[kMaxStubsFromLink]//input stubs 
+	, DTCStubStream& hInputStubs //input stubs, then end of BX 
 	, BXType & bx_o // output bx 
 	, DTCStubMemory hOutputStubs[]);//output memories 
 
+// number of links read out by the multi-link IR
+// all PS, as they share the phi correction tables
+constexpr unsigned int cNLinks = 4;
+
+void InputRouterMultiLinkTop( const BXType bx
+	, const ap_uint<kLINKMAPwidth> hLinkWord[cNLinks] // input link LUT of each link
+	, const ap_uint<kBINMAPwidth> hPhBnWord[cNLinks] // n phi bins LUT of each link
+	, const int kPhiCorrtable_L1[] // corrections frst brl lyr, shared
+	, const int kPhiCorrtable_L2[] // corrections scnd brl lyr, shared
+	, const int kPhiCorrtable_L3[] // corrections thrd brl lyr, shared
+	, DTCStubStream hInputStubs[cNLinks] //input stubs of each link, then end of BX
+	, BXType & bx_o // output bx 
+	, DTCStubMemory hOutputStubs[cNLinks][cNMemories]);//output memories of each link
+
 
 #endif
 
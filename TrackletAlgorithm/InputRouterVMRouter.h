@@ -0,0 +1,217 @@
+#ifndef TrackletAlgorithm_InputRouterVMRouter_h
+#define TrackletAlgorithm_InputRouterVMRouter_h
+
+// InputRouter and VMRouter of one barrel layer phi region fused in a single
+// module, without the InputRouter output memories in between.
+//
+// The module reads the DTC links of the VMRouter inputs, one stream per link
+// as the InputRouter does, one word of each link per clock. The phi of each
+// stub is corrected once, with the phi-correction table of the layer, and
+// gives both the phi region the InputRouter would sort the stub into and the
+// VMs the VMRouter writes it to. The stubs of the layer in the phi region of
+// the module are kept in a small buffer per link, written and read within
+// the BX, and routed to the VMRouter memories one per clock, link after link
+// as the VMRouter reads its input memories, so that the outputs are the same
+// as those of the InputRouters followed by the VMRouter. The stubs of the
+// other layers and phi regions on the links are skipped.
+
+#include "InputRouter.h"
+#include "VMRouter.h"
+
+// Layer - barrel layer number, the disks are not handled
+// PhiRegion - AllStub phi region, 'A' for the first
+// nLinks - number of links, one per input memory of the VMRouter
+// The other template parameters are those of VMRouter
+template<regionType InType, regionType OutType, int Layer, char PhiRegion, unsigned int nLinks, int MaxAllCopies, int MaxTEICopies, int MaxOLCopies, int MaxTEOCopies, int NBitsBin, int BendCutTableSize>
+void InputRouterVMRouter(const BXType bx, BXType& bx_o,
+		// Input links
+		const ap_uint<kLINKMAPwidth> hLinkWord[nLinks],
+		DTCStubStream hInputStubs[nLinks],
+		const int fineBinTable[], const int phiCorrTable[],
+		// rzbitstables, aka binlookup in emulation
+		const int rzbitsInnerTable[], const int rzbitsOverlapTable[], const int rzbitsOuterTable[],
+		// bendcut tables
+		const ap_uint<BendCutTableSize> bendCutInnerTable[], const ap_uint<BendCutTableSize> bendCutOverlapTable[], const ap_uint<BendCutTableSize> bendCutOuterTable[],
+		// AllStub memory
+		AllStubMemory<OutType> memoriesAS[],
+		// ME memories
+		const ap_uint<maskMEsize>& maskME, VMStubMEMemory<OutType, NBitsBin> memoriesME[],
+		// Inner TE memories, non-overlap
+		const ap_uint<maskTEIsize>& maskTEI, VMStubTEInnerMemory<OutType> memoriesTEI[][MaxTEICopies],
+		// TE Inner memories, overlap
+		const ap_uint<maskOLsize>& maskOL, VMStubTEInnerMemory<BARRELOL> memoriesOL[][MaxOLCopies],
+		// TE Outer memories
+		const ap_uint<maskTEOsize>& maskTEO, VMStubTEOuterMemory<OutType> memoriesTEO[][MaxTEOCopies]) {
+
+#pragma HLS inline
+#pragma HLS array_partition variable=hLinkWord complete
+#pragma HLS array_partition variable=hInputStubs complete
+#pragma HLS array_partition variable=bendCutInnerTable complete dim=1
+#pragma HLS array_partition variable=bendCutOverlapTable complete dim=1
+#pragma HLS array_partition variable=bendCutOuterTable complete dim=1
+#pragma HLS array_partition variable=memoriesAS complete dim=1
+#pragma HLS array_partition variable=memoriesME complete dim=1
+#pragma HLS array_partition variable=memoriesTEI complete dim=2
+#pragma HLS array_partition variable=memoriesOL complete dim=2
+#pragma HLS array_partition variable=memoriesTEO complete dim=2
+
+	static_assert(Layer > 0, "Only the barrel layers are handled.");
+
+	// Number of memories/VMs for one coarse phi region
+	constexpr int nvmME = nvmmelayers[Layer-1]; // ME memories
+	constexpr int nvmTE = nvmtelayers[Layer-1]; // TE memories
+	constexpr int nvmOL = ((Layer == 1) || (Layer == 2)) ? nvmollayers[Layer-1] : 0; // TE Overlap memories
+
+	constexpr int nmaxbinsperpage = maxBinsPerPage(Layer); // Number of bins per page in memories
+
+	// Number of bits of the phi regions of the layer, as sorted by the InputRouter
+	constexpr int nbitsphiregion = (Layer == kFrstPSBrlLyr) ? kNbitsPhiBinsPSL1 : kNbitsPhiBinsTkr;
+
+	ModuleMonitor monitor(module::VMR, bx);
+
+	// Encoded layers of each link that are this layer
+	ap_uint<kMaxLyrsPerDTC> selLayers[nLinks];
+#pragma HLS array_partition variable=selLayers complete
+	// Set once the end-of-BX word of a link has been read
+	bool done[nLinks];
+#pragma HLS array_partition variable=done complete
+
+	// Stubs of each link kept for the VMRouter, with their corrected phi
+	InputStub<InType> buffer[nLinks][kMaxProc];
+	typename AllStub<InType>::ASPHI bufferPhiCorr[nLinks][kMaxProc];
+	ap_uint<kNBits_MemAddr> nBuffer[nLinks];
+#pragma HLS array_partition variable=buffer complete dim=1
+#pragma HLS array_partition variable=bufferPhiCorr complete dim=1
+#pragma HLS array_partition variable=nBuffer complete
+
+	for (unsigned int l = 0; l < nLinks; l++) {
+#pragma HLS UNROLL
+		for (int e = 0; e < kMaxLyrsPerDTC; e++) {
+#pragma HLS UNROLL
+			auto hIsBrl = hLinkWord[l].range((kNBitsBrlBit-1) + kSizeLinkWord * e, kSizeLinkWord * e);
+			auto hLyrId = hLinkWord[l].range((kNBitsLyrTk-1) + kSizeLinkWord * e + kNBitsBrlBit, kNBitsBrlBit + kSizeLinkWord * e);
+			selLayers[l][e] = (hIsBrl == 1 && hLyrId == Layer);
+		}
+		done[l] = false;
+		nBuffer[l] = 0;
+	}
+
+	//Create variables that keep track of which memory address to write to
+	ap_uint<kNBits_MemAddr-NBitsBin+1> addrCountME[nvmME][nmaxbinsperpage]; // Writing of ME stubs
+	ap_uint<kNBits_MemAddr> addrCountTEI[nvmTE][MaxTEICopies]; // Writing of TE Inner stubs
+	ap_uint<kNBits_MemAddr> addrCountOL[nvmOL][MaxOLCopies]; // Writing of TE Overlap stubs
+	ap_uint<kNBits_MemAddr-NBitsBinTEO+1> addrCountTEO[nvmTE][MaxTEOCopies][nmaxbinsperpage]; // Writing of TE Outer stubs
+
+	if (maskME) {
+		clear2DArray(nvmME, addrCountME);
+	}
+	if (maskTEI) {
+		clear2DArray(nvmTE, addrCountTEI);
+	}
+	if (maskOL) {
+		clear2DArray(nvmOL, addrCountOL);
+	}
+	if (maskTEO) {
+		clear3DArray(nvmTE, addrCountTEO);
+	}
+
+	// Link whose stubs are being routed, and the next one in its buffer
+	ap_uint<kNBitsNLnks> routeLink = 0;
+	ap_uint<kNBits_MemAddr> routeAddr = 0;
+	// Number of stubs routed, i.e. the index of the next one in the AllStub memories
+	ap_uint<kNBits_MemAddr> nRouted = 0;
+
+	/////////////////////////////////////
+	// Main Loop
+	// The links are read in at most kMaxStubsFromLink + 1 clocks, and the
+	// routing of their stubs waits for them at most once per stub routed
+	// and once per link
+	constexpr int maxLoop = kMaxStubsFromLink + 1 + kMaxProc + nLinks;
+
+	IRVMR_TOPLEVEL: for (int i = 0; i < maxLoop; ++i) {
+#pragma HLS PIPELINE II=1
+
+		// Route the next stub kept, links in the order of the VMRouter inputs.
+		// A link is done once its end-of-BX word is read and all its stubs kept
+		// are routed.
+		bool busy = false;
+		if (routeLink < nLinks && nRouted < kMaxProc) {
+			if (routeAddr < nBuffer[routeLink]) {
+				const bool valid[1] = {true};
+				const InputStub<InType> stub[1] = {buffer[routeLink][routeAddr]};
+				const InputStub<DISK2S> stubDisk2S[1]; // No DISK2S stubs in the barrel
+				const bool disk2S[1] = {false};
+				const bool negDisk[1] = {false};
+				const typename AllStub<InType>::ASPHI phiCorr[1] = {bufferPhiCorr[routeLink][routeAddr]};
+
+				routeVMStubs<InType, OutType, Layer, 0, MaxAllCopies, MaxTEICopies, MaxOLCopies, MaxTEOCopies, NBitsBin, BendCutTableSize, 1>
+				(bx, nRouted, valid, stub, stubDisk2S, disk2S, negDisk, phiCorr, fineBinTable,
+					rzbitsInnerTable, rzbitsOverlapTable, rzbitsOuterTable,
+					bendCutInnerTable, bendCutOverlapTable, bendCutOuterTable,
+					memoriesAS,
+					maskME, memoriesME, addrCountME,
+					maskTEI, memoriesTEI, addrCountTEI,
+					maskOL, memoriesOL, addrCountOL,
+					maskTEO, memoriesTEO, addrCountTEO);
+
+				routeAddr++;
+				nRouted++;
+				busy = true;
+			} else if (done[routeLink]) {
+				routeLink++;
+				routeAddr = 0;
+			}
+		}
+
+		monitor.step(busy);
+		monitor.read(busy);
+
+		// Read one word of each link, and keep the stub if it is in this layer
+		// and phi region
+		bool allDone = true;
+		for (unsigned int l = 0; l < nLinks; l++) {
+#pragma HLS UNROLL
+			if (done[l]) continue;
+			auto hStub = hInputStubs[l].read();
+			// check valid bit, clear at the end of the BX
+			done[l] = (hStub.range(kMSBVldBt, kLSBVldBt) == 0);
+			if (done[l]) continue;
+			allDone = false;
+
+			const InputStub<InType> stub(hStub.range(kBRAMwidth - 1, 0));
+			const auto phiCorr = getPhiCorr<InType>(stub.getPhi(), stub.getR(), stub.getBend(), phiCorrTable);
+			const auto phiRegion = phiCorr.range(phiCorr.length() - 1, phiCorr.length() - nbitsphiregion);
+			if (selLayers[l][hStub.range(kMSBLyrBts, kLSBLyrBts)] == 0 || phiRegion != PhiRegion - 'A') continue;
+
+			monitor.inputs(1);
+			if (nBuffer[l] == kMaxProc) continue; // Dropped, as in the VMRouter after kMaxProc stubs
+			buffer[l][nBuffer[l]] = stub;
+			bufferPhiCorr[l][nBuffer[l]] = phiCorr;
+			nBuffer[l]++;
+		}
+
+		if (allDone && (routeLink == nLinks || nRouted == kMaxProc)) break;
+	} // Outside main loop
+
+	// Skip the words of the links past the loop budget, up to their end-of-BX
+	// word, so that the next BX starts at its first stub. The stubs of this
+	// layer and phi region among them are dropped.
+	IRVMR_SKIP: for (unsigned int l = 0; l < nLinks; l++) {
+		IRVMR_SKIPLINK: while (!done[l]) {
+#pragma HLS PIPELINE II=1
+			auto hStub = hInputStubs[l].read();
+			done[l] = (hStub.range(kMSBVldBt, kLSBVldBt) == 0);
+			monitor.step(false);
+			if (done[l]) continue;
+
+			const InputStub<InType> stub(hStub.range(kBRAMwidth - 1, 0));
+			const auto phiCorr = getPhiCorr<InType>(stub.getPhi(), stub.getR(), stub.getBend(), phiCorrTable);
+			const auto phiRegion = phiCorr.range(phiCorr.length() - 1, phiCorr.length() - nbitsphiregion);
+			monitor.inputs(selLayers[l][hStub.range(kMSBLyrBts, kLSBLyrBts)] != 0 && phiRegion == PhiRegion - 'A');
+		}
+	}
+
+	bx_o = bx;
+} // End InputRouterVMRouter
+
+#endif // TrackletAlgorithm_InputRouterVMRouter_h
@@ -0,0 +1,58 @@
+#include "InputRouterVMRouterTop.h"
+
+// InputRouter/VMRouter Top Function for the VMRouter region of VMRouterTop.h,
+// layer 1, AllStub region E
+
+// NOTE: to run a different phi region, see the list of changes in VMRouterTop.h
+
+
+void InputRouterVMRouterTop(const BXType bx, BXType& bx_o,
+	// Input links
+	const ap_uint<kLINKMAPwidth> hLinkWord[numInputs],
+	DTCStubStream hInputStubs[numInputs],
+
+	// Output memories
+	AllStubMemory<outputType> memoriesAS[maxASCopies],
+	VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME],
+	VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies],
+	VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies])
+ {
+
+
+	///////////////////////////
+	// Open Lookup tables, the same as those of VMRouterTop
+#include "../emData/VMR/tops/VMRouterTopLUTs_L1PHIE.h"
+
+#pragma HLS interface ap_fifo port = hInputStubs
+#pragma HLS interface register port=bx_o
+
+	//////////////////////////////////
+	// Create memory masks, see VMRouterTop.cc
+
+	static const ap_uint<maskMEsize> maskME = VMRConfig::maskME; // ME memories
+	static const ap_uint<maskTEIsize> maskTEI = VMRConfig::maskTEI; // TE Inner memories
+	static const ap_uint<maskOLsize> maskOL = VMRConfig::maskOL; // TE Inner Overlap memories
+	static const ap_uint<maskTEOsize> maskTEO = VMRConfig::maskTEO; // TE Outer memories
+
+
+	/////////////////////////
+	// Main function
+
+	InputRouterVMRouter<inputType, outputType, kLAYER, phiRegion, numInputs, maxASCopies, maxTEICopies, maxOLCopies, maxTEOCopies, nbitsbin, bendCutTableSize>
+	(bx, bx_o, hLinkWord, hInputStubs, fineBinTable, phiCorrTable,
+		rzBitsInnerTable, rzBitsOverlapTable, nullptr,
+		bendCutInnerTable, bendCutOverlapTable, nullptr,
+		// AllStub memories
+		memoriesAS,
+		// ME memories
+		maskME, memoriesME,
+		// TEInner memories
+		maskTEI, memoriesTEI,
+		// TEInner Overlap memories
+		maskOL, memoriesOL,
+		// TEOuter memories
+		maskTEO, nullptr
+		);
+
+	return;
+}
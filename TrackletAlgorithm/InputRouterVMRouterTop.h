@@ -0,0 +1,31 @@
+#ifndef TrackletAlgorithm_InputRouterVMRouterTop_h
+#define TrackletAlgorithm_InputRouterVMRouterTop_h
+
+#include "VMRouterTop.h"
+#include "InputRouterVMRouter.h"
+
+// InputRouter/VMRouter Top Function for the VMRouter region of VMRouterTop.h,
+// layer 1, AllStub region E
+// Reads the DTC links of the input memories of the VMRouter and sorts their
+// stubs of the region into the VMs, without the InputRouter memories.
+
+// NOTE: to run a different phi region, see the list of changes in VMRouterTop.h,
+//       only the barrel layers can be run
+
+/////////////////////////////////////////////////////
+// InputRouter/VMRouter Top Function
+// Changed manually
+
+void InputRouterVMRouterTop(const BXType bx, BXType& bx_o,
+	// Input links, one per input memory of the VMRouter
+	const ap_uint<kLINKMAPwidth> hLinkWord[numInputs],
+	DTCStubStream hInputStubs[numInputs],
+
+	// Output memories
+	AllStubMemory<outputType> memoriesAS[maxASCopies],
+	VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME],
+	VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies],
+	VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies]
+	);
+
+#endif // TrackletAlgorithm_InputRouterVMRouterTop_h
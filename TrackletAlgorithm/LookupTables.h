@@ -0,0 +1,239 @@
+#ifndef TrackletAlgorithm_LookupTables_h
+#define TrackletAlgorithm_LookupTables_h
+
+#include "Constants.h"
+#include "VMProjectionMemory.h"
+#include "VMStubMEMemory.h"
+
+// Lookup tables of the processing modules, in one place.
+//
+// Each table is a static const array, initialized from its .tab file at
+// compile time, in a function specialized for the module instance that uses
+// it, i.e. for the part of the instance name that selects the table (e.g. the
+// layer of ME_L3PHIC20). The modules read the table through this function, so
+// there is no copy of the table into a local array at every call, only the
+// tables of the instances that are compiled end up in the binary, and all the
+// instances of a module share one copy. In synthesis the tables are ROMs.
+//
+// The tables are read from emData/LUTs, which emData/download.sh fills with
+// the tables of all the module instances. C-simulation test benches that
+// need a table at run time rather than at compile time can read the same
+// files with TestBenches/LookupTableFile.h.
+
+namespace LUT {
+
+// Consistency of the stub bend with the rinv of the projection, for the
+// MatchEngine of layer L. Indexed by the rinv bin of the projection
+// concatenated with the stub bend.
+template<TF::layer L> struct MatchEngineTable;
+
+template<> struct MatchEngineTable<TF::L1> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_L1.tab"
+    return table[i];
+  }
+};
+
+template<> struct MatchEngineTable<TF::L2> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_L2.tab"
+    return table[i];
+  }
+};
+
+template<> struct MatchEngineTable<TF::L3> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_L3.tab"
+    return table[i];
+  }
+};
+
+template<> struct MatchEngineTable<TF::L4> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_L4.tab"
+    return table[i];
+  }
+};
+
+template<> struct MatchEngineTable<TF::L5> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_L5.tab"
+    return table[i];
+  }
+};
+
+template<> struct MatchEngineTable<TF::L6> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_L6.tab"
+    return table[i];
+  }
+};
+
+// The same for the MatchEngine of disk D, indexed by whether the stub is on a
+// PS module concatenated with the rinv bin of the projection and the stub
+// bend: the table has the 2S bends first and then the PS bends. A table of
+// another size does not have this layout and does not compile.
+constexpr unsigned int kMatchEngineDiskTableSize =
+  1 << (1 + VMProjectionBase<DISK>::kVMProjRinvSize + VMStubMEBase<DISK>::kVMSMEBendSize);
+
+template<TF::disk D> struct MatchEngineDiskTable;
+
+template<> struct MatchEngineDiskTable<TF::D1> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_D1.tab"
+    static_assert(sizeof(table)/sizeof(table[0]) == kMatchEngineDiskTableSize, "METable_D1.tab is not indexed by (PS, rinv, bend)");
+    return table[i];
+  }
+};
+
+template<> struct MatchEngineDiskTable<TF::D2> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_D2.tab"
+    static_assert(sizeof(table)/sizeof(table[0]) == kMatchEngineDiskTableSize, "METable_D2.tab is not indexed by (PS, rinv, bend)");
+    return table[i];
+  }
+};
+
+template<> struct MatchEngineDiskTable<TF::D3> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_D3.tab"
+    static_assert(sizeof(table)/sizeof(table[0]) == kMatchEngineDiskTableSize, "METable_D3.tab is not indexed by (PS, rinv, bend)");
+    return table[i];
+  }
+};
+
+template<> struct MatchEngineDiskTable<TF::D4> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_D4.tab"
+    static_assert(sizeof(table)/sizeof(table[0]) == kMatchEngineDiskTableSize, "METable_D4.tab is not indexed by (PS, rinv, bend)");
+    return table[i];
+  }
+};
+
+template<> struct MatchEngineDiskTable<TF::D5> {
+  static ap_uint<1> lookup(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<1> table[] =
+#include "../emData/LUTs/METable_D5.tab"
+    static_assert(sizeof(table)/sizeof(table[0]) == kMatchEngineDiskTableSize, "METable_D5.tab is not indexed by (PS, rinv, bend)");
+    return table[i];
+  }
+};
+
+// Cuts on the phi and z residuals of the MatchCalculator of layer L, indexed
+// by the seed of the projection.
+template<TF::layer L> struct MatchCalculatorCuts;
+
+template<> struct MatchCalculatorCuts<TF::L1> {
+  static ap_uint<17> phi(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<17> table[] =
+#include "../emData/LUTs/MC_L1PHIC_phicut.tab"
+    return table[i];
+  }
+  static ap_uint<13> z(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<13> table[] =
+#include "../emData/LUTs/MC_L1PHIC_zcut.tab"
+    return table[i];
+  }
+};
+
+template<> struct MatchCalculatorCuts<TF::L2> {
+  static ap_uint<17> phi(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<17> table[] =
+#include "../emData/LUTs/MC_L2PHIC_phicut.tab"
+    return table[i];
+  }
+  static ap_uint<13> z(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<13> table[] =
+#include "../emData/LUTs/MC_L2PHIC_zcut.tab"
+    return table[i];
+  }
+};
+
+template<> struct MatchCalculatorCuts<TF::L3> {
+  static ap_uint<17> phi(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<17> table[] =
+#include "../emData/LUTs/MC_L3PHIC_phicut.tab"
+    return table[i];
+  }
+  static ap_uint<13> z(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<13> table[] =
+#include "../emData/LUTs/MC_L3PHIC_zcut.tab"
+    return table[i];
+  }
+};
+
+template<> struct MatchCalculatorCuts<TF::L4> {
+  static ap_uint<17> phi(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<17> table[] =
+#include "../emData/LUTs/MC_L4PHIC_phicut.tab"
+    return table[i];
+  }
+  static ap_uint<13> z(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<13> table[] =
+#include "../emData/LUTs/MC_L4PHIC_zcut.tab"
+    return table[i];
+  }
+};
+
+template<> struct MatchCalculatorCuts<TF::L5> {
+  static ap_uint<17> phi(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<17> table[] =
+#include "../emData/LUTs/MC_L5PHIC_phicut.tab"
+    return table[i];
+  }
+  static ap_uint<13> z(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<13> table[] =
+#include "../emData/LUTs/MC_L5PHIC_zcut.tab"
+    return table[i];
+  }
+};
+
+template<> struct MatchCalculatorCuts<TF::L6> {
+  static ap_uint<17> phi(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<17> table[] =
+#include "../emData/LUTs/MC_L6PHIC_phicut.tab"
+    return table[i];
+  }
+  static ap_uint<13> z(unsigned int i) {
+#pragma HLS inline
+    static const ap_uint<13> table[] =
+#include "../emData/LUTs/MC_L6PHIC_zcut.tab"
+    return table[i];
+  }
+};
+
+} // namespace LUT
+
+#endif // TrackletAlgorithm_LookupTables_h
@@ -8,124 +8,9 @@
 #include "AllStubMemory.h"
 #include "AllProjectionMemory.h"
 #include "FullMatchMemory.h"
-
-//////////////////////////////////////////////////////////////
-
-template<int layer, int part>
-void merger(
-     // inputs
-     CandidateMatch inA,
-     bool validA,
-     CandidateMatch inB,
-     bool validB,
-     CandidateMatch out,
-     bool vout,
-     bool inread,
-     CandidateMatch A,
-     bool vA,
-     bool sA,
-     CandidateMatch B,
-     bool vB,
-     bool sB,
-     // outputs
-     CandidateMatch * Anext,
-     bool * vAnext,
-     bool * sAnext,
-     CandidateMatch * Bnext,
-     bool * vBnext,
-     bool * sBnext,
-     CandidateMatch * outnext,
-     bool * voutnext,
-     bool * readA,
-     bool * readB
-){
-
-#pragma HLS inline 
-#pragma HLS pipeline II=1 rewind
-#pragma HLS interface ap_ctrl_none port=return 
-#pragma HLS interface ap_ctrl_none port=inA,validA,inB,validB,out,vout,inread,A,vA,sA,B,vB,sB 
-#pragma HLS interface ap_ctrl_none port=Anext,Bnext,vAnext,vBnext,sAnext,sBnext,voutnext 
-
-    // Set read enables for A and B
-    *readA = (((inread || !vout) && sA) || !vA) && validA;
-    *readB = (((inread || !vout) && sB) || !vB) && validB;
-
-    // Setup state machine
-    static enum {HOLD, PROC_A, PROC_B, START, DONE} state;
-    if (sA && (inread || !vout))                          state = PROC_A;
-    else if (sB && (inread || !vout))                     state = PROC_B; 
-    else if ((!sA && !sB) && (validA || validB) && !vout) state = START;
-    else if (!sB && !sA && vout && inread)                state = DONE;              
-    else                                                  state = HOLD; 
-
-    //------------- Explanation of the states -------------
-    // START:  Either inA or inB is valid & there is no valid output & neither sA or sB is set
-    //         No output yet, but set the next sA and sB and pipeline the inputs  
-    // PROC_A: sA is set & either there is an inread from the next layer or not valid output
-    //         Output is the pipelined A, and set the next sA and sB   
-    // PROC_B: sB is set & either there is an inread from the next layer or not valid output
-    //         Output is the pipelined B, and set the next sA and sB
-    // DONE:   There is an valid output & there is no inread from the next layer and neither sA or sB is set
-    //         No output, and set all reads to false
-    // HOLD:   In all other cases, pipeline everthing 
-    //-----------------------------------------------------
-
-    // Case statements
-    switch(state)
-    {
-    case PROC_A: // just readA and compare inA with pipelined B
-        *outnext  = A;      // output is A
-        *voutnext = vA;     // output valid is vA
-    	*Anext    = inA;    // pipeline inA
-    	*vAnext   = validA; // pipeline inA valid
-        *Bnext    = B;      // pipeline B
-        *vBnext   = vB;     // pipeline vB
-        *sAnext   = ((inA.getProjIndex() <= B.getProjIndex()) || !vB) && validA;  // sA=true if inA is valid and (inA <= B or B not valid)
-    	*sBnext   = (!(inA.getProjIndex() <= B.getProjIndex()) || !validA) && vB; // sB=true if B is valid and (inA > B or inA not valid)
-        break;
-    case PROC_B: // just readB and compare inB with pipelined A
-        *outnext  = B;      // output is B
-    	*voutnext = vB;     // output valid is vB
-    	*Bnext    = inB;    // pipeline inB
-    	*vBnext   = validB; // pipeline inB valid
-        *Anext    = A;      // pipeline A
-        *vAnext   = vA;     // pipeline vA
-        *sAnext   = ((A.getProjIndex() <= inB.getProjIndex()) || !validB) && vA;  // sA=true if A is valid and (A <= inB or inB not valid) 
-        *sBnext   = (!(A.getProjIndex() <= inB.getProjIndex()) || !vA) && validB; // sB=true if inB is valid and (A > inB or A not valid)
-        break;
-    case START: // both in at same time
-        *outnext  = CandidateMatch();
-    	*voutnext = false;
-    	*Anext    = inA;    // pipeline inA
-    	*vAnext   = validA; // pipeline inA valid
-    	*Bnext    = inB;    // pipeline inB
-    	*vBnext   = validB; // pipeline inB valid
-        *sAnext   = ((inA.getProjIndex() <= inB.getProjIndex()) || !validB) && validA;  // sA=true if inA is valid and (inA <= inB or inB not valid)
-        *sBnext   = (!(inA.getProjIndex() <= inB.getProjIndex()) || !validA) && validB; // sB=true if inB is valid and (inA > inB or inA not valid)
-        break;
-    case DONE: // set everything to false 
-        *outnext  = CandidateMatch();
-        *voutnext = false;
-        *Anext    = CandidateMatch();
-        *vAnext   = false;
-        *Bnext    = CandidateMatch();
-        *vBnext   = false;
-        *sAnext   = false;
-        *sBnext   = false;
-        break;
-    case HOLD: // pipeline all 
-        *outnext  = out;
-        *voutnext = vout;
-        *Anext    = A;
-        *Bnext    = B;
-        *vAnext   = vA;
-        *vBnext   = vB;
-        *sAnext   = sA;
-        *sBnext   = sB; 
-        break;
-    }
-
-}
+#include "ModuleMonitor.h"
+#include "LookupTables.h"
+#include "MergeTree.h"
 
 //////////////////////////////////////////////////////////////
 
@@ -140,88 +25,6 @@ ap_uint<width> iabs( ap_int<width> value )
   return absval;
 };
 
-//////////////////////////////////////////////////////////////
-
-// Template to get look up tables
-
-// Table for phi or z cuts
-template<bool phi, TF::layer L, int width, int depth>
-void readTable_Cuts(ap_uint<width> table[depth]){
-  if (phi){ // phi cuts
-    if (L==TF::L1){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L1PHIC_phicut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else if (L==TF::L2){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L2PHIC_phicut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else if (L==TF::L3){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L3PHIC_phicut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else if (L==TF::L4){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L4PHIC_phicut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else if (L==TF::L4){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L5PHIC_phicut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else if (L==TF::L6){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L6PHIC_phicut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else {
-      static_assert(true, "Only LAYERS 1 to 6 are valid");
-    }
-  } // end phi cuts
-  else { // z cuts
-    if (L==TF::L1){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L1PHIC_zcut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else if (L==TF::L2){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L2PHIC_zcut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else if (L==TF::L3){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L3PHIC_zcut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else if (L==TF::L4){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L4PHIC_zcut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else if (L==TF::L5){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L5PHIC_zcut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else if (L==TF::L6){
-      ap_uint<width> tmp[depth] =
-#include "../emData/MC/tables/MC_L6PHIC_zcut.tab"
-      for (int i = 0; i < depth; i++) table[i] = tmp[i];
-    }
-    else {
-      static_assert(true, "Only LAYERS 1 to 6 are valid");
-    }
- 
-  }
-
-} // end readTable_Cuts
-
-
 //////////////////////////////////////////////////////////////
 
 // MatchCalculator
@@ -267,16 +70,8 @@ void MatchCalculator(BXType bx,
   const ap_uint<10> kZ_corr_shiftL456 = (-1-kShift_2S_zderL + kNbitszprojL123 - kNbitszprojL456 + kNbitsrL456 - kNbitsrL123); // icorzshift for L456
   const auto kZ_corr_shift       = (1 <= LAYER <= 3)? kZ_corr_shiftL123 : kZ_corr_shiftL456;                                  // icorzshift_ in emulation
 
-  const auto LUT_matchcut_phi_width = 17;
-  const auto LUT_matchcut_phi_depth = 12;
-  const auto LUT_matchcut_z_width = 13;
-  const auto LUT_matchcut_z_depth = 12;
-
-  // Setup look up tables for match cuts
-  ap_uint<LUT_matchcut_phi_width> LUT_matchcut_phi[LUT_matchcut_phi_depth];
-  readTable_Cuts<true,LAYER,LUT_matchcut_phi_width,LUT_matchcut_phi_depth>(LUT_matchcut_phi);
-  ap_uint<LUT_matchcut_z_width> LUT_matchcut_z[LUT_matchcut_z_depth];
-  readTable_Cuts<false,LAYER,LUT_matchcut_z_width,LUT_matchcut_z_depth>(LUT_matchcut_z);
+  // Look up tables for match cuts (LookupTables.h)
+  typedef LUT::MatchCalculatorCuts<LAYER> LUT_matchcut;
 
   // Initialize MC delta phi cut variables
   ap_uint<17> best_delta_phi;
@@ -285,36 +80,22 @@ void MatchCalculator(BXType bx,
   CandidateMatch::CMProjIndex id;
   CandidateMatch::CMProjIndex id_next;
 
-  ap_uint<kNBits_MemAddr> ncm1 = 0; 
-  ap_uint<kNBits_MemAddr> ncm2 = 0;
-  ap_uint<kNBits_MemAddr> ncm3 = 0;
-  ap_uint<kNBits_MemAddr> ncm4 = 0;
-  ap_uint<kNBits_MemAddr> ncm5 = 0;
-  ap_uint<kNBits_MemAddr> ncm6 = 0;
-  ap_uint<kNBits_MemAddr> ncm7 = 0;
-  ap_uint<kNBits_MemAddr> ncm8 = 0;
-  ap_uint<kNBits_MemAddr+1> total  = 0;
+  // Number of candidate matches in each CM memory and in total
+  ap_uint<kNBits_MemAddr> ncmem[MaxMatchCopies];
+#pragma HLS array_partition variable=ncmem complete
+  ap_uint<kNBits_MemAddr+4> total  = 0;
   ap_uint<kNBits_MemAddr> ncm = 0;
 
-  // Initialize read addresses for candidate matches
-  ap_uint<kNBits_MemAddr> addr1 = 0;  
-  ap_uint<kNBits_MemAddr> addr2 = 0;  
-  ap_uint<kNBits_MemAddr> addr3 = 0;  
-  ap_uint<kNBits_MemAddr> addr4 = 0;  
-  ap_uint<kNBits_MemAddr> addr5 = 0;  
-  ap_uint<kNBits_MemAddr> addr6 = 0;  
-  ap_uint<kNBits_MemAddr> addr7 = 0;  
-  ap_uint<kNBits_MemAddr> addr8 = 0; 
-
-  // Read signals for the input candidate matches
-  bool read1 = false;
-  bool read2 = false;
-  bool read3 = false;
-  bool read4 = false;
-  bool read5 = false;
-  bool read6 = false;
-  bool read7 = false;
-  bool read8 = false;
+  // Read addresses and read signals for the input candidate matches
+  ap_uint<kNBits_MemAddr> addr[MaxMatchCopies];
+  bool read[MaxMatchCopies];
+#pragma HLS array_partition variable=addr complete
+#pragma HLS array_partition variable=read complete
+  init_read: for (int i = 0; i < MaxMatchCopies; ++i) {
+#pragma HLS unroll
+    addr[i] = 0;
+    read[i] = false;
+  }
 
   // MC_L3PHIC mask {1: on, 0: off}
   //static const uint16_t FML1L2 = 1 << shift_L1L2;
@@ -326,76 +107,9 @@ void MatchCalculator(BXType bx,
   //static const uint16_t FML1D1 = 0 << shift_L1D1;
   //static const uint16_t FML2D1 = 0 << shift_L2D1;
 
-  // Variables for the merger
-  // layer 1 variables
-  bool read_L1_1 = false;
-  bool read_L1_2 = false;
-  bool read_L1_3 = false;
-  bool read_L1_4 = false;
-  CandidateMatch cm_L1_1 = CandidateMatch();
-  CandidateMatch cm_L1_2 = CandidateMatch();
-  CandidateMatch cm_L1_3 = CandidateMatch();
-  CandidateMatch cm_L1_4 = CandidateMatch();
-  CandidateMatch tmpA_L1_1 = CandidateMatch();
-  CandidateMatch tmpA_L1_2 = CandidateMatch();
-  CandidateMatch tmpA_L1_3 = CandidateMatch();
-  CandidateMatch tmpA_L1_4 = CandidateMatch();
-  CandidateMatch tmpB_L1_1 = CandidateMatch();
-  CandidateMatch tmpB_L1_2 = CandidateMatch();
-  CandidateMatch tmpB_L1_3 = CandidateMatch();
-  CandidateMatch tmpB_L1_4 = CandidateMatch();
-  bool valid_L1_1 = false; 
-  bool valid_L1_2 = false; 
-  bool valid_L1_3 = false; 
-  bool valid_L1_4 = false; 
-  bool vA_L1_1 = false; 
-  bool vA_L1_2 = false; 
-  bool vA_L1_3 = false; 
-  bool vA_L1_4 = false; 
-  bool vB_L1_1 = false; 
-  bool vB_L1_2 = false; 
-  bool vB_L1_3 = false; 
-  bool vB_L1_4 = false; 
-  bool sA_L1_1 = false; 
-  bool sA_L1_2 = false; 
-  bool sA_L1_3 = false; 
-  bool sA_L1_4 = false; 
-  bool sB_L1_1 = false; 
-  bool sB_L1_2 = false; 
-  bool sB_L1_3 = false; 
-  bool sB_L1_4 = false; 
-
-  // layer 2 variables
-  bool read_L2_1 = false;
-  bool read_L2_2 = false;
-  CandidateMatch cm_L2_1 = CandidateMatch();
-  CandidateMatch cm_L2_2 = CandidateMatch();
-  CandidateMatch tmpA_L2_1 = CandidateMatch();
-  CandidateMatch tmpA_L2_2 = CandidateMatch();
-  CandidateMatch tmpB_L2_1 = CandidateMatch();
-  CandidateMatch tmpB_L2_2 = CandidateMatch();
-  bool valid_L2_1 = false; 
-  bool valid_L2_2 = false; 
-  bool vA_L2_1 = false; 
-  bool vA_L2_2 = false; 
-  bool vB_L2_1 = false; 
-  bool vB_L2_2 = false; 
-  bool sA_L2_1 = false; 
-  bool sA_L2_2 = false; 
-  bool sB_L2_1 = false; 
-  bool sB_L2_2 = false; 
-
-  // layer 3 variables
-  CandidateMatch tmpA_L3;
-  CandidateMatch tmpB_L3;
-  bool valid_L3 = false;
-  bool vA_L3 = false;
-  bool vB_L3 = false;
-  bool sA_L3 = false;
-  bool sB_L3 = false;
-  
-  // Setup candidate match data stream that goes into match calculations
-  CandidateMatch datastream = CandidateMatch();
+  // Merge tree of the candidate matches of all the CM memories, ordered by
+  // projection index (MergeTree.h)
+  MergeTree<CandidateMatch, MaxMatchCopies> merge;
 
   // Full match shift register to store best match
   typename AllProjection<APTYPE>::AProjTCSEED projseed;
@@ -415,302 +129,52 @@ void MatchCalculator(BXType bx,
   ap_uint<kNBits_MemAddr> nmcout6 = 0;
   ap_uint<kNBits_MemAddr> nmcout7 = 0;
   ap_uint<kNBits_MemAddr> nmcout8 = 0;  
+
+  ModuleMonitor monitor(module::MC, bx);
+
   MC_LOOP: for (ap_uint<kNBits_MemAddr> istep = 0; istep < kMaxProc - kMaxProcOffset(module::MC); istep++)
   {
 
 #pragma HLS PIPELINE II=1 
 
     // Pick up number of candidate matches for each CM memory
-    ncm1 = match[0].getEntries(bx);
-    ncm2 = match[1].getEntries(bx);
-    ncm3 = match[2].getEntries(bx);
-    ncm4 = match[3].getEntries(bx);
-    ncm5 = match[4].getEntries(bx);
-    ncm6 = match[5].getEntries(bx);
-    ncm7 = match[6].getEntries(bx);
-    ncm8 = match[7].getEntries(bx);
-
     // Count up total number of CMs *and protect incase of overflow)
-    total  = ncm1+ncm2+ncm3+ncm4+ncm5+ncm6+ncm7+ncm8; 
+    total = 0;
+    count_cm: for (int i = 0; i < MaxMatchCopies; ++i) {
+#pragma HLS unroll
+      ncmem[i] = match[i].getEntries(bx);
+      total += ncmem[i];
+    }
     ncm    = (total > kMaxProc)? kMaxProc : total.range(7,0);
 
-    // pipeline variables
-    bool read_L1_1_next = false;
-    bool read_L1_2_next = false;
-    bool read_L1_3_next = false;
-    bool read_L1_4_next = false;
-    CandidateMatch cm_L1_1_next = CandidateMatch();
-    CandidateMatch cm_L1_2_next = CandidateMatch();
-    CandidateMatch cm_L1_3_next = CandidateMatch();
-    CandidateMatch cm_L1_4_next = CandidateMatch();
-    CandidateMatch tmpA_L1_1_next = CandidateMatch();
-    CandidateMatch tmpA_L1_2_next = CandidateMatch();
-    CandidateMatch tmpA_L1_3_next = CandidateMatch();
-    CandidateMatch tmpA_L1_4_next = CandidateMatch();
-    CandidateMatch tmpB_L1_1_next = CandidateMatch();
-    CandidateMatch tmpB_L1_2_next = CandidateMatch();
-    CandidateMatch tmpB_L1_3_next = CandidateMatch();
-    CandidateMatch tmpB_L1_4_next = CandidateMatch();
-    bool valid_L1_1_next = false;
-    bool valid_L1_2_next = false;
-    bool valid_L1_3_next = false;
-    bool valid_L1_4_next = false;
-    bool vA_L1_1_next = false; 
-    bool vA_L1_2_next = false; 
-    bool vA_L1_3_next = false; 
-    bool vA_L1_4_next = false; 
-    bool vB_L1_1_next = false; 
-    bool vB_L1_2_next = false; 
-    bool vB_L1_3_next = false; 
-    bool vB_L1_4_next = false; 
-    bool sA_L1_1_next = false; 
-    bool sA_L1_2_next = false; 
-    bool sA_L1_3_next = false; 
-    bool sA_L1_4_next = false; 
-    bool sB_L1_1_next = false; 
-    bool sB_L1_2_next = false; 
-    bool sB_L1_3_next = false; 
-    bool sB_L1_4_next = false; 
-
-    bool read_L2_1_next = false;
-    bool read_L2_2_next = false;
-    CandidateMatch cm_L2_1_next = CandidateMatch();
-    CandidateMatch cm_L2_2_next = CandidateMatch();
-    CandidateMatch tmpA_L2_1_next = CandidateMatch();
-    CandidateMatch tmpA_L2_2_next = CandidateMatch();
-    CandidateMatch tmpB_L2_1_next = CandidateMatch();
-    CandidateMatch tmpB_L2_2_next = CandidateMatch();
-    bool valid_L2_1_next = false; 
-    bool valid_L2_2_next = false; 
-    bool vA_L2_1_next = false; 
-    bool vA_L2_2_next = false; 
-    bool vB_L2_1_next = false; 
-    bool vB_L2_2_next = false; 
-    bool sA_L2_1_next = false; 
-    bool sA_L2_2_next = false; 
-    bool sB_L2_1_next = false; 
-    bool sB_L2_2_next = false; 
-
-    CandidateMatch cm_L3_next;
-    CandidateMatch tmpA_L3_next;
-    CandidateMatch tmpB_L3_next; 
-    bool valid_L3_next = false;
-    bool vA_L3_next = false;
-    bool vB_L3_next = false;
-    bool sA_L3_next = false;
-    bool sB_L3_next = false;
-    bool read1_next = false;
-    bool read2_next = false;
-    bool read3_next = false;
-    bool read4_next = false;
-    bool read5_next = false;
-    bool read6_next = false;
-    bool read7_next = false;
-    bool read8_next = false;
-
+    if (istep == 0) monitor.inputs(total);
 
     //-----------------------------------------------------------------------------------------------------------
     //-------------------------------- MERGE INPUT CANDIDATE MATCHES --------------------------------------------
     //-----------------------------------------------------------------------------------------------------------
 
-    // Increment the read addresses for the candidate matches
-
-    if (read1) addr1++;
-    if (read2) addr2++;
-    if (read3) addr3++;
-    if (read4) addr4++;
-    if (read5) addr5++;
-    if (read6) addr6++;
-    if (read7) addr7++;
-    if (read8) addr8++;
-
-    // Read in each candidate match
-    const CandidateMatch &cm1 = match[0].read_mem(bx,addr1);
-    const CandidateMatch &cm2 = match[1].read_mem(bx,addr2);
-    const CandidateMatch &cm3 = match[2].read_mem(bx,addr3); 
-    const CandidateMatch &cm4 = match[3].read_mem(bx,addr4); 
-    const CandidateMatch &cm5 = match[4].read_mem(bx,addr5); 
-    const CandidateMatch &cm6 = match[5].read_mem(bx,addr6); 
-    const CandidateMatch &cm7 = match[6].read_mem(bx,addr7); 
-    const CandidateMatch &cm8 = match[7].read_mem(bx,addr8); 
-
-    // Valid signal for the candidate match
-    bool valid1 = (addr1 < ncm1) && (ncm1 > 0);
-    bool valid2 = (addr2 < ncm2) && (ncm2 > 0);
-    bool valid3 = (addr3 < ncm3) && (ncm3 > 0);
-    bool valid4 = (addr4 < ncm4) && (ncm4 > 0);
-    bool valid5 = (addr5 < ncm5) && (ncm5 > 0);
-    bool valid6 = (addr6 < ncm6) && (ncm6 > 0);
-    bool valid7 = (addr7 < ncm7) && (ncm7 > 0);
-    bool valid8 = (addr8 < ncm8) && (ncm8 > 0);
-
-    // merger Layer 1 Part 1
-    merger<1,1>(
-      cm1, valid1, cm2, valid2,                      // inputs: inA, validA, inB, validB
-      cm_L1_1, valid_L1_1, read_L1_1,                // inputs: out, vout, inread from L2_1
-      tmpA_L1_1, vA_L1_1, sA_L1_1,                   // tmp variables internal to L1_1 merger
-      tmpB_L1_1, vB_L1_1, sB_L1_1,                   // tmp variables internal to L1_1 merger
-      &tmpA_L1_1_next, &vA_L1_1_next, &sA_L1_1_next, // tmp variables internal to L1_1 merger
-      &tmpB_L1_1_next, &vB_L1_1_next, &sB_L1_1_next, // tmp variables internal to L1_1 merger
-      &cm_L1_1_next, &valid_L1_1_next,               // outputs: out, vout
-      &read1_next, &read2_next                       // outputs: read1, read2 
-    );
-
-    // merger Layer 1 Part 2
-    merger<1,2>(
-      cm3, valid3, cm4, valid4,                      // inputs: inA, validA, inB, validB
-      cm_L1_2, valid_L1_2, read_L1_2,                // inputs: out, vout, inread from L2_1
-      tmpA_L1_2, vA_L1_2, sA_L1_2,                   // tmp variables internal to L1_2 merger
-      tmpB_L1_2, vB_L1_2, sB_L1_2,                   // tmp variables internal to L1_2 merger
-      &tmpA_L1_2_next, &vA_L1_2_next, &sA_L1_2_next, // tmp variables internal to L1_2 merger
-      &tmpB_L1_2_next, &vB_L1_2_next, &sB_L1_2_next, // tmp variables internal to L1_2 merger
-      &cm_L1_2_next, &valid_L1_2_next,               // outputs: out, vout
-      &read3_next, &read4_next                       // outputs: read3, read4 
-    );
-
-    // merger Layer 1 Part 3 
-    merger<1,3>(
-      cm5, valid5, cm6, valid6,                      // inputs: inA, validA, inB, validB
-      cm_L1_3, valid_L1_3, read_L1_3,                // inputs: out, vout, inread from L2_1
-      tmpA_L1_3, vA_L1_3, sA_L1_3,                   // tmp variables internal to L1_3 merger
-      tmpB_L1_3, vB_L1_3, sB_L1_3,                   // tmp variables internal to L1_3 merger
-      &tmpA_L1_3_next, &vA_L1_3_next, &sA_L1_3_next, // tmp variables internal to L1_3 merger
-      &tmpB_L1_3_next, &vB_L1_3_next, &sB_L1_3_next, // tmp variables internal to L1_3 merger
-      &cm_L1_3_next, &valid_L1_3_next,               // outputs: out, vout
-      &read5_next, &read6_next                       // outputs: read5, read6 
-    );
-
-    // merger Layer 1 Part 4  
-    merger<1,4>(
-      cm7, valid7, cm8, valid8,                      // inputs: inA, validA, inB, validB
-      cm_L1_4, valid_L1_4, read_L1_4,                // inputs: out, vout, inread from L2_1
-      tmpA_L1_4, vA_L1_4, sA_L1_4,                   // tmp variables internal to L1_4 merger
-      tmpB_L1_4, vB_L1_4, sB_L1_4,                   // tmp variables internal to L1_4 merger
-      &tmpA_L1_4_next, &vA_L1_4_next, &sA_L1_4_next, // tmp variables internal to L1_4 merger
-      &tmpB_L1_4_next, &vB_L1_4_next, &sB_L1_4_next, // tmp variables internal to L1_4 merger
-      &cm_L1_4_next, &valid_L1_4_next,               // outputs: out, vout
-      &read7_next, &read8_next                       // outputs: read7, read8 
-    );
-
-    // merger Layer 2 Part 1
-    merger<2,1>(
-      cm_L1_1_next, valid_L1_1_next,                 // inputs: inA, validA
-      cm_L1_2_next, valid_L1_2_next,                 // inputs: inB, validB
-      cm_L2_1, valid_L2_1, read_L2_1,                // inputs: out, vout, inread from L3_1
-      tmpA_L2_1, vA_L2_1, sA_L2_1,                   // tmp variables internal to L2_1 merger
-      tmpB_L2_1, vB_L2_1, sB_L2_1,                   // tmp variables internal to L2_1 merger
-      &tmpA_L2_1_next, &vA_L2_1_next, &sA_L2_1_next, // tmp variables internal to L2_1 merger
-      &tmpB_L2_1_next, &vB_L2_1_next, &sB_L2_1_next, // tmp variables internal to L2_1 merger
-      &cm_L2_1_next, &valid_L2_1_next,               // outputs: out, vout
-      &read_L1_1_next, &read_L1_2_next               // outputs: read_L1_1, read_L1_2
-    );
-
-    // merger Layer 2 Part 2
-    merger<2,2>(
-      cm_L1_3_next, valid_L1_3_next,                 // inputs: inA, validA 
-      cm_L1_4_next, valid_L1_4_next,                 // inputs: inB, validB
-      cm_L2_2, valid_L2_2, read_L2_2,                // inputs: out, vout, inread from L3_1
-      tmpA_L2_2, vA_L2_2, sA_L2_2,                   // tmp variables internal to L2_2 merger
-      tmpB_L2_2, vB_L2_2, sB_L2_2,                   // tmp variables internal to L2_2 merger
-      &tmpA_L2_2_next, &vA_L2_2_next, &sA_L2_2_next, // tmp variables internal to L2_2 merger
-      &tmpB_L2_2_next, &vB_L2_2_next, &sB_L2_2_next, // tmp variables internal to L2_2 merger
-      &cm_L2_2_next, &valid_L2_2_next,               // outputs: out, vout
-      &read_L1_3_next, &read_L1_4_next               // outputs: read_L1_3, read_L1_4
-    );
-
-    // merger Layer 3 Part 1
-    merger<3,1>(
-      cm_L2_1_next, valid_L2_1_next,           // inputs: inA, validA 
-      cm_L2_2_next, valid_L2_2_next,           // inputs: inB, validB
-      datastream, valid_L3, true,              // inputs: out, vout, true inread because last layer
-      tmpA_L3, vA_L3, sA_L3,                   // tmp variables internal to L3_1 merger
-      tmpB_L3, vB_L3, sB_L3,                   // tmp variables internal to L3_1 merger
-      &tmpA_L3_next, &vA_L3_next, &sA_L3_next, // tmp variables internal to L3_1 merger
-      &tmpB_L3_next, &vB_L3_next, &sB_L3_next, // tmp variables internal to L3_1 merger
-      &cm_L3_next, &valid_L3_next,             // outputs: out, vout
-      &read_L2_1_next, &read_L2_2_next         // outputs: read_L2_1, read_L2_2
-    );
-
-    // pipeline the variables
-    // set up the inputs for the next iteration of the loop
-
-    read1      = read1_next;
-    read2      = read2_next;
-    read3      = read3_next;
-    read4      = read4_next;
-    read5      = read5_next;
-    read6      = read6_next;
-    read7      = read7_next;
-    read8      = read8_next;
-
-    read_L1_1  = read_L1_1_next;
-    read_L1_2  = read_L1_2_next;
-    read_L1_3  = read_L1_3_next;
-    read_L1_4  = read_L1_4_next;
-    read_L2_1  = read_L2_1_next;
-    read_L2_2  = read_L2_2_next;
-
-    cm_L1_1    = cm_L1_1_next;
-    cm_L1_2    = cm_L1_2_next;
-    cm_L1_3    = cm_L1_3_next;
-    cm_L1_4    = cm_L1_4_next;
-    cm_L2_1    = cm_L2_1_next;
-    cm_L2_2    = cm_L2_2_next;
-    datastream = cm_L3_next;
-
-    valid_L1_1 = valid_L1_1_next;
-    valid_L1_2 = valid_L1_2_next;
-    valid_L1_3 = valid_L1_3_next;
-    valid_L1_4 = valid_L1_4_next;
-    valid_L2_1 = valid_L2_1_next;
-    valid_L2_2 = valid_L2_2_next;
-    valid_L3   = valid_L3_next;
-
-    tmpA_L1_1 = tmpA_L1_1_next;
-    tmpA_L1_2 = tmpA_L1_2_next;
-    tmpA_L1_3 = tmpA_L1_3_next;
-    tmpA_L1_4 = tmpA_L1_4_next;
-    tmpB_L1_1 = tmpB_L1_1_next;
-    tmpB_L1_2 = tmpB_L1_2_next;
-    tmpB_L1_3 = tmpB_L1_3_next;
-    tmpB_L1_4 = tmpB_L1_4_next;
-
-    tmpA_L2_1 = tmpA_L2_1_next;
-    tmpA_L2_2 = tmpA_L2_2_next;
-    tmpB_L2_1 = tmpB_L2_1_next;
-    tmpB_L2_2 = tmpB_L2_2_next;
-    tmpA_L3   = tmpA_L3_next;
-    tmpB_L3   = tmpB_L3_next;
-    
-    vA_L1_1   = vA_L1_1_next; 
-    vA_L1_2   = vA_L1_2_next; 
-    vA_L1_3   = vA_L1_3_next; 
-    vA_L1_4   = vA_L1_4_next; 
-    vB_L1_1   = vB_L1_1_next; 
-    vB_L1_2   = vB_L1_2_next; 
-    vB_L1_3   = vB_L1_3_next; 
-    vB_L1_4   = vB_L1_4_next; 
-    vA_L2_1   = vA_L2_1_next; 
-    vA_L2_2   = vA_L2_2_next; 
-    vB_L2_1   = vB_L2_1_next; 
-    vB_L2_2   = vB_L2_2_next;
-    vA_L3     = vA_L3_next;
-    vB_L3     = vB_L3_next; 
-
-    sA_L1_1   = sA_L1_1_next; 
-    sA_L1_2   = sA_L1_2_next; 
-    sA_L1_3   = sA_L1_3_next; 
-    sA_L1_4   = sA_L1_4_next; 
-    sB_L1_1   = sB_L1_1_next; 
-    sB_L1_2   = sB_L1_2_next; 
-    sB_L1_3   = sB_L1_3_next; 
-    sB_L1_4   = sB_L1_4_next; 
-    sA_L2_1   = sA_L2_1_next; 
-    sA_L2_2   = sA_L2_2_next; 
-    sB_L2_1   = sB_L2_1_next; 
-    sB_L2_2   = sB_L2_2_next;
-    sA_L3     = sA_L3_next;
-    sB_L3     = sB_L3_next; 
+    // Increment the read addresses for the candidate matches, read in each
+    // candidate match and set its valid signal
+    CandidateMatch cm[MaxMatchCopies];
+    bool valid[MaxMatchCopies];
+#pragma HLS array_partition variable=cm complete
+#pragma HLS array_partition variable=valid complete
+    read_cm: for (int i = 0; i < MaxMatchCopies; ++i) {
+#pragma HLS unroll
+      if (read[i]) addr[i]++;
+      cm[i] = match[i].read_mem(bx,addr[i]);
+      valid[i] = (addr[i] < ncmem[i]) && (ncmem[i] > 0);
+    }
+
+    // One step of the merge tree, which gives the read signals for the next
+    // iteration of the loop
+    merge.step(cm, valid, read);
+    const CandidateMatch datastream = merge.out();
+    const bool valid_L3 = merge.valid();
+
+    // Each candidate match leaves the merge tree once, on datastream
+    monitor.step(valid_L3);
+    monitor.read(valid_L3);
 
     //-----------------------------------------------------------------------------------------------------------
     //-------------------------------------- MATCH CALCULATION STEPS --------------------------------------------
@@ -786,10 +250,10 @@ void MatchCalculator(BXType bx,
     bool goodmatch_next              = false;
 
     // For first tracklet, pick up the phi cut value
-    best_delta_phi = (newtracklet)? LUT_matchcut_phi[proj_seed] : best_delta_phi;
+    best_delta_phi = (newtracklet)? LUT_matchcut::phi(proj_seed) : best_delta_phi;
   
     // Check that matches fall within the selection window of the projection 
-    if ((abs_delta_z <= LUT_matchcut_z[proj_seed]) && (abs_delta_phi <= best_delta_phi)){
+    if ((abs_delta_z <= LUT_matchcut::z(proj_seed)) && (abs_delta_phi <= best_delta_phi)){
       // Update values of best phi parameters, so that the next match
       // will be compared to this value instead of the original selection cut
       best_delta_phi = abs_delta_phi;
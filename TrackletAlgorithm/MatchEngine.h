@@ -6,6 +6,8 @@
 #include "VMProjectionMemory.h"
 #include "VMStubMEMemory.h"
 #include "CandidateMatchMemory.h"
+#include "ModuleMonitor.h"
+#include "LookupTables.h"
 
 // HLS Headers
 #include "hls_math.h"
@@ -54,64 +56,301 @@
 				  + IS_REPRESENTIBLE_IN_D_BITS(32, N)    \
 				  )                                      \
 	  )
+// Barrel layer of MatchEngineTop, the disk MatchEngine is MatchEngineTop_D1
 #define LAYER 3
-//Options: BARREL and DISK
 #define PROJECTIONTYPE BARREL
 #if (LAYER >= 1) && (LAYER <= 3)
 	#define MODULETYPE BARRELPS
 #elif (LAYER >= 4) && (LAYER <= 6)
 	#define MODULETYPE BARREL2S
 #endif
-#if LAYER
-  #define NBITBIN 3
-#else
-  #define NBITBIN 4
-#endif
+#define NBITBIN ME::nBitsBin(LAYER)
 
 #define RINVSTEPS 32
 //BARRELPS=256 and BARREL2S=512
 #define LSIZE RINVSTEPS*(1<<VMStubME<MODULETYPE>::kVMSMEBendSize)
 #define BUFFERSIZE 8
 constexpr unsigned int kNBits_BufferAddr=BITS_TO_REPRESENT(BUFFERSIZE-1);
-constexpr int kBufferDataSize = VMStubMEMemory<MODULETYPE,NBITBIN>::kNBitDataAddr   // number of bits for stubs array size
-							  + VMProjection<PROJECTIONTYPE>::kVMProjectionSize	// projection data size
-							  + MEBinsBits										// number of bits for index of z-bin
-							  + 1;												// z-bin flag (0 => first bin, 1 => second bin)
 namespace ME {
-	enum BitLocations {
-		// The location of the least significant bit (LSB) and most significant bit (MSB) in the ME buffer word for different fields
-		kVMMESecondLSB = 0,
-		kVMMESecondMSB = 0,
-		kVMMEZBinLSB = kVMMESecondMSB + 1,
-		kVMMEZBinMSB = kVMMEZBinLSB + MEBinsBits - 1,
-		kVMMEProjectionLSB = kVMMEZBinMSB + 1,
-		kVMMEProjectionMSB = kVMMEProjectionLSB + VMProjection<PROJECTIONTYPE>::kVMProjectionSize - 1,
-		kVMMENStubsLSB = kVMMEProjectionMSB + 1,
-		kVMMENStubsMSB = kVMMENStubsLSB + VMStubMEMemory<MODULETYPE,NBITBIN>::kNBitDataAddr - 1
+	// Number of bits of the bin of the VMStubME memories: the 8 z-bins of a
+	// barrel layer, or the 8 r-bins of the positive and of the negative disk.
+	constexpr int nBitsBin(int layer) { return layer ? MEBinsBits : MEBinsBits + 1; }
+
+	// Buffer word of the MatchEngine, see MatchEngine() below
+	template<int VMSMEType, int VMPMEType, int NBitsBin>
+	struct BufferWord {
+		enum BitLocations {
+			// The location of the least significant bit (LSB) and most significant bit (MSB) in the ME buffer word for different fields
+			kVMMESecondLSB = 0,
+			kVMMESecondMSB = 0,
+			kVMMEZBinLSB = kVMMESecondMSB + 1,
+			kVMMEZBinMSB = kVMMEZBinLSB + NBitsBin - 1,
+			kVMMEProjectionLSB = kVMMEZBinMSB + 1,
+			kVMMEProjectionMSB = kVMMEProjectionLSB + VMProjection<VMPMEType>::kVMProjectionSize - 1,
+			kVMMENStubsLSB = kVMMEProjectionMSB + 1,
+			kVMMENStubsMSB = kVMMENStubsLSB + VMStubMEMemory<VMSMEType,NBitsBin>::kNBitDataAddr - 1,
+			kBufferDataSize = kVMMENStubsMSB + 1
+		};
 	};
+
 	enum StubZPositionBarrelConsistency {
 		kPSMin = -2,
 		kPSMax = 2,
 		k2SMin = -5,
 		k2SMax = 5
 	};
+	enum StubRPositionDiskConsistency {
+		kDiskPSMin = -1,
+		kDiskPSMax = 1,
+		kDisk2SMin = -5,
+		kDisk2SMax = 5
+	};
+
+	// Bend-rinv consistency table of the layer or disk (LookupTables.h)
+	template<int Layer, int Disk> struct Table {
+		typedef LUT::MatchEngineTable<TF::layer(Layer-1)> type;
+	};
+	template<int Disk> struct Table<0, Disk> {
+		typedef LUT::MatchEngineDiskTable<TF::disk(Disk-1)> type;
+	};
 }
 constexpr unsigned int kZAdjustment = 8;
 
 /////////////////////////////
 // -- MATCH ENGINE FUNCTIONS
-void readTable(bool table[LSIZE]);
-
-//template<int L, regionType VMSMEType>
-template<int L, int VMSMEType>
+// Layer is the barrel layer (1-6), or 0 for the disk Disk (1-5). In the
+// barrel the stubs are binned in z and the projections have a PS seed flag, in
+// the disks the stubs are binned in r, with 8 more bins for the negative disk,
+// and whether the stub is on a PS module sets the r and bend cuts instead.
+// NBitsBuffer sets the size of the buffer of projections and z-bins waiting
+// to be matched, 1<<NBitsBuffer
+template<int Layer, int Disk, int VMSMEType, int VMPMEType, unsigned int NBitsBuffer = kNBits_BufferAddr>
 void MatchEngine(const BXType bx, BXType& bx_o,
-		 		 const VMStubMEMemory<VMSMEType, NBITBIN>& inputStubData,
-		 		 const VMProjectionMemory<PROJECTIONTYPE>& inputProjectionData,
-		 		 CandidateMatchMemory& outputCandidateMatch);
+				 const VMStubMEMemory<VMSMEType, ME::nBitsBin(Layer)>& inputStubData,
+				 const VMProjectionMemory<VMPMEType>& inputProjectionData,
+				 CandidateMatchMemory& outputCandidateMatch) {
+#pragma HLS inline
+	constexpr int nbitsbin = ME::nBitsBin(Layer);
+	typedef ME::BufferWord<VMSMEType, VMPMEType, nbitsbin> BufferWord;
+	constexpr int nbitsstubaddr = VMStubMEMemory<VMSMEType, nbitsbin>::kNBitDataAddr;
+
+	//
+	// Table for bend-rinv consistency (LookupTables.h)
+	//
+	typedef typename ME::Table<Layer, Disk>::type table;
+
+	//
+	// Set up a FIFO based on a circular buffer structure.
+	// Projection memory is read and if projections points to nonempty zbin for the stubs it is stored on this buffer.
+	// The projection reading will stop if buffer is full and continue after the buffer is drained.
+	// Each element consists of
+	//   * NBitsBuffer is the number of bits to handle buffer index (i.e. buffer size will be 1<<NBitsBuffer).
+	//   * kBufferDataSize is the size of each element in the buffer. The element data consists of, in order of MSB to LSB:
+	//       [# of stubs in z-bin][projection data][index of z-bin][z-bin flag]
+	//
+	ap_uint<BufferWord::kBufferDataSize> projectionBuffer[1<<NBitsBuffer];
+	#pragma HLS ARRAY_PARTITION variable=projectionBuffer complete dim=0
+	ap_uint<NBitsBuffer> head_writeindex = 0;	// handles current buffer index for writing
+	ap_uint<NBitsBuffer> tail_readindex = 0;	// handles current buffer index for reading
+
+	// The next projection to read, the number of projections and flag if we have more projections to read
+	ap_uint<kNBits_MemAddr> iprojection = 0;
+	auto const nproj = inputProjectionData.getEntries(bx);
+	bool moreProjectionsAvailable = iprojection < nproj;
+
+	ModuleMonitor monitor(module::ME, bx);
+	monitor.inputs(nproj);
+
+	// Variables for the projection
+	typename VMProjection<VMPMEType>::VMPID projindex;
+	typename VMProjection<VMPMEType>::VMPFINEZ projfinez;
+	typename VMProjection<VMPMEType>::VMPRINV projrinv;
+	ap_uint<nbitsbin> zbin = 0;
+	ap_uint<kNBits_MemAddr> ncmatch = 0;
+	bool isPSseed;
+	bool second;
+
+	// Number of stubs for current zbin and the stub being processed on this clock
+	ap_uint<nbitsstubaddr> nstubs=0;
+	ap_uint<nbitsstubaddr> istub=0;
+	#pragma HLS dependence variable=istub intra WAR true
+
+#ifdef DEBUG
+	std::cout << "ProjectionIndex\tStubIndex\t<=== (PASS/FAIL)" << std::endl;
+#endif
+
+	// Main processing loops starts here.
+	// Seven iterations are subtracted so that the total latency is 108 clock
+	// cycles. Pipeline rewinding does not currently work.
+	STEP_LOOP: for (ap_uint<kNBits_MemAddr> istep=0; istep<kMaxProc - kMaxProcOffset(module::ME); istep++) {
+		#pragma HLS PIPELINE II=1 rewind
+		#pragma HLS DEPENDENCE variable=tail_readindex inter false
+
+		// Pre-fetch an element from the buffer
+		auto const qdata=projectionBuffer[tail_readindex];
+
+		// The buffer is not full if 2 slots are available as we may write stubs for up to 2 z-bins
+		ap_uint<NBitsBuffer> head_writeindexplus     = head_writeindex+1;
+		ap_uint<NBitsBuffer> head_writeindexplusplus = head_writeindex+2;
+		bool bufferNotFull = (head_writeindexplus!=tail_readindex) && (head_writeindexplusplus!=tail_readindex);
+
+		// The buffer is not empty when current write index and read index are different
+		// With this you have to assume the buffer will never be absolutely full
+		bool bufferNotEmpty = head_writeindex != tail_readindex;
+
+		monitor.step(bufferNotEmpty, moreProjectionsAvailable && !bufferNotFull);
+
+		// If we have more projections and the buffer is not full we read
+		// next projection and put in buffer if there are stubs in the 
+		// memory the to which the projection points
+		if (moreProjectionsAvailable && bufferNotFull) {
+			auto const iprojectiontmp=iprojection;
+			auto const projectiondatatmp=inputProjectionData.read_mem(bx,iprojectiontmp);
+			iprojection++;
+			moreProjectionsAvailable=iprojection<nproj;
+			monitor.read();
 
+			// The first and last zbin the projection points to. For the disks
+			// the sign of the disk is the top bit, as in the stub memory.
+			auto const projectionzbitstmp=projectiondatatmp.getZBin();
+			ap_uint<nbitsbin> zbinfirst=projectionzbitstmp.range(nbitsbin,1);
+			ap_uint<nbitsbin> zbinlast=zbinfirst + projectionzbitstmp.range(0,0);
+
+			// Check if there are stubs in the memory
+			auto const nstubfirst = inputStubData.getEntries(bx,zbinfirst);
+			auto const nstublast  = inputStubData.getEntries(bx,zbinlast);
+			bool savefirst = (nstubfirst != 0);
+			bool savelast  = (nstublast != 0) && projectionzbitstmp.range(0,0);
+			auto const head_writeindex_tmp=head_writeindex;
+
+			if (savefirst) {
+				ap_uint<1> zero=0;
+				ap_uint<nbitsbin+1> tmp=zbinfirst.concat(zero);
+				ap_uint<VMProjection<VMPMEType>::kVMProjectionSize+nbitsbin+1> tmp2=projectiondatatmp.raw().concat(tmp);
+				projectionBuffer[head_writeindex_tmp] = nstubfirst.concat(tmp2);
+			}
+			if (savelast) {
+				ap_uint<1> one=1;
+				ap_uint<nbitsbin+1> tmp=zbinlast.concat(one);
+				ap_uint<VMProjection<VMPMEType>::kVMProjectionSize+nbitsbin+1> tmp2=projectiondatatmp.raw().concat(tmp);
+				ap_uint<NBitsBuffer> head_writeindex_tmp_last = head_writeindex_tmp+savefirst;
+				projectionBuffer[head_writeindex_tmp_last] = nstublast.concat(tmp2);
+			}
+#ifdef DEBUG
+			std::cout << "Writing " << savefirst+savelast << " z-bins ==> head_writeindex " << head_writeindex << "-->";
+#endif
+			head_writeindex = head_writeindex + savefirst + savelast;
+#ifdef DEBUG
+			std::cout << head_writeindex << std::endl;
+#endif
+		}
+
+		// If the buffer is not empty we have a projection that we need to process ...
+		if (bufferNotEmpty) {
+			ap_uint<nbitsstubaddr> istubtmp=istub;
+
+			//Need to read the information about the proj in the buffer
+			second=qdata.range(BufferWord::kVMMESecondMSB,BufferWord::kVMMESecondLSB);
+			nstubs=qdata.range(BufferWord::kVMMENStubsMSB,BufferWord::kVMMENStubsLSB);
+			VMProjection<VMPMEType> data(qdata.range(BufferWord::kVMMEProjectionMSB,BufferWord::kVMMEProjectionLSB));
+			zbin=qdata.range(BufferWord::kVMMEZBinMSB,BufferWord::kVMMEZBinLSB);
+
+			projindex=data.getIndex();
+			projfinez=data.getFineZ();
+			projrinv=data.getRInv();
+			isPSseed=(VMPMEType == BARREL) ? data.getIsPSSeed() : false;
+
+			// Check if last stub, if so, go to next buffer entry 
+			if (istub+1 >= nstubs){
+			  istub = 0;
+			  tail_readindex++;
+			}
+			else {
+			  istub++;
+			}
+
+			// Read stub memory and extract data fields
+			auto const stubadd   = zbin.concat(istubtmp);
+			auto const stubdata  = inputStubData.read_mem(bx,stubadd);
+			auto const stubindex = stubdata.getIndex();
+			auto const stubfinez = stubdata.getFineZ();
+			auto const stubbend  = stubdata.getBend();
+
+			// Calculate fine z (r for the disks) position
+			ap_int<VMProjectionBase<VMPMEType>::kVMProjFineZSize+1> projfinezadj = projfinez;
+			if (second) projfinezadj = projfinezadj - kZAdjustment;
+			ap_int<VMProjectionBase<VMPMEType>::kVMProjFineZSize+1> idz          = stubfinez - projfinezadj;
+
+			// The r position of a disk stub, its r-bin without the sign of the disk
+			// and its fine r, tells whether it is a PS stub (VMStubMEMemory.h)
+			ap_uint<MEBinsBits> rbin = zbin.range(MEBinsBits-1,0);
+			bool isPSstub = (Layer == 0) && isPSStubDisk(rbin, stubfinez);
+
+			// Check if stub z (r) position consistent
+			bool pass;
+			if (Layer != 0) {
+				pass = (isPSseed) ? (idz >= ME::StubZPositionBarrelConsistency::kPSMin && idz <= ME::StubZPositionBarrelConsistency::kPSMax)
+								  : (idz >= ME::StubZPositionBarrelConsistency::k2SMin && idz <= ME::StubZPositionBarrelConsistency::k2SMax);
+			}
+			else {
+				pass = (isPSstub) ? (idz >= ME::StubRPositionDiskConsistency::kDiskPSMin && idz <= ME::StubRPositionDiskConsistency::kDiskPSMax)
+								  : (idz >= ME::StubRPositionDiskConsistency::kDisk2SMin && idz <= ME::StubRPositionDiskConsistency::kDisk2SMax);
+			}
+
+			// Check if stub bend and proj rinv consistent
+#ifdef DEBUG
+			std::cout << projindex.to_string() << "\t" << stubindex.to_string() << "\t<=== ";
+#endif
+			// The disk tables have the 2S bends first and then the PS bends
+			ap_uint<1> psbend = isPSstub;
+			ap_uint<1+VMProjectionBase<VMPMEType>::kVMProjRinvSize+VMStubMEBase<VMSMEType>::kVMSMEBendSize> index=projrinv.concat(stubbend);
+			if (Layer == 0) index = psbend.concat(projrinv).concat(stubbend);
+			if (pass && table::lookup(index)) {
+				CandidateMatch cmatch(projindex.concat(stubindex));
+				outputCandidateMatch.write_mem(bx,cmatch,ncmatch);
+				ncmatch++;
+#ifdef DEBUG
+				std::cout << "PASS -- " << ncmatch-1 << "\n";
+#endif
+			}
+#ifdef DEBUG
+			else {
+				std::cout << "FAIL" << "\n";
+			}
+			std::cout << "\ttail_readindex: " << tail_readindex << "\n"
+					  << "\thead_writeindex: " << head_writeindex << "\n"
+					  << "\tsecond: " << second << "\n"
+					  << "\tprojfinez: " << projfinez << "\n"
+					  << "\tprojfinezadj: " << projfinezadj << "\n"
+					  << "\tstubfinez: " << stubfinez << "\n"
+					  << "\tidz: " << idz.to_string() << "\n"
+					  << "\tisPSseed: " << isPSseed << "\n"
+					  << "\tisPSstub: " << isPSstub << "\n"
+					  << "\tpass: " << pass << "\n"
+					  << "\tindex: " << index.to_string() << "\n"
+					  << "\ttable[index]: " << table::lookup(index) << "\n"
+					  << "\tnstubs:" << nstubs << "\n"
+					  << "\tistub:" << istub << std::endl;
+#endif
+		}
+	}
+
+	// z-bins left in the buffer
+	monitor.pending(ap_uint<NBitsBuffer>(head_writeindex-tail_readindex));
+
+	bx_o = bx;
+}
+
+// MatchEngine of the layer LAYER
 void MatchEngineTop(const BXType bx, BXType& bx_o,
 					const VMStubMEMemory<MODULETYPE, NBITBIN>& inputStubData,
 					const VMProjectionMemory<PROJECTIONTYPE>& inputProjectionData,
 					CandidateMatchMemory& outputCandidateMatch);
 
+// MatchEngine of the disk D1
+void MatchEngineTop_D1(const BXType bx, BXType& bx_o,
+					const VMStubMEMemory<DISK, ME::nBitsBin(0)>& inputStubData,
+					const VMProjectionMemory<DISK>& inputProjectionData,
+					CandidateMatchMemory& outputCandidateMatch);
+
 #endif
@@ -3,6 +3,23 @@
 #define TrackletAlgorithm_MemoryTemplate_h
 
 #include <iostream>
+#include "ModuleMonitor.h"
+#ifndef __SYNTHESIS__
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#endif
+
+// In C simulation, a BX page is cleared by starting a new generation of the
+// page instead of zeroing its entries, and an entry is valid only if it was
+// written in the current generation of its page: the other entries read as
+// zero. Not in cosim, where the RTL outputs are copied straight into the data
+// array, so that the layout of the class is the same as in synthesis; there
+// the page is zeroed.
+#if !defined(__SYNTHESIS__) && !defined(__RTL_SIMULATION__)
+#define MEMORY_PAGE_GENERATIONS
+#endif
 
 template<int> class AllStub;
 
@@ -23,6 +40,11 @@ protected:
 
   DataType dataarray_[1<<NBIT_BX][1<<NBIT_ADDR];  // data array
   NEntryT nentries_[1<<NBIT_BX];                  // number of entries
+
+#ifdef MEMORY_PAGE_GENERATIONS
+  uint32_t generation_[1<<NBIT_BX];               // current generation of each page
+  uint32_t written_[1<<NBIT_BX][1<<NBIT_ADDR];    // generation of the last write
+#endif
   
 public:
 
@@ -39,6 +61,9 @@ public:
   DataType read_mem(BunchXingT ibx, ap_uint<NBIT_ADDR> index) const
   {
 	// TODO: check if valid
+#ifdef MEMORY_PAGE_GENERATIONS
+	if (written_[ibx][index] != generation_[ibx]) return DataType();
+#endif
 	return dataarray_[ibx][index];
   }
 
@@ -60,8 +85,12 @@ public:
 #pragma HLS inline
     if (addr_index < (1<<NBIT_ADDR)) {
       dataarray_[ibx][addr_index] = data;
+#ifdef MEMORY_PAGE_GENERATIONS
+      written_[ibx][addr_index] = generation_[ibx];
+#endif
       return true;
     } else {
+      moduleDrop(drop::PAGEFULL);
       return false;
     }
   }
@@ -70,6 +99,11 @@ public:
 #ifndef __SYNTHESIS__
   MemoryTemplate()
   {
+       std::fill(&dataarray_[0][0], &dataarray_[0][0] + (1<<NBIT_BX)*(1<<NBIT_ADDR), DataType());
+#ifdef MEMORY_PAGE_GENERATIONS
+       std::fill(&written_[0][0], &written_[0][0] + (1<<NBIT_BX)*(1<<NBIT_ADDR), 0);
+       std::fill(generation_, generation_ + (1<<NBIT_BX), 0);
+#endif
        clear();
   }
 
@@ -77,15 +111,27 @@ public:
 
   void clear()
   {
-    DataType data("0",16);
     MEM_RST: for (size_t ibx=0; ibx<(1<<NBIT_BX); ++ibx) {
-      nentries_[ibx] = 0;
-      for (size_t addr=0; addr<(1<<NBIT_ADDR); ++addr) {
-        write_mem(ibx,data,addr);
-      }
+      clear(ibx);
     }
   }
 
+  // clear a single BX page, i.e. reset its number of entries and start a new
+  // generation, so that all its entries read as zero
+  void clear(BunchXingT ibx)
+  {
+    nentries_[ibx] = 0;
+#ifdef MEMORY_PAGE_GENERATIONS
+    if (++generation_[ibx] == 0) {
+      // wrapped around: entries of the first generation would be valid again
+      std::fill(written_[ibx], written_[ibx] + (1<<NBIT_ADDR), 0);
+      generation_[ibx] = 1;
+    }
+#else
+    std::fill(dataarray_[ibx], dataarray_[ibx] + (1<<NBIT_ADDR), DataType());
+#endif
+  }
+
   // write memory from text file
   bool write_mem(BunchXingT ibx, const char* datastr, int base=16)
   {
@@ -105,6 +151,21 @@ public:
         return success;
   }
 
+  // write a whole BX page from pre-parsed words, e.g. from MemPrintsBinary.
+  // records holds nent records of 1+nlimbs words: {slot, limb0 (LSBs), ...}
+  void write_page(BunchXingT ibx, const uint64_t* records, unsigned int nent, unsigned int nlimbs)
+  {
+	nentries_[ibx] = 0;
+	for (unsigned int i = 0; i < nent; ++i, records += 1+nlimbs) {
+	  typename std::decay<decltype(std::declval<DataType>().raw())>::type word(0);
+	  for (unsigned int ilimb = 0; ilimb < nlimbs && 64*ilimb < (unsigned int)word.length(); ++ilimb) {
+		const int msb = std::min(64*ilimb+63, (unsigned int)word.length()-1);
+		word.range(msb, 64*ilimb) = records[1+ilimb];
+	  }
+	  if (write_mem(ibx, DataType(word), nentries_[ibx])) nentries_[ibx] ++;
+	}
+  }
+
   // print memory contents
   void print_data(const DataType data) const
   {
@@ -114,7 +175,7 @@ public:
 
   void print_entry(BunchXingT bx, ap_uint<NBIT_ADDR> index) const
   {
-	print_data(dataarray_[bx][index]);
+	print_data(read_mem(bx,index));
   }
 
   void print_mem(BunchXingT bx) const
@@ -3,11 +3,22 @@
 #define TrackletAlgorithm_MemoryTemplateBinned_h
 
 #ifndef __SYNTHESIS__
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #endif
 
+#include "ModuleMonitor.h"
+
+// In C simulation, a BX page is cleared by starting a new generation of the
+// page, as in MemoryTemplate
+#if !defined(__SYNTHESIS__) && !defined(__RTL_SIMULATION__)
+#define MEMORY_PAGE_GENERATIONS
+#endif
 
 template<class DataType, unsigned int NBIT_BX, unsigned int NBIT_ADDR,
 		 unsigned int NBIT_BIN>
@@ -32,6 +43,11 @@ protected:
 
   DataType dataarray_[kNBxBins][kNMemDepth];  // data array
   NEntryT nentries_[kNBxBins][kNSlots];     // number of entries
+
+#ifdef MEMORY_PAGE_GENERATIONS
+  uint32_t generation_[kNBxBins];           // current generation of each page
+  uint32_t written_[kNBxBins][kNMemDepth];  // generation of the last write
+#endif
   
 public:
 
@@ -50,6 +66,9 @@ public:
   DataType read_mem(BunchXingT ibx, ap_uint<NBIT_ADDR> index) const
   {
     // TODO: check if valid
+#ifdef MEMORY_PAGE_GENERATIONS
+    if (written_[ibx][index] != generation_[ibx]) return DataType();
+#endif
     return dataarray_[ibx][index];
   }
   
@@ -57,6 +76,9 @@ public:
 		    ap_uint<NBIT_ADDR> index) const
   {
     // TODO: check if valid
+#ifdef MEMORY_PAGE_GENERATIONS
+    if (written_[ibx][(1<<(kNBitDataAddr))*slot+index] != generation_[ibx]) return DataType();
+#endif
     return dataarray_[ibx][(1<<(kNBitDataAddr))*slot+index];
   }
 
@@ -66,12 +88,16 @@ public:
 	if (nentry_ibx < (1<<(kNBitDataAddr))) {
 	  // write address for slot: 1<<(kNBitDataAddr) * slot + nentry_ibx
 	  dataarray_[ibx][(1<<(kNBitDataAddr))*slot+nentry_ibx] = data;
+#ifdef MEMORY_PAGE_GENERATIONS
+	  written_[ibx][(1<<(kNBitDataAddr))*slot+nentry_ibx] = generation_[ibx];
+#endif
 	  return true;
 	}
 	else {
 #ifndef __SYNTHESIS__
 	  std::cout << "Warning out of range" << std::endl;
 #endif
+	  moduleDrop(drop::BINFULL);
 	  return false;
 	}
   }
@@ -82,6 +108,11 @@ public:
   
   MemoryTemplateBinned()
   {
+        std::fill(&dataarray_[0][0], &dataarray_[0][0] + kNBxBins*kNMemDepth, DataType());
+#ifdef MEMORY_PAGE_GENERATIONS
+        std::fill(&written_[0][0], &written_[0][0] + kNBxBins*kNMemDepth, 0);
+        std::fill(generation_, generation_ + kNBxBins, 0);
+#endif
         clear();
   }
 
@@ -89,15 +120,27 @@ public:
 
   void clear()
   {
-    DataType data("0",16);
     for (size_t ibx=0; ibx<kNBxBins; ++ibx) {
-      for (size_t ibin=0; ibin<kNSlots; ++ibin) {
-        nentries_[ibx][ibin] = 0;
-        for (size_t addr=0; addr<(1<<(kNBitDataAddr)); ++addr) {
-          write_mem(ibx,ibin,data,addr);
-        }
-      }
+      clear(ibx);
+    }
+  }
+
+  // clear a single BX page, i.e. reset the number of entries of its bins and
+  // start a new generation, so that all its entries read as zero
+  void clear(BunchXingT ibx)
+  {
+    for (size_t ibin=0; ibin<kNSlots; ++ibin) {
+      nentries_[ibx][ibin] = 0;
     }
+#ifdef MEMORY_PAGE_GENERATIONS
+    if (++generation_[ibx] == 0) {
+      // wrapped around: entries of the first generation would be valid again
+      std::fill(written_[ibx], written_[ibx] + kNMemDepth, 0);
+      generation_[ibx] = 1;
+    }
+#else
+    std::fill(dataarray_[ibx], dataarray_[ibx] + kNMemDepth, DataType());
+#endif
   }
 
   ///////////////////////////////////
@@ -130,6 +173,22 @@ public:
   }
 
 
+  // write a whole BX page from pre-parsed words, e.g. from MemPrintsBinary.
+  // records holds nent records of 1+nlimbs words: {slot, limb0 (LSBs), ...}
+  void write_page(BunchXingT bx, const uint64_t* records, unsigned int nent, unsigned int nlimbs)
+  {
+    for (size_t ibin=0; ibin<kNSlots; ++ibin) nentries_[bx][ibin] = 0;
+    for (unsigned int i = 0; i < nent; ++i, records += 1+nlimbs) {
+      typename std::decay<decltype(std::declval<DataType>().raw())>::type word(0);
+      for (unsigned int ilimb = 0; ilimb < nlimbs && 64*ilimb < (unsigned int)word.length(); ++ilimb) {
+        const int msb = std::min(64*ilimb+63, (unsigned int)word.length()-1);
+        word.range(msb, 64*ilimb) = records[1+ilimb];
+      }
+      const int slot = records[0];
+      if (write_mem(bx, slot, DataType(word), nentries_[bx][slot])) nentries_[bx][slot] ++;
+    }
+  }
+
   // print memory contents
   void print_data(const DataType data) const
   {
@@ -139,7 +198,7 @@ public:
 
   void print_entry(BunchXingT bx, ap_uint<NBIT_ADDR> index) const
   {
-	print_data(dataarray_[bx][index]);
+	print_data(read_mem(bx,index));
   }
 
   void print_mem(BunchXingT bx) const
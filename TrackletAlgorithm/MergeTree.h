@@ -0,0 +1,261 @@
+#ifndef TrackletAlgorithm_MergeTree_h
+#define TrackletAlgorithm_MergeTree_h
+
+// Streaming k-way merge
+//
+// MergeTree merges NInputs streams, each sorted by increasing key, into one
+// stream sorted by key, one word per clock. It is a binary tree of 2-input
+// merge cells: the leaves take the heads of the input streams, each cell
+// passes the smaller of the heads of its two children to its parent, and the
+// root gives the merged stream. The number of cells is NInputs-1 (rounded up
+// to a power of 2) and the latency grows with log2(NInputs), so that adding
+// inputs costs one more cell level, not one more stage per input.
+//
+// The key of a word is mergeKey(word), which is the projection index for the
+// candidate matches of the MatchCalculator; other word types need their own
+// overload.
+
+#include "Constants.h"
+#include "CandidateMatchMemory.h"
+
+inline CandidateMatch::CMProjIndex mergeKey(const CandidateMatch& data)
+{
+  return data.getProjIndex();
+}
+
+// One 2-input merge cell, i.e. the state it keeps from one clock to the next.
+// Input A and B are pipelined in A and B, sA (sB) says that A (B) is the
+// smaller one and goes out next, and out is the registered output.
+template<class DataType>
+struct MergeCell {
+  DataType out;
+  DataType A;
+  DataType B;
+  bool vout;
+  bool vA;
+  bool sA;
+  bool vB;
+  bool sB;
+
+  void reset()
+  {
+    out = DataType();
+    A = DataType();
+    B = DataType();
+    vout = vA = sA = vB = sB = false;
+  }
+
+  // One clock of the cell: inA/inB are the heads of the two inputs and inread
+  // says that the next stage takes the output. Gives the state for the next
+  // clock and whether the heads of A and B were taken.
+  void step(const DataType& inA, const bool validA,
+            const DataType& inB, const bool validB,
+            const bool inread,
+            MergeCell& next, bool& readA, bool& readB) const
+  {
+#pragma HLS inline
+
+    // Set read enables for A and B
+    readA = (((inread || !vout) && sA) || !vA) && validA;
+    readB = (((inread || !vout) && sB) || !vB) && validB;
+
+    // Setup state machine
+    enum {HOLD, PROC_A, PROC_B, START, DONE} state;
+    if (sA && (inread || !vout))                          state = PROC_A;
+    else if (sB && (inread || !vout))                     state = PROC_B;
+    else if ((!sA && !sB) && (validA || validB) && !vout) state = START;
+    else if (!sB && !sA && vout && inread)                state = DONE;
+    else                                                  state = HOLD;
+
+    //------------- Explanation of the states -------------
+    // START:  Either inA or inB is valid & there is no valid output & neither sA or sB is set
+    //         No output yet, but set the next sA and sB and pipeline the inputs
+    // PROC_A: sA is set & either there is an inread from the next layer or not valid output
+    //         Output is the pipelined A, and set the next sA and sB
+    // PROC_B: sB is set & either there is an inread from the next layer or not valid output
+    //         Output is the pipelined B, and set the next sA and sB
+    // DONE:   There is an valid output & there is no inread from the next layer and neither sA or sB is set
+    //         No output, and set all reads to false
+    // HOLD:   In all other cases, pipeline everthing
+    //-----------------------------------------------------
+
+    switch(state)
+    {
+    case PROC_A: // just readA and compare inA with pipelined B
+      next.out  = A;      // output is A
+      next.vout = vA;     // output valid is vA
+      next.A    = inA;    // pipeline inA
+      next.vA   = validA; // pipeline inA valid
+      next.B    = B;      // pipeline B
+      next.vB   = vB;     // pipeline vB
+      next.sA   = ((mergeKey(inA) <= mergeKey(B)) || !vB) && validA;  // sA=true if inA is valid and (inA <= B or B not valid)
+      next.sB   = (!(mergeKey(inA) <= mergeKey(B)) || !validA) && vB; // sB=true if B is valid and (inA > B or inA not valid)
+      break;
+    case PROC_B: // just readB and compare inB with pipelined A
+      next.out  = B;      // output is B
+      next.vout = vB;     // output valid is vB
+      next.B    = inB;    // pipeline inB
+      next.vB   = validB; // pipeline inB valid
+      next.A    = A;      // pipeline A
+      next.vA   = vA;     // pipeline vA
+      next.sA   = ((mergeKey(A) <= mergeKey(inB)) || !validB) && vA;  // sA=true if A is valid and (A <= inB or inB not valid)
+      next.sB   = (!(mergeKey(A) <= mergeKey(inB)) || !vA) && validB; // sB=true if inB is valid and (A > inB or A not valid)
+      break;
+    case START: // both in at same time
+      next.out  = DataType();
+      next.vout = false;
+      next.A    = inA;    // pipeline inA
+      next.vA   = validA; // pipeline inA valid
+      next.B    = inB;    // pipeline inB
+      next.vB   = validB; // pipeline inB valid
+      next.sA   = ((mergeKey(inA) <= mergeKey(inB)) || !validB) && validA;  // sA=true if inA is valid and (inA <= inB or inB not valid)
+      next.sB   = (!(mergeKey(inA) <= mergeKey(inB)) || !validA) && validB; // sB=true if inB is valid and (inA > inB or inA not valid)
+      break;
+    case DONE: // set everything to false
+      next.reset();
+      break;
+    case HOLD: // pipeline all
+      next = *this;
+      break;
+    }
+  }
+};
+
+// Number of levels of a tree with at least n leaves, i.e. ceil(log2(n)) and
+// at least one
+constexpr unsigned mergeTreeLevels(unsigned n)
+{
+  return (n <= 2) ? 1 : 1 + mergeTreeLevels((n + 1) / 2);
+}
+
+// The cells are stored as a heap: cell 0 is the root and the children of
+// cell i are the cells 2i+1 (input A) and 2i+2 (input B). The inputs 2j and
+// 2j+1 go to the leaf cell kNLeafCells-1+j; inputs beyond NInputs, when
+// NInputs is not a power of 2, are never valid.
+template<class DataType, unsigned NInputs>
+class MergeTree
+{
+public:
+  static constexpr unsigned kNLevels = mergeTreeLevels(NInputs);
+  static constexpr unsigned kNLeafCells = 1 << (kNLevels - 1);
+  static constexpr unsigned kNCells = 2 * kNLeafCells - 1;
+
+  MergeTree() { reset(); }
+
+  void reset()
+  {
+    reset_cells: for (unsigned i = 0; i < kNCells; ++i) {
+#pragma HLS unroll
+      cell_[i].reset();
+      inread_[i] = false;
+    }
+  }
+
+  // One clock of the tree. in[i] is the head of input i and valid[i] says
+  // that it is valid. read[i] is set if the head of input i was taken, in
+  // which case the caller moves on to the next word of input i before the
+  // next step. The output of the step is then given by out() and valid().
+  void step(const DataType in[NInputs], const bool valid[NInputs], bool read[NInputs])
+  {
+#pragma HLS inline
+#pragma HLS array_partition variable=cell_ complete dim=0
+#pragma HLS array_partition variable=inread_ complete dim=0
+
+    // The cells are evaluated from the leaves to the root, so that a cell
+    // takes the outputs of its children in the same clock. The read enables
+    // a cell gives to its children are registered, as are the outputs.
+    MergeCell<DataType> next[kNCells];
+    bool inread_next[kNCells];
+    bool read_next[2 * kNLeafCells];
+#pragma HLS array_partition variable=next complete dim=0
+#pragma HLS array_partition variable=inread_next complete dim=0
+#pragma HLS array_partition variable=read_next complete dim=0
+
+    inread_next[0] = true; // the root output is always taken
+
+    cells: for (int i = kNCells - 1; i >= 0; --i) {
+#pragma HLS unroll
+      if (i >= int(kNLeafCells) - 1) {
+        const unsigned iA = 2 * (i - (kNLeafCells - 1));
+        const unsigned iB = iA + 1;
+        const DataType inA = (iA < NInputs) ? in[iA] : DataType();
+        const DataType inB = (iB < NInputs) ? in[iB] : DataType();
+        const bool validA = (iA < NInputs) && valid[iA];
+        const bool validB = (iB < NInputs) && valid[iB];
+        cell_[i].step(inA, validA, inB, validB, inread_[i],
+                      next[i], read_next[iA], read_next[iB]);
+      }
+      else {
+        const unsigned iA = 2 * i + 1;
+        const unsigned iB = 2 * i + 2;
+        cell_[i].step(next[iA].out, next[iA].vout, next[iB].out, next[iB].vout, inread_[i],
+                      next[i], inread_next[iA], inread_next[iB]);
+      }
+    }
+
+    update: for (unsigned i = 0; i < kNCells; ++i) {
+#pragma HLS unroll
+      cell_[i] = next[i];
+      inread_[i] = inread_next[i];
+    }
+    reads: for (unsigned i = 0; i < NInputs; ++i) {
+#pragma HLS unroll
+      read[i] = read_next[i];
+    }
+  }
+
+  // Output of the last step
+  const DataType& out() const { return cell_[0].out; }
+  bool valid() const { return cell_[0].vout; }
+
+private:
+  MergeCell<DataType> cell_[kNCells];
+  bool inread_[kNCells];
+};
+
+// Merge the NInputs memories of a BX into one, each sorted by increasing key,
+// one word per clock. The output memory gets the merged words from address 0
+// on; as for the other modules, its number of entries is not set.
+template<unsigned NInputs, class DataType, unsigned NBitsBX, unsigned NBitsAddr>
+void mergeMemories(const BXType bx,
+                   const MemoryTemplate<DataType, NBitsBX, NBitsAddr> input[NInputs],
+                   MemoryTemplate<DataType, NBitsBX, NBitsAddr>& output)
+{
+#pragma HLS inline
+#pragma HLS array_partition variable=input complete dim=1
+
+  MergeTree<DataType, NInputs> merge;
+
+  ap_uint<NBitsAddr> addr[NInputs];
+  bool read[NInputs];
+#pragma HLS array_partition variable=addr complete
+#pragma HLS array_partition variable=read complete
+  init_read: for (unsigned i = 0; i < NInputs; ++i) {
+#pragma HLS unroll
+    addr[i] = 0;
+    read[i] = false;
+  }
+
+  ap_uint<NBitsAddr> nout = 0;
+
+  merge_loop: for (unsigned istep = 0; istep < kMaxProc; ++istep) {
+#pragma HLS pipeline II=1 rewind
+
+    DataType in[NInputs];
+    bool valid[NInputs];
+#pragma HLS array_partition variable=in complete
+#pragma HLS array_partition variable=valid complete
+    read_inputs: for (unsigned i = 0; i < NInputs; ++i) {
+#pragma HLS unroll
+      if (read[i]) addr[i]++;
+      in[i] = input[i].read_mem(bx, addr[i]);
+      valid[i] = (addr[i] < input[i].getEntries(bx));
+    }
+
+    merge.step(in, valid, read);
+
+    if (merge.valid()) output.write_mem(bx, merge.out(), nout++);
+  }
+}
+
+#endif
@@ -0,0 +1,17 @@
+#include "MergeTreeTop.h"
+
+void MergeTreeTop(const BXType bx,
+                  const CandidateMatchMemory match[kNMergeTreeInputs],
+                  BXType& bx_o,
+                  CandidateMatchMemory& merged
+                 )
+{
+ #pragma HLS inline off
+ #pragma HLS interface register port=bx_o
+ #pragma HLS array_partition variable=match complete dim=1
+ #pragma HLS resource variable=merged.get_mem() latency=2
+
+  mergeMemories<kNMergeTreeInputs>(bx, match, merged);
+
+  bx_o = bx;
+}
@@ -0,0 +1,17 @@
+#ifndef TrackletAlgorithm_MergeTreeTop_h
+#define TrackletAlgorithm_MergeTreeTop_h
+
+#include "MergeTree.h"
+
+// Stand-alone merge of the candidate matches of kNMergeTreeInputs CM
+// memories, as in the MatchCalculator, so that the latency and II of the
+// merge tree can be synthesized for more inputs than a MatchCalculator has.
+constexpr unsigned kNMergeTreeInputs = 16;
+
+void MergeTreeTop(const BXType bx,
+                  const CandidateMatchMemory match[kNMergeTreeInputs],
+                  BXType& bx_o,
+                  CandidateMatchMemory& merged
+                 );
+
+#endif
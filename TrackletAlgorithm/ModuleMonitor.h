@@ -0,0 +1,173 @@
+// Occupancy counters of the processing loops, for C simulation only.
+//
+// The main loop of a processing module runs a fixed number of II=1 steps per
+// BX, and anything not done by the last step is lost. A ModuleMonitor placed
+// in front of the loop counts, step by step, whether the module did useful
+// work (busy), whether it could not take a new input because its internal
+// buffer was full (stalled), and at the end how many of its inputs were never
+// processed (truncated). Each call of the module adds one ModuleRecord to
+// moduleRecords(), from which the test benches print per-event histograms
+// (TestBenches/ModuleMonitorReport.h).
+//
+// The record also counts the entries the module dropped in that BX, by
+// cause: inputs left when the loop ran out of steps, and outputs that did
+// not fit in a memory page or in a bin of a binned memory. The memories
+// report the latter with moduleDrop() to the monitor of the module that is
+// running on the same thread.
+//
+// The counters are only compiled in C simulation with -DMODULE_MONITOR.
+// Otherwise ModuleMonitor is an empty class whose inline member functions do
+// nothing, so the synthesized code is unchanged.
+#ifndef TrackletAlgorithm_ModuleMonitor_h
+#define TrackletAlgorithm_ModuleMonitor_h
+
+#include "Constants.h"
+
+#if defined(MODULE_MONITOR) && !defined(__SYNTHESIS__)
+#define MODULE_MONITOR_ON
+#endif
+
+// Causes of dropped entries
+namespace drop {
+  enum cause {LOOPBUDGET, PAGEFULL, BINFULL, NCAUSES};
+};
+
+#ifdef MODULE_MONITOR_ON
+
+#include <mutex>
+#include <vector>
+
+struct ModuleRecord
+{
+  module::type module;
+  unsigned int bx;
+  unsigned int ninputs;   // inputs available to the call
+  unsigned int nread;     // inputs read out
+  unsigned int npending;  // inputs read out but not finished by the last step
+  std::vector<bool> busy; // per step
+  std::vector<bool> stalled;
+  unsigned int nfull[drop::NCAUSES]; // outputs dropped by PAGEFULL and BINFULL
+
+  unsigned int getNSteps() const {return busy.size();}
+  unsigned int getNBusy() const {return count(busy);}
+  unsigned int getNStalled() const {return count(stalled);}
+  unsigned int getNTruncated() const {return (ninputs > nread ? ninputs - nread : 0) + npending;}
+
+  unsigned int getNDropped(drop::cause c) const
+  {
+    return (c == drop::LOOPBUDGET) ? getNTruncated() : nfull[c];
+  }
+
+  // Number of steps left after the last busy one
+  unsigned int getHeadroom() const
+  {
+    unsigned int n = 0;
+    for (auto i = busy.rbegin(); i != busy.rend() && !*i; ++i) ++n;
+    return n;
+  }
+
+private:
+
+  static unsigned int count(const std::vector<bool>& steps)
+  {
+    unsigned int n = 0;
+    for (bool step : steps) n += step;
+    return n;
+  }
+
+};
+
+// Records of all monitored calls, shared by all threads
+inline std::vector<ModuleRecord>& moduleRecords()
+{
+  static std::vector<ModuleRecord> records;
+  return records;
+}
+
+inline std::mutex& moduleRecordsMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+class ModuleMonitor
+{
+public:
+
+  ModuleMonitor(module::type m, const BXType bx):
+    previous_(current())
+  {
+    record_.module = m;
+    record_.bx = bx;
+    record_.ninputs = 0;
+    record_.nread = 0;
+    record_.npending = 0;
+    record_.busy.reserve(kMaxProc);
+    record_.stalled.reserve(kMaxProc);
+    for (auto& n : record_.nfull) n = 0;
+    current() = this;
+  }
+
+  ~ModuleMonitor()
+  {
+    current() = previous_;
+    std::lock_guard<std::mutex> lock(moduleRecordsMutex());
+    moduleRecords().push_back(record_);
+  }
+
+  ModuleMonitor(const ModuleMonitor&) = delete;
+  ModuleMonitor& operator=(const ModuleMonitor&) = delete;
+
+  // Called once per iteration of the main loop
+  void step(bool busy, bool stalled = false)
+  {
+    record_.busy.push_back(busy);
+    record_.stalled.push_back(stalled);
+  }
+
+  void inputs(unsigned int n) {record_.ninputs += n;}
+  void read(unsigned int n = 1) {record_.nread += n;}
+  void pending(unsigned int n) {record_.npending += n;}
+  void dropped(drop::cause c, unsigned int n = 1) {record_.nfull[c] += n;}
+
+  // Monitor of the module running on this thread, if any
+  static ModuleMonitor*& current()
+  {
+    static thread_local ModuleMonitor* monitor = nullptr;
+    return monitor;
+  }
+
+private:
+
+  ModuleMonitor* const previous_;
+  ModuleRecord record_;
+
+};
+
+// Called by the memories for an entry they could not store
+inline void moduleDrop(drop::cause c)
+{
+  if (ModuleMonitor::current()) ModuleMonitor::current()->dropped(c);
+}
+
+#else
+
+class ModuleMonitor
+{
+public:
+
+  ModuleMonitor(module::type, const BXType) {}
+
+  void step(bool, bool = false) {}
+  void inputs(unsigned int) {}
+  void read(unsigned int = 1) {}
+  void pending(unsigned int) {}
+  void dropped(drop::cause, unsigned int = 1) {}
+
+};
+
+inline void moduleDrop(drop::cause) {}
+
+#endif // MODULE_MONITOR_ON
+
+#endif // TrackletAlgorithm_ModuleMonitor_h
@@ -0,0 +1,79 @@
+#ifndef TrackletAlgorithm_MultiMemoryReader_h
+#define TrackletAlgorithm_MultiMemoryReader_h
+
+// Streaming reader of several input memories
+//
+// The ProjectionRouter, TrackletCalculator and VMRouter read the entries of
+// all their input memories of a BX one per clock, memory after memory. The
+// reader takes the number of entries of each memory once, at the start of the
+// BX, and keeps their prefix sums: the n-th entry read is then in the first
+// memory whose prefix sum is above n, found by a priority encoder over one
+// comparison per memory, at the address n minus the prefix sum of the
+// memories before it. No state is carried from one entry to the next, so the
+// loops that use it stay at II=1 whatever the number of memories.
+
+#include "Constants.h"
+
+// Number of bits to index n memories, at least one
+constexpr unsigned multiMemoryBits(unsigned n)
+{
+  return (n <= 2) ? 1 : 1 + multiMemoryBits((n + 1) / 2);
+}
+
+template<unsigned NMem>
+class MultiMemoryReader
+{
+public:
+  static constexpr unsigned kNBitsMem = multiMemoryBits(NMem);
+
+  typedef ap_uint<kNBitsMem> MemIndex;
+  typedef ap_uint<kNBits_MemAddr> MemAddr;
+  // Index of an entry over all the memories, one bit more than needed so
+  // that it can go past the last entry
+  typedef ap_uint<kNBits_MemAddr + kNBitsMem + 1> Index;
+
+  // Set the number of entries of each memory, in the order they are read
+  void init(const MemAddr nentries[NMem])
+  {
+#pragma HLS inline
+#pragma HLS array_partition variable=nentries complete
+#pragma HLS array_partition variable=begin_ complete
+#pragma HLS array_partition variable=end_ complete
+
+    Index sum = 0;
+    prefix_sums: for (unsigned j = 0; j < NMem; ++j) {
+#pragma HLS unroll
+      begin_[j] = sum;
+      sum += nentries[j];
+      end_[j] = sum;
+    }
+  }
+
+  // Total number of entries
+  Index getEntries() const { return end_[NMem - 1]; }
+
+  // Memory and address of the entry i over all the memories. Returns false
+  // if all the entries have been read.
+  bool get(const Index i, MemIndex& imem, MemAddr& addr) const
+  {
+#pragma HLS inline
+
+    bool found = false;
+    imem = 0;
+    priority_encoder: for (int j = NMem - 1; j >= 0; --j) {
+#pragma HLS unroll
+      if (i < end_[j]) {
+        imem = j;
+        found = true;
+      }
+    }
+    addr = i - begin_[imem];
+    return found;
+  }
+
+private:
+  Index begin_[NMem];
+  Index end_[NMem];
+};
+
+#endif
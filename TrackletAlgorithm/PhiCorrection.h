@@ -0,0 +1,43 @@
+#ifndef TrackletAlgorithm_PhiCorrection_h
+#define TrackletAlgorithm_PhiCorrection_h
+
+// Phi correction of the barrel stubs, shared by the InputRouter, which bins
+// the stubs in corrected phi, and the VMRouter, which routes them to the VMs
+// by corrected phi.
+
+#include "Constants.h"
+#include "AllStubMemory.h"
+
+// Number of MSBs used for r index in phiCorr LUTs
+constexpr int nbitsrphicorrtable = 3; // Found hardcoded in VMRouterphiCorrTable.h
+
+// Get the corrected phi, i.e. phi at the average radius of the barrel
+// Corrected phi is used by ME and TE memories in the barrel
+template<regionType InType>
+inline typename AllStub<InType>::ASPHI getPhiCorr(
+		const typename AllStub<InType>::ASPHI phi,
+		const typename AllStub<InType>::ASR r,
+		const typename AllStub<InType>::ASBEND bend, const int phiCorrTable[]) {
+
+	if (InType == DISKPS || InType == DISK2S)
+		return phi; // Do nothing if disks
+
+	constexpr auto rBins = 1 << nbitsrphicorrtable; // The number of bins for r
+
+	ap_uint<nbitsrphicorrtable> rBin = (r + (1 << (r.length() - 1)))
+			>> (r.length() - nbitsrphicorrtable); // Which bin r belongs to. Note r = 0 is mid radius
+	auto index = bend * rBins + rBin; // Index for where we find our correction value
+	auto corrValue = phiCorrTable[index]; // The amount we need to correct our phi
+
+	auto phiCorr = phi - corrValue; // the corrected phi
+
+	// Check for overflow
+	if (phiCorr < 0)
+		phiCorr = 0; // can't be less than 0
+	if (phiCorr >= 1 << phi.length())
+		phiCorr = (1 << phi.length()) - 1;  // can't be more than the max value
+
+	return phiCorr;
+}
+
+#endif // TrackletAlgorithm_PhiCorrection_h
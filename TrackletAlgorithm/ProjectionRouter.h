@@ -6,36 +6,13 @@
 #include "TrackletProjectionMemory.h"
 #include "AllProjectionMemory.h"
 #include "VMProjectionMemory.h"
+#include "ModuleMonitor.h"
+#include "MultiMemoryReader.h"
 
 //#include <assert.h>
 
 namespace PR
 {
-  template<regionType PROJTYPE, unsigned int nINMEM>
-  bool read_input_mems(BXType bx,
-                       ap_uint<nINMEM>& mem_hasdata,
-                       ap_uint<kNBits_MemAddr> nentries[nINMEM],
-                       ap_uint<kNBits_MemAddr>& read_addr,
-                       const TrackletProjectionMemory<PROJTYPE> projin[],
-                       TrackletProjection<PROJTYPE>& data) 
-  {
-#pragma HLS inline
-
-    if (mem_hasdata == 0) return false;
-    // 5 bits memory index for up to 32 input memory priority encoder
-    ap_uint<5> read_imem = __builtin_ctz(mem_hasdata);
-    data = projin[read_imem].read_mem(bx, read_addr);
-    ++read_addr;
-    if (read_addr >= nentries[read_imem]) {
-      // All entries in the memory[read_imem] have been read out - Prepare to move to the next non-empty memory
-      read_addr = 0;
-      mem_hasdata.clear(read_imem);  // set the current lowest 1 bit to 0
-    }
-
-    return true;
-
-  } // read_input_mems
-
   /////////////////////////////////////////////////////
   // FIXME
   // Move the following to Constants.h?
@@ -61,6 +38,33 @@ namespace PR
   // value by which a z-projection is adjusted up & down when calculating which zbin(s) a projection should go to
   constexpr unsigned int zbins_adjust = 1;
 
+  // number of extra bits to keep when calculating which rbin(s) a disk projection should go to
+  constexpr unsigned int rbins_nbitsextra = 3;
+
+  // value by which an r-projection is adjusted up & down when calculating which rbin(s) a projection should go to
+  constexpr unsigned int rbins_adjust = 1;
+
+  // lower edge of the first rbin, and width of the rbins, in units of krprojdisk
+  constexpr unsigned int rbins_rmin = rmindiskvm / krprojdisk + 1.0e-1;
+  constexpr unsigned int rbins_rmax = rmaxdisk / krprojdisk + 1.0e-1;
+
+  // the r position in units of (1<<rbins_nbitsextra)-th of an rbin is
+  // (r-rbins_rmin)*rbins_mult >> rbins_nbitsmult
+  constexpr unsigned int rbins_nbitsmult = 16;
+  constexpr unsigned int rbins_mult = ((1 << (MEBinsBits+rbins_nbitsextra+rbins_nbitsmult)) + (rbins_rmax-rbins_rmin) - 1) / (rbins_rmax-rbins_rmin);
+  static_assert(rbins_mult < (1 << rbins_nbitsmult), "rbins_mult must fit in rbins_nbitsmult bits");
+
+  // r position of a disk projection in units of (1<<rbins_nbitsextra)-th of
+  // an rbin, from its r relative to rbins_rmin. For r below rbins_rmax this
+  // is the same as the division by the bin width, see ProjectionRouter_test.
+  template<int nrbits>
+  ap_uint<nrbits> getDiskRBinPosition(const ap_uint<nrbits>& irprojvm)
+  {
+#pragma HLS inline
+    const ap_uint<nrbits+rbins_nbitsmult> rbinposfull = irprojvm * ap_uint<rbins_nbitsmult>(rbins_mult);
+    return rbinposfull.range(nrbits+rbins_nbitsmult-1, rbins_nbitsmult);
+  }
+
 } // namespace PR
 
 //////////////////////////////
@@ -82,9 +86,10 @@ void ProjectionRouter(BXType bx,
   // Initialization
   ap_uint<kNBits_MemAddr> nallproj;
   ap_uint<kNBits_MemAddr> nvmprojout[nOUTMEM];
-  ap_uint<nINMEM> mem_hasdata;
   ap_uint<kNBits_MemAddr> numbersin[nINMEM];
-  ap_uint<kNBits_MemAddr> mem_read_addr;
+  MultiMemoryReader<nINMEM> reader; // input memories read one after the other
+
+  ModuleMonitor monitor(module::PR, bx);
 
   PROC_LOOP: for (int istep = 0; istep < kMaxProc - kMaxProcOffset(module::PR); ++istep) {
 #pragma HLS PIPELINE II=1 rewind
@@ -99,19 +104,21 @@ void ProjectionRouter(BXType bx,
       }
 
       // check the number of entries in the input memories
-      // fill the bit mask indicating if memories are empty or not
-      mem_hasdata = 0;
 #pragma HLS ARRAY_PARTITION variable=numbersin complete dim=0
       for (int i=0; i<nINMEM; i++) {
 #pragma HLS unroll
         numbersin[i] = projin[i].getEntries(bx);
-        if (numbersin[i] > 0) mem_hasdata.set(i);
+        monitor.inputs(numbersin[i]);
       }
-      mem_read_addr = 0;
+      reader.init(numbersin);
     }
-    // read inputs
-    TrackletProjection<PROJTYPE> tproj;
-    bool validin = read_input_mems<PROJTYPE,nINMEM>(bx, mem_hasdata, numbersin, mem_read_addr, projin, tproj);
+    // read inputs, one per step
+    typename MultiMemoryReader<nINMEM>::MemIndex read_imem;
+    ap_uint<kNBits_MemAddr> read_addr;
+    const bool validin = reader.get(istep, read_imem, read_addr);
+    TrackletProjection<PROJTYPE> tproj = projin[read_imem].read_mem(bx, read_addr);
+    monitor.step(validin);
+    monitor.read(validin);
 
     if (validin) {
 
@@ -134,47 +141,95 @@ void ProjectionRouter(BXType bx,
 
       ///////////////
       // VMProjection
-      static_assert(not DISK, "PR: Layer only for now.");
-    
+
       // vmproj index
       typename VMProjection<VMPTYPE>::VMPID index = nallproj;
 
-      // vmproj z
-      // Separate the vm projections into zbins
-      // To determine which zbin in VMStubsME the ME should look in to match this VMProjection,
-      // the purpose of these lines is to take the top MEBinsBits (3) bits of zproj and shift it
-      // to make it positive, which gives the bin index. But there is a range of possible z values
-      // over which we want to look for matched stubs, and there is therefore possibly 2 bins that
-      // we will have to look in. So we first take the first MEBinsBits+zbins_nbitsextra (3+2=5)
-      // bits of zproj, adjust the value up and down by zbins_adjust (2), then truncate the
-      // zbins_adjust (2) LSBs to get the lower & upper bins that we need to look in.
-      auto zbinposfull = (1<<(izproj.length()-1))+izproj;
-      auto zbinpos5 = zbinposfull.range(izproj.length()-1,izproj.length()-MEBinsBits-zbins_nbitsextra);
-
-      // Lower Bound
-      auto zbinlower = zbinpos5<zbins_adjust ?
-                       ap_uint<MEBinsBits+zbins_nbitsextra>(0) :
-                       ap_uint<MEBinsBits+zbins_nbitsextra>(zbinpos5-zbins_adjust);
-      // Upper Bound
-      auto zbinupper = zbinpos5>((1<<(MEBinsBits+zbins_nbitsextra))-1-zbins_adjust) ? 
-                       ap_uint<MEBinsBits+zbins_nbitsextra>((1<<(MEBinsBits+zbins_nbitsextra))-1) :
-                       ap_uint<MEBinsBits+zbins_nbitsextra>(zbinpos5+zbins_adjust);
-
-      ap_uint<MEBinsBits> zbin1 = zbinlower >> zbins_nbitsextra;
-      ap_uint<MEBinsBits> zbin2 = zbinupper >> zbins_nbitsextra;
-      
-      typename VMProjection<VMPTYPE>::VMPZBIN zbin = (zbin1, zbin2!=zbin1);
-    
-      //fine vm z bits. Use 4 bits for fine position. starting at zbin 1
+      typename VMProjection<VMPTYPE>::VMPZBIN zbin;
+      typename VMProjection<VMPTYPE>::VMPFINEZ finez;
       auto nfinebits = VMProjection<VMPTYPE>::BitWidths::kVMProjFineZSize;
-      ap_uint<VMProjection<VMPTYPE>::BitWidths::kVMProjFineZSize-1> zeropad(0);
-      // The finez calculation has three parts
-      // 1: +(1<<(MEBinsBits+(nfinebits-1)-1)) - converts the top MEBinsBits+(nfinebits-1) of the word to positive
-      // 2: +(izproj.range(...,...)            - gets the top MEBinsBits+(nfinebits-1) of izproj
-      // 3: -(zbin1,zeropad)                   - subtracts zbin1, left-shifted by kVMProjFineZSize-1, off of finez, so that the finez is relative to zbin1
-      // N.B. We use (nfinebits-1) instead of nfinebits throughout the calculation because we need to keep 1 extra MSB in case zbin1 is different
-      // from the 3 MSBs of zproj, which can happen because zbin1 is adjusted by zbins_adjust
-      typename VMProjection<VMPTYPE>::VMPFINEZ finez = (1<<(MEBinsBits+(nfinebits-1)-1))+(izproj.range(izproj.length()-1,izproj.length()-MEBinsBits-(nfinebits-1)))-(zbin1,zeropad);
+
+      if (LAYER != 0) {
+        // vmproj z
+        // Separate the vm projections into zbins
+        // To determine which zbin in VMStubsME the ME should look in to match this VMProjection,
+        // the purpose of these lines is to take the top MEBinsBits (3) bits of zproj and shift it
+        // to make it positive, which gives the bin index. But there is a range of possible z values
+        // over which we want to look for matched stubs, and there is therefore possibly 2 bins that
+        // we will have to look in. So we first take the first MEBinsBits+zbins_nbitsextra (3+2=5)
+        // bits of zproj, adjust the value up and down by zbins_adjust (2), then truncate the
+        // zbins_adjust (2) LSBs to get the lower & upper bins that we need to look in.
+        auto zbinposfull = (1<<(izproj.length()-1))+izproj;
+        auto zbinpos5 = zbinposfull.range(izproj.length()-1,izproj.length()-MEBinsBits-zbins_nbitsextra);
+
+        // Lower Bound
+        auto zbinlower = zbinpos5<zbins_adjust ?
+                         ap_uint<MEBinsBits+zbins_nbitsextra>(0) :
+                         ap_uint<MEBinsBits+zbins_nbitsextra>(zbinpos5-zbins_adjust);
+        // Upper Bound
+        auto zbinupper = zbinpos5>((1<<(MEBinsBits+zbins_nbitsextra))-1-zbins_adjust) ?
+                         ap_uint<MEBinsBits+zbins_nbitsextra>((1<<(MEBinsBits+zbins_nbitsextra))-1) :
+                         ap_uint<MEBinsBits+zbins_nbitsextra>(zbinpos5+zbins_adjust);
+
+        ap_uint<MEBinsBits> zbin1 = zbinlower >> zbins_nbitsextra;
+        ap_uint<MEBinsBits> zbin2 = zbinupper >> zbins_nbitsextra;
+
+        zbin = (zbin1, zbin2!=zbin1);
+
+        //fine vm z bits. Use 4 bits for fine position. starting at zbin 1
+        ap_uint<VMProjection<VMPTYPE>::BitWidths::kVMProjFineZSize-1> zeropad(0);
+        // The finez calculation has three parts
+        // 1: +(1<<(MEBinsBits+(nfinebits-1)-1)) - converts the top MEBinsBits+(nfinebits-1) of the word to positive
+        // 2: +(izproj.range(...,...)            - gets the top MEBinsBits+(nfinebits-1) of izproj
+        // 3: -(zbin1,zeropad)                   - subtracts zbin1, left-shifted by kVMProjFineZSize-1, off of finez, so that the finez is relative to zbin1
+        // N.B. We use (nfinebits-1) instead of nfinebits throughout the calculation because we need to keep 1 extra MSB in case zbin1 is different
+        // from the 3 MSBs of zproj, which can happen because zbin1 is adjusted by zbins_adjust
+        finez = (1<<(MEBinsBits+(nfinebits-1)-1))+(izproj.range(izproj.length()-1,izproj.length()-MEBinsBits-(nfinebits-1)))-(zbin1,zeropad);
+      }
+      else {
+        // vmproj r
+        // Separate the vm projections into rbins, as the VMRouter does for the
+        // disk stubs: the r range of the disk VMs, from rmindiskvm to rmaxdisk,
+        // is split into 1<<MEBinsBits bins. As for the layers, the position is
+        // first computed with rbins_nbitsextra more bits, adjusted up and down
+        // by rbins_adjust, and the LSBs are then dropped to get the lower and
+        // upper bins. The division by the size of a bin is a multiplication by
+        // rbins_mult and a shift.
+        constexpr unsigned int nrbits = TrackletProjection<PROJTYPE>::BitWidths::kTProjRZSize;
+        // Both operands of the comparisons are cast to the same ap_uint, as
+        // comparing an ap_uint with a constant of another type is ambiguous
+        const ap_uint<nrbits> irproj = izproj.range(nrbits-1,0);
+        const ap_uint<nrbits> irmin = rbins_rmin;
+        const ap_uint<nrbits> irprojvm = (irproj > irmin) ? ap_uint<nrbits>(irproj-irmin) : ap_uint<nrbits>(0);
+        const ap_uint<nrbits> rbinposshift = getDiskRBinPosition<nrbits>(irprojvm);
+        const ap_uint<nrbits> rbinposmax = (1<<(MEBinsBits+rbins_nbitsextra))-1;
+        ap_uint<MEBinsBits+rbins_nbitsextra> rbinpos6 = (rbinposshift > rbinposmax) ?
+                         ap_uint<MEBinsBits+rbins_nbitsextra>(rbinposmax) :
+                         ap_uint<MEBinsBits+rbins_nbitsextra>(rbinposshift);
+
+        // Lower Bound
+        auto rbinlower = rbinpos6<rbins_adjust ?
+                         ap_uint<MEBinsBits+rbins_nbitsextra>(0) :
+                         ap_uint<MEBinsBits+rbins_nbitsextra>(rbinpos6-rbins_adjust);
+        // Upper Bound
+        auto rbinupper = rbinpos6>((1<<(MEBinsBits+rbins_nbitsextra))-1-rbins_adjust) ?
+                         ap_uint<MEBinsBits+rbins_nbitsextra>((1<<(MEBinsBits+rbins_nbitsextra))-1) :
+                         ap_uint<MEBinsBits+rbins_nbitsextra>(rbinpos6+rbins_adjust);
+
+        ap_uint<MEBinsBits> rbin1 = rbinlower >> rbins_nbitsextra;
+        ap_uint<MEBinsBits> rbin2 = rbinupper >> rbins_nbitsextra;
+
+        // The stubs of the negative disks are in the upper half of the bins
+        // of the VMStubsME memories. A projection to a negative disk has
+        // dr/dz < 0.
+        ap_uint<1> negdisk = tproj.getRZDer() < 0;
+
+        zbin = ((negdisk, rbin1), rbin2!=rbin1);
+
+        // fine vm r bits, relative to rbin1
+        ap_uint<rbins_nbitsextra> zeropad(0);
+        finez = rbinpos6-(rbin1,zeropad);
+      }
 
       // vmproj irinv
       // phider = -irinv/2
@@ -186,7 +241,7 @@ void ProjectionRouter(BXType bx,
       // and is shifted to be positive
       typename VMProjection<VMPTYPE>::VMPRINV rinv = (1<<(nbits_maxvm-1))+irinv_tmp.range(irinv_tmp.length()-1,irinv_tmp.length()-nbits_maxvm);
       //assert(rinv >=0 and rinv < 32);
-    
+
       // PS seed
       // top 3 bits of tracklet index indicate the seeding pair
       ap_uint<nbits_seed> iseed = trackletid.range(trackletid.length()-1,trackletid.length()-nbits_seed);
@@ -195,10 +250,16 @@ void ProjectionRouter(BXType bx,
       // https://github.com/cms-tracklet/fpga_emulation_longVM/blob/fw_synch/FPGATracklet.hh#L1621
 
       // All seeding pairs are PS modules except L3L4 and L5L6
-      bool psseed = not(iseed==TF::L3L4 or iseed==TF::L5L6); 
+      bool psseed = not(iseed==TF::L3L4 or iseed==TF::L5L6);
 
       // VM Projection
-      VMProjection<VMPTYPE> vmproj(index, zbin, finez, rinv, psseed);
+      // The disk projections have no PS seed bit
+      VMProjection<VMPTYPE> vmproj;
+      vmproj.setIndex(index);
+      vmproj.setZBin(zbin);
+      vmproj.setFineZ(finez);
+      vmproj.setRInv(rinv);
+      if (VMPTYPE == BARREL) vmproj.setIsPSSeed(psseed);
 
       // write outputs
       //assert(iphi>=0 and iphi<4);
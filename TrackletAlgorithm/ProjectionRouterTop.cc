@@ -1,10 +1,10 @@
 #include "ProjectionRouterTop.h"
 
 void ProjectionRouterTop(BXType bx,
-                         const TrackletProjectionMemory<BARRELPS> projin[8],
+                         const TrackletProjectionMemory<BARRELPS> projin[kNInMemPR],
                          BXType& bx_o,
                          AllProjectionMemory<BARRELPS>& allprojout,
-                         VMProjectionMemory<BARREL> vmprojout[8])
+                         VMProjectionMemory<BARREL> vmprojout[kNOutMemPR])
 {
  #pragma HLS inline off
  #pragma HLS interface register port=bx_o
@@ -16,11 +16,8 @@ void ProjectionRouterTop(BXType bx,
  #pragma HLS resource variable=projin[5]->get_mem() latency=2
  #pragma HLS resource variable=projin[6]->get_mem() latency=2
  #pragma HLS resource variable=projin[7]->get_mem() latency=2
- // Constants specific to PR_L3PHIC
- constexpr unsigned int nInMem = 8;
- constexpr unsigned int nOutMem = 8;
  constexpr int layer = 3;
  constexpr int disk = 0;
- PR_L3PHIC: ProjectionRouter<BARRELPS, BARREL, nInMem, nOutMem, layer, disk>
+ PR_L3PHIC: ProjectionRouter<BARRELPS, BARREL, kNInMemPR, kNOutMemPR, layer, disk>
     (bx, projin, bx_o, allprojout, vmprojout);
 }
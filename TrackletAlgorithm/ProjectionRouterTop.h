@@ -3,6 +3,12 @@
 
 #include "ProjectionRouter.h"
 
+// Constants specific to PR_L3PHIC
+constexpr regionType kProjTypePR = BARRELPS;
+constexpr regionType kVMProjTypePR = BARREL;
+constexpr unsigned int kNInMemPR = 8;
+constexpr unsigned int kNOutMemPR = 8;
+
 void ProjectionRouterTop(BXType bx,
                          const TrackletProjectionMemory<BARRELPS>*,
                          BXType&,
@@ -0,0 +1,17 @@
+#include "ProjectionRouterTop_D1PHIA.h"
+
+void ProjectionRouterTop(BXType bx,
+                         const TrackletProjectionMemory<DISK> projin[kNInMemPR],
+                         BXType& bx_o,
+                         AllProjectionMemory<DISK>& allprojout,
+                         VMProjectionMemory<DISK> vmprojout[kNOutMemPR])
+{
+ #pragma HLS inline off
+ #pragma HLS interface register port=bx_o
+ #pragma HLS array_partition variable=projin complete dim=1
+ #pragma HLS resource variable=projin.get_mem() latency=2
+ constexpr int layer = 0;
+ constexpr int disk = 1;
+ PR_D1PHIA: ProjectionRouter<DISK, DISK, kNInMemPR, kNOutMemPR, layer, disk>
+    (bx, projin, bx_o, allprojout, vmprojout);
+}
@@ -0,0 +1,25 @@
+#ifndef TrackletAlgorithm_ProjectionRouterTop_D1PHIA_h
+#define TrackletAlgorithm_ProjectionRouterTop_D1PHIA_h
+
+#include "ProjectionRouter.h"
+
+// NOTE: To run this PR, run script_PR.tcl for the region D1PHIA
+//          vivado_hls -f script_PR.tcl -tclargs D1PHIA
+
+// Constants specific to PR_D1PHIA
+// The number of inputs is the number of memories read by PR_D1PHIA in
+// wires_hourglass.dat, written to PR/tables by download.sh.
+constexpr regionType kProjTypePR = DISK;
+constexpr regionType kVMProjTypePR = DISK;
+constexpr unsigned int kNInMemPR =
+#include "../emData/PR/tables/PR_D1PHIA_nInputs.tab"
+;
+constexpr unsigned int kNOutMemPR = 8;
+
+void ProjectionRouterTop(BXType bx,
+                         const TrackletProjectionMemory<DISK>*,
+                         BXType&,
+                         AllProjectionMemory<DISK>&,
+                         VMProjectionMemory<DISK>*);
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef TrackletAlgorithm_PurgeDuplicates_h
+#define TrackletAlgorithm_PurgeDuplicates_h
+
+#include "TrackFitMemory.h"
+#include "ModuleMonitor.h"
+
+#include <cassert>
+
+// The same particle gives several tracks, built from different tracklets, that
+// share most of their stubs. PurgeDuplicates reads the tracks written by the
+// TrackBuilder, one per clock, and only passes on one track of each group of
+// duplicates: two tracks are duplicates if at least kMinNSharedStubsPD of
+// their matched stubs are the same, i.e. have the same stub index and radius
+// in the same layer/disk slot of the track word, and the one with more
+// matched stubs is kept (the first one if they have the same number).
+//
+// Each track is compared in parallel with the kept tracks held in registers,
+// of which there are NKept: when there are more, the oldest are no longer
+// compared with, so that NKept sets the size of the comparators against the
+// fraction of duplicates found.
+//
+// The stub slots of the track word are layers and disks that depend on the
+// seed (kTBSlotLayer and kTBSlotDisk in TrackBuilder.h), so comparing the
+// stubs slot by slot only holds for tracks of the same seed. PurgeDuplicates
+// therefore handles the tracks of a single seed, Seed, as written by the
+// TrackBuilder of that seed; removing the duplicates across seeds would need
+// the stubs compared by layer and disk instead.
+static const unsigned short kMinNSharedStubsPD = 3;
+
+// Stubs of a kept track, as needed for the comparison with the next tracks.
+struct PDStub {
+  ap_uint<1> valid;
+  TrackFit::TFSTUBINDEX index;
+  TrackFit::TFDISKSTUBR r; // barrel radii are zero-padded
+};
+
+struct PDTrack {
+  ap_uint<1> valid;
+  ap_uint<4> nStubs; // number of valid stubs
+  ap_uint<kNBits_MemAddr> slot; // address of the track in the outputs
+  PDStub stubs[TrackFit::kNStubs];
+};
+
+template<uint8_t Hit> void
+getPDStub(const TrackFit &track, PDStub &stub)
+{
+  stub.valid = track.getStubValid<Hit>();
+  stub.index = track.getStubIndex<Hit>();
+  stub.r = (Hit < TrackFit::kNBarrelStubs) ?
+    TrackFit::TFDISKSTUBR(track.getBarrelStubR<Hit % TrackFit::kNBarrelStubs>()) :
+    track.getDiskStubR<TrackFit::kNBarrelStubs + Hit % TrackFit::kNBarrelStubs>();
+}
+
+// PurgeDuplicates top template function
+// The inputs are the outputs of the TrackBuilder of seed Seed, the valid
+// tracks first. The outputs have the same format, with the kept tracks first
+// and the remaining entries left as they are, so they need to be cleared by
+// the caller.
+template<TF::seed Seed, unsigned NKept>
+void PurgeDuplicates(
+    const BXType bx,
+    const TrackFit::TrackWord trackWord[],
+    const TrackFit::BarrelStubWord barrelStubWords[][kMaxProc],
+    const TrackFit::DiskStubWord diskStubWords[][kMaxProc],
+    BXType &bx_o,
+    TrackFit::TrackWord trackWord_o[],
+    TrackFit::BarrelStubWord barrelStubWords_o[][kMaxProc],
+    TrackFit::DiskStubWord diskStubWords_o[][kMaxProc]
+)
+{
+
+  // Kept tracks, newest first
+  PDTrack kept[NKept];
+#pragma HLS array_partition variable=kept complete dim=0
+
+  initialize_kept : for (unsigned short k = 0; k < NKept; k++) {
+#pragma HLS unroll
+    kept[k].valid = 0;
+  }
+
+  ModuleMonitor monitor(module::PD, bx);
+
+  ap_uint<kNBits_MemAddr> nTracks = 0;
+
+  tracks : for (unsigned short i = 0; i < kMaxProc; i++) {
+#pragma HLS pipeline II=1 rewind
+
+    TrackFit track;
+    track.setTrackWord(trackWord[i]);
+    track.setBarrelStubWord<0>(barrelStubWords[0][i]);
+    track.setBarrelStubWord<1>(barrelStubWords[1][i]);
+    track.setBarrelStubWord<2>(barrelStubWords[2][i]);
+    track.setBarrelStubWord<3>(barrelStubWords[3][i]);
+    track.setDiskStubWord<4>(diskStubWords[0][i]);
+    track.setDiskStubWord<5>(diskStubWords[1][i]);
+    track.setDiskStubWord<6>(diskStubWords[2][i]);
+    track.setDiskStubWord<7>(diskStubWords[3][i]);
+
+    const ap_uint<1> valid = track.getTrackValid();
+    assert(!valid || track.getSeedType() == Seed);
+    monitor.inputs(valid);
+    monitor.read(valid);
+
+    PDTrack current;
+    current.valid = valid;
+    getPDStub<0>(track, current.stubs[0]);
+    getPDStub<1>(track, current.stubs[1]);
+    getPDStub<2>(track, current.stubs[2]);
+    getPDStub<3>(track, current.stubs[3]);
+    getPDStub<4>(track, current.stubs[4]);
+    getPDStub<5>(track, current.stubs[5]);
+    getPDStub<6>(track, current.stubs[6]);
+    getPDStub<7>(track, current.stubs[7]);
+    current.nStubs = 0;
+    count_stubs : for (unsigned short j = 0; j < TrackFit::kNStubs; j++) {
+      current.nStubs += current.stubs[j].valid;
+    }
+
+    // Compare with all the kept tracks, the first duplicate found wins.
+    ap_uint<1> duplicate = 0;
+    ap_uint<1> replace = 0;
+    unsigned short dupIndex = 0;
+    compare_kept : for (unsigned short k = 0; k < NKept; k++) {
+      ap_uint<4> nShared = 0;
+      compare_stubs : for (unsigned short j = 0; j < TrackFit::kNStubs; j++) {
+        nShared += (current.stubs[j].valid && kept[k].stubs[j].valid
+                    && current.stubs[j].index == kept[k].stubs[j].index
+                    && current.stubs[j].r == kept[k].stubs[j].r) ? 1 : 0;
+      }
+      if (!duplicate && kept[k].valid && nShared >= kMinNSharedStubsPD) {
+        duplicate = 1;
+        replace = (current.nStubs > kept[k].nStubs);
+        dupIndex = k;
+      }
+    }
+
+    // A new track is appended to the outputs and becomes the newest kept
+    // track, a duplicate with more stubs overwrites the one it duplicates.
+    const ap_uint<kNBits_MemAddr> slot = duplicate ? kept[dupIndex].slot : nTracks;
+    current.slot = slot;
+    if (valid && (!duplicate || replace)) {
+      trackWord_o[slot] = trackWord[i];
+      barrel_stub_words : for (unsigned short j = 0; j < TrackFit::kNBarrelStubs; j++) {
+        barrelStubWords_o[j][slot] = barrelStubWords[j][i];
+      }
+      disk_stub_words : for (unsigned short j = 0; j < TrackFit::kNDiskStubs; j++) {
+        diskStubWords_o[j][slot] = diskStubWords[j][i];
+      }
+    }
+
+    if (valid && !duplicate) {
+      shift_kept : for (unsigned short k = NKept - 1; k > 0; k--) {
+        kept[k] = kept[k - 1];
+      }
+      kept[0] = current;
+      nTracks++;
+    }
+    else if (valid && replace) {
+      update_kept : for (unsigned short k = 0; k < NKept; k++) {
+        if (k == dupIndex) kept[k] = current;
+      }
+    }
+
+    monitor.step(valid);
+  }
+
+  bx_o = bx;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#include "PurgeDuplicatesTop.h"
+
+// L1L2 PurgeDuplicates top function
+void PurgeDuplicates_L1L2(
+    const BXType bx,
+    const TrackFit::TrackWord trackWord[kMaxProc],
+    const TrackFit::BarrelStubWord barrelStubWords[TrackFit::kNBarrelStubs][kMaxProc],
+    const TrackFit::DiskStubWord diskStubWords[TrackFit::kNDiskStubs][kMaxProc],
+    BXType &bx_o,
+    TrackFit::TrackWord trackWord_o[kMaxProc],
+    TrackFit::BarrelStubWord barrelStubWords_o[TrackFit::kNBarrelStubs][kMaxProc],
+    TrackFit::DiskStubWord diskStubWords_o[TrackFit::kNDiskStubs][kMaxProc]
+)
+{
+#pragma HLS inline recursive
+#pragma HLS interface register port=bx_o
+#pragma HLS array_partition variable=barrelStubWords complete dim=1
+#pragma HLS array_partition variable=diskStubWords complete dim=1
+#pragma HLS array_partition variable=barrelStubWords_o complete dim=1
+#pragma HLS array_partition variable=diskStubWords_o complete dim=1
+
+  PurgeDuplicates<TF::L1L2, 16>(
+      bx,
+      trackWord,
+      barrelStubWords,
+      diskStubWords,
+      bx_o,
+      trackWord_o,
+      barrelStubWords_o,
+      diskStubWords_o
+  );
+}
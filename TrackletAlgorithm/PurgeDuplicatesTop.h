@@ -0,0 +1,18 @@
+#ifndef TrackletAlgorithm_PurgeDuplicatesTop_h
+#define TrackletAlgorithm_PurgeDuplicatesTop_h
+
+#include "PurgeDuplicates.h"
+
+// L1L2 PurgeDuplicates top function
+void PurgeDuplicates_L1L2(
+    const BXType bx,
+    const TrackFit::TrackWord trackWord[],
+    const TrackFit::BarrelStubWord barrelStubWords[][kMaxProc],
+    const TrackFit::DiskStubWord diskStubWords[][kMaxProc],
+    BXType &bx_o,
+    TrackFit::TrackWord trackWord_o[],
+    TrackFit::BarrelStubWord barrelStubWords_o[][kMaxProc],
+    TrackFit::DiskStubWord diskStubWords_o[][kMaxProc]
+);
+
+#endif
@@ -4,6 +4,7 @@
 #include "TrackletParameterMemory.h"
 #include "FullMatchMemory.h"
 #include "TrackFitMemory.h"
+#include "ModuleMonitor.h"
 
 static const unsigned short kNBitsTBBuffer = 1;
 static const unsigned short kMinNMatches = 2;
@@ -17,6 +18,50 @@ typedef ap_uint<kNBitsTCID> TCIDType;
 typedef ap_uint<kNBits_MemAddr> IndexType;
 typedef ap_uint<kNBitsTrackletID> TrackletIDType;
 
+// Layers and disks of the stub slots of the track word for each seed, in the
+// order of TF::seed, with -1 for an unused slot. The barrel slots hold the
+// layers the seed projects to and the disk slots the disks, from the innermost
+// one, and the full-match memories passed to TrackBuilder follow the same
+// order, with one memory per all-stub phi region of the layer or disk.
+constexpr int kTBSlotLayer[8][TrackFitBase::kNBarrelStubs] = {
+  {TF::L3, TF::L4, TF::L5, TF::L6}, // L1L2
+  {TF::L1, TF::L4, TF::L5, TF::L6}, // L2L3
+  {TF::L1, TF::L2, TF::L5, TF::L6}, // L3L4
+  {TF::L1, TF::L2, TF::L3, TF::L4}, // L5L6
+  {TF::L1, TF::L2, -1, -1},         // D1D2
+  {TF::L1, TF::L2, -1, -1},         // D3D4
+  {-1, -1, -1, -1},                 // L1D1
+  {TF::L1, -1, -1, -1}              // L2D1
+};
+constexpr int kTBSlotDisk[8][TrackFitBase::kNDiskStubs] = {
+  {TF::D1, TF::D2, TF::D3, TF::D4}, // L1L2
+  {TF::D1, TF::D2, TF::D3, TF::D4}, // L2L3
+  {TF::D1, TF::D2, -1, -1},         // L3L4
+  {-1, -1, -1, -1},                 // L5L6
+  {TF::D3, TF::D4, TF::D5, -1},     // D1D2
+  {TF::D1, TF::D2, TF::D5, -1},     // D3D4
+  {TF::D2, TF::D3, TF::D4, TF::D5}, // L1D1
+  {TF::D2, TF::D3, TF::D4, -1}      // L2D1
+};
+
+// Number of full-match memories of a barrel or disk slot, and index of the
+// first one in barrelFullMatches or diskFullMatches.
+template<TF::seed Seed> constexpr unsigned nFMBarrelSlot(const unsigned slot) {
+  return (kTBSlotLayer[Seed][slot] < 0) ? 0 : (1 << nbitsallstubs[kTBSlotLayer[Seed][slot]]);
+}
+template<TF::seed Seed> constexpr unsigned nFMDiskSlot(const unsigned slot) {
+  return (kTBSlotDisk[Seed][slot] < 0) ? 0 : (1 << nbitsallstubs[N_LAYER + kTBSlotDisk[Seed][slot]]);
+}
+template<TF::seed Seed> constexpr unsigned firstFMBarrelSlot(const unsigned slot) {
+  return (slot == 0) ? 0 : (firstFMBarrelSlot<Seed>(slot - 1) + nFMBarrelSlot<Seed>(slot - 1));
+}
+template<TF::seed Seed> constexpr unsigned firstFMDiskSlot(const unsigned slot) {
+  return (slot == 0) ? 0 : (firstFMDiskSlot<Seed>(slot - 1) + nFMDiskSlot<Seed>(slot - 1));
+}
+
+// Largest number of full-match memories of one slot, i.e. of L1
+static const unsigned short kMaxNFMSlot = 1 << nbitsallstubs[TF::L1];
+
 // Slim data type used to store full match information in the circular buffers.
 struct MyStub {
   public:
@@ -51,8 +96,9 @@ getFM(const BXType bx, const FullMatchMemory<RegionType> &fullMatches, const uns
 }
 
 // TrackBuilder top template function
-// !!! CURRENTLY ONLY TESTED FOR L1L2 !!!
-template<unsigned NFMBarrel, unsigned NFMDisk>
+// NFMBarrel and NFMDisk are the total numbers of barrel and disk full-match
+// memories of the seed, see kTBSlotLayer and kTBSlotDisk.
+template<TF::seed Seed, unsigned NFMBarrel, unsigned NFMDisk>
 void TrackBuilder(
     const BXType bx,
     const TrackletParameterMemory trackletParameters[],
@@ -65,28 +111,36 @@ void TrackBuilder(
 )
 {
 
-  const unsigned NFMPerLayer = NFMBarrel / TrackFit::kNBarrelStubs;
-  const unsigned NFMPerDisk = NFMDisk / TrackFit::kNDiskStubs;
+  static_assert(NFMBarrel == firstFMBarrelSlot<Seed>(TrackFit::kNBarrelStubs), "Wrong number of barrel FullMatch memories for this seed.");
+  static_assert(NFMDisk == firstFMDiskSlot<Seed>(TrackFit::kNDiskStubs), "Wrong number of disk FullMatch memories for this seed.");
+
+  // Sizes of the arrays below, which cannot be empty for the seeds that
+  // have no barrel or no disk slots
+  const unsigned NBarrelArray = (NFMBarrel > 0) ? NFMBarrel : 1;
+  const unsigned NDiskArray = (NFMDisk > 0) ? NFMDisk : 1;
 
   // Circular buffers for each of the input full-match memories.
-  MyStub barrel_fm[NFMBarrel][1<<kNBitsTBBuffer];
-  MyStub disk_fm[NFMDisk][1<<kNBitsTBBuffer];
+  MyStub barrel_fm[NBarrelArray][1<<kNBitsTBBuffer];
+  MyStub disk_fm[NDiskArray][1<<kNBitsTBBuffer];
 #pragma HLS array_partition variable=barrel_fm complete dim=0
 #pragma HLS array_partition variable=disk_fm complete dim=0
 
   // Read and write indices for the circular buffers.
-  ap_uint<kNBits_MemAddr> barrel_mem_index[NFMBarrel];
-  ap_uint<kNBits_MemAddr> disk_mem_index[NFMDisk];
-  ap_uint<kNBitsTBBuffer> barrel_read_index[NFMBarrel];
-  ap_uint<kNBitsTBBuffer> disk_read_index[NFMDisk];
-  ap_uint<kNBitsTBBuffer> barrel_write_index[NFMBarrel];
-  ap_uint<kNBitsTBBuffer> disk_write_index[NFMDisk];
+  ap_uint<kNBits_MemAddr> barrel_mem_index[NBarrelArray];
+  ap_uint<kNBits_MemAddr> disk_mem_index[NDiskArray];
+  ap_uint<kNBitsTBBuffer> barrel_read_index[NBarrelArray];
+  ap_uint<kNBitsTBBuffer> disk_read_index[NDiskArray];
+  ap_uint<kNBitsTBBuffer> barrel_write_index[NBarrelArray];
+  ap_uint<kNBitsTBBuffer> disk_write_index[NDiskArray];
+
+  ModuleMonitor monitor(module::TB, bx);
 
   initialize_barrel_indices : for (unsigned short i = 0; i < NFMBarrel; i++) {
 #pragma HLS unroll
     barrel_mem_index[i] = 0;
     barrel_read_index[i] = 0;
     barrel_write_index[i] = 0;
+    monitor.inputs(barrelFullMatches[i].getEntries(bx));
   }
 
   initialize_disk_indices : for (unsigned short i = 0; i < NFMDisk; i++) {
@@ -94,6 +148,7 @@ void TrackBuilder(
     disk_mem_index[i] = 0;
     disk_read_index[i] = 0;
     disk_write_index[i] = 0;
+    monitor.inputs(diskFullMatches[i].getEntries(bx));
   }
 
   IndexType nTracks = 0;
@@ -103,10 +158,10 @@ void TrackBuilder(
 
     const ap_uint<1> empty = (i == 0);
     TrackletIDType min_id = kInvalidTrackletID;
-    IndexType barrel_index[NFMBarrel];
-    IndexType disk_index[NFMDisk];
-    ap_uint<1> barrel_valid[NFMBarrel];
-    ap_uint<1> disk_valid[NFMDisk];
+    IndexType barrel_index[NBarrelArray];
+    IndexType disk_index[NDiskArray];
+    ap_uint<1> barrel_valid[NBarrelArray];
+    ap_uint<1> disk_valid[NDiskArray];
 #pragma HLS array_partition variable=barrel_index complete dim=0
 #pragma HLS array_partition variable=disk_index complete dim=0
 #pragma HLS array_partition variable=barrel_valid complete dim=0
@@ -164,8 +219,9 @@ void TrackBuilder(
     // with the minimum tracklet ID.
     const TCIDType &TCID = (min_id != kInvalidTrackletID) ? (min_id >> kNBits_MemAddr) : TrackletIDType(0);
     TrackFit track(nTracks, TCID >> kNBitsITC);
+    const ap_uint<kNBitsITC> iTC = TCID;
     const IndexType &trackletIndex = (min_id != kInvalidTrackletID) ? (min_id & TrackletIDType(0x7F)) : TrackletIDType(0);
-    const auto &tpar = trackletParameters[TCID].read_mem(bx, trackletIndex);
+    const auto &tpar = trackletParameters[iTC].read_mem(bx, trackletIndex);
     track.setRinv(tpar.getRinv());
     track.setPhi0(tpar.getPhi0());
     track.setZ0(tpar.getZ0());
@@ -177,17 +233,22 @@ void TrackBuilder(
     ap_uint<3> nMatches = 0; // there can be up to eight matches (3 bits)
     barrel_stub_association : for (unsigned short j = 0; j < TrackFit::kNBarrelStubs; j++) {
 
+      const unsigned first = firstFMBarrelSlot<Seed>(j);
+      const int nFM = nFMBarrelSlot<Seed>(j);
+
+      // The full match of the slot is the one in the first of its memories
+      // that has the minimum tracklet ID.
       ap_uint<1> barrel_stub_valid = false;
-      barrel_stub_valid : for (unsigned short k = 0; k < NFMPerLayer; k++)
-        barrel_stub_valid = (barrel_stub_valid || barrel_valid[j * NFMPerLayer + k]);
+      FullMatch<BARREL> barrel_stub;
+      barrel_stub_valid : for (short k = kMaxNFMSlot - 1; k >= 0; k--) {
+        if (k < nFM) {
+          barrel_stub_valid = (barrel_stub_valid || barrel_valid[first + k]);
+          if (k == nFM - 1 || barrel_valid[first + k])
+            barrel_stub = barrelFullMatches[first + k].read_mem(bx, barrel_index[first + k]);
+        }
+      }
       nMatches += (barrel_stub_valid ? 1 : 0);
 
-      // The following code is currently specific to L1L2 with four FullMatch memories per layer.
-      static_assert(NFMPerLayer == 4, "Only tested for L1L2 with four FullMatch memories per layer.");
-      const auto &barrel_stub = (barrel_valid[j * 4]     ? barrelFullMatches[j * 4].read_mem(bx, barrel_index[j * 4]) :
-                                (barrel_valid[j * 4 + 1] ? barrelFullMatches[j * 4 + 1].read_mem(bx, barrel_index[j * 4 + 1]) :
-                                (barrel_valid[j * 4 + 2] ? barrelFullMatches[j * 4 + 2].read_mem(bx, barrel_index[j * 4 + 2]) : barrelFullMatches[j * 4 + 3].read_mem(bx, barrel_index[j * 4 + 3]))));
-
       const auto &barrel_stub_index = (barrel_stub_valid ? barrel_stub.getStubIndex() : FullMatch<BARREL>::FMSTUBINDEX(0));
       const auto &barrel_stub_r = (barrel_stub_valid ? barrel_stub.getStubR() : FullMatch<BARREL>::FMSTUBR(0));
       const auto &barrel_phi_res = (barrel_stub_valid ? barrel_stub.getPhiRes() : FullMatch<BARREL>::FMPHIRES(0));
@@ -209,19 +270,22 @@ void TrackBuilder(
       }
     }
 
-    disk_stub_association : for (unsigned short j = 0; j < 4; j++) {
+    disk_stub_association : for (unsigned short j = 0; j < TrackFit::kNDiskStubs; j++) {
+
+      const unsigned first = firstFMDiskSlot<Seed>(j);
+      const int nFM = nFMDiskSlot<Seed>(j);
 
       ap_uint<1> disk_stub_valid = false;
-      disk_stub_valid : for (unsigned short k = 0; k < NFMPerDisk; k++)
-        disk_stub_valid = (disk_stub_valid || disk_valid[j * NFMPerDisk + k]);
+      FullMatch<DISK> disk_stub;
+      disk_stub_valid : for (short k = kMaxNFMSlot - 1; k >= 0; k--) {
+        if (k < nFM) {
+          disk_stub_valid = (disk_stub_valid || disk_valid[first + k]);
+          if (k == nFM - 1 || disk_valid[first + k])
+            disk_stub = diskFullMatches[first + k].read_mem(bx, disk_index[first + k]);
+        }
+      }
       nMatches += (disk_stub_valid ? 1 : 0);
 
-      // The following code is currently specific to L1L2 with four FullMatch memories per disk.
-      static_assert(NFMPerDisk == 4, "Only tested for L1L2 with four FullMatch memories per disk.");
-      const auto &disk_stub = (disk_valid[j * 4]     ? diskFullMatches[j * 4].read_mem(bx, disk_index[j * 4]) :
-                              (disk_valid[j * 4 + 1] ? diskFullMatches[j * 4 + 1].read_mem(bx, disk_index[j * 4 + 1]) :
-                              (disk_valid[j * 4 + 2] ? diskFullMatches[j * 4 + 2].read_mem(bx, disk_index[j * 4 + 2]) : diskFullMatches[j * 4 + 3].read_mem(bx, disk_index[j * 4 + 3]))));
-
       const auto &disk_stub_index = (disk_stub_valid ? disk_stub.getStubIndex() : FullMatch<DISK>::FMSTUBINDEX(0));
       const auto &disk_stub_r = (disk_stub_valid ? disk_stub.getStubR() : FullMatch<DISK>::FMSTUBR(0));
       const auto &disk_phi_res = (disk_stub_valid ? disk_stub.getPhiRes() : FullMatch<DISK>::FMPHIRES(0));
@@ -285,12 +349,17 @@ void TrackBuilder(
     }
     nTracks += (nMatches >= kMinNMatches ? 1 : 0);
 
+    // A full match waiting in memory behind a full buffer is a stall
+    bool stalled = false;
+
     // Update the circular buffer indices and read a new element from each of
     // the input full-match memories.
     barrel_circular_buffer_update : for (unsigned short j = 0; j < NFMBarrel; j++) {
       barrel_read_index[j] += (barrel_valid[j] ? 1 : 0);
       const ap_uint<kNBitsTBBuffer> barrel_next_write_index = barrel_write_index[j] + 1;
       const ap_uint<1> barrel_not_full = (barrel_next_write_index != barrel_read_index[j]);
+      monitor.read(barrel_valid[j]);
+      stalled = stalled || (!empty && !barrel_not_full && barrel_mem_index[j] < barrelFullMatches[j].getEntries(bx));
       getFM<BARREL>(bx, barrelFullMatches[j], barrel_mem_index[j], barrel_fm[j][barrel_write_index[j]]);
       barrel_mem_index[j] += ((empty || barrel_not_full) ? 1 : 0);
       barrel_write_index[j] += ((empty || barrel_not_full) ? 1 : 0);
@@ -300,10 +369,14 @@ void TrackBuilder(
       disk_read_index[j] += (disk_valid[j] ? 1 : 0);
       const ap_uint<kNBitsTBBuffer> disk_next_write_index = disk_write_index[j] + 1;
       const ap_uint<1> disk_not_full = (disk_next_write_index != disk_read_index[j]);
+      monitor.read(disk_valid[j]);
+      stalled = stalled || (!empty && !disk_not_full && disk_mem_index[j] < diskFullMatches[j].getEntries(bx));
       getFM<DISK>(bx, diskFullMatches[j], disk_mem_index[j], disk_fm[j][disk_write_index[j]]);
       disk_mem_index[j] += ((empty || disk_not_full) ? 1 : 0);
       disk_write_index[j] += ((empty || disk_not_full) ? 1 : 0);
     }
+
+    monitor.step(min_id != kInvalidTrackletID, stalled);
   }
 
   bx_o = bx;
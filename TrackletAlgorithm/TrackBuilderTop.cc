@@ -26,7 +26,7 @@ void TrackBuilder_L1L2(
 #pragma HLS stream variable=barrelStubWords depth=1 dim=2
 #pragma HLS stream variable=diskStubWords depth=1 dim=2
 
-  TrackBuilder<16, 16>(
+  TrackBuilder<TF::L1L2, 16, 16>(
       bx,
       trackletParameters,
       barrelFullMatches,
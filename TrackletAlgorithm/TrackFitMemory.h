@@ -92,9 +92,10 @@ public:
 };
 
 // Data object definition:
-// Currently The TrackFit object is specific to L1L2-seeded tracks, containing
-// four matched barrel stubs and four matched disk stubs, as well as a track
-// word that contains the tracklet parameters.
+// The TrackFit object contains four matched barrel stubs and four matched disk
+// stubs, as well as a track word that contains the tracklet parameters. The
+// layers and disks of the stub slots depend on the seed, see kTBSlotLayer and
+// kTBSlotDisk in TrackBuilder.h.
 class TrackFit : public TrackFitBits
 {
 public:
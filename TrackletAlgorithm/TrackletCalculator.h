@@ -8,6 +8,8 @@
 #include "AllStubMemory.h"
 #include "TrackletParameterMemory.h"
 #include "TrackletProjectionMemory.h"
+#include "ModuleMonitor.h"
+#include "MultiMemoryReader.h"
 
 namespace TC {
 ////////////////////////////////////////////////////////////////////////////////
@@ -129,15 +131,6 @@ namespace TC {
 
   template<regionType TProjType, uint8_t NProjOut, uint32_t TPROJMask> bool addProj(const TrackletProjection<TProjType> &proj, const BXType bx, TrackletProjectionMemory<TProjType> projout[NProjOut], ap_uint<kNBits_MemAddr> nproj[NProjOut], const bool success);
 
-  template<uint8_t NSPMem> void
-  getIndices(
-      const BXType bx,
-      const StubPairMemory stubPairs[NSPMem],
-      TC::Types::nSPMem &iSPMem,
-      TC::Types::nSP &iSP,
-      bool &done
-  );
-
   template<TF::seed Seed, regionType InnerRegion, regionType OuterRegion, uint32_t TPROJMaskBarrel, uint32_t TPROJMaskDisk> void
   processStubPair(
       const BXType bx,
@@ -376,32 +369,6 @@ TC::addProj(const TrackletProjection<TProjType> &proj, const BXType bx, Tracklet
 }
 
 
-// Determine the correct stub-pair memory and stub-pair index given the global
-// index initially stored in iSP.
-template<uint8_t NSPMem> void
-TC::getIndices(
-    const BXType bx,
-    const StubPairMemory stubPairs[NSPMem],
-    TC::Types::nSPMem &iSPMem,
-    TC::Types::nSP &iSP,
-    bool &done
-)
-{
-  bool set = false;
-
-  iSPMem = 0;
-  done = false;
-
-  index: for (TC::Types::nSPMem j = 0; j < NSPMem; j++) {
-    if (!set && iSP >= stubPairs[j].getEntries(bx))
-      iSP -= stubPairs[j].getEntries(bx), iSPMem++;
-    else
-      set = true;
-  }
-
-  done = !set || iSPMem >= NSPMem;
-}
-
 // Processes a given stub pair and writes the calculated tracklet parameters
 // and tracklet projections to the appropriate memories.
 template<TF::seed Seed, regionType InnerRegion, regionType OuterRegion, uint32_t TPROJMaskBarrel, uint32_t TPROJMaskDisk> void
@@ -558,6 +525,19 @@ TrackletCalculator(
 
   const TrackletProjection<BARRELPS>::TProjTCID TCID = TC::ID<Seed, iTC>();
 
+  ModuleMonitor monitor(module::TC, bx);
+  ap_uint<kNBits_MemAddr> nStubPairs[NSPMem];
+#pragma HLS array_partition variable=nStubPairs complete
+  for (unsigned j = 0; j < NSPMem; j++) {
+#pragma HLS unroll
+    nStubPairs[j] = stubPairs[j].getEntries(bx);
+    monitor.inputs(nStubPairs[j]);
+  }
+
+// The stub pairs are read memory after memory (MultiMemoryReader.h).
+  MultiMemoryReader<NSPMem> spReader;
+  spReader.init(nStubPairs);
+
 // Loop over all stub pairs.
   stub_pairs: for (TC::Types::nSP i = 0; i < kMaxProc - kMaxProcOffset(module::TC); i++) {
 #pragma HLS pipeline II=1 rewind
@@ -565,10 +545,11 @@ TrackletCalculator(
 // The first iteration is sacrificed to clearing the output memories and
 // zeroing the number of tracklets and projections. Therefore, only
 // kMaxProc - 1 iterations are actually used for processing stub pairs.
-    TC::Types::nSPMem iSPMem;
-    TC::Types::nSP iSP = i - 1;
-    bool done;
-    TC::getIndices<NSPMem>(bx, stubPairs, iSPMem, iSP, done);
+    typename MultiMemoryReader<NSPMem>::MemIndex iSPMem;
+    typename MultiMemoryReader<NSPMem>::MemAddr iSP;
+    const bool done = (i == 0) || !spReader.get(i - 1, iSPMem, iSP);
+    monitor.step(!done);
+    monitor.read(!done);
 
     if (!done) {
 // Retrieve the inner and outer stubs for this stub pair, determining which
@@ -4,6 +4,7 @@
 #include "VMStubTEInnerMemory.h"
 #include "VMStubTEOuterMemory.h"
 #include "StubPairMemory.h"
+#include "ModuleMonitor.h"
 
 #include "hls_math.h"
 #include <string>
@@ -33,13 +34,19 @@ enum phireg {
 	 Z5,  Z6,  Z9, Z10, Z11, Z12
 };
 
+// Default number of bits of the index of the stub buffer, i.e. 8 entries
+constexpr unsigned int kNBits_BufferAddr = 3;
+
 }//namespace TE
 
 //----------------------------
 // Tracklet Engine main code
 //============================
+// NBitsBuffer sets the size of the buffer of inner stubs and z-bins waiting
+// to be paired, 1<<NBitsBuffer
 template<int innertype, int outertype,
-  unsigned int stubptinnerdepth, unsigned int stubptouterdepth>
+  unsigned int stubptinnerdepth, unsigned int stubptouterdepth,
+  unsigned int NBitsBuffer = TE::kNBits_BufferAddr>
 void TrackletEngine(
 		    const BXType bx,
 		    const VMStubTEInnerMemory<innertype>& instubinnerdata,
@@ -56,11 +63,10 @@ void TrackletEngine(
   //
   // Set up a FIFO based on a circular buffer structure
   // Each element consists of
-  //   * kNBits_BufferAddr is the number of bits to handle buffer index (i.e. buffer size will be 1<<kNBits_BufferAddr).
+  //   * NBitsBuffer is the number of bits to handle buffer index (i.e. buffer size will be 1<<NBitsBuffer).
   //   * kBufferDataSize is the size of each element in the buffer. The element data consists of, in order of MSB to LSB:
   //       [# of outer stubs in z-bin][inner stub data][index of z-bin][z-bin flag]
   //
-  constexpr unsigned int kNBits_BufferAddr = 3;
   constexpr unsigned int kNOuterStubsSize = 5;
   constexpr unsigned int kZBinFlagSize = 1;
   constexpr int kBufferDataSize =
@@ -78,16 +84,19 @@ void TrackletEngine(
   constexpr unsigned int kNOuterStubsLSB = kInnerStubDataMSB + 1;
   constexpr unsigned int kNOuterStubsMSB = kNOuterStubsLSB + kNOuterStubsSize - 1;
 
-  ap_uint<kBufferDataSize> teBuffer[1<<kNBits_BufferAddr];
+  ap_uint<kBufferDataSize> teBuffer[1<<NBitsBuffer];
 #pragma HLS ARRAY_PARTITION variable teBuffer complete dim=0
-  ap_uint<kNBits_BufferAddr> writeindex = 0;     // handles current buffer index for writing
-  ap_uint<kNBits_BufferAddr> readindex  = 0;     // handles current buffer index for reading
+  ap_uint<NBitsBuffer> writeindex = 0;     // handles current buffer index for writing
+  ap_uint<NBitsBuffer> readindex  = 0;     // handles current buffer index for reading
 
 
   ap_uint<kNBits_MemAddr> istubinner=0;
   auto const nstubinner = instubinnerdata.getEntries(bx);
   ap_uint<1> morestubinner = istubinner<nstubinner;
 
+  ModuleMonitor monitor(module::TE, bx);
+  monitor.inputs(nstubinner);
+
   // variables for inner stub information
   typename VMStubTEInner<innertype>::VMSTEIID      innerstubindex;
   typename VMStubTEInner<innertype>::VMSTEIBEND    innerstubbend;
@@ -113,18 +122,21 @@ void TrackletEngine(
 	  auto const bufdata = teBuffer[readindex];
 
 	  // buffer is not full if 2 slots are available, as we may write stubs for up to 2 z-bins
-	  const ap_uint<kNBits_BufferAddr> writeindexplus     = writeindex+1;
-	  const ap_uint<kNBits_BufferAddr> writeindexplusplus = writeindex+2;
+	  const ap_uint<NBitsBuffer> writeindexplus     = writeindex+1;
+	  const ap_uint<NBitsBuffer> writeindexplusplus = writeindex+2;
 	  const ap_uint<1> buffernotfull = (writeindexplus!=readindex) && (writeindexplusplus!=readindex);
 
 	  // buffer is not empty when current write index and read index are different
 	  const ap_uint<1> buffernotempty = (writeindex!=readindex);
 
+	  monitor.step(buffernotempty, morestubinner && !buffernotfull);
+
 	  // buffer is not full and there are more inner stubs to read in...
 	  if(morestubinner && buffernotfull) {
 		  auto const innerstubdatatmp  = instubinnerdata.read_mem(bx,istubinner);
 		  istubinner++;
 		  morestubinner = istubinner<nstubinner;
+		  monitor.read();
 
 		  const ap_uint<TEBinsBits> zbinstart = innerstubdatatmp.getZBinStart();
 		  const ap_uint<TEBinsBits> zbinlast  = zbinstart + innerstubdatatmp.getZBinDiff();
@@ -152,7 +164,7 @@ void TrackletEngine(
 			  const ap_uint<TEBinsBits+1> tmp1 = zbinlast.concat(one);
 			  const ap_uint<VMStubTEInner<innertype>::kVMStubTEInnerSize+TEBinsBits+1> tmp2 = innerstubdatatmp.raw().concat(tmp1);
 			  if(savestart) {
-				  const ap_uint<kNBits_BufferAddr> writeindextmpplus = writeindextmp+1;
+				  const ap_uint<NBitsBuffer> writeindextmpplus = writeindextmp+1;
 				  teBuffer[writeindextmpplus] = nstubslast.concat(tmp2);
 			  } else {
 				  teBuffer[writeindextmp] = nstubslast.concat(tmp2);
@@ -222,6 +234,9 @@ void TrackletEngine(
       	 }
   }
 
+  // z-bins left in the buffer
+  monitor.pending(ap_uint<NBitsBuffer>(writeindex-readindex));
+
   bx_o = bx;
 }
 
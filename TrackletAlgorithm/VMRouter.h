@@ -14,6 +14,8 @@
 
 // NOTE: Nothing in VMRouter.h needs to be changed to run a different phi region
 
+// Define VMR_DEBUG to print the stubs routed, in C-simulation
+
 
 #ifndef TrackletAlgorithm_VMRouter_h
 #define TrackletAlgorithm_VMRouter_h
@@ -27,6 +29,9 @@
 #include "VMStubMEMemory.h"
 #include "VMStubTEInnerMemory.h"
 #include "VMStubTEOuterMemory.h"
+#include "ModuleMonitor.h"
+#include "MultiMemoryReader.h"
+#include "PhiCorrection.h"
 
 
 /////////////////////////////////////////
@@ -60,9 +65,6 @@ constexpr int nbitsrtablelayer = 4;
 constexpr int nbitsztabledisk = 3;
 constexpr int nbitsrtabledisk = 8;
 
-// Number of MSBs used for r index in phiCorr LUTs
-constexpr int nbitsrphicorrtable = 3; // Found hardcoded in VMRouterphiCorrTable.h
-
 // Constants used for calculating which VM a stub belongs to
 constexpr int nbits_maxvmol = 4; // Overlap
 
@@ -81,9 +83,17 @@ constexpr int maskTEOsize = 1 << nbits_maxvm; // TEOuter memories
 // Maximum number of memories, exclusive DISK2S
 constexpr int maxinput = 4;
 
+// Order in which the input memories are read, as in the wiring script to pass
+// the test bench: the first DISK2S memory, the PS memories 0 and 1, the second
+// DISK2S memory and the PS memories 2 and 3. The memories from the second
+// DISK2S one on are the negative disk ones.
+constexpr int inputOrder[maskISsize] = {4, 0, 1, 5, 2, 3};
+constexpr int firstNegDiskInput = 3;
+
 // Number of bins per page in memories (may change in future)
 constexpr int nmaxbinsperpagelayer = 8;
 constexpr int nmaxbinsperpagedisk = 16;
+constexpr int maxBinsPerPage(int layer) {return (layer) ? nmaxbinsperpagelayer : nmaxbinsperpagedisk;}
 
 // Number of bits used for binning TE Outer memories, i.e. 1 << NBitsBinTEO bins
 constexpr int NBitsBinTEO = 3;
@@ -149,35 +159,6 @@ inline int iphivmFineBins(const typename AllStub<InType>::ASPHI phi,
 	return finebin;
 }
 
-// Get the corrected phi, i.e. phi at the average radius of the barrel
-// Corrected phi is used by ME and TE memories in the barrel
-template<regionType InType>
-inline typename AllStub<InType>::ASPHI getPhiCorr(
-		const typename AllStub<InType>::ASPHI phi,
-		const typename AllStub<InType>::ASR r,
-		const typename AllStub<InType>::ASBEND bend, const int phiCorrTable[]) {
-
-	if (InType == DISKPS || InType == DISK2S)
-		return phi; // Do nothing if disks
-
-	constexpr auto rBins = 1 << nbitsrphicorrtable; // The number of bins for r
-
-	ap_uint<nbitsrphicorrtable> rBin = (r + (1 << (r.length() - 1)))
-			>> (r.length() - nbitsrphicorrtable); // Which bin r belongs to. Note r = 0 is mid radius
-	auto index = bend * rBins + rBin; // Index for where we find our correction value
-	auto corrValue = phiCorrTable[index]; // The amount we need to correct our phi
-
-	auto phiCorr = phi - corrValue; // the corrected phi
-
-	// Check for overflow
-	if (phiCorr < 0)
-		phiCorr = 0; // can't be less than 0
-	if (phiCorr >= 1 << phi.length())
-		phiCorr = (1 << phi.length()) - 1;  // can't be more than the max value
-
-	return phiCorr;
-}
-
 // Returns the number of the first ME/TE memory for the current VMRouter
 // I.e. the position of the first non-zero bit in the mask
 // L1PHIE17 would return 16
@@ -231,7 +212,7 @@ void clear3DArray(int dim1Length, ap_uint<nbits> array[][dim2Length][dim3Length]
 template<regionType InType, regionType OutType, int Layer, int Disk>
 inline VMStubME<OutType> createStubME(const InputStub<InType> stub,
 		const int index, const bool negDisk, const int fineBinTable[],
-		const int phiCorrTable[], int& ivmPlus, int& ivmMinus, int& bin) {
+		const typename AllStub<InType>::ASPHI phiCorr, int& ivmPlus, int& ivmMinus, int& bin) {
 
 	// The MEStub that is going to be returned
 	VMStubME<OutType> stubME;
@@ -240,8 +221,6 @@ inline VMStubME<OutType> createStubME(const InputStub<InType> stub,
 	auto z = stub.getZ();
 	auto r = stub.getR();
 	auto bend = stub.getBend();
-	auto phi = stub.getPhi();
-	auto phiCorr = getPhiCorr<InType>(phi, r, bend, phiCorrTable); // Corrected phi, i.e. phi at nominal radius (what about disks?)
 
 	int nrBits = r.length(); // Number of bits for r
 	int nzBits = z.length(); // Number of bits for z
@@ -333,7 +312,7 @@ inline VMStubME<OutType> createStubME(const InputStub<InType> stub,
 template<regionType InType, regionType OutType, int Layer, int Disk>
 inline VMStubTEInner<OutType> createStubTEInner(const InputStub<InType> stub,
 		const int index, const bool negDisk, const int rzbitsInnerTable[],
-		const int phiCorrTable[], int& ivm, int& rzbits) {
+		const typename AllStub<InType>::ASPHI phiCorr, int& ivm, int& rzbits) {
 
 	// The TEInner Stub that is going to be returned
 	VMStubTEInner<OutType> stubTEI;
@@ -342,8 +321,6 @@ inline VMStubTEInner<OutType> createStubTEInner(const InputStub<InType> stub,
 	auto z = stub.getZ();
 	auto r = stub.getR();
 	auto bend = stub.getBend();
-	auto phi = stub.getPhi();
-	auto phiCorr = getPhiCorr<InType>(phi, r, bend, phiCorrTable); // Corrected phi, i.e. phi at nominal radius (what about disks?)
 
 	int nrBits = r.length(); // Number of bits for r
 	int nzBits = z.length(); // Number of bits for z
@@ -420,7 +397,7 @@ inline VMStubTEInner<OutType> createStubTEInner(const InputStub<InType> stub,
 template<regionType InType, regionType OutType, int Layer, int Disk>
 inline VMStubTEOuter<OutType> createStubTEOuter(const InputStub<InType> stub,
 		const int index, const bool negDisk, const int rzbitsOuterTable[],
-		const int phiCorrTable[], int& ivm, int& bin) {
+		const typename AllStub<InType>::ASPHI phiCorr, int& ivm, int& bin) {
 
 	// The TEOuter stub that is going to be returned
 	VMStubTEOuter<OutType> stubTEO;
@@ -429,8 +406,6 @@ inline VMStubTEOuter<OutType> createStubTEOuter(const InputStub<InType> stub,
 	auto z = stub.getZ();
 	auto r = stub.getR();
 	auto bend = stub.getBend();
-	auto phi = stub.getPhi();
-	auto phiCorr = getPhiCorr<InType>(phi, r, bend, phiCorrTable); // Corrected phi, i.e. phi at nominal radius
 
 	int nrBits = r.length(); // Number of bits for r
 	int nzBits = z.length(); // Number of bits for z
@@ -518,7 +493,7 @@ inline VMStubTEOuter<OutType> createStubTEOuter(const InputStub<InType> stub,
 template<regionType InType, int Layer>
 inline VMStubTEInner<BARRELOL> createStubTEOverlap(const InputStub<InType> stub,
 		const int index, const int rzbitsOverlapTable[],
-		const int phiCorrTable[], int& ivm, int& rzbits) {
+		const typename AllStub<InType>::ASPHI phiCorr, int& ivm, int& rzbits) {
 
 	// The overlap stub that is going to be returned
 	VMStubTEInner<BARRELOL> stubOL;
@@ -527,8 +502,6 @@ inline VMStubTEInner<BARRELOL> createStubTEOverlap(const InputStub<InType> stub,
 	auto z = stub.getZ();
 	auto r = stub.getR();
 	auto bend = stub.getBend();
-	auto phi = stub.getPhi();
-	auto phiCorr = getPhiCorr<InType>(phi, r, bend, phiCorrTable); // Corrected phi, i.e. phi at nominal radius (what about disks?)
 
 	int nrBits = r.length(); // Number of bits for r
 	int nzBits = z.length(); // Number of bits for z
@@ -572,47 +545,49 @@ inline VMStubTEInner<BARRELOL> createStubTEOverlap(const InputStub<InType> stub,
 }
 
 
-/////////////////////////////////
-// Main function
-
-// InType DISK2S - Two input region types InType and DISK2S due to the disks having both 2S and PS inputs.
-// 		According to wiring script, there's two DISK2S and half the inputs are for negative disks.
-// Layer Disk - Specifies the layer or disk number
-// MAXCopies - The maximum number of copies of a memory type
-// NBitsBin number of bits used for the bins in MEMemories
-template<regionType InType, regionType OutType, int Layer, int Disk, int MaxAllCopies, int MaxTEICopies, int MaxOLCopies, int MaxTEOCopies, int NBitsBin, int BendCutTableSize>
-void VMRouter(const BXType bx, BXType& bx_o, const int fineBinTable[], const int phiCorrTable[],
+// Writes NStubs input stubs, read in the same clock, to the AllStub, ME,
+// TE Inner, TE Outer and overlap memories. index is the address of the first
+// stub in the AllStub memories, the others following it, and phiCorr their
+// phi corrected to the nominal radius, computed once by the caller
+// (getPhiCorr). stubDisk2S is the stub if disk2S, as the disks have both PS
+// and 2S inputs, and valid is false for the stubs that were not read.
+// The address counters of the memories are kept by the caller over the BX.
+// The stubs of a clock written to the same memory, or to the same bin of a
+// binned memory, go to consecutive addresses in the order of the stubs: the
+// address of a stub is the counter at the start of the clock plus the number
+// of stubs before it written there, so that the writes of a clock do not
+// depend on each other.
+template<regionType InType, regionType OutType, int Layer, int Disk, int MaxAllCopies, int MaxTEICopies, int MaxOLCopies, int MaxTEOCopies, int NBitsBin, int BendCutTableSize, int NStubs>
+inline void routeVMStubs(const BXType bx, const int index, const bool valid[NStubs],
+		const InputStub<InType> stub[NStubs], const InputStub<DISK2S> stubDisk2S[NStubs],
+		const bool disk2S[NStubs], const bool negDisk[NStubs],
+		const typename AllStub<InType>::ASPHI phiCorr[NStubs], const int fineBinTable[],
 		// rzbitstables, aka binlookup in emulation
 		const int rzbitsInnerTable[], const int rzbitsOverlapTable[], const int rzbitsOuterTable[],
 		// bendcut tables
 		const ap_uint<BendCutTableSize> bendCutInnerTable[], const ap_uint<BendCutTableSize> bendCutOverlapTable[], const ap_uint<BendCutTableSize> bendCutOuterTable[],
-		// Input memories
-		const ap_uint<maskISsize>& maskIS,
-		const InputStubMemory<InType> inputStubs[],
-		const InputStubMemory<DISK2S> inputStubsDisk2S[],
 		// AllStub memory
 		AllStubMemory<OutType> memoriesAS[],
 		// ME memories
 		const ap_uint<maskMEsize>& maskME, VMStubMEMemory<OutType, NBitsBin> memoriesME[],
+		ap_uint<kNBits_MemAddr-NBitsBin+1> addrCountME[][maxBinsPerPage(Layer)],
 		// Inner TE memories, non-overlap
 		const ap_uint<maskTEIsize>& maskTEI, VMStubTEInnerMemory<OutType> memoriesTEI[][MaxTEICopies],
+		ap_uint<kNBits_MemAddr> addrCountTEI[][MaxTEICopies],
 		// TE Inner memories, overlap
 		const ap_uint<maskOLsize>& maskOL, VMStubTEInnerMemory<BARRELOL> memoriesOL[][MaxOLCopies],
+		ap_uint<kNBits_MemAddr> addrCountOL[][MaxOLCopies],
 		// TE Outer memories
-		const ap_uint<maskTEOsize>& maskTEO, VMStubTEOuterMemory<OutType> memoriesTEO[][MaxTEOCopies]) {
+		const ap_uint<maskTEOsize>& maskTEO, VMStubTEOuterMemory<OutType> memoriesTEO[][MaxTEOCopies],
+		ap_uint<kNBits_MemAddr-NBitsBinTEO+1> addrCountTEO[][MaxTEOCopies][maxBinsPerPage(Layer)]) {
 
 #pragma HLS inline
-#pragma HLS array_partition variable=bendCutInnerTable complete dim=1
-#pragma HLS array_partition variable=bendCutOverlapTable complete dim=1
-#pragma HLS array_partition variable=bendCutOuterTable complete dim=1
-#pragma HLS array_partition variable=inputStubs complete dim=1
-#pragma HLS array_partition variable=inputStubsDisk2S complete dim=1
-#pragma HLS array_partition variable=memoriesAS complete dim=1
-#pragma HLS array_partition variable=memoriesME complete dim=1
-#pragma HLS array_partition variable=memoriesTEI complete dim=2
-#pragma HLS array_partition variable=memoriesOL complete dim=2
-#pragma HLS array_partition variable=memoriesTEO complete dim=2
-
+#pragma HLS array_partition variable=valid complete
+#pragma HLS array_partition variable=stub complete
+#pragma HLS array_partition variable=stubDisk2S complete
+#pragma HLS array_partition variable=disk2S complete
+#pragma HLS array_partition variable=negDisk complete
+#pragma HLS array_partition variable=phiCorr complete
 
 	// The first memory numbers, the position of the first non-zero bit in the mask
 	// Do not change these to ap_uint as cosim will fail
@@ -621,317 +596,460 @@ void VMRouter(const BXType bx, BXType& bx_o, const int fineBinTable[], const int
 	static const int firstOL = firstMemNumber(maskOL); // TE Overlap memory
 	static const int firstTEO = firstMemNumber(maskTEO); // TE Inner memory
 
-	// Number of memories/VMs for one coarse phi region
-	constexpr int nvmME = (Layer) ? nvmmelayers[Layer-1] : nvmmedisks[Disk-1]; // ME memories
-	constexpr int nvmTE = (Layer) ? nvmtelayers[Layer-1] : nvmtedisks[Disk-1]; // TE memories
-	constexpr int nvmOL = ((Layer == 1) || (Layer == 2)) ? nvmollayers[Layer-1] : 0; // TE Overlap memories
-
-	constexpr int nmaxbinsperpage = (Layer) ? nmaxbinsperpagelayer : nmaxbinsperpagedisk; // Number of bins per page in memories
+	////////////////////////////////////////
+	// AllStub memories
 
-	// Number of data in each input memory
-	typename InputStubMemory<InType>::NEntryT nInputs[maskISsize]; // Array containing the number of inputs. Last two indices are for DISK2S
-	#pragma HLS array_partition variable=nInputs complete dim=0
+	for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
+		if (!valid[s]) continue;
 
-	const typename InputStubMemory<InType>::NEntryT zero(0);
+		AllStub<OutType> allstub =
+				(disk2S[s]) ? stubDisk2S[s].raw() : stub[s].raw();
 
-	for (int i = 0; i < maskISsize; i++) {
+		// Write stub to all memory copies
+		for (int n = 0; n < MaxAllCopies; n++) {
 #pragma HLS UNROLL
-		if (i < maxinput) {
-			nInputs[i] = maskIS[i] != 0 ? inputStubs[i].getEntries(bx) : zero;
-		} else { // For DISK2S
-			nInputs[i] = maskIS[i] != 0 ? inputStubsDisk2S[i-maxinput].getEntries(bx) : zero;
+			memoriesAS[n].write_mem(bx, allstub, index + s);
 		}
-	}
-
-	//Create variables that keep track of which memory address to read and write to
-	ap_uint<kNBits_MemAddr> read_addr(0); // Reading of input stubs
-	ap_uint<kNBits_MemAddr-NBitsBin+1> addrCountME[nvmME][nmaxbinsperpage]; // Writing of ME stubs
-	ap_uint<kNBits_MemAddr> addrCountTEI[nvmTE][MaxTEICopies]; // Writing of TE Inner stubs
-	ap_uint<kNBits_MemAddr> addrCountOL[nvmOL][MaxOLCopies]; // Writing of TE Overlap stubs
-	ap_uint<kNBits_MemAddr-NBitsBinTEO+1> addrCountTEO[nvmTE][MaxTEOCopies][nmaxbinsperpage]; // Writing of TE Outer stubs
 
-	if (maskME) {
-		clear2DArray(nvmME, addrCountME);
-	}
-	if (maskTEI) {
-		clear2DArray(nvmTE, addrCountTEI);
-	}
-	if (maskOL) {
-		clear2DArray(nvmOL, addrCountOL);
-	}
-	if (maskTEO) {
-		clear3DArray(nvmTE, addrCountTEO);
+// For debugging
+#if defined(VMR_DEBUG) && !defined(__SYNTHESIS__)
+		std::cout << std::endl << "Stub index no. " << index + s << std::endl << "Out put stub: " << std::hex << allstub.raw() << std::dec
+				<< std::endl;
+#endif // VMR_DEBUG
 	}
 
 
-	/////////////////////////////////////
-	// Main Loop
-	constexpr int maxLoop = kMaxProc;
-
-	TOPLEVEL: for (int i = 0; i < maxLoop; ++i) {
-#pragma HLS PIPELINE II=1 rewind
-
-		bool resetNext = false; // Used to reset read_addr
-		bool disk2S = false; // Used to determine if DISK2S
-		bool negDisk = false; // Used to determine if it's negative disk, the last 3 inputs memories
-		bool noStubsLeft = false; // Used to determine if we have processed all stubs
-
-		InputStub<InType> stub;
-		InputStub<DISK2S> stubDisk2S; // Used for disks. TODO: Find a better way to do this...?
-
-		// Read stub from memory in turn.
-		// Reading is ordered as in wiring script to pass testbench
-		if (maskIS[4] && nInputs[4]) { // For DISK2S
-			assert(Disk);
-			stubDisk2S = inputStubsDisk2S[0].read_mem(bx, read_addr);
-			disk2S = true;
-			--nInputs[4];
-			if (nInputs[4] == 0)
-				resetNext = true;
-		} else if (maskIS[0] && nInputs[0]) {
-			stub = inputStubs[0].read_mem(bx, read_addr);
-			--nInputs[0];
-			if (nInputs[0] == 0)
-				resetNext = true;
-		} else if (maskIS[1] && nInputs[1]) {
-			stub = inputStubs[1].read_mem(bx, read_addr);
-			--nInputs[1];
-			if (nInputs[1] == 0)
-				resetNext = true;
-		} else if (maskIS[5] && nInputs[5]) { // For DISK2S
-			assert(Disk);
-			stubDisk2S = inputStubsDisk2S[1].read_mem(bx, read_addr);
-			disk2S = true;
-			negDisk = (Disk) ? true : false;
-			--nInputs[5];
-			if (nInputs[5] == 0)
-				resetNext = true;
-		} else if (maskIS[2] && nInputs[2]) {
-			stub = inputStubs[2].read_mem(bx, read_addr);
-			negDisk = (Disk) ? true : false;
-			--nInputs[2];
-			if (nInputs[2] == 0)
-				resetNext = true;
-		} else if (maskIS[3] && nInputs[3]) {
-			stub = inputStubs[3].read_mem(bx, read_addr);
-			negDisk = (Disk) ? true : false;
-			--nInputs[3];
-			if (nInputs[3] == 0)
-				resetNext = true;
-		} else {
-			noStubsLeft = true;
-		}
-
-
-		// Increment the read address, or reset it to zero when all stubs in a memory has been read
-		if (resetNext)
-			read_addr = 0;
-		else
-			++read_addr;
-
-		if (noStubsLeft) continue; // End here if we already have processed all stubs
-
-
-		////////////////////////////////////////
-		// AllStub memories
-
-			AllStub<OutType> allstub =
-					(disk2S) ? stubDisk2S.raw() : stub.raw();
+	/////////////////////////////////////////////
+	// ME memories
 
-			// Write stub to all memory copies
-			for (int n = 0; n < MaxAllCopies; n++) {
-	#pragma HLS UNROLL
-				memoriesAS[n].write_mem(bx, allstub, i);
-			}
+	if (maskME != 0) {
 
-// For debugging
-#ifndef __SYNTHESIS__
-			std::cout << std::endl << "Stub index no. " << i << std::endl << "Out put stub: " << std::hex << allstub.raw() << std::dec
-					<< std::endl;
-#endif // DEBUG
+		// Virtual modules to write to
+		int ivmPlus[NStubs];
+		int ivmMinus[NStubs];
 
+		int bin[NStubs]; // Coarse z. The bin the stub is going to be put in, in the memory
 
-		/////////////////////////////////////////////
-		// ME memories
-
-		if (maskME != 0) {
-
-			// Virtual modules to write to
-			int ivmPlus;
-			int ivmMinus;
-
-			int bin; // Coarse z. The bin the stub is going to be put in, in the memory
+		VMStubME<OutType> stubME[NStubs];
 
+		for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
 			// Create the ME stub to save
-			VMStubME<OutType> stubME = (disk2S) ?
-					createStubME<DISK2S, OutType, Layer, Disk>(stubDisk2S, i, negDisk, fineBinTable, phiCorrTable, ivmPlus, ivmMinus, bin) :
-					createStubME<InType, OutType, Layer, Disk>(stub, i, negDisk, fineBinTable, phiCorrTable, ivmPlus, ivmMinus, bin);;
+			stubME[s] = (disk2S[s]) ?
+					createStubME<DISK2S, OutType, Layer, Disk>(stubDisk2S[s], index + s, negDisk[s], fineBinTable, stubDisk2S[s].getPhi(), ivmPlus[s], ivmMinus[s], bin[s]) :
+					createStubME<InType, OutType, Layer, Disk>(stub[s], index + s, negDisk[s], fineBinTable, phiCorr[s], ivmPlus[s], ivmMinus[s], bin[s]);
 
 // For debugging
-#ifndef __SYNTHESIS__
-			std::cout << "ME stub " << std::hex << stubME.raw() << std::endl;
-			std::cout << "ivm Minus,Plus = " << std::dec << ivmMinus << " " << ivmPlus << " " << "\t0x"
+#if defined(VMR_DEBUG) && !defined(__SYNTHESIS__)
+			if (!valid[s]) continue;
+			std::cout << "ME stub " << std::hex << stubME[s].raw() << std::endl;
+			std::cout << "ivm Minus,Plus = " << std::dec << ivmMinus[s] << " " << ivmPlus[s] << " " << "\t0x"
 					<< std::setfill('0') << std::setw(4) << std::hex
-					<< stubME.raw().to_int() << std::dec << ", to bin " << bin << std::endl;
-			if (!maskME[ivmPlus]) {
-				std::cerr << "Trying to write to non-existent memory for ivm = " << ivmPlus << std::endl;
-					}
-			if (!maskME[ivmMinus]) {
-				std::cerr << "Trying to write to non-existent memory for ivm = " << ivmMinus << std::endl;
+					<< stubME[s].raw().to_int() << std::dec << ", to bin " << bin[s] << std::endl;
+			if (!maskME[ivmPlus[s]]) {
+				std::cerr << "Trying to write to non-existent memory for ivm = " << ivmPlus[s] << std::endl;
+			}
+			if (!maskME[ivmMinus[s]]) {
+				std::cerr << "Trying to write to non-existent memory for ivm = " << ivmMinus[s] << std::endl;
 			}
-#endif // DEBUG
+#endif // VMR_DEBUG
+		}
 
-			// Write the ME stub to the correct memory.
-			// If stub is close to a border (ivmPlus != ivmMinus)
-			// write it to the adjacent memory as well
-			// #pragma HLS dependence variable=memoriesME intra false
-			for (int n = 0; n < maxvmbins; n++) {
+		// Write the ME stubs to the correct memory.
+		// If a stub is close to a border (ivmPlus != ivmMinus)
+		// write it to the adjacent memory as well
+		for (int n = 0; n < maxvmbins; n++) {
 #pragma HLS UNROLL
-				if (maskME[n]) {
-					if ((ivmMinus == n) || (ivmPlus == n)) {
+			if (maskME[n]) {
+				int memIndex = n-firstME;
+
+				bool write[NStubs];
+				ap_uint<kNBits_MemAddr-NBitsBin+1> addr[NStubs];
+				for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
+					write[s] = valid[s] && ((ivmMinus[s] == n) || (ivmPlus[s] == n));
+					addr[s] = addrCountME[memIndex][bin[s]];
+					for (int t = 0; t < s; t++) {
+#pragma HLS UNROLL
+						if (write[t] && (bin[t] == bin[s])) addr[s] += 1;
+					}
+				}
+
+				for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
+					if (write[s]) {
 #pragma HLS dependence variable=addrCountME intra WAR true
-						int memIndex = n-firstME;
-						memoriesME[memIndex].write_mem(bx, bin, stubME, addrCountME[memIndex][bin]);
-						addrCountME[memIndex][bin] += 1;
+						memoriesME[memIndex].write_mem(bx, bin[s], stubME[s], addr[s]);
+						addrCountME[memIndex][bin[s]] = addr[s] + 1;
 					}
 				}
 			}
-		} // End ME memories
+		}
+	} // End ME memories
 
 
-		//////////////////////////////////
-		// TE Inner Memories
+	//////////////////////////////////
+	// TE Inner Memories
 
-		// No stubs for DISK2S
-		if ((maskTEI != 0) && (!disk2S)) {
+	if (maskTEI != 0) {
+
+		int ivm[NStubs]; // Which VM to write to
 
-			int ivm;// Which VM to write to
+		// The z/r information bits saved for TE Inner memories.
+		// Which VMs to look at in the outer layer.
+		// Note: not the z/r coordinate for the inner stub
+		// Called binlookup in emulation
+		int rzbits[NStubs];
 
-			// The z/r information bits saved for TE Inner memories.
-			// Which VMs to look at in the outer layer.
-			// Note: not the z/r coordinate for the inner stub
-			// Called binlookup in emulation
-			int rzbits;
+		VMStubTEInner<OutType> stubTEI[NStubs];
 
+		// Only if it has a valid rzbits/binlookup value, i.e. not -1,
+		// and no stubs for DISK2S
+		bool write[NStubs];
+		int memIndex[NStubs]; // Index for the correct memory in memory array
+
+		for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
 			// Create the TE Inner stub to save
-			VMStubTEInner<OutType> stubTEI = createStubTEInner<InType, OutType, Layer, Disk>(stub, i, negDisk, rzbitsInnerTable, phiCorrTable, ivm, rzbits);
+			stubTEI[s] = createStubTEInner<InType, OutType, Layer, Disk>(stub[s], index + s, negDisk[s], rzbitsInnerTable, phiCorr[s], ivm[s], rzbits[s]);
+
+			write[s] = valid[s] && !disk2S[s] && (rzbits[s] != -1) && maskTEI[ivm[s]];
+			memIndex[s] = (write[s]) ? ivm[s]-firstTEI : 0;
 
 // For debugging
-#ifndef __SYNTHESIS__
-			std::cout << "TEInner stub " << std::hex << stubTEI.raw()
+#if defined(VMR_DEBUG) && !defined(__SYNTHESIS__)
+			if (!valid[s] || disk2S[s]) continue;
+			std::cout << "TEInner stub " << std::hex << stubTEI[s].raw()
 					<< std::endl;
-			std::cout << "ivm: " << std::dec << ivm <<std::endl
+			std::cout << "ivm: " << std::dec << ivm[s] <<std::endl
 					<< std::endl;
-#endif // DEBUG
+#endif // VMR_DEBUG
+		}
 
-			// Write the TE Inner stub to the correct memory
-			// Only if it has a valid rzbits/binlookup value, i.e. not -1,
-			// and a valid bend
-			if ((rzbits != -1) && maskTEI[ivm]) {
-				int memIndex = ivm-firstTEI; // Index for the correct memory in memory array
-				int bendIndex = memIndex*MaxTEICopies; // Index for bendcut LUTs
+		// Write the TE Inner stubs to the correct memory, if they pass
+		// the bend cut of the memory "copy"
+		for (int n = 0; n < MaxTEICopies; n++) {
+#pragma HLS UNROLL
+			bool passBend[NStubs];
+			ap_uint<kNBits_MemAddr> addr[NStubs];
+			for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
+				passBend[s] = write[s] && bendCutInnerTable[memIndex[s]*MaxTEICopies + n][stubTEI[s].getBend()];
+				addr[s] = addrCountTEI[memIndex[s]][n];
+				for (int t = 0; t < s; t++) {
+#pragma HLS UNROLL
+					if (passBend[t] && (memIndex[t] == memIndex[s])) addr[s] += 1;
+				}
+			}
 
-				for (int n = 0; n < MaxTEICopies; n++) {
+			for (int s = 0; s < NStubs; s++) {
 #pragma HLS UNROLL
-					bool passBend = bendCutInnerTable[bendIndex][stubTEI.getBend()];
-					if (passBend) {
+				if (passBend[s]) {
 #pragma HLS dependence variable=addrCountTEI intra WAR true
-						memoriesTEI[memIndex][n].write_mem(bx, stubTEI, addrCountTEI[memIndex][n]);
-						addrCountTEI[memIndex][n] += 1; // Count the memory addresses we have written to
-					}
-					bendIndex++; // Use next bendcut table for the next memory "copy"
+					memoriesTEI[memIndex[s]][n].write_mem(bx, stubTEI[s], addr[s]);
+					addrCountTEI[memIndex[s]][n] = addr[s] + 1; // Count the memory addresses we have written to
 				}
 			}
-		} // End TE Inner memories
+		}
+	} // End TE Inner memories
 
 
-		////////////////////////////////////
-		// TE Outer memories
+	////////////////////////////////////
+	// TE Outer memories
 
-		if ((maskTEO != 0) && (!disk2S)) {
+	if (maskTEO != 0) {
 
-			int ivm; // The VM number
-			int bin; // Coarse z. The bin the stub is going to be put in, in the memory
+		int ivm[NStubs]; // The VM number
+		int bin[NStubs]; // Coarse z. The bin the stub is going to be put in, in the memory
 
+		VMStubTEOuter<OutType> stubTEO[NStubs];
+
+		// No stubs for DISK2S
+		bool write[NStubs];
+		int memIndex[NStubs]; // Index for the correct memory in memory array and address
+
+		for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
 			// Create the TE Outer stub to save
-			VMStubTEOuter<OutType> stubTEO = createStubTEOuter<InType, OutType, Layer, Disk>(stub, i, negDisk, rzbitsOuterTable, phiCorrTable, ivm, bin);
+			stubTEO[s] = createStubTEOuter<InType, OutType, Layer, Disk>(stub[s], index + s, negDisk[s], rzbitsOuterTable, phiCorr[s], ivm[s], bin[s]);
+
+			write[s] = valid[s] && !disk2S[s] && maskTEO[ivm[s]];
+			memIndex[s] = (write[s]) ? ivm[s]-firstTEO : 0;
 
 // For debugging
-#ifndef __SYNTHESIS__
-			std::cout << "TEOuter stub " << std::hex << stubTEO.raw()
+#if defined(VMR_DEBUG) && !defined(__SYNTHESIS__)
+			if (!valid[s] || disk2S[s]) continue;
+			std::cout << "TEOuter stub " << std::hex << stubTEO[s].raw()
 					<< std::endl;
-			std::cout << "    ivm: " << std::dec << ivm << "       to bin " << bin << std::endl;
-#endif // DEBUG
-
-			// Write the TE Outer stub to the correct memory
-			// Only if it has a valid bend
-			if (maskTEO[ivm]) {
-				int memIndex = ivm-firstTEO; // Index for the correct memory in memory array and address
-				int bendIndex = memIndex*MaxTEOCopies; // Index for bendcut LUTs
-				for (int n = 0; n < MaxTEOCopies; n++) {
+			std::cout << "    ivm: " << std::dec << ivm[s] << "       to bin " << bin[s] << std::endl;
+#endif // VMR_DEBUG
+		}
+
+		// Write the TE Outer stubs to the correct memory, if they pass
+		// the bend cut of the memory "copy"
+		for (int n = 0; n < MaxTEOCopies; n++) {
 #pragma HLS UNROLL
-					bool passBend = bendCutOuterTable[bendIndex][stubTEO.getBend()]; // Check if stub passes bend cut
-					if (passBend) {
+			bool passBend[NStubs];
+			ap_uint<kNBits_MemAddr-NBitsBinTEO+1> addr[NStubs];
+			for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
+				passBend[s] = write[s] && bendCutOuterTable[memIndex[s]*MaxTEOCopies + n][stubTEO[s].getBend()];
+				addr[s] = addrCountTEO[memIndex[s]][n][bin[s]];
+				for (int t = 0; t < s; t++) {
+#pragma HLS UNROLL
+					if (passBend[t] && (memIndex[t] == memIndex[s]) && (bin[t] == bin[s])) addr[s] += 1;
+				}
+			}
+
+			for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
+				if (passBend[s]) {
 #pragma HLS dependence variable=addrCountTEO intra WAR true
-						memoriesTEO[memIndex][n].write_mem(bx, bin, stubTEO, addrCountTEO[memIndex][n][bin]);
-						addrCountTEO[memIndex][n][bin] += 1;
-					}
-					bendIndex++; // Use next bendcut table for the next memory "copy"
+					memoriesTEO[memIndex[s]][n].write_mem(bx, bin[s], stubTEO[s], addr[s]);
+					addrCountTEO[memIndex[s]][n][bin[s]] = addr[s] + 1;
 				}
 			}
-		} // End TE Outer memories
+		}
+	} // End TE Outer memories
 
 
-		/////////////////////////////////////
-		// OVERLAP Memories
+	/////////////////////////////////////
+	// OVERLAP Memories
+
+	if (maskOL != 0) {
 
-		if (maskOL != 0) {
+		assert(Layer == 1 || Layer == 2); // Make sure that only run layer 1 and 2
 
-			assert(Layer == 1 || Layer == 2); // Make sure that only run layer 1 and 2
+		int ivm[NStubs]; // Which VM to write to
 
-			int ivm; // Which VM to write to
+		// The z/r information bits saved for TE Inner memories.
+		// Which VMs to look at in the outer layer.
+		// Note: not the z/r coordinate for the inner stub
+		// Called binlookup in emulation
+		int rzbits[NStubs];
 
-			// The z/r information bits saved for TE Inner memories.
-			// Which VMs to look at in the outer layer.
-			// Note: not the z/r coordinate for the inner stub
-			// Called binlookup in emulation
-			int rzbits;
+		VMStubTEInner<BARRELOL> stubOL[NStubs];
 
+		bool write[NStubs];
+		int memIndex[NStubs]; // The memory index in array and addrcount
+
+		for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
 			// Create the TE Inner Overlap stub to save
-			VMStubTEInner<BARRELOL> stubOL = createStubTEOverlap<InType, Layer>(stub, i, rzbitsOverlapTable, phiCorrTable, ivm, rzbits);
+			stubOL[s] = createStubTEOverlap<InType, Layer>(stub[s], index + s, rzbitsOverlapTable, phiCorr[s], ivm[s], rzbits[s]);
+
+			write[s] = valid[s] && maskOL[ivm[s]] && (rzbits[s] != -1);
+			memIndex[s] = (write[s]) ? ivm[s] - firstOL : 0;
 
 // For debugging
-#ifndef __SYNTHESIS__
+#if defined(VMR_DEBUG) && !defined(__SYNTHESIS__)
+			if (!valid[s]) continue;
 			std::cout << "Overlap stub " << " " << std::hex
-					<< stubOL.raw() << std::endl;
-			std::cout << "ivm: " << std::dec << ivm << std::endl
+					<< stubOL[s].raw() << std::endl;
+			std::cout << "ivm: " << std::dec << ivm[s] << std::endl
 					<< std::endl;
-#endif // DEBUG
+#endif // VMR_DEBUG
+		}
+
+		// Save stubs to Overlap memories
+		for (int n = 0; n < MaxOLCopies; n++) {
+#pragma HLS UNROLL
+			bool passBend[NStubs];
+			ap_uint<kNBits_MemAddr> addr[NStubs];
+			for (int s = 0; s < NStubs; s++) {
+#pragma HLS UNROLL
+				passBend[s] = write[s] && bendCutOverlapTable[memIndex[s]*MaxOLCopies + n][stubOL[s].getBend()];
+				addr[s] = addrCountOL[memIndex[s]][n];
+				for (int t = 0; t < s; t++) {
+#pragma HLS UNROLL
+					if (passBend[t] && (memIndex[t] == memIndex[s])) addr[s] += 1;
+				}
+			}
 
-			// Save stub to Overlap memories
-			if (maskOL[ivm] && (rzbits != -1)) {
-				int memIndex = ivm - firstOL; // The memory index in array and addrcount
-				int bendIndex = memIndex*MaxOLCopies; // Index for bendcut LUTs
-				for (int n = 0; n < MaxOLCopies; n++) {
+			for (int s = 0; s < NStubs; s++) {
 #pragma HLS UNROLL
-					bool passBend = bendCutOverlapTable[bendIndex][stubOL.getBend()];
-					if (passBend) {
+				if (passBend[s]) {
 #pragma HLS dependence variable=addrCountOL intra WAR true
-						memoriesOL[memIndex][n].write_mem(bx, stubOL, addrCountOL[memIndex][n]);
-						addrCountOL[memIndex][n] += 1;
-					}
-					bendIndex++;
+					memoriesOL[memIndex[s]][n].write_mem(bx, stubOL[s], addr[s]);
+					addrCountOL[memIndex[s]][n] = addr[s] + 1;
 				}
 			}
+		}
 
 // For debugging
-#ifndef __SYNTHESIS__
-			else {
+#if defined(VMR_DEBUG) && !defined(__SYNTHESIS__)
+		for (int s = 0; s < NStubs; s++) {
+			if (valid[s] && !write[s]) {
 				std::cout << "NO OVERLAP" << std::endl << std::endl;
 			}
-#endif // DEBUG
+		}
+#endif // VMR_DEBUG
+
+	} // End TE Overlap memories
+} // End routeVMStubs
+
+
+/////////////////////////////////
+// Main function
+
+// InType DISK2S - Two input region types InType and DISK2S due to the disks having both 2S and PS inputs.
+// 		According to wiring script, there's two DISK2S and half the inputs are for negative disks.
+// Layer Disk - Specifies the layer or disk number
+// MAXCopies - The maximum number of copies of a memory type
+// NBitsBin number of bits used for the bins in MEMemories
+// NStubsPerClock - number of stubs read and routed per clock, 2 for the
+// 		high-occupancy regions, with input memories of two read ports and
+// 		output memories of two write ports
+template<regionType InType, regionType OutType, int Layer, int Disk, int MaxAllCopies, int MaxTEICopies, int MaxOLCopies, int MaxTEOCopies, int NBitsBin, int BendCutTableSize, int NStubsPerClock = 1>
+void VMRouter(const BXType bx, BXType& bx_o, const int fineBinTable[], const int phiCorrTable[],
+		// rzbitstables, aka binlookup in emulation
+		const int rzbitsInnerTable[], const int rzbitsOverlapTable[], const int rzbitsOuterTable[],
+		// bendcut tables
+		const ap_uint<BendCutTableSize> bendCutInnerTable[], const ap_uint<BendCutTableSize> bendCutOverlapTable[], const ap_uint<BendCutTableSize> bendCutOuterTable[],
+		// Input memories
+		const ap_uint<maskISsize>& maskIS,
+		const InputStubMemory<InType> inputStubs[],
+		const InputStubMemory<DISK2S> inputStubsDisk2S[],
+		// AllStub memory
+		AllStubMemory<OutType> memoriesAS[],
+		// ME memories
+		const ap_uint<maskMEsize>& maskME, VMStubMEMemory<OutType, NBitsBin> memoriesME[],
+		// Inner TE memories, non-overlap
+		const ap_uint<maskTEIsize>& maskTEI, VMStubTEInnerMemory<OutType> memoriesTEI[][MaxTEICopies],
+		// TE Inner memories, overlap
+		const ap_uint<maskOLsize>& maskOL, VMStubTEInnerMemory<BARRELOL> memoriesOL[][MaxOLCopies],
+		// TE Outer memories
+		const ap_uint<maskTEOsize>& maskTEO, VMStubTEOuterMemory<OutType> memoriesTEO[][MaxTEOCopies]) {
+
+#pragma HLS inline
+#pragma HLS array_partition variable=bendCutInnerTable complete dim=1
+#pragma HLS array_partition variable=bendCutOverlapTable complete dim=1
+#pragma HLS array_partition variable=bendCutOuterTable complete dim=1
+#pragma HLS array_partition variable=inputStubs complete dim=1
+#pragma HLS array_partition variable=inputStubsDisk2S complete dim=1
+#pragma HLS array_partition variable=memoriesAS complete dim=1
+#pragma HLS array_partition variable=memoriesME complete dim=1
+#pragma HLS array_partition variable=memoriesTEI complete dim=2
+#pragma HLS array_partition variable=memoriesOL complete dim=2
+#pragma HLS array_partition variable=memoriesTEO complete dim=2
+
+
+	// Number of memories/VMs for one coarse phi region
+	constexpr int nvmME = (Layer) ? nvmmelayers[Layer-1] : nvmmedisks[Disk-1]; // ME memories
+	constexpr int nvmTE = (Layer) ? nvmtelayers[Layer-1] : nvmtedisks[Disk-1]; // TE memories
+	constexpr int nvmOL = ((Layer == 1) || (Layer == 2)) ? nvmollayers[Layer-1] : 0; // TE Overlap memories
+
+	constexpr int nmaxbinsperpage = maxBinsPerPage(Layer); // Number of bins per page in memories
+
+	// Number of data in each input memory, in the order they are read
+	typename InputStubMemory<InType>::NEntryT nInputs[maskISsize];
+	#pragma HLS array_partition variable=nInputs complete dim=0
+
+	const typename InputStubMemory<InType>::NEntryT zero(0);
+
+	ModuleMonitor monitor(module::VMR, bx);
+
+	for (int k = 0; k < maskISsize; k++) {
+#pragma HLS UNROLL
+		const int i = inputOrder[k];
+		if (i < maxinput) {
+			nInputs[k] = maskIS[i] != 0 ? inputStubs[i].getEntries(bx) : zero;
+		} else { // For DISK2S
+			nInputs[k] = maskIS[i] != 0 ? inputStubsDisk2S[i-maxinput].getEntries(bx) : zero;
+		}
+		monitor.inputs(nInputs[k]);
+	}
+
+	// The input stubs are read one per clock, memory after memory
+	MultiMemoryReader<maskISsize> reader;
+	reader.init(nInputs);
+
+	//Create variables that keep track of which memory address to write to
+	ap_uint<kNBits_MemAddr-NBitsBin+1> addrCountME[nvmME][nmaxbinsperpage]; // Writing of ME stubs
+	ap_uint<kNBits_MemAddr> addrCountTEI[nvmTE][MaxTEICopies]; // Writing of TE Inner stubs
+	ap_uint<kNBits_MemAddr> addrCountOL[nvmOL][MaxOLCopies]; // Writing of TE Overlap stubs
+	ap_uint<kNBits_MemAddr-NBitsBinTEO+1> addrCountTEO[nvmTE][MaxTEOCopies][nmaxbinsperpage]; // Writing of TE Outer stubs
+
+	if (maskME) {
+		clear2DArray(nvmME, addrCountME);
+	}
+	if (maskTEI) {
+		clear2DArray(nvmTE, addrCountTEI);
+	}
+	if (maskOL) {
+		clear2DArray(nvmOL, addrCountOL);
+	}
+	if (maskTEO) {
+		clear3DArray(nvmTE, addrCountTEO);
+	}
+
+
+	/////////////////////////////////////
+	// Main Loop
+	// At most kMaxProc clocks of NStubsPerClock stubs, and no more stubs than
+	// the depth of the memories, as the stub index has kNBits_MemAddr bits
+	constexpr int maxStubs = (NStubsPerClock * kMaxProc < (1 << kNBits_MemAddr)) ?
+			NStubsPerClock * kMaxProc : (1 << kNBits_MemAddr);
+	constexpr int maxLoop = (maxStubs + NStubsPerClock - 1) / NStubsPerClock;
+
+	TOPLEVEL: for (int i = 0; i < maxLoop; ++i) {
+#pragma HLS PIPELINE II=1 rewind
+
+		bool valid[NStubsPerClock]; // Set if a stub was read
+		InputStub<InType> stub[NStubsPerClock];
+		InputStub<DISK2S> stubDisk2S[NStubsPerClock]; // Used for disks. TODO: Find a better way to do this...?
+		bool disk2S[NStubsPerClock]; // Used to determine if DISK2S
+		bool negDisk[NStubsPerClock]; // Used to determine if it's negative disk
+		typename AllStub<InType>::ASPHI phiCorr[NStubsPerClock]; // The phi correction of the stub, shared by all its VM stubs
+#pragma HLS array_partition variable=valid complete
+#pragma HLS array_partition variable=stub complete
+#pragma HLS array_partition variable=stubDisk2S complete
+#pragma HLS array_partition variable=disk2S complete
+#pragma HLS array_partition variable=negDisk complete
+#pragma HLS array_partition variable=phiCorr complete
+
+		// Read the next NStubsPerClock stubs from memory in turn,
+		// from the same memory or from consecutive ones
+		int nRead = 0;
+		for (int s = 0; s < NStubsPerClock; s++) {
+#pragma HLS UNROLL
+			typename MultiMemoryReader<maskISsize>::MemIndex k;
+			ap_uint<kNBits_MemAddr> read_addr;
+			const int j = i * NStubsPerClock + s; // Index of the stub over all inputs
+			valid[s] = (j < maxStubs) && reader.get(j, k, read_addr);
+			const int imem = inputOrder[k];
+			disk2S[s] = (imem >= maxinput);
+			negDisk[s] = (Disk) ? (k >= firstNegDiskInput) : false;
+
+			if (valid[s]) {
+				if (disk2S[s]) {
+					assert(Disk);
+					stubDisk2S[s] = inputStubsDisk2S[imem-maxinput].read_mem(bx, read_addr);
+				} else {
+					stub[s] = inputStubs[imem].read_mem(bx, read_addr);
+				}
+				nRead++;
+			}
+
+			phiCorr[s] = getPhiCorr<InType>(stub[s].getPhi(), stub[s].getR(), stub[s].getBend(), phiCorrTable);
+		}
+		const bool noStubsLeft = !valid[0]; // Used to determine if we have processed all stubs
+
+		monitor.step(!noStubsLeft);
+		monitor.read(nRead);
+
+		if (noStubsLeft) continue; // End here if we already have processed all stubs
 
-		} // End TE Overlap memories
+		routeVMStubs<InType, OutType, Layer, Disk, MaxAllCopies, MaxTEICopies, MaxOLCopies, MaxTEOCopies, NBitsBin, BendCutTableSize, NStubsPerClock>
+		(bx, i * NStubsPerClock, valid, stub, stubDisk2S, disk2S, negDisk, phiCorr, fineBinTable,
+			rzbitsInnerTable, rzbitsOverlapTable, rzbitsOuterTable,
+			bendCutInnerTable, bendCutOverlapTable, bendCutOuterTable,
+			memoriesAS,
+			maskME, memoriesME, addrCountME,
+			maskTEI, memoriesTEI, addrCountTEI,
+			maskOL, memoriesOL, addrCountOL,
+			maskTEO, memoriesTEO, addrCountTEO);
 	} // Outside main loop
 
 	bx_o = bx;
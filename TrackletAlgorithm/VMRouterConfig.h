@@ -0,0 +1,105 @@
+#ifndef TrackletAlgorithm_VMRouterConfig_h
+#define TrackletAlgorithm_VMRouterConfig_h
+
+#include "VMRouter.h"
+
+// Configuration of the VMRouters, keyed by layer/disk and phi region.
+//
+// The numbers that depend on the wiring, i.e. the number of input memories and
+// the number of copies of each output memory, are listed in vmrouterRegions.
+// Everything else (number of VMs, region types, memory masks) follows from the
+// layer/disk and phi region, and is computed by VMRouterConfig. A VMRouter top
+// function then only needs to name its region and include its LUTs, e.g.
+//   typedef VMRouterConfig<1, 0, 'E'> VMRConfig;
+//   VMRouter<VMRConfig::inputType, ...>(...);
+// The top function of every region is written in emData/VMR/tops by
+// emData/vmrouter_tops.sh, from the same lines as vmrouterRegions.
+
+// Region-specific numbers, from the wiring file
+struct VMRouterRegion {
+	int layer; // barrel layer number, 0 if disk
+	int disk; // disk number, 0 if barrel
+	char phiRegion; // AllStub/PhiRegion
+
+	// Maximum number of memory "copies"
+	// Note: can't use 0 if we don't have any memories of a certain type. Use 1.
+	int maxASCopies; // Allstub memory
+	int maxTEICopies; // TE Inner memories
+	int maxOLCopies; // TE Inner Overlap memories
+	int maxTEOCopies; // TE Outer memories
+
+	// Number of inputs
+	int numInputs; // Total number of input memories
+	int numInputsDiskPS; // Only used for disks
+};
+
+// One line per VMRouter of wires_hourglass.dat, i.e.
+//  {L, D, phi, AS, TEI, OL, TEO, in, inPS}
+// The table is written by emData/vmrouter_regions.sh when emData/download.sh
+// is run, so that it follows the wiring of the downloaded test vectors.
+constexpr VMRouterRegion vmrouterRegions[] = {
+#include "../emData/VMR/tables/vmrouterRegions.tab"
+};
+
+constexpr int nvmrouterRegions = sizeof(vmrouterRegions) / sizeof(vmrouterRegions[0]);
+
+// Index of a region in vmrouterRegions, -1 if it is not there
+constexpr int vmrouterRegionIndex(int layer, int disk, char phiRegion, int i = 0) {
+	return (i == nvmrouterRegions) ? -1 :
+		(vmrouterRegions[i].layer == layer && vmrouterRegions[i].disk == disk && vmrouterRegions[i].phiRegion == phiRegion) ?
+				i : vmrouterRegionIndex(layer, disk, phiRegion, i + 1);
+}
+
+template<int Layer, int Disk, char PhiRegion>
+struct VMRouterConfig {
+
+	static_assert(Layer != Disk && (Layer == 0 || Disk == 0), "Need to have either Layer or Disk larger than 0.");
+	static_assert(vmrouterRegionIndex(Layer, Disk, PhiRegion) >= 0, "Region missing in vmrouterRegions.");
+
+	static constexpr int index = vmrouterRegionIndex(Layer, Disk, PhiRegion); // in vmrouterRegions
+
+	// Maximum number of memory "copies" for this Phi region
+	static constexpr int maxASCopies = vmrouterRegions[index].maxASCopies;
+	static constexpr int maxTEICopies = vmrouterRegions[index].maxTEICopies;
+	static constexpr int maxOLCopies = vmrouterRegions[index].maxOLCopies;
+	static constexpr int maxTEOCopies = vmrouterRegions[index].maxTEOCopies;
+
+	// Number of inputs
+	static constexpr int numInputs = vmrouterRegions[index].numInputs;
+	static constexpr int numInputsDiskPS = vmrouterRegions[index].numInputsDiskPS;
+	static constexpr int numInputsDisk2S = numInputs - numInputsDiskPS;
+
+	static constexpr int bendCutTableSize = 8; // Number of entries in each bendcut table. Can't use 0.
+
+	// Number of VMs
+	static constexpr int nvmME = (Layer) ? nvmmelayers[Layer-1] : nvmmedisks[Disk-1]; // ME memories
+	static constexpr int nvmTEI = (Layer) ?
+			((Layer != 2) ? nvmtelayers[Layer-1] : nvmteextralayers[Layer-1]) : nvmtedisks[Disk-1]; // TE Inner memories
+	static constexpr int nvmOL = (Layer == 1 || Layer == 2) ? nvmollayers[Layer-1] : 1; // TE Inner Overlap memories, can't use 0 when we don't have any OL memories
+	static constexpr int nvmTEO = (Layer) ?
+			((Layer != 3) ? nvmtelayers[Layer-1] : nvmteextralayers[Layer-1]) : nvmtedisks[Disk-1]; // TE Outer memories
+
+	// Number of bits used for the bins in VMStubeME memories
+	static constexpr int nbitsbin = (Layer) ? 3 : 4;
+
+	// What regionType the input/output is
+	static constexpr regionType inputType = (Layer) ? ((Layer > 3) ? BARREL2S : BARRELPS) : DISKPS;
+	static constexpr regionType outputType = (Layer) ? ((Layer > 3) ? BARREL2S : BARRELPS) : DISK;
+
+	// Masks of which memories that are being used. The first memory is represented by the LSB
+	// and a "1" implies that the specified memory is used for this phi region
+	// Create "nvm" 1s, e.g. "1111", shift the mask until it corresponds to the correct phi region
+	static constexpr unsigned long long maskIS = (1ull << numInputs) - 1; // Input memories
+	static constexpr unsigned long long maskME = ((1ull << nvmME) - 1) << (nvmME * (PhiRegion - 'A')); // ME memories
+	static constexpr unsigned long long maskTEI =
+		(Layer == 1 || Layer == 2 || Layer == 3 || Layer == 5 || Disk == 1 || Disk == 3) ?
+				((1ull << nvmTEI) - 1) << (nvmTEI * (PhiRegion - 'A')) : 0x0; // TE Inner memories, only used for odd layers/disk and layer 2
+	static constexpr unsigned long long maskOL =
+		(Layer == 1 || Layer == 2) ?
+				((1ull << nvmOL) - 1) << (nvmOL * (PhiRegion - 'A')) : 0x0; // TE Inner Overlap memories, only used for layer 1 and 2
+	static constexpr unsigned long long maskTEO =
+		(Layer == 2 || Layer == 3 || Layer == 4 || Layer == 6 || Disk == 1 || Disk == 2 || Disk == 4) ?
+				((1ull << nvmTEO) - 1) << (nvmTEO * (PhiRegion - 'A')) : 0x0; // TE Outer memories, only for even layers/disks, and layer and disk 1
+};
+
+#endif // TrackletAlgorithm_VMRouterConfig_h
@@ -3,15 +3,7 @@
 // VMRouter Top Function for layer 1, AllStub region E
 // Sort stubs into smaller regions in phi, i.e. Virtual Modules (VMs).
 
-// NOTE: to run a different phi region, change the following
-//          - constants specified in VMRouterTop.h
-//          - the input parameters to VMRouterTop in VMRouterTop.h/.cc
-//          - the the number and directories to the LUTs
-//          - add/remove pragmas depending on inputStub in VMRouterTop.cc
-//          - the call to VMRouter() in VMRouterTop.cc
-//          - the included top function in VMRouter_test.cpp (if file name is changed)
-//          - the top function and memory directory in script_VMR.tcl (if file name is changed)
-//          - add the phi region in emData/download.sh, make sure to also run clean
+// NOTE: the tops of the other regions are written by emData/vmrouter_tops.sh, see VMRouterTop.h
 
 
 void VMRouterTop(const BXType bx, BXType& bx_o,
@@ -28,137 +20,168 @@ void VMRouterTop(const BXType bx, BXType& bx_o,
 
 	///////////////////////////
 	// Open Lookup tables
-	// NOTE: needs to be changed manually if run for a different phi region
+#include "../emData/VMR/tops/VMRouterTopLUTs_L1PHIE.h"
 
-	// LUT with the corrected r/z. It is corrected for the average r (z) of the barrel (disk).
-	// Includes both coarse r/z position (bin), and finer region each r/z bin is divided into.
-	// Indexed using r and z position bits
-	static const int fineBinTable[] =
-#include "../emData/VMR/tables/VMR_L1PHIE_finebin.tab"
-
-
-	// LUT with phi corrections to project the stub to the average radius in a layer.
-	// Only used by layers.
-	// Indexed using phi and bend bits
-	static const int phiCorrTable[] =
-#include "../emData/VMR/tables/VMPhiCorrL1.tab"
-
-
-	// LUT with the Z/R bits for TE memories
-	// Contain information about where in z to look for valid stub pairs
-	// Indexed using z and r position bits
-
-	static const int rzBitsInnerTable[] =
-#include "../emData/VMR/tables/VMTableInnerL1L2.tab" // 11 bits used for LUT
-
-	static const int rzBitsOverlapTable[] = // 11 bits used for LUT
-#include "../emData/VMR/tables/VMTableInnerL1D1.tab"
-
-// 	static const int rzBitsOuterTable[] = // 11 bits used for LUT
-// #include "../emData/VMR/tables/VMTableOuterXX.tab"
-
-
-	// LUT with bend-cuts for the TE memories
-	// The cuts are different depending on the memory version (nX)
-	// Indexed using bend bits
-	// Note: use an array of zeros for "missing" memories in the first and last Phi Region
-
-	// TE Memory 1
-	ap_uint<1> tmpBendInnerTable1_n1[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE17n1_vmbendcut.tab"
-
-	ap_uint<1> tmpBendInnerTable1_n2[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE17n2_vmbendcut.tab"
-
-	ap_uint<1> tmpBendInnerTable1_n3[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE17n3_vmbendcut.tab"
-
-	ap_uint<1> tmpBendInnerTable1_n4[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE17n4_vmbendcut.tab"
-
-	ap_uint<1> tmpBendInnerTable1_n5[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE17n5_vmbendcut.tab"
+// Takes 2 clock cycles before on gets data, used at high frequencies
+#pragma HLS resource variable=inputStub[0].get_mem() latency=2
+#pragma HLS resource variable=inputStub[1].get_mem() latency=2
+#pragma HLS resource variable=inputStub[2].get_mem() latency=2
+#pragma HLS resource variable=inputStub[3].get_mem() latency=2
 
-	// TE Memory 2
-	ap_uint<1> tmpBendInnerTable2_n1[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE18n1_vmbendcut.tab"
+#pragma HLS interface register port=bx_o
 
-	ap_uint<1> tmpBendInnerTable2_n2[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE18n2_vmbendcut.tab"
+	//////////////////////////////////
+	// Create memory masks
 
-	ap_uint<1> tmpBendInnerTable2_n3[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE18n3_vmbendcut.tab"
+	// Masks of which memories that are being used. The first memory is represented by the LSB
+	// and a "1" implies that the specified memory is used for this phi region (VMRouterConfig.h)
+	static const ap_uint<maskISsize> maskIS = VMRConfig::maskIS; // Input memories
+	static const ap_uint<maskMEsize> maskME = VMRConfig::maskME; // ME memories
+	static const ap_uint<maskTEIsize> maskTEI = VMRConfig::maskTEI; // TE Inner memories, only used for odd layers/disk and layer 2
+	static const ap_uint<maskOLsize> maskOL = VMRConfig::maskOL; // TE Inner Overlap memories, only used for layer 1 and 2
+	static const ap_uint<maskTEOsize> maskTEO = VMRConfig::maskTEO; // TE Outer memories, only for even layers/disks, and layer and disk 1
 
-	ap_uint<1> tmpBendInnerTable2_n4[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE18n4_vmbendcut.tab"
 
-	ap_uint<1> tmpBendInnerTable2_n5[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE18n5_vmbendcut.tab"
+	/////////////////////////
+	// Main function
 
-	// TE Memory 3
-	ap_uint<1> tmpBendInnerTable3_n1[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE19n1_vmbendcut.tab"
+	VMRouter<inputType, outputType, kLAYER, kDISK,  maxASCopies, maxTEICopies, maxOLCopies, maxTEOCopies, nbitsbin, bendCutTableSize>
+	(bx, bx_o, fineBinTable, phiCorrTable,
+		rzBitsInnerTable, rzBitsOverlapTable, nullptr,
+		bendCutInnerTable, bendCutOverlapTable, nullptr,
+		// Input memories
+		maskIS, inputStub, nullptr,
+		// AllStub memories
+		memoriesAS,
+		// ME memories
+		maskME, memoriesME,
+		// TEInner memories
+		maskTEI, memoriesTEI,
+		// TEInner Overlap memories
+		maskOL, memoriesOL,
+		// TEOuter memories
+		maskTEO, nullptr
+		);
 
-	ap_uint<1> tmpBendInnerTable3_n2[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE19n2_vmbendcut.tab"
+	return;
+}
 
-	ap_uint<1> tmpBendInnerTable3_n3[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE19n3_vmbendcut.tab"
+// VMRouter of the same region, routing two stubs per clock
 
-	ap_uint<1> tmpBendInnerTable3_n4[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE19n4_vmbendcut.tab"
+void VMRouterDualTop(const BXType bx, BXType& bx_o,
+	// Input memories
+	const InputStubMemory<inputType> inputStub[numInputs],
 
-	ap_uint<1> tmpBendInnerTable3_n5[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE19n5_vmbendcut.tab"
+	// Output memories
+	AllStubMemory<outputType> memoriesAS[maxASCopies],
+	VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME],
+	VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies],
+	VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies])
+ {
 
-// TE Memory 4
-	ap_uint<1> tmpBendInnerTable4_n1[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE20n1_vmbendcut.tab"
 
-	ap_uint<1> tmpBendInnerTable4_n2[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE20n2_vmbendcut.tab"
+	///////////////////////////
+	// Open Lookup tables
+#include "../emData/VMR/tops/VMRouterTopLUTs_L1PHIE.h"
+
+// Two stubs are read per clock, from one input memory or two, and both
+// can be written to the same output memory: two read ports for the inputs,
+// two write ports for the outputs
+#pragma HLS resource variable=inputStub[0].get_mem() core=RAM_2P_BRAM latency=2
+#pragma HLS resource variable=inputStub[1].get_mem() core=RAM_2P_BRAM latency=2
+#pragma HLS resource variable=inputStub[2].get_mem() core=RAM_2P_BRAM latency=2
+#pragma HLS resource variable=inputStub[3].get_mem() core=RAM_2P_BRAM latency=2
+#pragma HLS resource variable=memoriesAS[0].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesAS[1].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesAS[2].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesAS[3].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesAS[4].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesAS[5].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesME[0].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesME[1].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesME[2].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesME[3].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[0][0].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[0][1].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[0][2].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[0][3].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[0][4].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[1][0].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[1][1].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[1][2].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[1][3].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[1][4].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[2][0].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[2][1].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[2][2].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[2][3].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[2][4].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[3][0].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[3][1].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[3][2].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[3][3].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesTEI[3][4].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesOL[0][0].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesOL[0][1].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesOL[0][2].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesOL[1][0].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesOL[1][1].get_mem() core=RAM_T2P_BRAM
+#pragma HLS resource variable=memoriesOL[1][2].get_mem() core=RAM_T2P_BRAM
 
-	ap_uint<1> tmpBendInnerTable4_n3[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE20n3_vmbendcut.tab"
+#pragma HLS interface register port=bx_o
 
-	ap_uint<1> tmpBendInnerTable4_n4[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE20n4_vmbendcut.tab"
+	//////////////////////////////////
+	// Create memory masks, see VMRouterTop
 
-	ap_uint<1> tmpBendInnerTable4_n5[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIE20n5_vmbendcut.tab"
+	static const ap_uint<maskISsize> maskIS = VMRConfig::maskIS; // Input memories
+	static const ap_uint<maskMEsize> maskME = VMRConfig::maskME; // ME memories
+	static const ap_uint<maskTEIsize> maskTEI = VMRConfig::maskTEI; // TE Inner memories
+	static const ap_uint<maskOLsize> maskOL = VMRConfig::maskOL; // TE Inner Overlap memories
+	static const ap_uint<maskTEOsize> maskTEO = VMRConfig::maskTEO; // TE Outer memories
 
-	// Combine all the temporary tables into one big table
-	static const ap_uint<bendCutTableSize> bendCutInnerTable[] = {
-		arrayToInt<bendCutTableSize>(tmpBendInnerTable1_n1), arrayToInt<bendCutTableSize>(tmpBendInnerTable1_n2), arrayToInt<bendCutTableSize>(tmpBendInnerTable1_n3), arrayToInt<bendCutTableSize>(tmpBendInnerTable1_n4), arrayToInt<bendCutTableSize>(tmpBendInnerTable1_n5),
-		arrayToInt<bendCutTableSize>(tmpBendInnerTable2_n1), arrayToInt<bendCutTableSize>(tmpBendInnerTable2_n2), arrayToInt<bendCutTableSize>(tmpBendInnerTable2_n3), arrayToInt<bendCutTableSize>(tmpBendInnerTable2_n4), arrayToInt<bendCutTableSize>(tmpBendInnerTable2_n5),
-		arrayToInt<bendCutTableSize>(tmpBendInnerTable3_n1), arrayToInt<bendCutTableSize>(tmpBendInnerTable3_n2), arrayToInt<bendCutTableSize>(tmpBendInnerTable3_n3), arrayToInt<bendCutTableSize>(tmpBendInnerTable3_n4), arrayToInt<bendCutTableSize>(tmpBendInnerTable3_n5),
-		arrayToInt<bendCutTableSize>(tmpBendInnerTable4_n1), arrayToInt<bendCutTableSize>(tmpBendInnerTable4_n2), arrayToInt<bendCutTableSize>(tmpBendInnerTable4_n3), arrayToInt<bendCutTableSize>(tmpBendInnerTable4_n4), arrayToInt<bendCutTableSize>(tmpBendInnerTable4_n5)};
 
+	/////////////////////////
+	// Main function
 
-	// TE Overlap Memory 1
-	ap_uint<1> tmpBendOverlapTable1_n1[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIQ9n1_vmbendcut.tab"
+	VMRouter<inputType, outputType, kLAYER, kDISK,  maxASCopies, maxTEICopies, maxOLCopies, maxTEOCopies, nbitsbin, bendCutTableSize, 2>
+	(bx, bx_o, fineBinTable, phiCorrTable,
+		rzBitsInnerTable, rzBitsOverlapTable, nullptr,
+		bendCutInnerTable, bendCutOverlapTable, nullptr,
+		// Input memories
+		maskIS, inputStub, nullptr,
+		// AllStub memories
+		memoriesAS,
+		// ME memories
+		maskME, memoriesME,
+		// TEInner memories
+		maskTEI, memoriesTEI,
+		// TEInner Overlap memories
+		maskOL, memoriesOL,
+		// TEOuter memories
+		maskTEO, nullptr
+		);
 
-	ap_uint<1> tmpBendOverlapTable1_n2[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIQ9n2_vmbendcut.tab"
+	return;
+}
 
-	ap_uint<1> tmpBendOverlapTable1_n3[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIQ9n3_vmbendcut.tab"
+// VMRouter of the same region, writing the copies of a virtual AllStub memory,
+// see VMRouterTop.h: not a replacement for VMRouterTop
 
-	// TE Overlap Memory 2
-	ap_uint<1> tmpBendOverlapTable2_n1[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIQ10n1_vmbendcut.tab"
+void VMRouterVirtualTop(const BXType bx, BXType& bx_o,
+	// Input memories
+	const InputStubMemory<inputType> inputStub[numInputs],
 
-	ap_uint<1> tmpBendOverlapTable2_n2[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIQ10n2_vmbendcut.tab"
+	// Output memories
+	VirtualAllStubMemory& allStub,
+	VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME],
+	VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies],
+	VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies])
+ {
 
-	ap_uint<1> tmpBendOverlapTable2_n3[bendCutTableSize] =
-#include "../emData/VMR/tables/VMSTE_L1PHIQ10n3_vmbendcut.tab"
 
-	// Combine all the temporary Overlap tables into one big table
-	static const ap_uint<bendCutTableSize> bendCutOverlapTable[] = {
-		arrayToInt<bendCutTableSize>(tmpBendOverlapTable1_n1), arrayToInt<bendCutTableSize>(tmpBendOverlapTable1_n2), arrayToInt<bendCutTableSize>(tmpBendOverlapTable1_n3),
-		arrayToInt<bendCutTableSize>(tmpBendOverlapTable2_n1), arrayToInt<bendCutTableSize>(tmpBendOverlapTable2_n2), arrayToInt<bendCutTableSize>(tmpBendOverlapTable2_n3)};
+	///////////////////////////
+	// Open Lookup tables
+#include "../emData/VMR/tops/VMRouterTopLUTs_L1PHIE.h"
 
 // Takes 2 clock cycles before on gets data, used at high frequencies
 #pragma HLS resource variable=inputStub[0].get_mem() latency=2
@@ -169,35 +192,26 @@ void VMRouterTop(const BXType bx, BXType& bx_o,
 #pragma HLS interface register port=bx_o
 
 	//////////////////////////////////
-	// Create memory masks
+	// Create memory masks, see VMRouterTop
 
-	// Masks of which memories that are being used. The first memory is represented by the LSB
-	// and a "1" implies that the specified memory is used for this phi region
-	// Create "nvm" 1s, e.g. "1111", shift the mask until it corresponds to the correct phi region
-	static const ap_uint<maskISsize> maskIS = ((1 << numInputs) - 1); // Input memories
-	static const ap_uint<maskMEsize> maskME = ((1 << nvmME) - 1) << (nvmME * (phiRegion - 'A')); // ME memories
-	static const ap_uint<maskTEIsize> maskTEI =
-		(kLAYER == 1 || kLAYER  == 2 || kLAYER == 3 || kLAYER == 5 || kDISK == 1 || kDISK == 3) ?
-				((1 << nvmTEI) - 1) << (nvmTEI * (phiRegion - 'A')) : 0x0; // TE Inner memories, only used for odd layers/disk and layer 2
-	static const ap_uint<maskOLsize> maskOL =
-		((kLAYER == 1) || (kLAYER == 2)) ?
-				((1 << nvmOL) - 1) << (nvmOL * (phiRegion - 'A')) : 0x0; // TE Inner Overlap memories, only used for layer 1 and 2
-	static const ap_uint<maskTEOsize> maskTEO =
-		(kLAYER == 2 || kLAYER == 3 || kLAYER == 4 || kLAYER == 6 || kDISK == 1 || kDISK == 2 || kDISK == 4) ?
-				((1 << nvmTEO) - 1) << (nvmTEO * (phiRegion - 'A')) : 0x0; // TE Outer memories, only for even layers/disks, and layer and disk 1
+	static const ap_uint<maskISsize> maskIS = VMRConfig::maskIS; // Input memories
+	static const ap_uint<maskMEsize> maskME = VMRConfig::maskME; // ME memories
+	static const ap_uint<maskTEIsize> maskTEI = VMRConfig::maskTEI; // TE Inner memories
+	static const ap_uint<maskOLsize> maskOL = VMRConfig::maskOL; // TE Inner Overlap memories
+	static const ap_uint<maskTEOsize> maskTEO = VMRConfig::maskTEO; // TE Outer memories
 
 
 	/////////////////////////
 	// Main function
 
-	VMRouter<inputType, outputType, kLAYER, kDISK,  maxASCopies, maxTEICopies, maxOLCopies, maxTEOCopies, nbitsbin, bendCutTableSize>
+	VMRouter<inputType, outputType, kLAYER, kDISK,  VirtualAllStubMemory::kNCopies, maxTEICopies, maxOLCopies, maxTEOCopies, nbitsbin, bendCutTableSize>
 	(bx, bx_o, fineBinTable, phiCorrTable,
 		rzBitsInnerTable, rzBitsOverlapTable, nullptr,
 		bendCutInnerTable, bendCutOverlapTable, nullptr,
 		// Input memories
 		maskIS, inputStub, nullptr,
-		// AllStub memories
-		memoriesAS,
+		// AllStub memories, the copies of the virtual memory
+		allStub.getCopies(),
 		// ME memories
 		maskME, memoriesME,
 		// TEInner memories
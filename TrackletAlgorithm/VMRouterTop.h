@@ -1,24 +1,21 @@
 #ifndef TrackletAlgorithm_VMRouterTop_h
 #define TrackletAlgorithm_VMRouterTop_h
 
-#include "VMRouter.h"
+#include "VMRouterConfig.h"
+#include "VirtualMemory.h"
 
 // VMRouter Top Function for layer 1, AllStub region E
 // Sort stubs into smaller regions in phi, i.e. Virtual Modules (VMs).
 
-// NOTE: to run a different phi region, change the following
-//          - constants specified in VMRouterTop.h
-//          - the input parameters to VMRouterTop in VMRouterTop.h/.cc
-//          - the the number and directories to the LUTs
-//          - add/remove pragmas depending on inputStub in VMRouterTop.cc
-//          - the call to VMRouter() in VMRouterTop.cc
-//          - the included top function in VMRouter_test.cpp (if file name is changed)
-//          - the top function and memory directory in script_VMR.tcl (if file name is changed)
-//          - add the phi region in emData/download.sh, make sure to also run clean
+// NOTE: the top function of every VMRouter, with its LUTs, is written in
+//       emData/VMR/tops by emData/vmrouter_tops.sh, run by download.sh.
+//       This region, layer 1 AllStub region E, is kept here for the tops
+//       that have no generated counterpart (VMRouterDualTop, VMRouterVirtualTop)
+//       and for the chain and InputRouterVMRouter tests, and uses the
+//       generated LUTs of the region, VMRouterTopLUTs_L1PHIE.h.
 
 ////////////////////////////////////////////
 // Variables for that are specified with regards to the VMR region
-// Changed manually
 
 #define kLAYER 1 // Which barrel layer number the data is coming from
 #define kDISK 0 // Which disk number the data is coming from, 0 if not disk
@@ -26,62 +23,41 @@
 constexpr char phiRegion = 'E'; // Which AllStub/PhiRegion
 constexpr int sector = 4; //  Specifies the sector
 
-// Maximum number of memory "copies" for this Phi region
-// Note: can't use 0 if we don't have any memories of a certain type. Use 1.
-constexpr int maxASCopies(6); // Allstub memory
-constexpr int maxTEICopies(5); // TE Inner memories
-constexpr int maxOLCopies(3); // TE Inner Overlap memories
-constexpr int maxTEOCopies(1); // TE Outer memories
-
-// Number of inputs
-constexpr int numInputs(4); // Total number of input memories
-constexpr int numInputsDiskPS(0); // Only used for disks
-constexpr int numInputsDisk2S(numInputs-numInputsDiskPS); // Only used for disks
-
-constexpr int bendCutTableSize(8); // Number of entries in each bendcut table. Can't use 0.
-
 
 ///////////////////////////////////////////////
-// Variables that don't need manual changing
+// Variables that don't need manual changing, from VMRouterConfig.h
 
-#if kLAYER == kDISK
-#error kLAYER and kDISK can't be the sam
-#elif kLAYER > 0
-	// Number of VMs
-	constexpr int nvmME = nvmmelayers[kLAYER-1]; // ME memories
-	constexpr int nvmTEI = (kLAYER != 2) ? nvmtelayers[kLAYER-1] : nvmteextralayers[kLAYER-1]; // TE Inner memories
-	constexpr int nvmOL = (kLAYER == 1 || kLAYER == 2) ? nvmollayers[kLAYER-1] : 1; // TE Inner Overlap memories, can't use 0 when we don't have any OL memories
-	constexpr int nvmTEO = (kLAYER != 3) ? nvmtelayers[kLAYER-1] : nvmteextralayers[kLAYER-1]; // TE Outer memories
+typedef VMRouterConfig<kLAYER, kDISK, phiRegion> VMRConfig;
 
-	// Number of bits used for the bins in VMStubeME memories
-	constexpr int nbitsbin = 3;
+// Maximum number of memory "copies" for this Phi region
+constexpr int maxASCopies = VMRConfig::maxASCopies; // Allstub memory
+constexpr int maxTEICopies = VMRConfig::maxTEICopies; // TE Inner memories
+constexpr int maxOLCopies = VMRConfig::maxOLCopies; // TE Inner Overlap memories
+constexpr int maxTEOCopies = VMRConfig::maxTEOCopies; // TE Outer memories
 
-	// What regionType the input/output is
-	constexpr regionType inputType = (kLAYER > 3) ? BARREL2S : BARRELPS;
-	constexpr regionType outputType = (kLAYER > 3) ? BARREL2S : BARRELPS;
+// Number of inputs
+constexpr int numInputs = VMRConfig::numInputs; // Total number of input memories
+constexpr int numInputsDiskPS = VMRConfig::numInputsDiskPS; // Only used for disks
+constexpr int numInputsDisk2S = VMRConfig::numInputsDisk2S; // Only used for disks
 
-#elif kDISK > 0
-	// Number of VMs
-	constexpr int nvmME = nvmmedisks[kDISK-1]; // ME memories
-	constexpr int nvmTEI = nvmtedisks[kDISK-1]; // TE Inner memories
-	constexpr int nvmOL = 1; // TE Inner Overlap memories, can't use 0 when we don't have any OL memories
-	constexpr int nvmTEO = nvmtedisks[kDISK-1]; // TE Outer memories
+constexpr int bendCutTableSize = VMRConfig::bendCutTableSize; // Number of entries in each bendcut table
 
-	// Number of bits used for the bins in VMStubeME memories
-	constexpr int nbitsbin = 4;
+// Number of VMs
+constexpr int nvmME = VMRConfig::nvmME; // ME memories
+constexpr int nvmTEI = VMRConfig::nvmTEI; // TE Inner memories
+constexpr int nvmOL = VMRConfig::nvmOL; // TE Inner Overlap memories
+constexpr int nvmTEO = VMRConfig::nvmTEO; // TE Outer memories
 
-	// What regionType the input/output is
-	constexpr regionType inputType = DISKPS;
-	constexpr regionType outputType = DISK;
+// Number of bits used for the bins in VMStubeME memories
+constexpr int nbitsbin = VMRConfig::nbitsbin;
 
-#else
-#error Need to have either kLAYER or kDISK larger than 0.
-#endif
+// What regionType the input/output is
+constexpr regionType inputType = VMRConfig::inputType;
+constexpr regionType outputType = VMRConfig::outputType;
 
 
 /////////////////////////////////////////////////////
 // VMRouter Top Function
-// Changed manually
 
 void VMRouterTop(const BXType bx, BXType& bx_o,
 	// Input memories
@@ -94,4 +70,39 @@ void VMRouterTop(const BXType bx, BXType& bx_o,
 	VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies]
 	);
 
+// VMRouter of the same region routing two stubs per clock, for the
+// high-occupancy regions: up to 1 << kNBits_MemAddr stubs per BX,
+// the depth of the memories, in half the clocks
+void VMRouterDualTop(const BXType bx, BXType& bx_o,
+	// Input memories
+	const InputStubMemory<inputType> inputStub[numInputs],
+
+	// Output memories
+	AllStubMemory<outputType> allStub[maxASCopies],
+	VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME],
+	VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies],
+	VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies]
+	);
+
+// AllStub memory read by the maxASCopies readers of the AllStub copies,
+// from fewer copies (VirtualMemory.h, a model: the time-multiplexed read port
+// of the copies is not implemented)
+typedef VirtualMemory<AllStubMemory<outputType>, maxASCopies> VirtualAllStubMemory;
+
+// VMRouter of the same region writing the AllStub copies of the
+// virtual AllStub memory instead of one per reader. It is not a replacement
+// for VMRouterTop: its kNCopies copies can only serve the maxASCopies readers
+// through a time-multiplexed read port, which is not implemented. It is there
+// to check the copies in C simulation.
+void VMRouterVirtualTop(const BXType bx, BXType& bx_o,
+	// Input memories
+	const InputStubMemory<inputType> inputStub[numInputs],
+
+	// Output memories
+	VirtualAllStubMemory& allStub,
+	VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME],
+	VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies],
+	VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies]
+	);
+
 #endif // TrackletAlgorithm_VMRouterTop_h
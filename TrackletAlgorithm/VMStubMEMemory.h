@@ -49,6 +49,19 @@ public:
   };
 };
 
+// The disk stubs carry no PS/2S flag. Their r-bin, without the sign of the
+// disk, and their fine r give their r in 1<<(MEBinsBits+kVMSMEFineZSize) steps
+// from rmindiskvm to rmaxdisk, and the stubs in the steps below rPS2S are taken
+// as PS stubs by the MatchEngine. VMRouter_test checks this split against the
+// PS and 2S inputs of the disk VMRouter.
+constexpr unsigned int kVMSMEFirst2SRPosDisk = (rPS2S - rmindiskvm) * (1 << (MEBinsBits + VMStubMEBase<DISK>::kVMSMEFineZSize)) / (rmaxdisk - rmindiskvm);
+
+inline bool isPSStubDisk(const ap_uint<MEBinsBits> rbin, const ap_uint<VMStubMEBase<DISK>::kVMSMEFineZSize> finer)
+{
+#pragma HLS inline
+  return rbin.concat(finer) < kVMSMEFirst2SRPosDisk;
+}
+
 
 // Data object definition
 template<int VMSMEType>
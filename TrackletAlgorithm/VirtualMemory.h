@@ -0,0 +1,173 @@
+// Memory with several logical read ports backed by fewer physical copies
+#ifndef TrackletAlgorithm_VirtualMemory_h
+#define TrackletAlgorithm_VirtualMemory_h
+
+// A module writes one copy of a memory per module that reads it, e.g. the
+// VMRouter writes the same AllStub to maxASCopies AllStub memories, only so
+// that each reader has its own read port. VirtualMemory<MemType, NPorts>
+// presents NPorts read ports, one per reader, backed by
+// kNCopies = ceil(NPorts/NTimeMux) copies of MemType: each copy is read by
+// NTimeMux readers, time-multiplexed on the phases of a memory clock NTimeMux
+// times faster than the processing clock, and the writer writes kNCopies
+// copies instead of NPorts. Port p reads copy p/NTimeMux.
+//
+// The writer takes the copies as its memory array, e.g. the memoriesAS of
+// VMRouter with MaxAllCopies = kNCopies, and each reader the memory of its
+// port. Only memories whose copies hold the same entries can be shared: the
+// TE Inner and overlap copies of the VMRouter each have their own bend cut.
+//
+// This is a model of such a memory, for C simulation and for the block RAM
+// estimate of printVirtualMemoryReport. Neither the faster memory clock nor
+// the arbitration of the read port of a copy between its readers is
+// implemented, and HLS cannot synthesize NTimeMux readers of one RAM_2P copy
+// at the processing clock: in synthesis, a copy still has one reader. The
+// block RAMs saved are those that such a read port, e.g. an RTL memory
+// wrapper, would give.
+
+#include "MemoryTemplate.h"
+#include "MemoryTemplateBinned.h"
+
+#ifndef __SYNTHESIS__
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#endif
+
+template<class MemType, unsigned int NPorts, unsigned int NTimeMux = 2>
+class VirtualMemory
+{
+public:
+  static_assert(NPorts > 0 && NTimeMux > 0, "At least one port and one read per clock");
+
+  static constexpr unsigned int kNPorts = NPorts;
+  static constexpr unsigned int kNTimeMux = NTimeMux;
+  static constexpr unsigned int kNCopies = (NPorts + NTimeMux - 1) / NTimeMux;
+
+  typedef MemType MemoryType;
+  typedef typename MemType::BunchXingT BunchXingT;
+
+  // Physical copies, all written with the same entries
+  MemType* getCopies() {return copies_;}
+  const MemType* getCopies() const {return copies_;}
+
+  // Memory read by port
+  const MemType& getPort(unsigned int port) const {return copies_[port / NTimeMux];}
+
+  template<class DataType>
+  bool write_mem(BunchXingT ibx, const DataType data, int addr_index)
+  {
+#pragma HLS inline
+    bool success = true;
+    for (unsigned int n = 0; n < kNCopies; ++n) {
+#pragma HLS unroll
+      success &= copies_[n].write_mem(ibx, data, addr_index);
+    }
+    return success;
+  }
+
+#ifndef __SYNTHESIS__
+  void clear()
+  {
+    for (auto& copy : copies_) copy.clear();
+  }
+
+  void clear(BunchXingT ibx)
+  {
+    for (auto& copy : copies_) copy.clear(ibx);
+  }
+#endif
+
+private:
+  MemType copies_[kNCopies];
+};
+
+
+// Methods for C simulation only
+#ifndef __SYNTHESIS__
+
+// Width and number of words, over all the BXs, of a memory
+template<class MemType> struct MemoryGeometry;
+
+template<class DataType, unsigned int NBIT_BX, unsigned int NBIT_ADDR>
+struct MemoryGeometry<MemoryTemplate<DataType, NBIT_BX, NBIT_ADDR> > {
+  static constexpr unsigned int kWidth = DataType::getWidth();
+  static constexpr unsigned int kDepth = (1 << NBIT_BX) * (1 << NBIT_ADDR);
+};
+
+template<class DataType, unsigned int NBIT_BX, unsigned int NBIT_ADDR, unsigned int NBIT_BIN>
+struct MemoryGeometry<MemoryTemplateBinned<DataType, NBIT_BX, NBIT_ADDR, NBIT_BIN> > {
+  static constexpr unsigned int kWidth = DataType::getWidth();
+  static constexpr unsigned int kDepth = (1 << NBIT_BX) * (1 << NBIT_ADDR);
+};
+
+// Number of 18Kb block RAMs of a memory of depth words of width bits, in the
+// best aspect ratio of a RAMB18, up to 512x36 in simple dual-port mode
+inline unsigned int bram18kCount(unsigned int width, unsigned int depth)
+{
+  const unsigned int depths[] = {16384, 8192, 4096, 2048, 1024, 512};
+  const unsigned int widths[] = {1, 2, 4, 9, 18, 36};
+  unsigned int count = 0;
+  for (unsigned int i = 0; i < sizeof(depths)/sizeof(depths[0]); ++i) {
+    const unsigned int n = ((depth + depths[i] - 1) / depths[i]) * ((width + widths[i] - 1) / widths[i]);
+    if (count == 0 || n < count) count = n;
+  }
+  return count;
+}
+
+// Block RAMs of a memory read by nports modules, nmemories times (e.g. one
+// per VM), with one copy per port or ncopies copies
+struct VirtualMemoryReport {
+  std::string name;
+  unsigned int nmemories;
+  unsigned int nports;
+  unsigned int ncopies;
+  unsigned int bramPerCopy;
+
+  unsigned int getBRAMReplicated() const {return nmemories * nports * bramPerCopy;}
+  unsigned int getBRAMVirtual() const {return nmemories * ncopies * bramPerCopy;}
+  unsigned int getBRAMSaved() const {return getBRAMReplicated() - getBRAMVirtual();}
+};
+
+// Report of nmemories VirtualMemory
+template<class VirtualMemType>
+VirtualMemoryReport virtualMemoryReport(const std::string& name, unsigned int nmemories = 1)
+{
+  typedef MemoryGeometry<typename VirtualMemType::MemoryType> Geometry;
+  return {name, nmemories, VirtualMemType::kNPorts, VirtualMemType::kNCopies,
+      bram18kCount(Geometry::kWidth, Geometry::kDepth)};
+}
+
+// Report of nmemories memories of nports copies each, kept replicated
+template<class MemType>
+VirtualMemoryReport replicatedMemoryReport(const std::string& name, unsigned int nports, unsigned int nmemories = 1)
+{
+  typedef MemoryGeometry<MemType> Geometry;
+  return {name, nmemories, nports, nports, bram18kCount(Geometry::kWidth, Geometry::kDepth)};
+}
+
+// Prints one line per memory and the total block RAMs (RAMB18) that a
+// time-multiplexed read port would save, see VirtualMemory
+inline void printVirtualMemoryReport(const std::vector<VirtualMemoryReport>& reports, std::ostream& os = std::cout)
+{
+  unsigned int replicated = 0;
+  unsigned int saved = 0;
+  os << std::setfill(' ') << std::left << std::setw(16) << "memory" << std::right << std::setw(10) << "memories"
+     << std::setw(8) << "ports" << std::setw(8) << "copies" << std::setw(12) << "RAMB18/copy"
+     << std::setw(12) << "replicated" << std::setw(10) << "virtual" << std::setw(8) << "saved" << std::endl;
+  for (const auto& report : reports) {
+    os << std::left << std::setw(16) << report.name << std::right << std::setw(10) << report.nmemories
+       << std::setw(8) << report.nports << std::setw(8) << report.ncopies << std::setw(12) << report.bramPerCopy
+       << std::setw(12) << report.getBRAMReplicated() << std::setw(10) << report.getBRAMVirtual()
+       << std::setw(8) << report.getBRAMSaved() << std::endl;
+    replicated += report.getBRAMReplicated();
+    saved += report.getBRAMSaved();
+  }
+  os << "RAMB18 saved with a time-multiplexed read port (not implemented): " << saved << " of " << replicated;
+  if (replicated) os << " (" << std::fixed << std::setprecision(1) << 100. * saved / replicated << "%)";
+  os << std::endl;
+}
+
+#endif // __SYNTHESIS__
+
+#endif // TrackletAlgorithm_VirtualMemory_h
@@ -8,9 +8,11 @@ then
   exit 1
 fi
 
-# Remove everything except download.sh and clean.sh.
+# Remove everything except download.sh, clean.sh and the VMRouter scripts.
 find -mindepth 1 -maxdepth 1 \
   ! -regex "^\.\/download\.sh$" \
   ! -regex "^\.\/clean\.sh$" \
+  ! -regex "^\.\/vmrouter_regions\.sh$" \
+  ! -regex "^\.\/vmrouter_tops\.sh$" \
     -exec rm -rfv {} \;
   #! -regex "^\.\/dtclinklayerdisk\.dat$" \
@@ -31,11 +31,13 @@ declare -a processing_modules=(
 
   # ProjectionRouter
   "PR_L3PHIC"
+  "PR_D1PHIA"
 
   # MatchEngine
   "ME_L1PHIE20"
   "ME_L3PHIC20"
   "ME_L4PHIB12"
+  "ME_D1PHIA4"
 
   # MatchCalculator
   "MC_L1PHIC"
@@ -154,11 +156,15 @@ do
           find ${table_location} -type f -name "${layer_pair}_*.tab" -exec ln -sf ../../{} ${table_target_dir}/ \;
   elif [[ ${module_type} == "ME" ]]
   then
-          layer=`echo ${module} | sed "s/.*_\(L[1-9]\).*$/\1/g"`
+          layer=`echo ${module} | sed "s/.*_\([LD][1-9]\).*$/\1/g"`
           find ${table_location} -type f -name "METable_${layer}.tab" -exec ln -sf ../../{} ${table_target_dir}/ \;
   elif [[ ${module_type} == "MC" ]] || [[ ${module_type} == "TE" ]]
   then
           find ${table_location} -type f -name "${module}_*.tab" -exec ln -sf ../../{} ${table_target_dir}/ \;
+  elif [[ ${module_type} == "PR" ]]
+  then
+          # Number of input memories, included by ProjectionRouterTop_<region>.h
+          grep -c "output=> ${module}\." wires_hourglass.dat > ${table_target_dir}/${module}_nInputs.tab
   elif [[ ${module_type} == "VMR" ]]
   then
           layer=`echo ${module} | sed "s/VMR_\(..\).*/\1/g"`
@@ -170,3 +176,9 @@ do
           done
   fi
 done
+
+# VMRouter regions of the wiring, included in vmrouterRegions of
+# TrackletAlgorithm/VMRouterConfig.h, and the top function of each of them.
+mkdir -p VMR/tables
+./vmrouter_regions.sh wires_hourglass.dat > VMR/tables/vmrouterRegions.tab
+./vmrouter_tops.sh wires_hourglass.dat VMR/tops
@@ -0,0 +1,61 @@
+#!/usr/bin/env bash
+
+# Prints the lines of vmrouterRegions in TrackletAlgorithm/VMRouterConfig.h,
+# i.e. the number of input memories and the maximum number of copies of each
+# output memory of every VMRouter, as found in the wiring file.
+#
+# Usage: ./vmrouter_regions.sh [wiring file]
+# The wiring file defaults to wires_hourglass.dat, downloaded by download.sh.
+
+wires=${1:-wires_hourglass.dat}
+
+if [[ ! -f ${wires} ]]
+then
+  echo "Could not find wiring file ${wires}, run download.sh first."
+  exit 1
+fi
+
+# Each line of the wiring file is
+#   <memory> input=> <module>.<port> output=> <module>.<port>
+# The memories written by a VMRouter are AllStubs (AS_...n<copy>), ME stubs and
+# TE stubs (VMSTE_...n<copy>). The TE stubs are inner or outer depending on the
+# port of the TrackletEngine reading them; inner stubs of a layer read by a
+# TrackletEngine seeding with a disk are the overlap (OL) memories.
+awk '
+  $3 ~ /^VMR_/ {
+    vmr = substr($3, 1, index($3, ".") - 1)
+    mem = $1
+    copy = mem; sub(/.*n/, "", copy); copy += 0
+    if (mem ~ /^AS_/) {
+      nas[vmr]++
+    } else if (mem ~ /^VMSTE_/) {
+      te = substr($5, 1, index($5, ".") - 1)
+      if ($5 ~ /\.outervmstubin/) {
+        if (copy > teo[vmr]) teo[vmr] = copy
+      } else if (vmr ~ /^VMR_L/ && te ~ /_D[0-9]/) {
+        if (copy > ol[vmr]) ol[vmr] = copy
+      } else {
+        if (copy > tei[vmr]) tei[vmr] = copy
+      }
+    }
+    vmrs[vmr] = 1
+  }
+  $5 ~ /^VMR_.*\.stubin/ {
+    vmr = substr($5, 1, index($5, ".") - 1)
+    nin[vmr]++
+    if (vmr ~ /^VMR_D/ && $1 ~ /PS/) ninps[vmr]++
+    vmrs[vmr] = 1
+  }
+  END {
+    for (vmr in vmrs) {
+      region = substr(vmr, 5)
+      layer = (region ~ /^L/) ? substr(region, 2, 1) : 0
+      disk = (region ~ /^D/) ? substr(region, 2, 1) : 0
+      phi = substr(region, length(region), 1)
+      # Cannot use 0 copies, see VMRouterConfig.h
+      printf "\t{%d, %d, '\''%s'\'', %2d, %d, %d, %d, %2d, %d}, // %s\n", layer, disk, phi,
+        nas[vmr] ? nas[vmr] : 1, tei[vmr] ? tei[vmr] : 1, ol[vmr] ? ol[vmr] : 1, teo[vmr] ? teo[vmr] : 1,
+        nin[vmr], ninps[vmr], vmr
+    }
+  }
+' ${wires} | sort -t/ -k3
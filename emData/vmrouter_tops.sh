@@ -0,0 +1,359 @@
+#!/usr/bin/env bash
+
+# Writes the top function of every VMRouter of the wiring file, with the
+# lookup tables of its region:
+#   VMRouterTop_<region>.h/.cc  VMRouterTop of the region
+#   VMRouterTopLUTs_<region>.h  its lookup tables, included in the body of the top
+# The number of inputs and of copies of each region are taken from the lines
+# printed by vmrouter_regions.sh, i.e. the vmrouterRegions table of
+# TrackletAlgorithm/VMRouterConfig.h, the names of the memories from the wiring.
+#
+# Usage: ./vmrouter_tops.sh [wiring file] [output directory]
+# The wiring file defaults to wires_hourglass.dat and the output directory to
+# VMR/tops, as run by download.sh. The tables are read from VMR/tables.
+
+wires=${1:-wires_hourglass.dat}
+outdir=${2:-VMR/tops}
+
+if [[ ! -f ${wires} ]]
+then
+  echo "Could not find wiring file ${wires}, run download.sh first."
+  exit 1
+fi
+
+mkdir -p ${outdir}
+
+# Number of VMs per phi region, as in TrackletAlgorithm/VMRouter.h
+nvmtelayers=(4 8 4 8 4 8)
+nvmtedisks=(4 4 4 4 4)
+nvmollayers=(2 2)
+nvmteextralayers=(0 4 4)
+
+# Naming of the TE memories, as in TestBenches/VMRouter_test.cpp
+overlapPhiRegion=(X Y Z W Q R S T) # TE overlap memories, and outer memories of disk 1
+extraPhiRegion=(I J K L) # TE inner memories of layer 2 and outer memories of layer 3
+
+# Writes the bend-cut tables of the nvm TE memories <prefix><ivm>n<copy> of the
+# region, starting at ivm = ivmfirst, for copies 1 to ncopies, and the table
+# named table that combines them. The copies missing from the wiring are
+# arrays of zeros. Tables after the first one of the region are preceded by
+# two blank lines.
+write_bendcut_tables() {
+  local kind=$1 prefix=$2 ivmfirst=$3 nvm=$4 ncopies=$5 table=$6
+  local rows=()
+  [[ ${table} != ${firsttable} ]] && echo -e "\n"
+  for ((i = 1; i <= nvm; i++))
+  do
+    local ivm=$((ivmfirst + i - 1))
+    local row=""
+    echo "	// TE ${kind} Memory ${i}"
+    for ((n = 1; n <= ncopies; n++))
+    do
+      local mem=${prefix}${ivm}n${n}
+      if grep -q "^${mem} " ${wires}
+      then
+        echo "	ap_uint<1> tmpBend${kind}Table${i}_n${n}[bendCutTableSize] ="
+        echo "#include \"../tables/${mem}_vmbendcut.tab\""
+      else
+        echo "	ap_uint<1> tmpBend${kind}Table${i}_n${n}[bendCutTableSize] = {0};"
+      fi
+      echo
+      [[ -n ${row} ]] && row="${row}, "
+      row="${row}arrayToInt<bendCutTableSize>(tmpBend${kind}Table${i}_n${n})"
+    done
+    rows+=("${row}")
+  done
+  echo "	// Combine all the temporary ${kind} tables into one big table"
+  echo "	static const ap_uint<bendCutTableSize> ${table}[] = {"
+  for ((i = 0; i < ${#rows[@]}; i++))
+  do
+    [[ $i -lt $((${#rows[@]} - 1)) ]] && sep="," || sep="};"
+    echo "		${rows[$i]}${sep}"
+  done
+}
+
+$(dirname $0)/vmrouter_regions.sh ${wires} | tr -d "{},'/" |
+while read layer disk phi nas ntei nol nteo nin ninps vmr
+do
+  region=${vmr#VMR_}
+  iphi=$(( $(printf "%d" "'${phi}") - $(printf "%d" "'A") ))
+  if [[ ${layer} != 0 ]]
+  then
+    layerID=L${layer}PHI${phi}
+    name="layer ${layer}"
+  else
+    layerID=D${disk}PHI${phi}
+    name="disk ${disk}"
+  fi
+
+  # Memories written by the region, as for the masks of VMRouterConfig
+  hasTEI=0; hasOL=0; hasTEO=0
+  [[ ${layer} =~ ^[1235]$ || ${disk} =~ ^[13]$ ]] && hasTEI=1
+  [[ ${layer} =~ ^[12]$ ]] && hasOL=1
+  [[ ${layer} =~ ^[2346]$ || ${disk} =~ ^[124]$ ]] && hasTEO=1
+
+  guard=TrackletAlgorithm_VMRouterTop_${region}_h
+  header=${outdir}/VMRouterTop_${region}.h
+  source=${outdir}/VMRouterTop_${region}.cc
+  luts=${outdir}/VMRouterTopLUTs_${region}.h
+
+  ##############################
+  # Header
+  {
+    echo "#ifndef ${guard}"
+    echo "#define ${guard}"
+    echo
+    echo "// Generated from $(basename ${wires}) by emData/$(basename $0), do not edit."
+    echo
+    echo "#include \"VMRouterConfig.h\""
+    echo
+    echo "// VMRouter Top Function for ${name}, AllStub region ${phi}"
+    echo "// Sort stubs into smaller regions in phi, i.e. Virtual Modules (VMs)."
+    echo
+    echo "// NOTE: To run this VMR, run script_VMR.tcl for the region ${region}"
+    echo "//          vivado_hls -f script_VMR.tcl -tclargs ${region}"
+    echo
+    echo
+    echo "//////////////////////////////////"
+    echo "// Variables for that are specified with regards to the VMR region"
+    echo
+    echo "#define kLAYER ${layer} // Which barrel layer number the data is coming from, 0 if not barrel"
+    echo "#define kDISK ${disk} // Which disk number the data is coming from, 0 if not disk"
+    echo
+    echo "constexpr char phiRegion = '${phi}'; // Which AllStub/PhiRegion"
+    echo "constexpr int sector = 4; //  Specifies the sector"
+    echo
+    echo
+    cat <<'EOF'
+///////////////////////////////////////////////
+// Variables that don't need manual changing, from VMRouterConfig.h
+
+typedef VMRouterConfig<kLAYER, kDISK, phiRegion> VMRConfig;
+
+// Maximum number of memory "copies" for this Phi region
+constexpr int maxASCopies = VMRConfig::maxASCopies; // Allstub memory
+constexpr int maxTEICopies = VMRConfig::maxTEICopies; // TE Inner memories
+constexpr int maxOLCopies = VMRConfig::maxOLCopies; // TE Inner Overlap memories
+constexpr int maxTEOCopies = VMRConfig::maxTEOCopies; // TE Outer memories
+
+// Number of inputs
+constexpr int numInputs = VMRConfig::numInputs; // Total number of input memories
+constexpr int numInputsDiskPS = VMRConfig::numInputsDiskPS; // Only used for disks
+constexpr int numInputsDisk2S = VMRConfig::numInputsDisk2S; // Only used for disks
+
+constexpr int bendCutTableSize = VMRConfig::bendCutTableSize; // Number of entries in each bendcut table
+
+// Number of VMs
+constexpr int nvmME = VMRConfig::nvmME; // ME memories
+constexpr int nvmTEI = VMRConfig::nvmTEI; // TE Inner memories
+constexpr int nvmOL = VMRConfig::nvmOL; // TE Inner Overlap memories
+constexpr int nvmTEO = VMRConfig::nvmTEO; // TE Outer memories
+
+// Number of bits used for the bins in VMStubeME memories
+constexpr int nbitsbin = VMRConfig::nbitsbin;
+
+// What regionType the input/output is
+constexpr regionType inputType = VMRConfig::inputType;
+constexpr regionType outputType = VMRConfig::outputType;
+
+
+/////////////////////////////////////////////////////
+// VMRouter Top Function
+
+void VMRouterTop(const BXType bx, BXType& bx_o,
+	// Input memories
+	const InputStubMemory<inputType> inputStub[numInputs],
+EOF
+    [[ ${disk} != 0 ]] && echo "	const InputStubMemory<DISK2S> inputStubDisk2S[numInputsDisk2S], // Only disks has 2S modules"
+    echo
+    echo "	// Output memories"
+    outputs=("	AllStubMemory<outputType> allStub[maxASCopies]" "	VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME]")
+    [[ ${hasTEI} == 1 ]] && outputs+=("	VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies]")
+    [[ ${hasOL} == 1 ]] && outputs+=("	VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies]")
+    [[ ${hasTEO} == 1 ]] && outputs+=("	VMStubTEOuterMemory<outputType> memoriesTEO[nvmTEO][maxTEOCopies]")
+    for ((i = 0; i < ${#outputs[@]}; i++))
+    do
+      [[ $i -lt $((${#outputs[@]} - 1)) ]] && echo "${outputs[$i]}," || echo "${outputs[$i]}"
+    done
+    echo "	);"
+    echo
+    echo "#endif // ${guard}"
+  } > ${header}
+
+  ##############################
+  # Lookup tables
+  {
+    echo "// Lookup tables of the VMRouter region ${region}, ${name}, AllStub region ${phi}."
+    echo "// Included in the body of its top functions, so that they use the same tables."
+    echo "// Generated from $(basename ${wires}) by emData/$(basename $0), do not edit."
+    echo
+    echo "	// LUT with the corrected r/z. It is corrected for the average r (z) of the barrel (disk)."
+    echo "	// Includes both coarse r/z position (bin), and finer region each r/z bin is divided into."
+    echo "	// Indexed using r and z position bits"
+    echo "	static const int fineBinTable[] ="
+    echo "#include \"../tables/VMR_${region}_finebin.tab\""
+    echo
+    echo
+    if [[ ${layer} != 0 ]]
+    then
+      echo "	// LUT with phi corrections to project the stub to the average radius in a layer."
+      echo "	// Only used by layers."
+      echo "	// Indexed using phi and bend bits"
+      echo "	static const int phiCorrTable[] ="
+      echo "#include \"../tables/VMPhiCorrL${layer}.tab\""
+      echo
+      echo
+    fi
+    echo "	// LUT with the Z/R bits for TE memories"
+    echo "	// Contain information about where in z to look for valid stub pairs"
+    echo "	// Indexed using z and r position bits"
+    echo
+    if [[ ${hasTEI} == 1 ]]
+    then
+      [[ ${layer} != 0 ]] && pair=L${layer}L$((layer + 1)) || pair=D${disk}D$((disk + 1))
+      echo "	static const int rzBitsInnerTable[] = // 11 bits used for LUT"
+      echo "#include \"../tables/VMTableInner${pair}.tab\""
+      echo
+    fi
+    if [[ ${hasOL} == 1 ]]
+    then
+      echo "	static const int rzBitsOverlapTable[] = // 11 bits used for LUT"
+      echo "#include \"../tables/VMTableInnerL${layer}D1.tab\""
+      echo
+    fi
+    if [[ ${hasTEO} == 1 ]]
+    then
+      [[ ${layer} != 0 ]] && outer=L${layer} || outer=D${disk}
+      echo "	static const int rzBitsOuterTable[] = // 11 bits used for LUT"
+      echo "#include \"../tables/VMTableOuter${outer}.tab\""
+      echo
+    fi
+    echo
+    echo "	// LUT with bend-cuts for the TE memories"
+    echo "	// The cuts are different depending on the memory version (nX)"
+    echo "	// Indexed using bend bits"
+    echo "	// Note: arrays of zeros for the memories that are not in the wiring"
+    echo
+    [[ ${hasTEI} == 1 ]] && firsttable=bendCutInnerTable ||
+      { [[ ${hasOL} == 1 ]] && firsttable=bendCutOverlapTable || firsttable=bendCutOuterTable; }
+    if [[ ${hasTEI} == 1 ]]
+    then
+      if [[ ${layer} == 2 ]]
+      then
+        nvm=${nvmteextralayers[1]}; prefix=VMSTE_L2PHI${extraPhiRegion[$iphi]}
+      elif [[ ${layer} != 0 ]]
+      then
+        nvm=${nvmtelayers[$((layer - 1))]}; prefix=VMSTE_${layerID}
+      else
+        nvm=${nvmtedisks[$((disk - 1))]}; prefix=VMSTE_${layerID}
+      fi
+      write_bendcut_tables Inner ${prefix} $((iphi * nvm + 1)) ${nvm} ${ntei} bendCutInnerTable
+    fi
+    if [[ ${hasOL} == 1 ]]
+    then
+      nvm=${nvmollayers[$((layer - 1))]}
+      write_bendcut_tables Overlap VMSTE_L${layer}PHI${overlapPhiRegion[$iphi]} $((iphi * nvm + 1)) ${nvm} ${nol} bendCutOverlapTable
+    fi
+    if [[ ${hasTEO} == 1 ]]
+    then
+      if [[ ${disk} == 1 ]]
+      then
+        nvm=${nvmtedisks[0]}; prefix=VMSTE_D1PHI${overlapPhiRegion[$iphi]}
+      elif [[ ${layer} == 3 ]]
+      then
+        nvm=${nvmteextralayers[2]}; prefix=VMSTE_L3PHI${extraPhiRegion[$iphi]}
+      elif [[ ${layer} != 0 ]]
+      then
+        nvm=${nvmtelayers[$((layer - 1))]}; prefix=VMSTE_${layerID}
+      else
+        nvm=${nvmtedisks[$((disk - 1))]}; prefix=VMSTE_${layerID}
+      fi
+      write_bendcut_tables Outer ${prefix} $((iphi * nvm + 1)) ${nvm} ${nteo} bendCutOuterTable
+    fi
+  } > ${luts}
+
+  ##############################
+  # Top function
+  [[ ${disk} != 0 ]] && nps=${ninps} || nps=${nin}
+  {
+    echo "#include \"VMRouterTop_${region}.h\""
+    echo
+    echo "// VMRouter Top Function for ${name}, AllStub region ${phi}"
+    echo "// Sort stubs into smaller regions in phi, i.e. Virtual Modules (VMs)."
+    echo "// Generated from $(basename ${wires}) by emData/$(basename $0), do not edit."
+    echo
+    echo
+    echo "void VMRouterTop(const BXType bx, BXType& bx_o,"
+    echo "	// Input memories"
+    echo "	const InputStubMemory<inputType> inputStub[numInputs],"
+    [[ ${disk} != 0 ]] && echo "	const InputStubMemory<DISK2S> inputStubDisk2S[numInputsDisk2S], // Only disks has 2S modules"
+    echo "	// Output memories"
+    outputs=("	AllStubMemory<outputType> memoriesAS[maxASCopies]" "	VMStubMEMemory<outputType, nbitsbin> memoriesME[nvmME]")
+    [[ ${hasTEI} == 1 ]] && outputs+=("	VMStubTEInnerMemory<outputType> memoriesTEI[nvmTEI][maxTEICopies]")
+    [[ ${hasOL} == 1 ]] && outputs+=("	VMStubTEInnerMemory<BARRELOL> memoriesOL[nvmOL][maxOLCopies]")
+    [[ ${hasTEO} == 1 ]] && outputs+=("	VMStubTEOuterMemory<outputType> memoriesTEO[nvmTEO][maxTEOCopies]")
+    for ((i = 0; i < ${#outputs[@]}; i++))
+    do
+      [[ $i -lt $((${#outputs[@]} - 1)) ]] && echo "${outputs[$i]}," || echo "${outputs[$i]})"
+    done
+    echo " {"
+    echo
+    echo
+    echo "	///////////////////////////"
+    echo "	// Open Lookup tables"
+    echo "#include \"VMRouterTopLUTs_${region}.h\""
+    echo
+    echo "// Takes 2 clock cycles before on gets data, used at high frequencies"
+    for ((i = 0; i < nps; i++))
+    do
+      echo "#pragma HLS resource variable=inputStub[${i}].get_mem() latency=2"
+    done
+    for ((i = 0; i < nin - nps; i++))
+    do
+      echo "#pragma HLS resource variable=inputStubDisk2S[${i}].get_mem() latency=2"
+    done
+    echo
+    echo "#pragma HLS interface register port=bx_o"
+    echo
+    cat <<'EOF'
+	//////////////////////////////////
+	// Create memory masks
+
+	// Masks of which memories that are being used. The first memory is represented by the LSB
+	// and a "1" implies that the specified memory is used for this phi region (VMRouterConfig.h)
+	static const ap_uint<maskISsize> maskIS = VMRConfig::maskIS; // Input memories
+	static const ap_uint<maskMEsize> maskME = VMRConfig::maskME; // ME memories
+	static const ap_uint<maskTEIsize> maskTEI = VMRConfig::maskTEI; // TE Inner memories, only used for odd layers/disk and layer 2
+	static const ap_uint<maskOLsize> maskOL = VMRConfig::maskOL; // TE Inner Overlap memories, only used for layer 1 and 2
+	static const ap_uint<maskTEOsize> maskTEO = VMRConfig::maskTEO; // TE Outer memories, only for even layers/disks, and layer and disk 1
+
+
+	/////////////////////////
+	// Main function
+
+	VMRouter<inputType, outputType, kLAYER, kDISK,  maxASCopies, maxTEICopies, maxOLCopies, maxTEOCopies, nbitsbin, bendCutTableSize>
+EOF
+    [[ ${layer} != 0 ]] && phicorr=phiCorrTable || phicorr=nullptr
+    # Tables and memories of the TE memories, nullptr if the region does not write them
+    tables() { [[ $1 == 1 ]] && echo "$2" || echo nullptr; }
+    echo "	(bx, bx_o, fineBinTable, ${phicorr},"
+    echo "		$(tables ${hasTEI} rzBitsInnerTable), $(tables ${hasOL} rzBitsOverlapTable), $(tables ${hasTEO} rzBitsOuterTable),"
+    echo "		$(tables ${hasTEI} bendCutInnerTable), $(tables ${hasOL} bendCutOverlapTable), $(tables ${hasTEO} bendCutOuterTable),"
+    echo "		// Input memories"
+    [[ ${disk} != 0 ]] && echo "		maskIS, inputStub, inputStubDisk2S," || echo "		maskIS, inputStub, nullptr,"
+    echo "		// AllStub memories"
+    echo "		memoriesAS,"
+    echo "		// ME memories"
+    echo "		maskME, memoriesME,"
+    echo "		// TEInner memories"
+    echo "		maskTEI, $(tables ${hasTEI} memoriesTEI),"
+    echo "		// TEInner Overlap memories"
+    echo "		maskOL, $(tables ${hasOL} memoriesOL),"
+    echo "		// TEOuter memories"
+    echo "		maskTEO, $(tables ${hasTEO} memoriesTEO)"
+    echo "		);"
+    echo
+    echo "	return;"
+    echo "}"
+  } > ${source}
+done
@@ -0,0 +1,173 @@
+#!/usr/bin/env python
+
+#================================================================
+# Summary of the HLS synthesis reports of the module projects.
+#
+# Run from project/ after the script_*.tcl have run csynth_design:
+#  ./hlsReports.py [--baseline hlsBaseline.json] [--save-baseline hlsBaseline.json]
+#
+# Reads <project>/solution1/syn/report/*.xml for every project and
+# prints one line per project with the latency and interval of the
+# top function, the worst II of its pipelined loops and its resources,
+# then the changes with respect to the baseline, if any. A project is
+# flagged if a loop has an II above 1 or if the latency of its top
+# function is above the kMaxProc budget, in which case the exit code
+# is 1.
+#================================================================
+
+from __future__ import print_function
+
+import argparse
+import glob
+import json
+import os
+import sys
+import xml.etree.ElementTree as ET
+
+# kMaxProc of TrackletAlgorithm/Constants.h, the number of clocks per BX
+kMaxProc = 108
+
+# Resources, as named in the reports; newer versions call the DSPs DSP
+RESOURCES = ['BRAM_18K', 'DSP48E', 'FF', 'LUT', 'URAM']
+METRICS = ['latency', 'interval', 'II'] + RESOURCES
+
+def to_int(text):
+    try:
+        return int(text)
+    except (TypeError, ValueError):
+        return None
+
+def loop_iis(element):
+    # PipelineII of the loops under element, including nested loops
+    iis = []
+    for loop in element:
+        ii = to_int(loop.findtext('PipelineII'))
+        if ii is not None:
+            iis.append(ii)
+        iis += loop_iis(loop)
+    return iis
+
+def parse_report(filename):
+    root = ET.parse(filename).getroot()
+    report = {}
+    report['top'] = root.findtext('UserAssignments/TopModelName')
+    report['latency'] = to_int(root.findtext('PerformanceEstimates/SummaryOfOverallLatency/Worst-caseLatency'))
+    report['interval'] = to_int(root.findtext('PerformanceEstimates/SummaryOfOverallLatency/Interval-max'))
+    loops = root.find('PerformanceEstimates/SummaryOfLoopLatency')
+    iis = loop_iis(loops) if loops is not None else []
+    report['II'] = max(iis) if iis else None
+    for resource in RESOURCES:
+        value = root.findtext('AreaEstimates/Resources/' + resource)
+        if value is None and resource == 'DSP48E':
+            value = root.findtext('AreaEstimates/Resources/DSP')
+        report[resource] = to_int(value)
+    return report
+
+def parse_project(report_dir):
+    # The summary of the top function is csynth.xml, the other files are
+    # the reports of the functions it calls, whose loops count for the II
+    summary = os.path.join(report_dir, 'csynth.xml')
+    if not os.path.exists(summary):
+        return None
+    project = parse_report(summary)
+    for filename in glob.glob(os.path.join(report_dir, '*.xml')):
+        if os.path.basename(filename) == 'csynth.xml':
+            continue
+        try:
+            ii = parse_report(filename)['II']
+        except ET.ParseError:
+            continue
+        if ii is not None and (project['II'] is None or ii > project['II']):
+            project['II'] = ii
+    return project
+
+def get_flags(project, max_latency):
+    flags = []
+    if project['II'] is not None and project['II'] > 1:
+        flags.append('II=%d' % project['II'])
+    if project['latency'] is not None and project['latency'] > max_latency:
+        flags.append('latency>%d' % max_latency)
+    return flags
+
+def format_value(value):
+    return '-' if value is None else str(value)
+
+def print_table(projects, max_latency):
+    header = ['project', 'top'] + METRICS + ['flags']
+    rows = []
+    for name in sorted(projects):
+        project = projects[name]
+        rows.append([name, format_value(project['top'])]
+                    + [format_value(project[metric]) for metric in METRICS]
+                    + [' '.join(get_flags(project, max_latency))])
+    widths = [max(len(row[i]) for row in [header] + rows) for i in range(len(header))]
+    for row in [header] + rows:
+        print('  '.join(cell.ljust(width) if i < 2 or i == len(row) - 1 else cell.rjust(width)
+                        for i, (cell, width) in enumerate(zip(row, widths))).rstrip())
+
+def print_diffs(projects, baseline):
+    print('\nChanges with respect to the baseline:')
+    nchanges = 0
+    for name in sorted(set(projects) | set(baseline)):
+        if name not in baseline:
+            print('  %s: new project' % name)
+            nchanges += 1
+            continue
+        if name not in projects:
+            print('  %s: no report' % name)
+            nchanges += 1
+            continue
+        for metric in METRICS:
+            old = baseline[name].get(metric)
+            new = projects[name][metric]
+            if old == new:
+                continue
+            change = ''
+            if old is not None and new is not None:
+                change = ' (%+d' % (new - old)
+                change += ', %+.1f%%)' % (100. * (new - old) / old) if old else ')'
+            print('  %s %s: %s -> %s%s' % (name, metric, format_value(old), format_value(new), change))
+            nchanges += 1
+    if nchanges == 0:
+        print('  none')
+
+def main():
+    parser = argparse.ArgumentParser(description='Summary of the HLS synthesis reports of the module projects')
+    parser.add_argument('-d', '--dir', default=os.path.dirname(os.path.abspath(__file__)),
+                        help='directory of the projects (default: the directory of this script)')
+    parser.add_argument('-s', '--solution', default='solution1', help='solution of the projects (default: solution1)')
+    parser.add_argument('-b', '--baseline', help='JSON file of the baseline to compare with')
+    parser.add_argument('--save-baseline', help='write the reports to this JSON file, as a new baseline')
+    parser.add_argument('--max-latency', type=int, default=kMaxProc,
+                        help='latency budget of a top function in clocks (default: kMaxProc = %d)' % kMaxProc)
+    args = parser.parse_args()
+
+    projects = {}
+    for report_dir in sorted(glob.glob(os.path.join(args.dir, '*', args.solution, 'syn', 'report'))):
+        name = os.path.relpath(report_dir, args.dir).split(os.sep)[0]
+        project = parse_project(report_dir)
+        if project is not None:
+            projects[name] = project
+
+    if not projects:
+        print('No synthesis report found in %s/*/%s/syn/report' % (args.dir, args.solution))
+        return 1
+
+    print_table(projects, args.max_latency)
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            print_diffs(projects, json.load(f))
+
+    if args.save_baseline:
+        with open(args.save_baseline, 'w') as f:
+            json.dump(projects, f, indent=2, sort_keys=True)
+
+    flagged = [name for name in projects if get_flags(projects[name], args.max_latency)]
+    if flagged:
+        print('\nFlagged: %s' % ' '.join(sorted(flagged)))
+        return 1
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,47 @@
+# Script to run the C simulation throughput benchmark of the processing
+# modules and of the chain
+#   vivado_hls -f script_Benchmark.tcl [-tclargs <module> ...]
+# The modules are among IR, VMR, TE, TC, PR, ME, MC, TB and chain, all of
+# them by default. The results, one JSON object per line, are printed in the
+# csim log and appended to $BENCH_OUTPUT if set; $BENCH_NEVENTS sets the
+# number of events (500 by default). This project is only used for C
+# simulation.
+# WARNING: this will wipe out the original project by the same name
+
+# vivado_hls passes the whole command line in argv
+set modules {}
+set iarg [lsearch -exact $argv "-tclargs"]
+if {$iarg >= 0} {
+  set modules [lrange $argv [expr {$iarg + 1}] end]
+}
+
+# create new project (deleting any existing one of same name)
+open_project -reset benchmark
+
+# source files
+set CFLAGS {-std=c++11 -I../TrackletAlgorithm}
+set_top TrackBuilder_L1L2
+add_files ../TrackletAlgorithm/InputRouterTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/VMRouterTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/TrackletEngineTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/TrackletCalculatorTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/ProjectionRouterTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/MatchEngine.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/MatchCalculatorTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/TrackBuilderTop.cc -cflags "$CFLAGS"
+add_files -tb ../TestBenches/Benchmark_test.cpp -cflags "$CFLAGS"
+
+open_solution "solution1"
+
+# Define FPGA, clock frequency & common HLS settings.
+source settings_hls.tcl
+
+# data files
+add_files -tb ../emData/
+
+# The benchmark is compiled with optimization, as the timing of an
+# unoptimized C simulation says little about the code
+set nProc [exec nproc]
+csim_design -O -compiler gcc -mflags "-j$nProc" -ldflags "-lpthread" -argv "$modules"
+
+exit
@@ -0,0 +1,29 @@
+# Script to run the C simulation of the buffer depth sweep of the
+# TrackletEngine and the MatchEngine
+#   vivado_hls -f script_BufferSweep.tcl
+#   vivado_hls -p buffersweep
+# The modules are synthesized by their own scripts; this project is only
+# used for C simulation.
+# WARNING: this will wipe out the original project by the same name
+
+# create new project (deleting any existing one of same name)
+open_project -reset buffersweep
+
+# source files
+set CFLAGS {-std=c++11 -I../TrackletAlgorithm}
+set_top MatchEngineTop
+add_files ../TrackletAlgorithm/MatchEngine.cc -cflags "$CFLAGS"
+add_files -tb ../TestBenches/BufferSweep_test.cpp -cflags "$CFLAGS"
+
+open_solution "solution1"
+
+# Define FPGA, clock frequency & common HLS settings.
+source settings_hls.tcl
+
+# data files
+add_files -tb ../emData/TE/
+add_files -tb ../emData/ME/
+
+csim_design -compiler gcc -mflags "-j8"
+
+exit
@@ -0,0 +1,36 @@
+# Script to run the C simulation of a chain of processing modules, from the
+# InputRouter to the TrackBuilder, in a single test bench
+#   vivado_hls -f script_Chain.tcl
+#   vivado_hls -p chain
+# The modules are synthesized by their own scripts; this project is only
+# used for C simulation.
+# WARNING: this will wipe out the original project by the same name
+
+# create new project (deleting any existing one of same name)
+open_project -reset chain
+
+# source files
+set CFLAGS {-std=c++11 -I../TrackletAlgorithm}
+set_top TrackBuilder_L1L2
+add_files ../TrackletAlgorithm/InputRouterTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/VMRouterTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/TrackletEngineTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/TrackletCalculatorTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/ProjectionRouterTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/MatchEngine.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/MatchCalculatorTop.cc -cflags "$CFLAGS"
+add_files ../TrackletAlgorithm/TrackBuilderTop.cc -cflags "$CFLAGS"
+add_files -tb ../TestBenches/Chain_test.cpp -cflags "$CFLAGS"
+
+open_solution "solution1"
+
+# Define FPGA, clock frequency & common HLS settings.
+source settings_hls.tcl
+
+# data files
+add_files -tb ../emData/
+
+set nProc [exec nproc]
+csim_design -compiler gcc -mflags "-j$nProc" -ldflags "-lpthread"
+
+exit
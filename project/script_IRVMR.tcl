@@ -0,0 +1,30 @@
+# Script to generate project for the fused IR/VMR
+#   vivado_hls -f script_IRVMR.tcl
+#   vivado_hls -p inputrouter_vmrouter
+# WARNING: this will wipe out the original project by the same name
+
+# create new project (deleting any existing one of same name)
+open_project -reset inputrouter_vmrouter
+
+# source files
+set CFLAGS {-std=c++11 -I../TrackletAlgorithm}
+set_top InputRouterVMRouterTop
+add_files ../TrackletAlgorithm/InputRouterVMRouterTop.cc -cflags "$CFLAGS"
+add_files -tb ../TrackletAlgorithm/InputRouterTop.cc -cflags "$CFLAGS"
+add_files -tb ../TrackletAlgorithm/VMRouterTop.cc -cflags "$CFLAGS"
+add_files -tb ../TestBenches/InputRouterVMRouter_test.cpp -cflags "$CFLAGS"
+
+open_solution "solution1"
+
+# Define FPGA, clock frequency & common HLS settings.
+source settings_hls.tcl
+
+# data files
+add_files -tb ../emData/
+
+set nProc [exec nproc]
+csim_design -compiler gcc -mflags "-j$nProc"
+csynth_design
+cosim_design
+#export_design -format ip_catalog
+exit
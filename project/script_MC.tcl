@@ -20,9 +20,9 @@ source settings_hls.tcl
 # data files
 add_files -tb ../emData/MC/
 
-#csim_design -compiler gcc -mflags "-j8" # FIXME: activate when missing values are fixed
+#csim_design -compiler gcc -mflags "-j8" -ldflags "-lpthread" # FIXME: activate when missing values are fixed
 csynth_design
-#cosim_design # FIXME: activate when missing values are fixed
+#cosim_design -ldflags "-lpthread" # FIXME: activate when missing values are fixed
 export_design -format ip_catalog
 # Adding "-flow impl" runs full Vivado implementation, providing accurate resource use numbers (very slow).
 #export_design -format ip_catalog -flow impl
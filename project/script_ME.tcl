@@ -1,15 +1,29 @@
 # Script to generate project for ME
-#   vivado_hls -f script_ME.tcl
-#   vivado_hls -p matchengine
+#   vivado_hls -f script_ME.tcl [-tclargs D1]
+#   vivado_hls -p matchengine[_D1]
+# Without arguments the barrel MatchEngine (LAYER in MatchEngine.h) is built,
+# D1 builds the disk one.
 # WARNING: this will wipe out the original project by the same name
 
-# create new project (deleting any existing one of same name)
-open_project -reset matchengine
+# vivado_hls passes the whole command line in argv
+set region ""
+set iarg [lsearch -exact $argv "-tclargs"]
+if {$iarg >= 0 && [llength $argv] > $iarg + 1} {
+  set region [lindex $argv [expr {$iarg + 1}]]
+}
 
 # source files
 # Optional Flags: -DDEBUG
 set CFLAGS {-std=c++11 -I../TrackletAlgorithm}
-set_top MatchEngineTop
+if {$region eq ""} {
+  # create new project (deleting any existing one of same name)
+  open_project -reset matchengine
+  set_top MatchEngineTop
+} else {
+  open_project -reset matchengine_${region}
+  set_top MatchEngineTop_${region}
+  lappend CFLAGS -DME_${region}
+}
 add_files ../TrackletAlgorithm/MatchEngine.cc -cflags "$CFLAGS"
 add_files -tb ../TestBenches/MatchEngine_test.cpp -cflags "$CFLAGS"
 
@@ -21,7 +35,7 @@ source settings_hls.tcl
 # data files
 add_files -tb ../emData/ME/
 
-#csim_design -compiler gcc -mflags "-j8" # FIXME: activate on next synchronization with emulation
+csim_design -compiler gcc -mflags "-j8"
 csynth_design
 #cosim_design -trace_level all -rtl verilog -verbose # FIXME: activate on next synchronization with emulation
 export_design -format ip_catalog
@@ -0,0 +1,27 @@
+# Script to generate project for the merge tree of the MatchCalculator
+#   vivado_hls -f script_MergeTree.tcl
+#   vivado_hls -p mergetree
+# WARNING: this will wipe out the original project by the same name
+
+# create new project (deleting any existing one of same name)
+open_project -reset mergetree
+
+# source files
+set CFLAGS {-std=c++11 -I../TrackletAlgorithm}
+set_top MergeTreeTop
+add_files ../TrackletAlgorithm/MergeTreeTop.cc -cflags "$CFLAGS"
+add_files -tb ../TestBenches/MergeTree_test.cpp -cflags "$CFLAGS"
+
+open_solution "solution1"
+
+# Define FPGA, clock frequency & common HLS settings.
+source settings_hls.tcl
+
+csim_design -compiler gcc -mflags "-j8"
+csynth_design
+cosim_design
+export_design -format ip_catalog
+# Adding "-flow impl" runs full Vivado implementation, providing accurate resource use numbers (very slow).
+#export_design -format ip_catalog -flow impl
+
+exit
@@ -1,15 +1,31 @@
 # Script to generate project for PR
-#   vivado_hls -f script_PR.tcl
-#   vivado_hls -p projrouter
+#   vivado_hls -f script_PR.tcl [-tclargs <region>]
+#   vivado_hls -p projrouter_<region>
+# The region defaults to L3PHIC; D1PHIA runs the disk ProjectionRouter.
 # WARNING: this will wipe out the original project by the same name
 
+# vivado_hls passes the whole command line in argv
+set region L3PHIC
+set iarg [lsearch -exact $argv "-tclargs"]
+if {$iarg >= 0 && [llength $argv] > $iarg + 1} {
+  set region [lindex $argv [expr {$iarg + 1}]]
+}
+
+# Top function of the region: ProjectionRouterTop.cc for L3PHIC,
+# ProjectionRouterTop_<region>.cc otherwise
+if {$region eq "L3PHIC"} {
+  set top ../TrackletAlgorithm/ProjectionRouterTop.cc
+} else {
+  set top ../TrackletAlgorithm/ProjectionRouterTop_${region}.cc
+}
+
 # create new project (deleting any existing one of same name)
-open_project -reset projrouter
+open_project -reset projrouter_${region}
 
 # source files
-set CFLAGS {-std=c++11 -I../TrackletAlgorithm}
+set CFLAGS "-std=c++11 -I../TrackletAlgorithm -DPR_REGION_${region}"
 set_top ProjectionRouterTop
-add_files ../TrackletAlgorithm/ProjectionRouterTop.cc -cflags "$CFLAGS"
+add_files $top -cflags "$CFLAGS"
 add_files -tb ../TestBenches/ProjectionRouter_test.cpp -cflags "$CFLAGS"
 
 open_solution "solution1"
@@ -18,8 +34,7 @@ open_solution "solution1"
 source settings_hls.tcl
 
 # data files
-add_files -tb ../emData/PR/PR_L3PHIC/
-#add_files -tb ../emData/PR/PR_L3L4_L1PHI3/
+add_files -tb ../emData/PR/PR_${region}/
 
 csim_design -compiler gcc -mflags "-j8"
 csynth_design
@@ -20,9 +20,9 @@ source settings_hls.tcl
 # data files
 add_files -tb ../emData/TE/
 
-csim_design -compiler gcc -mflags "-j8"
+csim_design -compiler gcc -mflags "-j8" -ldflags "-lpthread"
 csynth_design
-cosim_design 
+cosim_design -ldflags "-lpthread"
 export_design -format ip_catalog
 # Adding "-flow impl" runs full Vivado implementation, providing accurate resource use numbers (very slow).
 #export_design -format ip_catalog -flow impl
@@ -1,25 +1,37 @@
 # Script to generate project for VMR
-#   vivado_hls -f script_VMR.tcl
-#   vivado_hls -p vmrouter
+#   vivado_hls -f script_VMR.tcl [-tclargs <region>]
+#   vivado_hls -p vmrouter_<region>
+# The region defaults to L1PHIE. Each region has its own project, so that
+# several regions can be run in parallel, e.g.
+#   for region in L1PHIE D1PHIA; do vivado_hls -f script_VMR.tcl -tclargs $region & done
 # WARNING: this will wipe out the original project by the same name
 
-# create new project (deleting any existing one of same name)
-open_project -reset vmrouter
+# vivado_hls passes the whole command line in argv
+set region L1PHIE
+set iarg [lsearch -exact $argv "-tclargs"]
+if {$iarg >= 0 && [llength $argv] > $iarg + 1} {
+  set region [lindex $argv [expr {$iarg + 1}]]
+}
 
-# source files
-set CFLAGS {-std=c++11 -I../TrackletAlgorithm}
-set_top VMRouterTop
-add_files ../TrackletAlgorithm/VMRouterTop.cc -cflags "$CFLAGS"
-add_files -tb ../TestBenches/VMRouter_test.cpp -cflags "$CFLAGS"
+# create new project (deleting any existing one of same name)
+open_project -reset vmrouter_${region}
 
 open_solution "solution1"
 
 # Define FPGA, clock frequency & common HLS settings.
+# Also runs download.sh, which writes the top function of every region
+# in emData/VMR/tops (emData/vmrouter_tops.sh)
 source settings_hls.tcl
 
+# source files
+set CFLAGS "-std=c++11 -I../TrackletAlgorithm -I../emData/VMR/tops -DVMR_REGION=${region}"
+set_top VMRouterTop
+add_files ../emData/VMR/tops/VMRouterTop_${region}.cc -cflags "$CFLAGS"
+add_files -tb ../TestBenches/VMRouter_test.cpp -cflags "$CFLAGS"
+
 # data files
 add_files -tb ../emData/VMR/tables/
-add_files -tb ../emData/VMR/VMR_L1PHIE/
+add_files -tb ../emData/VMR/VMR_${region}/
 add_files -tb ../emData/wires_hourglass.dat
 
 csim_design -compiler gcc -mflags "-j8"
@@ -0,0 +1,27 @@
+# Script to generate project for the VMR routing two stubs per clock
+#   vivado_hls -f script_VMRDual.tcl
+#   vivado_hls -p vmrouter_dual
+# WARNING: this will wipe out the original project by the same name
+
+# create new project (deleting any existing one of same name)
+open_project -reset vmrouter_dual
+
+# source files
+set CFLAGS {-std=c++11 -I../TrackletAlgorithm}
+set_top VMRouterDualTop
+add_files ../TrackletAlgorithm/VMRouterTop.cc -cflags "$CFLAGS"
+add_files -tb ../TestBenches/VMRouterDual_test.cpp -cflags "$CFLAGS"
+
+open_solution "solution1"
+
+# Define FPGA, clock frequency & common HLS settings.
+source settings_hls.tcl
+
+# data files
+add_files -tb ../emData/VMR/tables/
+
+csim_design -compiler gcc -mflags "-j8"
+csynth_design
+cosim_design
+#export_design -format ip_catalog
+exit
@@ -0,0 +1,30 @@
+# Script to generate project for the VMR with a virtual AllStub memory
+#   vivado_hls -f script_VirtualMemory.tcl
+#   vivado_hls -p vmrouter_virtual
+# The C simulation prints the block RAMs a time-multiplexed read port of the
+# virtual memory would save. That read port is not implemented, so the
+# synthesized top only writes the copies, and cannot replace VMRouterTop.
+# WARNING: this will wipe out the original project by the same name
+
+# create new project (deleting any existing one of same name)
+open_project -reset vmrouter_virtual
+
+# source files
+set CFLAGS {-std=c++11 -I../TrackletAlgorithm}
+set_top VMRouterVirtualTop
+add_files ../TrackletAlgorithm/VMRouterTop.cc -cflags "$CFLAGS"
+add_files -tb ../TestBenches/VirtualMemory_test.cpp -cflags "$CFLAGS"
+
+open_solution "solution1"
+
+# Define FPGA, clock frequency & common HLS settings.
+source settings_hls.tcl
+
+# data files
+add_files -tb ../emData/VMR/tables/
+
+csim_design -compiler gcc -mflags "-j8"
+csynth_design
+cosim_design
+#export_design -format ip_catalog
+exit